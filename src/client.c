@@ -0,0 +1,118 @@
+// [ INCLUDING ] //
+
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+
+#include "icl/cstdef.h"
+#include "icl/cstint.h"
+#include "server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <string.h>
+
+// [ FUNCTIONS ] //
+
+static bool client_send(SOCKET server, char* buffer, size_t size) {
+	
+	// Keep writing until everything has gone out
+	size_t sent = 0;
+	while (sent < size) {
+		int count = send(server, &buffer[sent], (int)(size - sent), 0);
+		if (count <= 0) return false;
+		sent += count;
+	}
+	
+	return true;
+	
+}
+
+static bool client_receive(SOCKET server, char* buffer, size_t size) {
+	
+	// Keep reading until everything has arrived
+	size_t received = 0;
+	while (received < size) {
+		int count = recv(server, &buffer[received], (int)(size - received), 0);
+		if (count <= 0) return false;
+		received += count;
+	}
+	
+	return true;
+	
+}
+
+// [ MAIN ] //
+
+int main(int argCount, char* argList[]) {
+	
+	// The socket path can be overridden so several servers can run side by side
+	char* serverPath = getenv("CSR_SERVER");
+	if (!serverPath) serverPath = SERVER_DEFAULT_PATH;
+	
+	// Pack the working directory and the command line into one request
+	char payload[SERVER_MAX_REQUEST];
+	if (!getcwd(payload, sizeof(payload))) return EXIT_FAILURE;
+	size_t size = strlen(payload) + 1;
+	
+	for (int i = 0; i < argCount; i++) {
+		size_t length = strlen(argList[i]) + 1;
+		if ((size + length) > sizeof(payload)) return EXIT_FAILURE;
+		memcpy(&payload[size], argList[i], length);
+		size += length;
+	}
+	
+	// Connect to the server
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return EXIT_FAILURE;
+	
+	SOCKET server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server == INVALID_SOCKET) {
+		WSACleanup();
+		return EXIT_FAILURE;
+	}
+	
+	struct sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, serverPath, sizeof(address.sun_path) - 1);
+	
+	if (connect(server, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		fprintf(stderr, "Could not connect to the compiler server at %s\n", serverPath);
+		closesocket(server);
+		WSACleanup();
+		return EXIT_FAILURE;
+	}
+	
+	// Send the request
+	server_request request = {};
+	request.size = (uint32_t)size;
+	
+	int status = EXIT_FAILURE;
+	server_response response = {};
+	
+	if ((client_send(server, (char*)&request, sizeof(request))) && (client_send(server, payload, size)) && (client_receive(server, (char*)&response, sizeof(response)))) {
+		
+		// Pass the output straight through
+		char chunk[4096];
+		size_t remaining = response.size;
+		while (remaining > 0) {
+			size_t count = (remaining < sizeof(chunk)) ? remaining : sizeof(chunk);
+			if (!client_receive(server, chunk, count)) break;
+			fwrite(chunk, 1, count, stdout);
+			remaining -= count;
+		}
+		
+		if (remaining == 0) status = response.status;
+		
+	}
+	
+	// Clean up
+	closesocket(server);
+	WSACleanup();
+	
+	// Return the compiler's status
+	return status;
+	
+}
@@ -1,8 +1,11 @@
 // [ INCLUDING ] //
 
+#include <winsock2.h>
+#include <afunix.h>
 #include <windows.h>
 
 #include "module/common.h"
+#include "server.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,19 +14,121 @@
 #include <stdbool.h>
 #include <string.h>
 #include <stdarg.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <process.h>
+
+// [ MACROS ] //
+
+#define DEFAULT_MAX_ERRORS 20
+#define DEFAULT_FILE_NAME "test.csr"
+#define DEFAULT_HEADER_CACHE "csrcache"
+
+#define OPTIONS_MAX_FILES 256
+#define OPTIONS_MAX_JOBS 64
+#define OPTIONS_MAX_PATH 1024
+#define OPTIONS_MAX_INCLUDES 64
+
+#define CACHE_MAX_ENTRIES 64 // Files kept by the server; the one used longest ago makes room for a new one
 
 // [ DEFINING ] //
 
+typedef enum {
+	OPTIONS_OUTPUT_CONSOLE, // Every stage is printed, with the Assembly at the end
+	OPTIONS_OUTPUT_ASSEMBLY, // -S writes an Assembly file
+	OPTIONS_OUTPUT_OBJECT, // -c assembles it into an object file
+	OPTIONS_OUTPUT_INTERPRET, // --interpret runs the IR and prints what main returned
+	OPTIONS_OUTPUT_RUN, // --run encodes the Assembly into memory, calls main and prints what it returned
+} options_output;
+
+typedef struct {
+	char* fileName;
+	char* fileNames[OPTIONS_MAX_FILES];
+	size_t fileCount;
+	char* outputName;
+	options_output outputMode;
+	size_t jobs;
+	size_t maxErrors;
+	char* includePaths[OPTIONS_MAX_INCLUDES];
+	size_t includeCount;
+	char* headerCache;
+	bool server;
+	char* serverPath;
+	bool invalid;
+} options;
+
 struct {
 	code code;
+	preprocessor preprocessor;
 	stream stream;
+	stream lexed; // The stream as the lexer left it, before headers were imported and the parser resolved it
 	symbol_table symbolTable;
 	error_table errorTable;
 	ast ast;
 	ir ir;
 	assm asm;
+	header_paths headers;
 } currentFile;
 
+// Output goes to the console, unless it is being collected to answer a server request
+struct {
+	bool capture;
+	bool quiet;
+	size_t memSize;
+	size_t size;
+	char* buffer;
+} output;
+
+/*////////*/
+
+// A file other than the one compiled that went into its output
+typedef struct {
+	char* fileName;
+	int64_t modifiedTime;
+	int64_t fileSize;
+} cache_dependency;
+
+typedef struct {
+	char* key; // The directory, the file and every option that changes the output
+	uint64_t lastUsed;
+	int64_t modifiedTime;
+	int64_t fileSize;
+	int64_t cachedTime;
+	uint64_t hash;
+	int status;
+	size_t outputSize;
+	char* output;
+	
+	// Included files and imported headers, which have to be untouched too for the output to be given again
+	bool dependenciesKnown;
+	size_t dependencyCount;
+	cache_dependency* dependencies;
+	
+	// The file as it was last read and lexed, so the next compile only lexes what changed
+	bool lexed;
+	code code;
+	stream tokens;
+	
+	// The last parse of the file, so the next compile only parses declarations that changed, and what its functions were lowered to
+	bool parsed;
+	stream stream;
+	symbol_table symbolTable;
+	ast ast;
+	ir_fragments fragments;
+	
+	// What its functions were selected into, which only depends on the IR they were lowered to
+	asm_fragments asmFragments;
+} cache_entry;
+
+// State that is built once and kept between compiles
+struct {
+	symbol_table builtinTable;
+	size_t memSize;
+	size_t size;
+	cache_entry* buffer;
+	uint64_t clock; // Counts lookups, so entries can tell which was used longest ago
+} warm;
+
 // [ FUNCTIONS ] //
 
 __attribute__((constructor)) void init() {
@@ -35,10 +140,38 @@ __attribute__((constructor)) void init() {
 
 /*////////*/
 
+static bool output_resize(size_t needed) {
+	
+	// If the buffer can hold the text and a null terminator, just return
+	if ((output.size + needed) < output.memSize) return true;
+	
+	// Double the buffer until it fits
+	size_t newMemSize = (output.memSize == 0) ? 4096 : output.memSize;
+	while ((output.size + needed) >= newMemSize) newMemSize *= 2;
+	
+	// Allocate a new buffer
+	char* newBuffer = calloc(newMemSize, sizeof(char));
+	if (!newBuffer) return false;
+	
+	// Copy the new memory in and free the old buffer
+	if (output.buffer) memcpy(newBuffer, output.buffer, output.size);
+	free(output.buffer);
+	
+	// Assign the new buffer to the old one
+	output.memSize = newMemSize;
+	output.buffer = newBuffer;
+	
+	// Return success
+	return true;
+	
+}
+
 void print_utf16(const unsigned short* msg, ...) {
 	HANDLE stdHandle = GetStdHandle(STD_OUTPUT_HANDLE);
 	DWORD written;
 	
+	if (output.quiet) return;
+	
 	va_list args;
 	va_start(args, msg);
 	int len = _vsnwprintf(NULL, 0, msg, args);
@@ -53,7 +186,15 @@ void print_utf16(const unsigned short* msg, ...) {
 	vsnwprintf(str, len + 1, msg, args);
 	va_end(args);
 
-	WriteConsoleW(stdHandle, str, (DWORD)len, &written, NULL);
+	if (output.capture) {
+		int size = WideCharToMultiByte(CP_UTF8, 0, str, len, NULL, 0, NULL, NULL);
+		if ((size > 0) && output_resize(size)) {
+			WideCharToMultiByte(CP_UTF8, 0, str, len, &output.buffer[output.size], size, NULL, NULL);
+			output.size += size;
+		}
+	} else {
+		WriteConsoleW(stdHandle, str, (DWORD)len, &written, NULL);
+	}
 
 	free(str);
 }
@@ -62,6 +203,8 @@ void print_utf8(const char* msg, ...) {
 	HANDLE stdHandle = GetStdHandle(STD_OUTPUT_HANDLE);
 	DWORD written;
 	
+	if (output.quiet) return;
+	
 	va_list args;
 	va_start(args, msg);
 	int len = vsnprintf(NULL, 0, msg, args);
@@ -69,6 +212,16 @@ void print_utf8(const char* msg, ...) {
 
 	if (len < 0) return;
 
+	// Format straight into the collected output when answering a request
+	if (output.capture) {
+		if (!output_resize(len)) return;
+		va_start(args, msg);
+		vsnprintf(&output.buffer[output.size], len + 1, msg, args);
+		va_end(args);
+		output.size += len;
+		return;
+	}
+
 	char* str = malloc(len + 1);
 	if (!str) return;
 
@@ -81,74 +234,209 @@ void print_utf8(const char* msg, ...) {
 	free(str);
 }
 
-// [ MAIN ] //
+void print_bytes(const char* text, size_t length) {
+	HANDLE stdHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD written;
+	
+	if (output.quiet) return;
+	
+	// Text that is already written out is passed on without being formatted again
+	if (output.capture) {
+		if (!output_resize(length)) return;
+		memcpy(&output.buffer[output.size], text, length);
+		output.size += length;
+		output.buffer[output.size] = '\0';
+		return;
+	}
+	
+	WriteConsoleA(stdHandle, text, (DWORD)length, &written, NULL);
+}
 
-int main(int argCount, char* argList[]) {
+/*////////*/
+
+static bool builtins_create(symbol_table* pSymbolTable) {
+	
+	// Create the symbol table
+	if (!symbol_table_create(pSymbolTable)) return false;
+	
+	// Add recognized identifiers to the symbol table
+	symbol_add(pSymbolTable, "byte",    SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_8, 0,  SYMBOL_CLASS_TYPE);
+	symbol_add(pSymbolTable, "int",     SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_32, 0, SYMBOL_CLASS_TYPE);
+	symbol_add(pSymbolTable, "float",   SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_64, 0, SYMBOL_CLASS_TYPE);
+	symbol_add(pSymbolTable, "decimal", SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_64, 0, SYMBOL_CLASS_TYPE);
+	symbol_add(pSymbolTable, "bool",    SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_8, 0,  SYMBOL_CLASS_TYPE);
+	
+	symbol_add(pSymbolTable, "true",  SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
+	symbol_add(pSymbolTable, "false", SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
+	
+	symbol_add(pSymbolTable, "null", SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
+	
+	symbol_add(pSymbolTable, "void", SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_TYPE);
+	
+	// Return success
+	return true;
+	
+}
+
+static bool path_extension(char* buffer, size_t size, char* fileName, char* extension) {
+	
+	// Only a dot in the last part of the path starts an extension
+	char* base = fileName;
+	for (char* c = fileName; *c; c++) if ((*c == '/') || (*c == '\\')) base = c + 1;
+	
+	char* dot = strrchr(base, '.');
+	size_t length = (dot) ? (size_t)(dot - fileName) : strlen(fileName);
+	
+	int written = snprintf(buffer, size, "%.*s%s", (int)length, fileName, extension);
+	return ((written > 0) && ((size_t)written < size));
+	
+}
+
+static bool compile_write(options* pOptions, assm* pAssm) {
+	
+	// Output goes next to the input, unless it was given a name
+	char objectName[OPTIONS_MAX_PATH] = {};
+	char assemblyName[OPTIONS_MAX_PATH] = {};
+	
+	if (pOptions->outputMode == OPTIONS_OUTPUT_OBJECT) {
+		if (pOptions->outputName) strncpy(objectName, pOptions->outputName, sizeof(objectName) - 1);
+		else if (!path_extension(objectName, sizeof(objectName), pOptions->fileName, ".obj")) return false;
+		if (!path_extension(assemblyName, sizeof(assemblyName), objectName, ".asm")) return false;
+	} else {
+		if (pOptions->outputName) strncpy(assemblyName, pOptions->outputName, sizeof(assemblyName) - 1);
+		else if (!path_extension(assemblyName, sizeof(assemblyName), pOptions->fileName, ".asm")) return false;
+	}
+	
+	if (!assm_write(pAssm, assemblyName)) {
+		print_utf8("%s: error: Could not write %s\n", pOptions->fileName, assemblyName);
+		return false;
+	}
+	
+	if (pOptions->outputMode == OPTIONS_OUTPUT_ASSEMBLY) return true;
+	
+	// Objects are assembled from the Assembly file, which is removed again afterwards
+	char command[(OPTIONS_MAX_PATH * 2) + 64] = {};
+	snprintf(command, sizeof(command), "nasm -f win64 -o \"%s\" \"%s\"", objectName, assemblyName);
+	
+	int result = system(command);
+	remove(assemblyName);
+	
+	if (result != 0) {
+		print_utf8("%s: error: Could not assemble %s\n", pOptions->fileName, objectName);
+		return false;
+	}
+	
+	return true;
+	
+}
+
+static bool compile_interpret(options* pOptions, ir* pIR) {
+	
+	// Define run info
+	ir_run_info runInfo = {};
+	runInfo.pIR = pIR;
+	
+	// Run the IR, and say how it went whether or not it got to the end
+	ir_run run = {};
+	bool succeeded = ir_interpret(&run, &runInfo);
+	
+	print_utf8("%s: ", pOptions->fileName);
+	ir_run_print(&run);
+	
+	return succeeded;
+	
+}
+
+static bool compile_execute(options* pOptions, assm* pAsm) {
+	
+	// Define JIT info
+	jit_info jitInfo = {};
+	jitInfo.pAsm = pAsm;
+	
+	// Run the machine code, and say how it went whether or not main returned
+	jit_run run = {};
+	bool succeeded = jit_execute(&run, &jitInfo);
+	
+	print_utf8("%s: ", pOptions->fileName);
+	jit_run_print(&run);
+	
+	return succeeded;
+	
+}
+
+static bool compile_run(options* pOptions, cache_entry* pEntry) {
+	
+	// Each stage is only shown when nothing is being written to a file
+	bool verbose = (pOptions->outputMode == OPTIONS_OUTPUT_CONSOLE);
 	
 	// Define file code info
 	code_info currentFileCodeInfo = {};
-	currentFileCodeInfo.fileName = "test.csr";
+	currentFileCodeInfo.fileName = pOptions->fileName;
 	
 	// Create the code
-	if (!code_create(&currentFile.code, &currentFileCodeInfo)) {
-		
-		// Return error
-		return EXIT_FAILURE;
-		
-	}
+	if (!code_create(&currentFile.code, &currentFileCodeInfo)) return false;
+	
+	if (verbose) print_utf8("Creation of file code succeeded.\n");
+	
+	// Define file preprocessor info
+	preprocessor_info currentFilePreprocessorInfo = {};
+	currentFilePreprocessorInfo.pCode = &currentFile.code;
+	currentFilePreprocessorInfo.includePaths = pOptions->includePaths;
+	currentFilePreprocessorInfo.includeCount = pOptions->includeCount;
 	
-	print_utf8("Creation of file code succeeded.\n");
+	// Find out whether the file has directives, and read it into tokens if it does
+	if (!preprocessor_create(&currentFile.preprocessor, &currentFilePreprocessorInfo)) return false;
 	
 	// Define file stream info
 	stream_info currentFileStreamInfo = {};
 	currentFileStreamInfo.pCode = &currentFile.code;
 	currentFileStreamInfo.pSymbolTable = &currentFile.symbolTable;
 	
-	// Create the file stream
-	if (!stream_create(&currentFile.stream, &currentFileStreamInfo)) {
-		
-		// Return error
-		return EXIT_FAILURE;
-		
+	// Only lex again what changed since the file was last lexed
+	if ((pEntry) && (pEntry->lexed)) {
+		currentFileStreamInfo.pPreviousCode = &pEntry->code;
+		currentFileStreamInfo.pPreviousStream = &pEntry->tokens;
 	}
 	
-	stream_print(&currentFile.stream);
-	
-	print_utf8("Creation of file stream succeeded.\n");
-	
-	// Create the symbol table
-	if (!symbol_table_create(&currentFile.symbolTable)) {
+	// Create the file stream, expanding macros and includes on the way if there are any
+	if (currentFile.preprocessor.needed) {
+		if (!preprocessor_stream(&currentFile.stream, &currentFile.preprocessor)) return false;
+	} else {
 		
-		// Return error
-		return EXIT_FAILURE;
+		if (!stream_create(&currentFile.stream, &currentFileStreamInfo)) return false;
+		
+		// Importing headers and parsing both change the stream, so the next compile gets a copy from before that
+		if ((pEntry) && (!stream_copy(&currentFile.lexed, &currentFile.stream))) return false;
 		
 	}
 	
-	// Add recognized identifiers to the symbol table
-	symbol_add(&currentFile.symbolTable, "byte",    SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_8, 0,  SYMBOL_CLASS_TYPE);
-	symbol_add(&currentFile.symbolTable, "int",     SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_32, 0, SYMBOL_CLASS_TYPE);
-	symbol_add(&currentFile.symbolTable, "float",   SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_64, 0, SYMBOL_CLASS_TYPE);
-	symbol_add(&currentFile.symbolTable, "decimal", SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_64, 0, SYMBOL_CLASS_TYPE);
-	symbol_add(&currentFile.symbolTable, "bool",    SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_8, 0,  SYMBOL_CLASS_TYPE);
+	// Define file header import info
+	header_import_info currentFileHeaderInfo = {};
+	currentFileHeaderInfo.pCode = &currentFile.code;
+	currentFileHeaderInfo.cacheDir = pOptions->headerCache;
+	currentFileHeaderInfo.includePaths = pOptions->includePaths;
+	currentFileHeaderInfo.includeCount = pOptions->includeCount;
+	currentFileHeaderInfo.pFound = &currentFile.headers;
+	
+	// Replace each imported C header with the module interface made from it
+	if (!header_import(&currentFile.stream, &currentFileHeaderInfo)) return false;
 	
-	symbol_add(&currentFile.symbolTable, "true",  SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
-	symbol_add(&currentFile.symbolTable, "false", SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
+	if (verbose) stream_print(&currentFile.stream);
 	
-	symbol_add(&currentFile.symbolTable, "null", SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
+	if (verbose) print_utf8("Creation of file stream succeeded.\n");
 	
-	symbol_add(&currentFile.symbolTable, "void", SYMBOL_TYPE_TYPE, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_TYPE);
+	// Start the symbol table from a copy of the builtin identifiers
+	if (!symbol_table_copy(&currentFile.symbolTable, &warm.builtinTable)) return false;
 	
-	print_utf8("Creation of symbol table succeeded.\n");
+	if (verbose) print_utf8("Creation of symbol table succeeded.\n");
 	
 	// Create the error table
-	if (!error_table_create(&currentFile.errorTable)) {
-		
-		// Return error
-		return EXIT_FAILURE;
-		
-	}
+	if (!error_table_create(&currentFile.errorTable)) return false;
+	
+	// Limit how many errors are collected
+	currentFile.errorTable.maxSize = pOptions->maxErrors;
 	
-	print_utf8("Creation of error table succeeded.\n");
+	if (verbose) print_utf8("Creation of error table succeeded.\n");
 	
 	// Define file AST info
 	ast_info currentFileASTInfo = {};
@@ -156,69 +444,798 @@ int main(int argCount, char* argList[]) {
 	currentFileASTInfo.pSymbolTable = &currentFile.symbolTable;
 	currentFileASTInfo.pErrorTable = &currentFile.errorTable;
 	
-	// Create the AST
-	if (!ast_create(&currentFile.ast, &currentFileASTInfo)) {
-		
-		// Return error
-		return EXIT_FAILURE;
-		
+	// Reuse what can be reused from the last parse of this file
+	currentFileASTInfo.incremental = (pEntry != NULL);
+	if ((pEntry) && (pEntry->parsed)) {
+		currentFileASTInfo.pPrevious = &pEntry->ast;
+		currentFileASTInfo.pPreviousStream = &pEntry->stream;
+		currentFileASTInfo.pPreviousSymbolTable = &pEntry->symbolTable;
 	}
 	
-	print_utf8("Creation of file AST succeeded.\n");
+	// Create the AST
+	// The parser and the IR generator trace what they do as they go, which is only wanted when every stage is shown
+	output.quiet = !verbose;
+	bool parsed = ast_create(&currentFile.ast, &currentFileASTInfo);
+	output.quiet = false;
+	if (!parsed) return false;
+	
+	if (verbose) print_utf8("Creation of file AST succeeded.\n");
 	
-	ast_print(&currentFile.ast);
+	if (verbose) ast_print(&currentFile.ast);
 	
-	error_table_print(&currentFile.errorTable);
+	error_table_print(&currentFile.errorTable, &currentFile.code);
 	
-	symbol_table_print(&currentFile.symbolTable);
+	if (verbose) symbol_table_print(&currentFile.symbolTable);
 	
 	// Define file IR info
 	ir_info currentFileIRInfo = {};
 	currentFileIRInfo.pAST = &currentFile.ast;
 	currentFileIRInfo.pSymbolTable = &currentFile.symbolTable;
 	
+	// Copy in what unchanged functions were lowered to last time
+	currentFileIRInfo.incremental = (pEntry != NULL);
+	if ((pEntry) && (pEntry->parsed)) currentFileIRInfo.pPrevious = &pEntry->fragments;
+	
 	// Generate the IR
-	if (!ir_generate(&currentFile.ir, &currentFileIRInfo)) {
-		
-		// Return error
-		return EXIT_FAILURE;
-		
-	}
+	output.quiet = !verbose;
+	bool generated = ir_generate(&currentFile.ir, &currentFileIRInfo);
+	output.quiet = false;
+	if (!generated) return false;
+	
+	if (verbose) ir_print(&currentFile.ir);
 	
-	ir_print(&currentFile.ir);
+	if (verbose) print_utf8("Generation of file IR succeeded.\n");
 	
-	print_utf8("Generation of file IR succeeded.\n");
+	// The IR can be run as it is, without an assembler or a linker
+	if (pOptions->outputMode == OPTIONS_OUTPUT_INTERPRET) return compile_interpret(pOptions, &currentFile.ir);
 	
 	// Define file IR info
 	assm_info currentFileAsmInfo = {};
 	currentFileAsmInfo.pIR = &currentFile.ir;
 	
+	// Copy in the instructions of functions that were lowered to the same units last time
+	currentFileAsmInfo.incremental = (pEntry != NULL);
+	if (pEntry) currentFileAsmInfo.pPrevious = &pEntry->asmFragments;
+	
 	// Generate the Assembly
-	if (!assm_generate(&currentFile.asm, &currentFileAsmInfo)) {
-		
-		// Return error
-		return EXIT_FAILURE;
-		
-	}
+	if (!assm_generate(&currentFile.asm, &currentFileAsmInfo)) return false;
+	
+	// The same instructions an object file would get can be run in place
+	if (pOptions->outputMode == OPTIONS_OUTPUT_RUN) return compile_execute(pOptions, &currentFile.asm);
 	
-	assm_print(&currentFile.asm);
+	// Print it after everything else, or write it out
+	if (verbose) assm_print(&currentFile.asm);
+	else if (!compile_write(pOptions, &currentFile.asm)) return false;
 	
-	print_utf8("Generation of file Assembly succeeded.\n");
+	if (verbose) print_utf8("Generation of file Assembly succeeded.\n");
 	
 	// Print success
-	print_utf8("Creation of file compilation objects succeeded.\n");
+	if (verbose) print_utf8("Creation of file compilation objects succeeded.\n");
+	
+	// Return success
+	return true;
+	
+}
+
+static void cache_depend_add(cache_entry* pEntry, char* fileName) {
+	
+	cache_dependency* pDependency = &pEntry->dependencies[(pEntry->dependencyCount)++];
+	pDependency->fileName = strdup(fileName);
+	
+	// A dependency that can't be looked at is recorded as missing, so it never matches
+	struct stat fileStat;
+	if ((pDependency->fileName) && (stat(fileName, &fileStat) == 0)) {
+		pDependency->modifiedTime = (int64_t)fileStat.st_mtime;
+		pDependency->fileSize = (int64_t)fileStat.st_size;
+	} else {
+		pDependency->modifiedTime = -1;
+		pDependency->fileSize = -1;
+	}
+	
+}
+
+static void cache_depend(cache_entry* pEntry) {
+	
+	// Forget what the last compile depended on
+	for (size_t i = 0; i < pEntry->dependencyCount; i++) free(pEntry->dependencies[i].fileName);
+	free(pEntry->dependencies);
+	pEntry->dependencies = NULL;
+	pEntry->dependencyCount = 0;
+	pEntry->dependenciesKnown = false;
+	
+	// Files read by the preprocessor are the included ones; the file being compiled is checked on its own
+	size_t count = currentFile.headers.size;
+	for (size_t i = 0; i < currentFile.preprocessor.files.size; i++) if (currentFile.preprocessor.files.buffer[i].owned) count++;
+	if (count == 0) {
+		pEntry->dependenciesKnown = true;
+		return;
+	}
+	
+	pEntry->dependencies = calloc(count, sizeof(cache_dependency));
+	if (!pEntry->dependencies) return;
+	
+	for (size_t i = 0; i < currentFile.preprocessor.files.size; i++) {
+		if (currentFile.preprocessor.files.buffer[i].owned) cache_depend_add(pEntry, currentFile.preprocessor.files.buffer[i].pCode->fileName);
+	}
+	for (size_t i = 0; i < currentFile.headers.size; i++) cache_depend_add(pEntry, currentFile.headers.buffer[i]);
+	
+	pEntry->dependenciesKnown = true;
+	
+}
+
+static int compile(options* pOptions, cache_entry* pEntry) {
+	
+	// Every compile starts from empty objects
+	memset(&currentFile, 0, sizeof(currentFile));
+	
+	bool succeeded = compile_run(pOptions, pEntry);
+	
+	// Everything the file pulled in has to be untouched for this output to be given again
+	if (pEntry) cache_depend(pEntry);
+	
+	// Keep the file and its tokens for next time, in place of the ones they were lexed from; a file with directives is always lexed in full
+	if (pEntry) {
+		
+		if (pEntry->lexed) {
+			code_destroy(&pEntry->code);
+			stream_destroy(&pEntry->tokens);
+			pEntry->lexed = false;
+		}
+		
+		if (currentFile.lexed.buffer) {
+			
+			pEntry->lexed = true;
+			pEntry->code = currentFile.code;
+			pEntry->tokens = currentFile.lexed;
+			
+			memset(&currentFile.code, 0, sizeof(currentFile.code));
+			memset(&currentFile.lexed, 0, sizeof(currentFile.lexed));
+			
+		}
+		
+	}
+	
+	// Keep the parse around for next time, in place of the one it was built from, with the functions lowered from it
+	if ((pEntry) && (currentFile.ast.root)) {
+		
+		if (pEntry->parsed) {
+			ast_destroy(&pEntry->ast);
+			symbol_table_destroy(&pEntry->symbolTable);
+			stream_destroy(&pEntry->stream);
+			ir_fragments_destroy(&pEntry->fragments);
+		}
+		
+		pEntry->parsed = true;
+		pEntry->ast = currentFile.ast;
+		pEntry->symbolTable = currentFile.symbolTable;
+		pEntry->stream = currentFile.stream;
+		pEntry->fragments = currentFile.ir.fragments;
+		
+		memset(&currentFile.ast, 0, sizeof(currentFile.ast));
+		memset(&currentFile.symbolTable, 0, sizeof(currentFile.symbolTable));
+		memset(&currentFile.stream, 0, sizeof(currentFile.stream));
+		memset(&currentFile.ir.fragments, 0, sizeof(currentFile.ir.fragments));
+		
+	}
 	
-	sleep(2);
+	// The instructions are kept whenever the Assembly was generated, whatever the parse
+	if ((pEntry) && (currentFile.asm.fragments.buffer)) {
+		
+		assm_fragments_destroy(&pEntry->asmFragments);
+		pEntry->asmFragments = currentFile.asm.fragments;
+		memset(&currentFile.asm.fragments, 0, sizeof(currentFile.asm.fragments));
+		
+	}
 	
-	// Destroy everything
+	// Destroy everything, whether or not the compile got all the way through
+	assm_destroy(&currentFile.asm);
+	ir_destroy(&currentFile.ir);
+	ast_destroy(&currentFile.ast);
+	error_table_destroy(&currentFile.errorTable);
+	symbol_table_destroy(&currentFile.symbolTable);
 	stream_destroy(&currentFile.stream);
+	stream_destroy(&currentFile.lexed);
+	preprocessor_destroy(&currentFile.preprocessor);
+	header_paths_destroy(&currentFile.headers);
 	code_destroy(&currentFile.code);
 	
+	if (!succeeded) return EXIT_FAILURE;
+	
 	// Print success
-	print_utf8("Destruction of file compilation objects succeeded.\n");
-	sleep(2);
+	if (pOptions->outputMode == OPTIONS_OUTPUT_CONSOLE) print_utf8("Destruction of file compilation objects succeeded.\n");
+	
+	// Return success
+	return EXIT_SUCCESS;
+	
+}
+
+/*////////*/
+
+static bool cache_resize() {
+	
+	// If the buffer can hold more elements, just return
+	if (warm.size < warm.memSize) return true;
+	
+	// Allocate a new buffer
+	size_t newMemSize = (warm.memSize == 0) ? 8 : (warm.memSize * 2);
+	cache_entry* newBuffer = calloc(newMemSize, sizeof(cache_entry));
+	if (!newBuffer) return false;
+	
+	// Copy the new memory in and free the old buffer
+	if (warm.buffer) memcpy(newBuffer, warm.buffer, (warm.size * sizeof(cache_entry)));
+	free(warm.buffer);
+	
+	// Assign the new buffer to the old one
+	warm.memSize = newMemSize;
+	warm.buffer = newBuffer;
 	
 	// Return success
+	return true;
+	
+}
+
+static bool cache_hash(char* fileName, uint64_t* pHash) {
+	
+	FILE* file = fopen(fileName, "rb");
+	if (file == NULL) return false;
+	
+	// FNV-1a over the whole file
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	char chunk[4096];
+	size_t bytesRead = 0;
+	while ((bytesRead = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		for (size_t i = 0; i < bytesRead; i++) {
+			hash ^= (uint8_t)chunk[i];
+			hash *= 0x100000001b3ULL;
+		}
+	}
+	
+	fclose(file);
+	
+	*pHash = hash;
+	return true;
+	
+}
+
+static char* cache_key(options* pOptions) {
+	
+	// Relative paths in the file name and in -I mean something else from every directory, so the directory is part of the key
+	char directory[OPTIONS_MAX_PATH] = {};
+	if (!getcwd(directory, sizeof(directory))) return NULL;
+	
+	// Headers are also searched for where the C compiler would look
+	char* include = getenv("INCLUDE");
+	if (!include) include = "";
+	
+	size_t length = strlen(directory) + strlen(pOptions->fileName) + strlen(pOptions->headerCache) + strlen(include) + 64;
+	for (size_t i = 0; i < pOptions->includeCount; i++) length += strlen(pOptions->includePaths[i]) + 1;
+	
+	char* key = malloc(length);
+	if (!key) return NULL;
+	
+	// Lines can't be part of a path, so they keep every part apart
+	size_t written = (size_t)snprintf(key, length, "%s\n%s\n%llu\n%d\n%s\n%s", directory, pOptions->fileName, (unsigned long long)pOptions->maxErrors, (int)pOptions->outputMode, pOptions->headerCache, include);
+	for (size_t i = 0; (i < pOptions->includeCount) && (written < length); i++) {
+		written += (size_t)snprintf(&key[written], length - written, "\n%s", pOptions->includePaths[i]);
+	}
+	
+	return key;
+	
+}
+
+static void cache_clear(cache_entry* pEntry) {
+	
+	free(pEntry->key);
+	free(pEntry->output);
+	
+	for (size_t i = 0; i < pEntry->dependencyCount; i++) free(pEntry->dependencies[i].fileName);
+	free(pEntry->dependencies);
+	
+	if (pEntry->lexed) {
+		code_destroy(&pEntry->code);
+		stream_destroy(&pEntry->tokens);
+	}
+	
+	if (pEntry->parsed) {
+		ast_destroy(&pEntry->ast);
+		symbol_table_destroy(&pEntry->symbolTable);
+		stream_destroy(&pEntry->stream);
+		ir_fragments_destroy(&pEntry->fragments);
+	}
+	
+	assm_fragments_destroy(&pEntry->asmFragments);
+	
+	*pEntry = (cache_entry){};
+	
+}
+
+static cache_entry* cache_find(char* key) {
+	
+	// Output depends on the file and on every option that changes it, which is all in the key
+	for (size_t i = 0; i < warm.size; i++) {
+		if (strcmp(warm.buffer[i].key, key) == 0) {
+			warm.buffer[i].lastUsed = ++(warm.clock);
+			return &warm.buffer[i];
+		}
+	}
+	
+	// Return NULL if we found nothing
+	return NULL;
+	
+}
+
+static cache_entry* cache_add(char* key) {
+	
+	cache_entry* pEntry = NULL;
+	
+	// Once the cache is full, the entry used longest ago makes room
+	if (warm.size >= CACHE_MAX_ENTRIES) {
+		pEntry = &warm.buffer[0];
+		for (size_t i = 1; i < warm.size; i++) if (warm.buffer[i].lastUsed < pEntry->lastUsed) pEntry = &warm.buffer[i];
+		cache_clear(pEntry);
+	} else {
+		if (!cache_resize()) return NULL;
+		pEntry = &warm.buffer[(warm.size)++];
+		*pEntry = (cache_entry){};
+	}
+	
+	pEntry->key = key;
+	pEntry->lastUsed = ++(warm.clock);
+	
+	return pEntry;
+	
+}
+
+static bool cache_current(cache_entry* pEntry) {
+	
+	if (!pEntry->dependenciesKnown) return false;
+	
+	// Every file pulled in has to be as it was, and not modified in the same second it was cached
+	for (size_t i = 0; i < pEntry->dependencyCount; i++) {
+		cache_dependency* pDependency = &pEntry->dependencies[i];
+		struct stat fileStat;
+		if (stat(pDependency->fileName, &fileStat) != 0) return false;
+		if ((pDependency->modifiedTime != (int64_t)fileStat.st_mtime) || (pDependency->fileSize != (int64_t)fileStat.st_size)) return false;
+		if (pDependency->modifiedTime >= pEntry->cachedTime) return false;
+	}
+	
+	return true;
+	
+}
+
+static int compile_cached(options* pOptions) {
+	
+	// Files that can not be looked at are compiled as usual, so the usual failure is reported
+	struct stat fileStat;
+	if (stat(pOptions->fileName, &fileStat) != 0) return compile(pOptions, NULL);
+	
+	char* key = cache_key(pOptions);
+	if (!key) return compile(pOptions, NULL);
+	
+	cache_entry* pEntry = cache_find(key);
+	
+	// Printed output can be given again, but files have to be written again every time
+	bool replay = (pOptions->outputMode == OPTIONS_OUTPUT_CONSOLE) && (pEntry) && cache_current(pEntry);
+	
+	// An untouched file gives the same output as last time; a file modified in the same second it was cached might have changed since
+	if ((replay) && (pEntry->modifiedTime == (int64_t)fileStat.st_mtime) && (pEntry->modifiedTime < pEntry->cachedTime) && (pEntry->fileSize == (int64_t)fileStat.st_size)) {
+		free(key);
+		if (output_resize(pEntry->outputSize)) {
+			memcpy(&output.buffer[output.size], pEntry->output, pEntry->outputSize);
+			output.size += pEntry->outputSize;
+		}
+		return pEntry->status;
+	}
+	
+	// A touched file might still have the same contents
+	uint64_t hash = 0;
+	if (!cache_hash(pOptions->fileName, &hash)) {
+		free(key);
+		return compile(pOptions, NULL);
+	}
+	
+	if ((replay) && (pEntry->hash == hash)) {
+		free(key);
+		pEntry->modifiedTime = (int64_t)fileStat.st_mtime;
+		pEntry->fileSize = (int64_t)fileStat.st_size;
+		pEntry->cachedTime = (int64_t)time(NULL);
+		if (output_resize(pEntry->outputSize)) {
+			memcpy(&output.buffer[output.size], pEntry->output, pEntry->outputSize);
+			output.size += pEntry->outputSize;
+		}
+		return pEntry->status;
+	}
+	
+	// Otherwise compile it, starting from the last parse, and remember the result
+	if (pEntry) {
+		free(key);
+	} else {
+		pEntry = cache_add(key);
+		if (!pEntry) {
+			free(key);
+			return compile(pOptions, NULL);
+		}
+	}
+	
+	size_t outputStart = output.size;
+	int status = compile(pOptions, pEntry);
+	
+	// Without the new output, the old one must not be given again for what the file now depends on
+	char* newOutput = malloc((output.size - outputStart) + 1);
+	if (!newOutput) {
+		pEntry->dependenciesKnown = false;
+		return status;
+	}
+	memcpy(newOutput, &output.buffer[outputStart], (output.size - outputStart));
+	
+	free(pEntry->output);
+	pEntry->output = newOutput;
+	pEntry->outputSize = (output.size - outputStart);
+	pEntry->modifiedTime = (int64_t)fileStat.st_mtime;
+	pEntry->fileSize = (int64_t)fileStat.st_size;
+	pEntry->cachedTime = (int64_t)time(NULL);
+	pEntry->hash = hash;
+	pEntry->status = status;
+	
+	return status;
+	
+}
+
+/*////////*/
+
+static void options_parse(options* pOptions, int argCount, char* argList[]) {
+	
+	// Set defaults
+	pOptions->fileName = DEFAULT_FILE_NAME;
+	pOptions->fileCount = 0;
+	pOptions->outputName = NULL;
+	pOptions->outputMode = OPTIONS_OUTPUT_CONSOLE;
+	pOptions->jobs = 1;
+	pOptions->maxErrors = DEFAULT_MAX_ERRORS;
+	pOptions->includeCount = 0;
+	pOptions->headerCache = DEFAULT_HEADER_CACHE;
+	pOptions->server = false;
+	pOptions->serverPath = SERVER_DEFAULT_PATH;
+	pOptions->invalid = false;
+	
+	for (int i = 1; i < argCount; i++) {
+	
+		// Anything that isn't an option is a file to compile
+		if (argList[i][0] != '-') {
+			if (pOptions->fileCount < OPTIONS_MAX_FILES) pOptions->fileNames[(pOptions->fileCount)++] = argList[i];
+			else {
+				print_utf8("error: No more than %d files can be compiled at once\n", OPTIONS_MAX_FILES);
+				pOptions->invalid = true;
+			}
+		}
+	
+		// Where the output of a single file goes
+		else if ((strcmp(argList[i], "-o") == 0) && ((i + 1) < argCount)) {
+			pOptions->outputName = argList[i + 1];
+			i++;
+		} else if ((strncmp(argList[i], "-o", 2) == 0) && (argList[i][2] != '\0')) {
+			pOptions->outputName = &argList[i][2];
+		}
+	
+		// Stop after writing Assembly, or assemble it into an object
+		else if (strcmp(argList[i], "-S") == 0) {
+			pOptions->outputMode = OPTIONS_OUTPUT_ASSEMBLY;
+		} else if (strcmp(argList[i], "-c") == 0) {
+			pOptions->outputMode = OPTIONS_OUTPUT_OBJECT;
+		}
+	
+		// Run the IR instead of generating Assembly from it
+		else if (strcmp(argList[i], "--interpret") == 0) {
+			pOptions->outputMode = OPTIONS_OUTPUT_INTERPRET;
+		}
+	
+		// Run the generated machine code without writing anything out
+		else if (strcmp(argList[i], "--run") == 0) {
+			pOptions->outputMode = OPTIONS_OUTPUT_RUN;
+		}
+	
+		// How many files are compiled at the same time
+		else if ((strcmp(argList[i], "-j") == 0) && ((i + 1) < argCount)) {
+			pOptions->jobs = strtoull(argList[i + 1], NULL, 10);
+			i++;
+		} else if ((strncmp(argList[i], "-j", 2) == 0) && (argList[i][2] != '\0')) {
+			pOptions->jobs = strtoull(&argList[i][2], NULL, 10);
+		}
+	
+		// The number of errors to collect before parsing stops; zero removes the limit
+		else if ((strcmp(argList[i], "--max-errors") == 0) && ((i + 1) < argCount)) {
+			pOptions->maxErrors = strtoull(argList[i + 1], NULL, 10);
+			i++;
+		} else if (strncmp(argList[i], "--max-errors=", 13) == 0) {
+			pOptions->maxErrors = strtoull(&argList[i][13], NULL, 10);
+		}
+	
+		// Where imported headers are looked for, after the directory of the file importing them
+		else if ((strcmp(argList[i], "-I") == 0) && ((i + 1) < argCount)) {
+			if (pOptions->includeCount < OPTIONS_MAX_INCLUDES) pOptions->includePaths[(pOptions->includeCount)++] = argList[i + 1];
+			i++;
+		} else if ((strncmp(argList[i], "-I", 2) == 0) && (argList[i][2] != '\0')) {
+			if (pOptions->includeCount < OPTIONS_MAX_INCLUDES) pOptions->includePaths[(pOptions->includeCount)++] = &argList[i][2];
+		}
+	
+		// Where the module interfaces made from headers are kept; an empty directory turns the cache off
+		else if (strncmp(argList[i], "--header-cache=", 15) == 0) {
+			pOptions->headerCache = &argList[i][15];
+		}
+	
+		// Stay resident and answer compile requests on a local socket
+		else if (strcmp(argList[i], "--server") == 0) {
+			pOptions->server = true;
+		} else if (strncmp(argList[i], "--server=", 9) == 0) {
+			pOptions->server = true;
+			pOptions->serverPath = &argList[i][9];
+		}
+	
+		else {
+			print_utf8("error: Unknown option %s\n", argList[i]);
+			pOptions->invalid = true;
+		}
+	
+	}
+	
+	// Without any files, the default one is compiled
+	if (pOptions->fileCount == 0) pOptions->fileNames[(pOptions->fileCount)++] = DEFAULT_FILE_NAME;
+	pOptions->fileName = pOptions->fileNames[0];
+	
+	if (pOptions->jobs < 1) pOptions->jobs = 1;
+	if (pOptions->jobs > OPTIONS_MAX_JOBS) pOptions->jobs = OPTIONS_MAX_JOBS;
+	
+	// A name for the output only makes sense for one file, and implies it is written out
+	if ((pOptions->outputName) && (pOptions->fileCount > 1)) {
+		print_utf8("error: -o can only be used with a single file\n");
+		pOptions->invalid = true;
+	}
+	
+	if ((pOptions->outputName) && (pOptions->outputMode == OPTIONS_OUTPUT_INTERPRET)) {
+		print_utf8("error: -o can't be used with --interpret\n");
+		pOptions->invalid = true;
+	}
+	
+	if ((pOptions->outputName) && (pOptions->outputMode == OPTIONS_OUTPUT_RUN)) {
+		print_utf8("error: -o can't be used with --run\n");
+		pOptions->invalid = true;
+	}
+	
+	if ((pOptions->outputName) && (pOptions->outputMode == OPTIONS_OUTPUT_CONSOLE)) pOptions->outputMode = OPTIONS_OUTPUT_ASSEMBLY;
+	
+}
+
+static bool job_wait(intptr_t job) {
+	
+	int status = EXIT_FAILURE;
+	if (_cwait(&status, job, 0) == -1) return false;
+	
+	return (status == EXIT_SUCCESS);
+	
+}
+
+static int compile_jobs(options* pOptions) {
+	
+	// Each job is another run of this compiler on a single file
+	char program[OPTIONS_MAX_PATH] = {};
+	if (GetModuleFileNameA(NULL, program, sizeof(program)) == 0) return EXIT_FAILURE;
+	
+	char maxErrors[32] = {};
+	snprintf(maxErrors, sizeof(maxErrors), "--max-errors=%llu", (unsigned long long)pOptions->maxErrors);
+	
+	char* mode = (pOptions->outputMode == OPTIONS_OUTPUT_OBJECT) ? "-c" : "-S";
+	
+	char headerCache[OPTIONS_MAX_PATH + 32] = {};
+	snprintf(headerCache, sizeof(headerCache), (strchr(pOptions->headerCache, ' ')) ? "\"--header-cache=%s\"" : "--header-cache=%s", pOptions->headerCache);
+	
+	// Include paths are passed on the same way, with quotes around any with spaces in them
+	static char includePaths[OPTIONS_MAX_INCLUDES][OPTIONS_MAX_PATH + 8];
+	for (size_t i = 0; i < pOptions->includeCount; i++) {
+		snprintf(includePaths[i], sizeof(includePaths[i]), (strchr(pOptions->includePaths[i], ' ')) ? "\"-I%s\"" : "-I%s", pOptions->includePaths[i]);
+	}
+	
+	// Jobs are started in order, waiting on the oldest whenever all of them are running
+	intptr_t running[OPTIONS_MAX_JOBS] = {};
+	size_t first = 0;
+	size_t count = 0;
+	int status = EXIT_SUCCESS;
+	
+	for (size_t i = 0; i < pOptions->fileCount; i++) {
+		
+		if (count == pOptions->jobs) {
+			if (!job_wait(running[first])) status = EXIT_FAILURE;
+			first = (first + 1) % OPTIONS_MAX_JOBS;
+			count--;
+		}
+		
+		// The command line is joined back up with spaces on Windows, so a path with spaces in it needs quotes
+		char fileName[OPTIONS_MAX_PATH + 2] = {};
+		snprintf(fileName, sizeof(fileName), (strchr(pOptions->fileNames[i], ' ')) ? "\"%s\"" : "%s", pOptions->fileNames[i]);
+		
+		char* argList[OPTIONS_MAX_INCLUDES + 6] = { program, maxErrors, mode, headerCache };
+		size_t argIndex = 4;
+		for (size_t j = 0; j < pOptions->includeCount; j++) argList[argIndex++] = includePaths[j];
+		argList[argIndex++] = fileName;
+		argList[argIndex] = NULL;
+		
+		intptr_t job = _spawnv(_P_NOWAIT, program, (const char* const*)argList);
+		
+		if (job == -1) {
+			print_utf8("%s: error: Could not start a job\n", pOptions->fileNames[i]);
+			status = EXIT_FAILURE;
+			continue;
+		}
+		
+		running[(first + count) % OPTIONS_MAX_JOBS] = job;
+		count++;
+		
+	}
+	
+	// Wait for the rest
+	while (count > 0) {
+		if (!job_wait(running[first])) status = EXIT_FAILURE;
+		first = (first + 1) % OPTIONS_MAX_JOBS;
+		count--;
+	}
+	
+	return status;
+	
+}
+
+static int compile_all(options* pOptions, bool cached) {
+	
+	if (pOptions->invalid) return EXIT_FAILURE;
+	
+	// Files are only handed out to jobs when each of them goes to its own output file
+	bool writes = (pOptions->outputMode == OPTIONS_OUTPUT_ASSEMBLY) || (pOptions->outputMode == OPTIONS_OUTPUT_OBJECT);
+	if ((pOptions->jobs > 1) && (pOptions->fileCount > 1) && (writes) && (!output.capture)) return compile_jobs(pOptions);
+	
+	// Otherwise they are compiled one after the other, and all of them are compiled even if one fails
+	int status = EXIT_SUCCESS;
+	for (size_t i = 0; i < pOptions->fileCount; i++) {
+		pOptions->fileName = pOptions->fileNames[i];
+		int fileStatus = (cached) ? compile_cached(pOptions) : compile(pOptions, NULL);
+		if (fileStatus != EXIT_SUCCESS) status = fileStatus;
+	}
+	
+	return status;
+	
+}
+
+static bool server_receive(SOCKET client, char* buffer, size_t size) {
+	
+	// Keep reading until everything has arrived
+	size_t received = 0;
+	while (received < size) {
+		int count = recv(client, &buffer[received], (int)(size - received), 0);
+		if (count <= 0) return false;
+		received += count;
+	}
+	
+	return true;
+	
+}
+
+static bool server_send(SOCKET client, char* buffer, size_t size) {
+	
+	// Keep writing until everything has gone out
+	size_t sent = 0;
+	while (sent < size) {
+		int count = send(client, &buffer[sent], (int)(size - sent), 0);
+		if (count <= 0) return false;
+		sent += count;
+	}
+	
+	return true;
+	
+}
+
+static void server_answer(SOCKET client) {
+	
+	// Read the request
+	server_request request = {};
+	if (!server_receive(client, (char*)&request, sizeof(request))) return;
+	if ((request.size == 0) || (request.size > SERVER_MAX_REQUEST)) return;
+	
+	char* payload = calloc(request.size + 1, sizeof(char));
+	if (!payload) return;
+	if (!server_receive(client, payload, request.size)) {
+		free(payload);
+		return;
+	}
+	
+	// Split the payload into the working directory and the command line
+	char* argList[256] = {};
+	int argCount = 0;
+	for (size_t i = 0; (i < request.size) && (argCount < 256); i += strlen(&payload[i]) + 1) {
+		argList[argCount] = &payload[i];
+		argCount++;
+	}
+	
+	// Paths are relative to wherever the client was run from
+	int32_t status = EXIT_FAILURE;
+	if (chdir(argList[0]) == 0) {
+	
+		output.capture = true;
+		output.size = 0;
+	
+		// The client's command line starts after the working directory
+		options requestOptions = {};
+		options_parse(&requestOptions, argCount - 1, &argList[1]);
+		status = compile_all(&requestOptions, true);
+		output.capture = false;
+	
+	}
+	
+	// Send the reply
+	server_response response = {};
+	response.status = status;
+	response.size = (uint32_t)output.size;
+	if (server_send(client, (char*)&response, sizeof(response))) {
+		server_send(client, output.buffer, output.size);
+	}
+	
+	free(payload);
+	
+}
+
+static int server_run(options* pOptions) {
+	
+	// Start up sockets
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return EXIT_FAILURE;
+	
+	SOCKET listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener == INVALID_SOCKET) {
+		WSACleanup();
+		return EXIT_FAILURE;
+	}
+	
+	// Bind to the socket path, replacing one left behind by an earlier server
+	struct sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, pOptions->serverPath, sizeof(address.sun_path) - 1);
+	unlink(pOptions->serverPath);
+	
+	if ((bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) || (listen(listener, SOMAXCONN) != 0)) {
+		closesocket(listener);
+		WSACleanup();
+		return EXIT_FAILURE;
+	}
+	
+	print_utf8("Listening for compile requests on %s\n", pOptions->serverPath);
+	
+	// Answer requests one at a time, forever
+	while (1) {
+		SOCKET client = accept(listener, NULL, NULL);
+		if (client == INVALID_SOCKET) continue;
+		server_answer(client);
+		closesocket(client);
+	}
+	
 	return EXIT_SUCCESS;
 	
 }
+
+// [ MAIN ] //
+
+int main(int argCount, char* argList[]) {
+	
+	// Parse the command line
+	options currentOptions = {};
+	options_parse(&currentOptions, argCount, argList);
+	
+	// Build the builtin identifiers once; every compile starts from a copy of them
+	if (!builtins_create(&warm.builtinTable)) {
+	
+		// Return error
+		return EXIT_FAILURE;
+	
+	}
+	
+	// Serve requests, or compile once and exit
+	if (currentOptions.server) return server_run(&currentOptions);
+	
+	return compile_all(&currentOptions, false);
+	
+}
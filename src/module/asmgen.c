@@ -19,52 +19,344 @@
 #define upeek(x) (pIR->buffer[pIR->index + (x)])
 #define ppeek(x) ((pIR->index + (x) >= pIR->size) ? (unit[]){(unit){UNIT_TYPE_KW_END, ""}} : &(pIR->buffer[pIR->index + (x)]))
 
+#define SELECT_MAX_NODES 64
+#define SELECT_MAX_ADDRESSES 8
+#define SELECT_REGISTERS 2
+
+#define LOOP_MAX_HOIST 16
+
+#define ASM_NAME(x) { x, sizeof(x) - 1 }
+
+#define SWITCH_MAX_LINEAR 4 // Cases that are simply compared one after the other
+#define SWITCH_MIN_DENSITY 40 // Percentage of a jump table that has to go to a case
+#define SWITCH_MAX_TABLE 1024
+
 // [ DEFINING ] //
 
+typedef enum {
+	ASM_REGISTER_RAX,
+	ASM_REGISTER_RCX,
+	ASM_REGISTER_RDX,
+	ASM_REGISTER_R8,
+	ASM_REGISTER_R9,
+	ASM_REGISTER_R10,
+	ASM_REGISTER_R11,
+	ASM_REGISTER_RBP,
+	ASM_REGISTER_RSP,
+} asm_register;
+
+// Every register the generator names, with the register it is part of and that register's 32-bit name
+static struct {
+	char* name;
+	asm_register family;
+	char* name32;
+} registerTable[] = {
+	{ "rax", ASM_REGISTER_RAX, "eax" },  { "eax", ASM_REGISTER_RAX, "eax" },  { "al", ASM_REGISTER_RAX, "eax" },
+	{ "rcx", ASM_REGISTER_RCX, "ecx" },  { "ecx", ASM_REGISTER_RCX, "ecx" },
+	{ "rdx", ASM_REGISTER_RDX, "edx" },  { "edx", ASM_REGISTER_RDX, "edx" },
+	{ "r8", ASM_REGISTER_R8, "r8d" },    { "r8d", ASM_REGISTER_R8, "r8d" },
+	{ "r9", ASM_REGISTER_R9, "r9d" },    { "r9d", ASM_REGISTER_R9, "r9d" },
+	{ "r10", ASM_REGISTER_R10, "r10d" }, { "r10d", ASM_REGISTER_R10, "r10d" },
+	{ "r11", ASM_REGISTER_R11, "r11d" }, { "r11d", ASM_REGISTER_R11, "r11d" },
+	{ "rbp", ASM_REGISTER_RBP, "ebp" },
+	{ "rsp", ASM_REGISTER_RSP, "esp" },
+};
+
+// The registers the first four arguments are passed in
+static struct {
+	char* name32;
+	char* name64;
+} argRegisters[] = {
+	{ "ecx", "rcx" },
+	{ "edx", "rdx" },
+	{ "r8d", "r8" },
+	{ "r9d", "r9" },
+};
+
+// Mnemonics are kept with their lengths so rendering never has to measure them
+static struct {
+	char* name;
+	size_t length;
+} opTable[] = {
+	[ASM_OP_MOV] = ASM_NAME("mov"),
+	[ASM_OP_MOVSXD] = ASM_NAME("movsxd"),
+	[ASM_OP_LEA] = ASM_NAME("lea"),
+	[ASM_OP_PUSH] = ASM_NAME("push"),
+	[ASM_OP_POP] = ASM_NAME("pop"),
+	[ASM_OP_XOR] = ASM_NAME("xor"),
+	[ASM_OP_AND] = ASM_NAME("and"),
+	[ASM_OP_ADD] = ASM_NAME("add"),
+	[ASM_OP_SUB] = ASM_NAME("sub"),
+	[ASM_OP_SBB] = ASM_NAME("sbb"),
+	[ASM_OP_NEG] = ASM_NAME("neg"),
+	[ASM_OP_SHR] = ASM_NAME("shr"),
+	[ASM_OP_SAR] = ASM_NAME("sar"),
+	[ASM_OP_INC] = ASM_NAME("inc"),
+	[ASM_OP_DEC] = ASM_NAME("dec"),
+	[ASM_OP_MUL] = ASM_NAME("mul"),
+	[ASM_OP_IMUL] = ASM_NAME("imul"),
+	[ASM_OP_DIV] = ASM_NAME("div"),
+	[ASM_OP_IDIV] = ASM_NAME("idiv"),
+	[ASM_OP_CDQ] = ASM_NAME("cdq"),
+	[ASM_OP_TEST] = ASM_NAME("test"),
+	[ASM_OP_CMP] = ASM_NAME("cmp"),
+	[ASM_OP_SETZ] = ASM_NAME("setz"),
+	[ASM_OP_SETNZ] = ASM_NAME("setnz"),
+	[ASM_OP_SETL] = ASM_NAME("setl"),
+	[ASM_OP_SETLE] = ASM_NAME("setle"),
+	[ASM_OP_SETG] = ASM_NAME("setg"),
+	[ASM_OP_SETGE] = ASM_NAME("setge"),
+	[ASM_OP_CMOVZ] = ASM_NAME("cmovz"),
+	[ASM_OP_CMOVNZ] = ASM_NAME("cmovnz"),
+	[ASM_OP_CMOVL] = ASM_NAME("cmovl"),
+	[ASM_OP_CMOVLE] = ASM_NAME("cmovle"),
+	[ASM_OP_CMOVG] = ASM_NAME("cmovg"),
+	[ASM_OP_CMOVGE] = ASM_NAME("cmovge"),
+	[ASM_OP_JMP] = ASM_NAME("jmp"),
+	[ASM_OP_JZ] = ASM_NAME("jz"),
+	[ASM_OP_JNZ] = ASM_NAME("jnz"),
+	[ASM_OP_JA] = ASM_NAME("ja"),
+	[ASM_OP_JL] = ASM_NAME("jl"),
+	[ASM_OP_JLE] = ASM_NAME("jle"),
+	[ASM_OP_JG] = ASM_NAME("jg"),
+	[ASM_OP_JGE] = ASM_NAME("jge"),
+	[ASM_OP_CALL] = ASM_NAME("call"),
+	[ASM_OP_RET] = ASM_NAME("ret"),
+};
+
+// How each comparison is branched on, set from and selected with, and what it becomes with its sides swapped
+static struct {
+	unit_type compare;
+	unit_type swapped;
+	asm_op jump;
+	asm_op set;
+	asm_op move;
+} compareTable[] = {
+	{ UNIT_TYPE_KW_CMP_Z, UNIT_TYPE_KW_CMP_Z, ASM_OP_JZ, ASM_OP_SETZ, ASM_OP_CMOVZ },
+	{ UNIT_TYPE_KW_CMP_NZ, UNIT_TYPE_KW_CMP_NZ, ASM_OP_JNZ, ASM_OP_SETNZ, ASM_OP_CMOVNZ },
+	{ UNIT_TYPE_KW_CMP_E, UNIT_TYPE_KW_CMP_E, ASM_OP_JZ, ASM_OP_SETZ, ASM_OP_CMOVZ },
+	{ UNIT_TYPE_KW_CMP_NE, UNIT_TYPE_KW_CMP_NE, ASM_OP_JNZ, ASM_OP_SETNZ, ASM_OP_CMOVNZ },
+	{ UNIT_TYPE_KW_CMP_L, UNIT_TYPE_KW_CMP_G, ASM_OP_JL, ASM_OP_SETL, ASM_OP_CMOVL },
+	{ UNIT_TYPE_KW_CMP_LE, UNIT_TYPE_KW_CMP_GE, ASM_OP_JLE, ASM_OP_SETLE, ASM_OP_CMOVLE },
+	{ UNIT_TYPE_KW_CMP_G, UNIT_TYPE_KW_CMP_L, ASM_OP_JG, ASM_OP_SETG, ASM_OP_CMOVG },
+	{ UNIT_TYPE_KW_CMP_GE, UNIT_TYPE_KW_CMP_LE, ASM_OP_JGE, ASM_OP_SETGE, ASM_OP_CMOVGE },
+};
+
+/*////////*/
+
+typedef enum {
+	SELECT_TILE_NONE,
+	SELECT_TILE_LOAD,      // mov r, m/imm
+	SELECT_TILE_OPERAND,   // op r, m/imm with the left side in r
+	SELECT_TILE_SWAPPED,   // op r, m with the right side in r, for commutative operations
+	SELECT_TILE_REGISTERS, // op r, r2
+	SELECT_TILE_IMMEDIATE, // imul r, r/m, imm
+	SELECT_TILE_ADDRESS,   // lea r, [base + index*scale + disp]
+} select_tile;
+
+typedef struct {
+	char left[MAX_VALUE_LEN];
+	char right[MAX_VALUE_LEN];
+	unit_type compare;
+	int constant; // Whether it always holds, or -1 if that is only known at run time
+} asm_compare;
+
+typedef struct {
+	int64_t base;
+	int64_t index;
+	int64_t scale;
+	int64_t disp;
+} select_address;
+
+typedef struct {
+	size_t cost;
+	size_t need;
+	select_tile tile;
+	size_t address;
+	bool rightFirst;
+} select_plan;
+
+typedef struct {
+	
+	// Leaves have no operation and carry their operand instead
+	asm_op op;
+	int64_t left;
+	int64_t right;
+	asm_operand operand;
+	int64_t value;
+	
+	// Every way this value can be written as an address
+	size_t addressCount;
+	select_address addresses[SELECT_MAX_ADDRESSES];
+	
+	// The cheapest cover of this node using at most 1 or 2 registers
+	select_plan plans[SELECT_REGISTERS + 1];
+	
+} select_node;
+
+typedef struct {
+	size_t size;
+	select_node nodes[SELECT_MAX_NODES];
+} select_tree;
 
+typedef struct {
+	int64_t value;
+	char* label;
+	size_t order;
+} switch_case;
+
+// The scratch registers expressions are evaluated in
+static struct {
+	char* name32;
+	char* name64;
+} selectRegisters[SELECT_REGISTERS] = {
+	{ "r10d", "r10" },
+	{ "r11d", "r11" },
+};
+
+// What each instruction costs, roughly in cycles; the selector covers a tree with the cheapest tiles
+static size_t opCost[] = {
+	[ASM_OP_MOV] = 1,
+	[ASM_OP_LEA] = 1,
+	[ASM_OP_ADD] = 1,
+	[ASM_OP_SUB] = 1,
+	[ASM_OP_IMUL] = 3,
+};
 
 // [ FUNCTIONS ] //
 
-static bool assm_resize(assm* pAssm, size_t needed) { 
+static bool writer_grow(asm_writer* pWriter) {
 	
-	// If the buffer can hold more elements, just return
-	if ((pAssm->size + needed) < pAssm->memSize) return true;
+	// If the last chunk has room left, just return
+	if ((pWriter->pLast) && (pWriter->pLast->size < ASM_CHUNK_SIZE)) return true;
 	
-	// If there is no buffer, allocate a new buffer
-	if (pAssm->memSize == 0) {
-		
-		// Set default buffer size
-		pAssm->memSize = 8;
-		pAssm->size = 0;
+	// Allocate a new chunk; nothing written so far is moved
+	asm_chunk* pChunk = malloc(sizeof(asm_chunk));
+	if (!pChunk) return false;
+	
+	pChunk->pNext = NULL;
+	pChunk->size = 0;
+	
+	// Link it onto the end
+	if (pWriter->pLast) pWriter->pLast->pNext = pChunk;
+	else pWriter->pFirst = pChunk;
+	pWriter->pLast = pChunk;
+	
+	// Return success
+	return true;
+	
+}
+
+static bool writer_append(asm_writer* pWriter, const char* text, size_t length) {
+	
+	// Most text fits in what is left of the last chunk
+	if ((pWriter->pLast) && ((ASM_CHUNK_SIZE - pWriter->pLast->size) >= length)) {
+		memcpy(&pWriter->pLast->buffer[pWriter->pLast->size], text, length);
+		pWriter->pLast->size += length;
+		return true;
+	}
+	
+	// Otherwise fill up chunks until it is all in
+	while (length > 0) {
 		
-		// Allocate a new buffer
-		char* newBuffer = calloc(pAssm->memSize, 1);
-		if (!newBuffer) return false;
+		if (!writer_grow(pWriter)) {
+			pWriter->failed = true;
+			return false;
+		}
 		
-		// Assign the new buffer to the old one
-		pAssm->buffer = newBuffer;
+		asm_chunk* pChunk = pWriter->pLast;
+		size_t count = ASM_CHUNK_SIZE - pChunk->size;
+		if (count > length) count = length;
 		
-		// Return success
-		return true;
+		memcpy(&pChunk->buffer[pChunk->size], text, count);
+		pChunk->size += count;
+		text += count;
+		length -= count;
 		
 	}
 	
-	// Allocate a new buffer
-	char* newBuffer = calloc(((pAssm->memSize * 2) + needed), 1);
-	if (!newBuffer) return false;
+	// Return success
+	return true;
 	
-	// Copy the new memory in and free the old buffer
-	memcpy(newBuffer, pAssm->buffer, pAssm->memSize);
-	newBuffer[pAssm->memSize - 1] = '\0';
-	free(pAssm->buffer);
+}
+
+static bool writer_string(asm_writer* pWriter, const char* text) {
+	return writer_append(pWriter, text, strlen(text));
+}
+
+static bool writer_line(asm_writer* pWriter, const char* text) {
+	return (writer_string(pWriter, text)) && (writer_append(pWriter, "\n", 1));
+}
+
+static void writer_join(asm_writer* pWriter, asm_writer* pOther) {
 	
-	// Assign the new buffer to the old one
-	pAssm->memSize *= 2;
-	pAssm->memSize += needed;
-	pAssm->buffer = newBuffer;
+	// The other writer's chunks are linked on as they are and it is left empty
+	pWriter->failed |= pOther->failed;
+	if (!pOther->pFirst) return;
 	
-	// Return success
-	return true;
+	if (pWriter->pLast) pWriter->pLast->pNext = pOther->pFirst;
+	else pWriter->pFirst = pOther->pFirst;
+	pWriter->pLast = pOther->pLast;
+	
+	pOther->pFirst = NULL;
+	pOther->pLast = NULL;
+	
+}
+
+static void writer_destroy(asm_writer* pWriter) {
+	
+	// Free every chunk
+	asm_chunk* pChunk = pWriter->pFirst;
+	while (pChunk) {
+		asm_chunk* pNext = pChunk->pNext;
+		free(pChunk);
+		pChunk = pNext;
+	}
+	
+	pWriter->pFirst = NULL;
+	pWriter->pLast = NULL;
+	pWriter->failed = false;
+	
+}
+
+static size_t text_decimal(char* buffer, uint64_t value) {
+	
+	// Digits come out backwards, so they are collected first and then copied over in order
+	char digits[20];
+	size_t count = 0;
+	
+	do {
+		digits[count++] = (char)('0' + (value % 10));
+		value /= 10;
+	} while (value > 0);
+	
+	for (size_t i = 0; i < count; i++) buffer[i] = digits[count - 1 - i];
+	buffer[count] = '\0';
+	
+	return count;
+	
+}
+
+static size_t text_signed(char* buffer, int64_t value) {
+	
+	// Negating in unsigned arithmetic keeps the most negative value in range
+	if (value >= 0) return text_decimal(buffer, (uint64_t)value);
+	buffer[0] = '-';
+	return 1 + text_decimal(&buffer[1], 0 - (uint64_t)value);
+	
+}
+
+static size_t text_append(char* buffer, size_t size, size_t length, const char* text) {
+	
+	// Like snprintf, whatever does not fit is cut off, but the full length is returned so it can be checked against the size
+	size_t count = strlen(text);
+	if (length >= size) return length + count;
+	
+	size_t room = size - length - 1;
+	memcpy(&buffer[length], text, (count < room) ? count : room);
+	buffer[length + ((count < room) ? count : room)] = '\0';
+	
+	return length + count;
 	
 }
 
@@ -110,6 +402,39 @@ static size_t to_size(unit* pUnit) {
 	
 }
 
+static char* to_slot(size_t size, char sign, uint64_t offset) {
+	
+	static char buf[MAX_VALUE_LEN] = {};
+	
+	// Put together "<word> [rbp - <offset>]" piece by piece
+	char* word = to_word(size);
+	size_t length = strlen(word);
+	memcpy(buf, word, length);
+	memcpy(&buf[length], " [rbp   ", 8);
+	buf[length + 6] = sign;
+	length += 8;
+	length += text_decimal(&buf[length], offset);
+	buf[length++] = ']';
+	buf[length] = '\0';
+	
+	return buf;
+	
+}
+
+static char* to_static(size_t size, char* name) {
+	
+	static char buf[MAX_VALUE_LEN] = {};
+	
+	// Statics are addressed relative to the instruction as "<word> [rel <name>]"
+	size_t length = text_append(buf, sizeof(buf), 0, to_word(size));
+	length = text_append(buf, sizeof(buf), length, " [rel ");
+	length = text_append(buf, sizeof(buf), length, name);
+	text_append(buf, sizeof(buf), length, "]");
+	
+	return buf;
+	
+}
+
 static char* to_reg(assm* pAssm, unit* pUnit) {
 	
 	switch (pUnit[0].type) {
@@ -193,17 +518,27 @@ static char* to_reg(assm* pAssm, unit* pUnit) {
 			
 			symbol* pSym = symbol_find(&pAssm->offsetTable, pUnit->value, SYMBOL_CLASS_ALL);
 			
-			if (pSym) {
+			// Scope index is reused as a variable offset here
+			if (pSym) return to_slot(pSym->size, '-', pSym->scopeIndex);
+			
+			// Parameters are either still in their register, or in the slot above the return address the caller left for them
+			for (size_t i = 0; (i < pAssm->params.count) && (i < ASM_MAX_PARAMS); i++) {
 				
-				static char buf[256] = {};
+				if (strcmp(pAssm->params.names[i], pUnit->value) != 0) continue;
 				
-				// Scope index is reused as a variable offset here
-				sprintf(buf, "%s [rbp - %u]", to_word(pSym->size), pSym->scopeIndex);
+				unit type = { pAssm->params.types[i] };
+				size_t size = to_size(&type);
 				
-				return buf;
+				if ((pAssm->params.inRegisters) && (i < 4)) return (size == 8) ? argRegisters[i].name64 : argRegisters[i].name32;
+				
+				return to_slot(size, '+', 16 + (i * 8));
 				
 			}
 			
+			// Anything else is a static in the data section
+			pSym = symbol_find(&pAssm->staticTable, pUnit->value, SYMBOL_CLASS_VARIABLE);
+			if (pSym) return to_static(pSym->size, pSym->identifier);
+			
 			return "";
 			
 		}
@@ -213,377 +548,2805 @@ static char* to_reg(assm* pAssm, unit* pUnit) {
 	}
 }
 
-static char* to_arith(unit* pUnit) {
+static asm_op to_arith(unit* pUnit) {
 	switch (pUnit[0].type) {
-		case (UNIT_TYPE_KW_MOVE) return "mov";
-		case (UNIT_TYPE_KW_ADD)  return "add";
-		case (UNIT_TYPE_KW_SUB)  return "sub";
-		case (UNIT_TYPE_KW_MUL)  return "imul";
-		case (UNIT_TYPE_KW_DIV)  return "div";
-		default: return "UNKNOWN";
+		case (UNIT_TYPE_KW_MOVE) return ASM_OP_MOV;
+		case (UNIT_TYPE_KW_ADD)  return ASM_OP_ADD;
+		case (UNIT_TYPE_KW_SUB)  return ASM_OP_SUB;
+		case (UNIT_TYPE_KW_MUL)  return ASM_OP_IMUL;
+		case (UNIT_TYPE_KW_DIV)  return ASM_OP_DIV;
+		default: return ASM_OP_NONE;
 	}
 }
 
-static void instruction_push(assm* pAssm, char* msg, ...) {
+/*////////*/
+
+static bool text_resize(assm* pAssm) {
 	
-	// String to be appended to
-	char str[256];
+	// If the buffer can hold more elements, just return
+	if (pAssm->text.size < pAssm->text.memSize) return true;
+	
+	// If there is no buffer, allocate a new buffer
+	if (pAssm->text.memSize == 0) {
+		
+		// Set default buffer size
+		pAssm->text.memSize = 64;
+		pAssm->text.size = 0;
+		
+		// Allocate a new buffer
+		instruction* newBuffer = calloc(pAssm->text.memSize, sizeof(instruction));
+		if (!newBuffer) return false;
+		
+		// Assign the new buffer to the old one
+		pAssm->text.buffer = newBuffer;
+		
+		// Return success
+		return true;
+		
+	}
 	
-	// Appending additional arguments
-	va_list args;
-	va_start(args, msg);
-	size_t len = vsnprintf(str, sizeof(str), msg, args);
-	va_end(args);
+	// Allocate a new buffer
+	instruction* newBuffer = calloc((pAssm->text.memSize * 2), sizeof(instruction));
+	if (!newBuffer) return false;
 	
-	// Resize if needed
-	assm_resize(pAssm, len + 1);
+	// Copy the new memory in and free the old buffer
+	memcpy(newBuffer, pAssm->text.buffer, (pAssm->text.memSize * sizeof(instruction)));
+	free(pAssm->text.buffer);
 	
-	// Copy the string into the Assembly
-	memcpy(&pAssm->buffer[pAssm->size], str, len);
+	// Assign the new buffer to the old one
+	pAssm->text.memSize *= 2;
+	pAssm->text.buffer = newBuffer;
 	
-	// Add len to the size
-	pAssm->size += len;
+	// Return success
+	return true;
 	
 }
 
-static void instruction_parse(assm* pAssm, ir* pIR) {
+static int64_t register_find(char* name, size_t length) {
 	
-	static struct {
-		
-		bool funcVisible;
-		bool inFunc;
-		
-	} percall;
+	for (size_t i = 0; i < (sizeof(registerTable) / sizeof(registerTable[0])); i++) {
+		if ((strlen(registerTable[i].name) == length) && (strncmp(registerTable[i].name, name, length) == 0)) return i;
+	}
 	
-	// Get the current unit
-	unit* currentUnit = &pIR->buffer[pIR->index];
+	return -1;
 	
-	if (pAssm->mode == ASM_MODE_VISIBILITY) {
+}
+
+static asm_operand_type operand_classify(char* value) {
+	
+	if ((value == NULL) || (value[0] == '\0')) return ASM_OPERAND_NONE;
+	if (strchr(value, '[')) return ASM_OPERAND_MEMORY;
+	if (isdigit(value[0]) || ((value[0] == '-') && isdigit(value[1]))) return ASM_OPERAND_IMMEDIATE;
+	if (register_find(value, strlen(value)) >= 0) return ASM_OPERAND_REGISTER;
+	
+	return ASM_OPERAND_LABEL;
+	
+}
+
+static bool operand_isValue(asm_operand* pOperand, int64_t value) {
+	
+	if (pOperand->type != ASM_OPERAND_IMMEDIATE) return false;
+	
+	char* end = NULL;
+	int64_t parsed = strtoll(pOperand->value, &end, 0);
+	
+	return (*end == '\0') && (parsed == value);
+	
+}
+
+static bool operand_uses(asm_operand* pOperand, asm_register family) {
+	
+	if ((pOperand->type != ASM_OPERAND_REGISTER) && (pOperand->type != ASM_OPERAND_MEMORY)) return false;
+	
+	// Look at every word in the operand, which covers registers used in addressing too
+	char* value = pOperand->value;
+	for (size_t i = 0; value[i] != '\0'; ) {
 		
-		// For all functions and variables, move them into the appropriate code sections
-		switch (currentUnit->type) {
-			
-			case (UNIT_TYPE_KW_FUNC) {
-				
-				// Check if this is being imported or exported
-				if ((pIR->index) > 0) {
-					
-					unit_type linkage = peek(-1).type;
-					
-					// Advance past the type and onto the name
-					while (peek(0).type != UNIT_TYPE_IDENTIFIER) advance(1);
-					
-					if (strcmp(peek(0).value, "main") == 0) {
-						
-						pAssm->foundMain = true;
-						
-					} else {
-						
-						if (linkage == UNIT_TYPE_KW_EXPORT) {
-							instruction_push(pAssm, "global ");
-							percall.funcVisible = true;
-						} else if (linkage == UNIT_TYPE_KW_IMPORT) {
-							instruction_push(pAssm, "extern ");
-							percall.funcVisible = true;
-						}
-						
-						// Emit the identifier
-						instruction_push(pAssm, "%s\n", peek(0).value);
-						
-					}
-					
-				} else {
-					
-					// Advance regardless to not hang the compiler
-					advance(1);
-					
-				}
-				
-			} break;
-			
-			case (UNIT_TYPE_KW_RETURN) {
-				
-				percall.inFunc = false;
-				
-				advance(1);
-				
-			} break;
-			
-			default: {
-				
-				advance(1);
-				
-			} break;
-			
+		if (!isalnum(value[i])) {
+			i++;
+			continue;
 		}
 		
+		size_t length = 0;
+		while (isalnum(value[i + length])) length++;
+		
+		int64_t index = register_find(&value[i], length);
+		if ((index >= 0) && (registerTable[index].family == family)) return true;
+		
+		i += length;
+		
+	}
+	
+	return false;
+	
+}
+
+static asm_register operand_family(asm_operand* pOperand) {
+	
+	return registerTable[register_find(pOperand->value, strlen(pOperand->value))].family;
+	
+}
+
+static bool operand_is32(asm_operand* pOperand) {
+	
+	// Registers by their name, memory by its size prefix
+	if (pOperand->type == ASM_OPERAND_REGISTER) return strcmp(registerTable[register_find(pOperand->value, strlen(pOperand->value))].name32, pOperand->value) == 0;
+	if (pOperand->type == ASM_OPERAND_MEMORY) return strncmp(pOperand->value, "dword ", 6) == 0;
+	
+	return false;
+	
+}
+
+static char* register_name32(asm_register family) {
+	
+	for (size_t i = 0; i < (sizeof(registerTable) / sizeof(registerTable[0])); i++) {
+		if (registerTable[i].family == family) return registerTable[i].name32;
+	}
+	
+	return "";
+	
+}
+
+static char* register_name64(asm_register family) {
+	
+	// Every register is listed by its full name first
+	for (size_t i = 0; i < (sizeof(registerTable) / sizeof(registerTable[0])); i++) {
+		if (registerTable[i].family == family) return registerTable[i].name;
 	}
 	
-	if (pAssm->mode == ASM_MODE_LITERALS) {
+	return "";
+	
+}
+
+static bool operand_equals(asm_operand* pFirst, asm_operand* pSecond) {
+	
+	return (pFirst->type == pSecond->type) && (strcmp(pFirst->value, pSecond->value) == 0);
+	
+}
+
+static void instruction_add3(assm* pAssm, asm_op op, char* first, char* second, char* third) {
+	
+	// The address of data can't be an immediate in 64-bit code, so it is loaded relative to the instruction first
+	if ((first) && (second) && (op != ASM_OP_LEA) && (operand_classify(second) == ASM_OPERAND_LABEL)) {
 		
-		// For all literals in the program, assign them to the data section
-		switch (currentUnit->type) {
-			
-			case (UNIT_TYPE_KW_STATIC) {
-				
-				// Advance to the identifier
-				while (peek(0).type != UNIT_TYPE_IDENTIFIER) advance(1);
-				
-				// Emit the variable name
-				instruction_push(pAssm, "%s ", peek(0).value);
-				
-				// Advance to the colon
-				advance(1);
-				
-				// Emit the word size
-				instruction_push(pAssm, "db ");
-				
-				// Advance past this keyword
-				advance(1);
-				
-				// Emit the string
-				instruction_push(pAssm, "%s, 0\n", peek(0).value);
-				
-				// Advance past the string
-				advance(1);
-				
-			} break;
-			
-			default: {
-				
-				// Advance past this unit
-				advance(1);
-				
-			}
-			
+		char address[MAX_VALUE_LEN];
+		size_t length = text_append(address, sizeof(address), 0, "[rel ");
+		length = text_append(address, sizeof(address), length, second);
+		text_append(address, sizeof(address), length, "]");
+		
+		asm_operand target = { operand_classify(first) };
+		strncpy(target.value, first, MAX_VALUE_LEN - 1);
+		
+		// A register can take the address directly
+		if ((op == ASM_OP_MOV) && (target.type == ASM_OPERAND_REGISTER)) {
+			instruction_add3(pAssm, ASM_OP_LEA, register_name64(operand_family(&target)), address, NULL);
+			return;
 		}
 		
+		// Anything else goes through a scratch register the target doesn't use
+		asm_register scratch = (operand_uses(&target, ASM_REGISTER_RAX)) ? ASM_REGISTER_RCX : ASM_REGISTER_RAX;
+		instruction_add3(pAssm, ASM_OP_LEA, register_name64(scratch), address, NULL);
+		second = (operand_is32(&target)) ? register_name32(scratch) : register_name64(scratch);
+		
 	}
 	
-	if (pAssm->mode == ASM_MODE_PARSE) {
-		
-		// Check the current unit and emit the appropriate instruction
-		switch (currentUnit->type) {
-			
-			case (UNIT_TYPE_KW_RETURN) {
-				
-				// Destroy the stack frame
-				if (strcmp(pAssm->currentFunc, "main") != 0) {
-					
-					instruction_push(pAssm, "mov rsp, rbp\n");
-					instruction_push(pAssm, "pop rbp\n");
-					
-				}
-				
-				// Advance past the return keyword
-				advance(1);
-				
-				// Search backwards for the index of the retval unit
-				int64_t index = 0;
-				while (peek(index).type != UNIT_TYPE_RG_RETVAL) index--;
-				
-				// Return
-				if (strcmp(pAssm->currentFunc, "main") == 0) {
-					
-					instruction_push(pAssm, "mov ecx, %s\n", to_reg(pAssm, ppeek(index)));
-					instruction_push(pAssm, "call ExitProcess\n");
-					
-				} else {
-					
-					instruction_push(pAssm, "mov ecx, %s\n", to_reg(pAssm, ppeek(index)));
-					instruction_push(pAssm, "ret\n");
-					
-				}
-				
-				// Advance past the semicolon
-				advance(1);
-				
-			} break;
-			
-			case (UNIT_TYPE_KW_ARG_PUSH) {
-				
-				// Save our registers
-				instruction_push(pAssm, "mov [rsp+0], rcx\n");
-				instruction_push(pAssm, "mov [rsp+8], rdx\n");
-				instruction_push(pAssm, "mov [rsp+16], r8\n");
-				instruction_push(pAssm, "mov [rsp+24], r9\n");
-				
-				// Advance
-				advance(1);
-				
-			} break;
-			
-			case (UNIT_TYPE_KW_ARG_POP) {
-				
-				// Return the state of our registers
-				instruction_push(pAssm, "mov rcx, [rsp+0]\n");
-				instruction_push(pAssm, "mov rdx, [rsp+8]\n");
-				instruction_push(pAssm, "mov r8, [rsp+16]\n");
-				instruction_push(pAssm, "mov r9, [rsp+24]\n");
-				
-				// Advance
-				advance(1);
-				
+	// Resize if needed
+	if (!text_resize(pAssm)) return;
+	
+	instruction* pInstruction = &pAssm->text.buffer[pAssm->text.size];
+	*pInstruction = (instruction){};
+	pInstruction->op = op;
+	
+	// Copy the operands in, working out what kind each one is
+	if (first) {
+		strncpy(pInstruction->operands[0].value, first, MAX_VALUE_LEN - 1);
+		pInstruction->operands[0].type = (op == ASM_OP_LABEL) ? ASM_OPERAND_LABEL : operand_classify(first);
+	}
+	if (second) {
+		strncpy(pInstruction->operands[1].value, second, MAX_VALUE_LEN - 1);
+		pInstruction->operands[1].type = operand_classify(second);
+	}
+	if (third) {
+		strncpy(pInstruction->operands[2].value, third, MAX_VALUE_LEN - 1);
+		pInstruction->operands[2].type = operand_classify(third);
+	}
+	
+	(pAssm->text.size)++;
+	
+}
+
+static void instruction_add(assm* pAssm, asm_op op, char* first, char* second) {
+	
+	instruction_add3(pAssm, op, first, second, NULL);
+	
+}
+
+/*////////*/
+
+static int64_t instruction_next(assm* pAssm, int64_t index) {
+	
+	// Find the next instruction that hasn't been removed
+	for (index++; index < (int64_t)pAssm->text.size; index++) {
+		if (pAssm->text.buffer[index].op != ASM_OP_NONE) return index;
+	}
+	
+	return -1;
+	
+}
+
+static bool instruction_isBranch(asm_op op) {
+	
+	switch (op) {
+		case (ASM_OP_JZ)
+		case (ASM_OP_JNZ)
+		case (ASM_OP_JA)
+		case (ASM_OP_JL)
+		case (ASM_OP_JLE)
+		case (ASM_OP_JG)
+		case (ASM_OP_JGE)
+			return true;
+		default: return false;
+	}
+	
+}
+
+static bool instruction_readsFlags(asm_op op) {
+	
+	if (instruction_isBranch(op)) return true;
+	
+	switch (op) {
+		case (ASM_OP_SBB)
+		case (ASM_OP_SETZ)
+		case (ASM_OP_SETNZ)
+		case (ASM_OP_SETL)
+		case (ASM_OP_SETLE)
+		case (ASM_OP_SETG)
+		case (ASM_OP_SETGE)
+		case (ASM_OP_CMOVZ)
+		case (ASM_OP_CMOVNZ)
+		case (ASM_OP_CMOVL)
+		case (ASM_OP_CMOVLE)
+		case (ASM_OP_CMOVG)
+		case (ASM_OP_CMOVGE)
+			return true;
+		default: return false;
+	}
+	
+}
+
+static int64_t instruction_previous(assm* pAssm, int64_t index) {
+	
+	// Find the previous instruction that hasn't been removed
+	for (index--; index >= 0; index--) {
+		if (pAssm->text.buffer[index].op != ASM_OP_NONE) return index;
+	}
+	
+	return -1;
+	
+}
+
+static bool instruction_writesFirst(asm_op op) {
+	
+	switch (op) {
+		case (ASM_OP_MOV)
+		case (ASM_OP_MOVSXD)
+		case (ASM_OP_LEA)
+		case (ASM_OP_POP)
+		case (ASM_OP_XOR)
+		case (ASM_OP_AND)
+		case (ASM_OP_ADD)
+		case (ASM_OP_SUB)
+		case (ASM_OP_SBB)
+		case (ASM_OP_NEG)
+		case (ASM_OP_SHR)
+		case (ASM_OP_SAR)
+		case (ASM_OP_INC)
+		case (ASM_OP_DEC)
+		case (ASM_OP_IMUL)
+		case (ASM_OP_SETZ)
+		case (ASM_OP_SETNZ)
+		case (ASM_OP_SETL)
+		case (ASM_OP_SETLE)
+		case (ASM_OP_SETG)
+		case (ASM_OP_SETGE)
+		case (ASM_OP_CMOVZ)
+		case (ASM_OP_CMOVNZ)
+		case (ASM_OP_CMOVL)
+		case (ASM_OP_CMOVLE)
+		case (ASM_OP_CMOVG)
+		case (ASM_OP_CMOVGE)
+			return true;
+		default: return false;
+	}
+	
+}
+
+static bool instruction_defines(instruction* pInstruction) {
+	
+	// Whether the first operand is written without its old value being read
+	switch (pInstruction->op) {
+		case (ASM_OP_MOV)
+		case (ASM_OP_MOVSXD)
+		case (ASM_OP_LEA)
+		case (ASM_OP_POP)
+			return true;
+		case (ASM_OP_XOR) return operand_equals(&pInstruction->operands[0], &pInstruction->operands[1]);
+		case (ASM_OP_IMUL) return (pInstruction->operands[2].type != ASM_OPERAND_NONE);
+		default: return false;
+	}
+	
+}
+
+static bool instruction_readsMemory(instruction* pInstruction, size_t operand) {
+	
+	if (pInstruction->operands[operand].type != ASM_OPERAND_MEMORY) return false;
+	
+	// The destination is only read if its old value is, and lea only computes its address
+	if (operand == 0) return !instruction_defines(pInstruction);
+	if ((operand == 1) && (pInstruction->op == ASM_OP_LEA)) return false;
+	
+	return true;
+	
+}
+
+static uint32_t instruction_reads(instruction* pInstruction) {
+	
+	uint32_t mask = 0;
+	
+	// xor r, r doesn't depend on r
+	if ((pInstruction->op == ASM_OP_XOR) && (instruction_defines(pInstruction))) return 0;
+	
+	for (asm_register family = ASM_REGISTER_RAX; family <= ASM_REGISTER_RSP; family++) {
+		
+		// Registers used to address memory are always read
+		bool first = (pInstruction->operands[0].type == ASM_OPERAND_MEMORY) || (!instruction_defines(pInstruction));
+		
+		if ((first) && (operand_uses(&pInstruction->operands[0], family))) mask |= (1 << family);
+		if (operand_uses(&pInstruction->operands[1], family)) mask |= (1 << family);
+		if (operand_uses(&pInstruction->operands[2], family)) mask |= (1 << family);
+		
+	}
+	
+	return mask;
+	
+}
+
+static uint32_t instruction_writes(instruction* pInstruction) {
+	
+	if ((!instruction_writesFirst(pInstruction->op)) || (pInstruction->operands[0].type != ASM_OPERAND_REGISTER)) return 0;
+	
+	return (1 << operand_family(&pInstruction->operands[0]));
+	
+}
+
+static bool operand_slot(asm_operand* pOperand, int64_t* pOffset, int64_t* pSize) {
+	
+	if (pOperand->type != ASM_OPERAND_MEMORY) return false;
+	
+	// Locals are always addressed as "<size> [rbp - <offset>]"
+	char word[8] = {};
+	long long offset = 0;
+	int length = 0;
+	
+	if (sscanf(pOperand->value, "%7s [rbp - %lld]%n", word, &offset, &length) != 2) return false;
+	if ((length == 0) || (pOperand->value[length] != '\0')) return false;
+	
+	if (strcmp(word, "byte") == 0) *pSize = 1;
+	else if (strcmp(word, "word") == 0) *pSize = 2;
+	else if (strcmp(word, "dword") == 0) *pSize = 4;
+	else if (strcmp(word, "qword") == 0) *pSize = 8;
+	else return false;
+	
+	*pOffset = offset;
+	
+	return true;
+	
+}
+
+static bool slot_overlaps(asm_operand* pOperand, int64_t offset, int64_t size) {
+	
+	// Anything that isn't a plain local has to be assumed to overlap
+	int64_t otherOffset = 0;
+	int64_t otherSize = 0;
+	if (!operand_slot(pOperand, &otherOffset, &otherSize)) return true;
+	
+	// A slot covers [rbp - offset, rbp - offset + size)
+	return (-offset < (-otherOffset + otherSize)) && (-otherOffset < (-offset + size));
+	
+}
+
+static bool flags_needed(assm* pAssm, int64_t index) {
+	
+	// Flags only matter if the next real instruction reads them
+	for (index = instruction_next(pAssm, index); index >= 0; index = instruction_next(pAssm, index)) {
+		if (pAssm->text.buffer[index].op != ASM_OP_LABEL) return instruction_readsFlags(pAssm->text.buffer[index].op);
+	}
+	
+	return false;
+	
+}
+
+static int64_t label_find(assm* pAssm, char* name) {
+	
+	for (size_t i = 0; i < pAssm->text.size; i++) {
+		if ((pAssm->text.buffer[i].op == ASM_OP_LABEL) && (strcmp(pAssm->text.buffer[i].operands[0].value, name) == 0)) return i;
+	}
+	
+	return -1;
+	
+}
+
+static bool register_isDead(assm* pAssm, int64_t index, asm_register family, size_t jumps) {
+	
+	// Scratch registers are not preserved across calls, and nothing is returned in them
+	bool scratch = (family == ASM_REGISTER_R10) || (family == ASM_REGISTER_R11);
+	
+	for (index = instruction_next(pAssm, index); index >= 0; index = instruction_next(pAssm, index)) {
+		
+		instruction* pInstruction = &pAssm->text.buffer[index];
+		
+		switch (pInstruction->op) {
+			
+			// Falling through a label doesn't change what this path reads
+			case (ASM_OP_LABEL)
+				continue;
+			
+			// Follow a few jumps; a jump that can't be followed has to be assumed to read everything
+			case (ASM_OP_JMP) {
+				int64_t target = label_find(pAssm, pInstruction->operands[0].value);
+				return (jumps > 0) && (target >= 0) && register_isDead(pAssm, target, family, jumps - 1);
+			}
+			
+			// A branch has to be dead both ways
+			case (ASM_OP_JZ)
+			case (ASM_OP_JNZ)
+			case (ASM_OP_JA)
+			case (ASM_OP_JL)
+			case (ASM_OP_JLE)
+			case (ASM_OP_JG)
+			case (ASM_OP_JGE) {
+				int64_t target = label_find(pAssm, pInstruction->operands[0].value);
+				if ((jumps == 0) || (target < 0) || !register_isDead(pAssm, target, family, jumps - 1)) return false;
+				continue;
+			}
+			
+			case (ASM_OP_CALL)
+			case (ASM_OP_RET)
+				return scratch;
+			
+			// These use the accumulator and data registers without naming them
+			case (ASM_OP_MUL)
+			case (ASM_OP_DIV)
+			case (ASM_OP_IDIV)
+			case (ASM_OP_CDQ)
+				if ((family == ASM_REGISTER_RAX) || (family == ASM_REGISTER_RDX)) return false;
+				break;
+			
+			case (ASM_OP_PUSH)
+			case (ASM_OP_POP)
+				if (family == ASM_REGISTER_RSP) return false;
+				break;
+			
+			default: break;
+			
+		}
+		
+		// Writing the whole register without reading it first kills the old value
+		if ((instruction_defines(pInstruction)) && (pInstruction->operands[0].type == ASM_OPERAND_REGISTER) && (operand_family(&pInstruction->operands[0]) == family)) {
+			return !(instruction_reads(pInstruction) & (1 << family));
+		}
+		
+		if (operand_uses(&pInstruction->operands[0], family) || operand_uses(&pInstruction->operands[1], family) || operand_uses(&pInstruction->operands[2], family)) return false;
+		
+	}
+	
+	return false;
+	
+}
+
+static bool text_optimize_window(assm* pAssm, int64_t index) {
+	
+	instruction* a = &pAssm->text.buffer[index];
+	
+	int64_t indexB = instruction_next(pAssm, index);
+	instruction* b = (indexB >= 0) ? &pAssm->text.buffer[indexB] : NULL;
+	
+	// mov x, x
+	if ((a->op == ASM_OP_MOV) && (operand_equals(&a->operands[0], &a->operands[1]))) {
+		a->op = ASM_OP_NONE;
+		return true;
+	}
+	
+	// mov r, y, when nothing reads r afterwards
+	if ((a->op == ASM_OP_MOV) && (a->operands[0].type == ASM_OPERAND_REGISTER) && (register_isDead(pAssm, index, operand_family(&a->operands[0]), 4))) {
+		a->op = ASM_OP_NONE;
+		return true;
+	}
+	
+	// jmp x; x:
+	if ((a->op == ASM_OP_JMP) && (b) && (b->op == ASM_OP_LABEL) && (strcmp(a->operands[0].value, b->operands[0].value) == 0)) {
+		a->op = ASM_OP_NONE;
+		return true;
+	}
+	
+	// sub x, 16; sub x, 32 -> sub x, 48
+	if (((a->op == ASM_OP_ADD) || (a->op == ASM_OP_SUB)) && (b) && (b->op == a->op) && (operand_equals(&a->operands[0], &b->operands[0])) &&
+		(a->operands[1].type == ASM_OPERAND_IMMEDIATE) && (b->operands[1].type == ASM_OPERAND_IMMEDIATE) && (!flags_needed(pAssm, indexB))) {
+		text_signed(a->operands[1].value, strtoll(a->operands[1].value, NULL, 0) + strtoll(b->operands[1].value, NULL, 0));
+		b->op = ASM_OP_NONE;
+		return true;
+	}
+	
+	// mov x, y; mov y, x -> mov x, y
+	if ((a->op == ASM_OP_MOV) && (b) && (b->op == ASM_OP_MOV) && (operand_equals(&a->operands[0], &b->operands[1])) && (operand_equals(&a->operands[1], &b->operands[0]))) {
+		if (!((a->operands[0].type == ASM_OPERAND_REGISTER) && (operand_uses(&a->operands[1], operand_family(&a->operands[0]))))) {
+			b->op = ASM_OP_NONE;
+			return true;
+		}
+	}
+	
+	// mov r, 0; add r, y -> mov r, y
+	if ((a->op == ASM_OP_MOV) && (a->operands[0].type == ASM_OPERAND_REGISTER) && (operand_isValue(&a->operands[1], 0)) &&
+		(b) && (b->op == ASM_OP_ADD) && (operand_equals(&a->operands[0], &b->operands[0])) && (b->operands[1].type != ASM_OPERAND_NONE) &&
+		(!operand_uses(&b->operands[1], operand_family(&a->operands[0]))) && (!flags_needed(pAssm, indexB))) {
+		a->operands[1] = b->operands[1];
+		b->op = ASM_OP_NONE;
+		return true;
+	}
+	
+	// mov r, y; mov z, r -> mov z, y, when nothing reads r afterwards
+	if ((a->op == ASM_OP_MOV) && (a->operands[0].type == ASM_OPERAND_REGISTER) && (b) && (b->op == ASM_OP_MOV) && (operand_equals(&a->operands[0], &b->operands[1])) &&
+		(!operand_uses(&b->operands[0], operand_family(&a->operands[0])))) {
+		
+		asm_operand* y = &a->operands[1];
+		asm_operand* z = &b->operands[0];
+		
+		// Memory can only be stored to from a register or a 32-bit immediate
+		bool encodable = (y->type != ASM_OPERAND_NONE);
+		if (z->type == ASM_OPERAND_MEMORY) {
+			if (y->type == ASM_OPERAND_MEMORY) encodable = false;
+			if (y->type == ASM_OPERAND_LABEL) encodable = false;
+			if ((y->type == ASM_OPERAND_IMMEDIATE) && ((strtoll(y->value, NULL, 0) > INT32_MAX) || (strtoll(y->value, NULL, 0) < INT32_MIN))) encodable = false;
+		}
+		
+		if ((encodable) && (register_isDead(pAssm, indexB, operand_family(&a->operands[0]), 4))) {
+			b->operands[1] = *y;
+			a->op = ASM_OP_NONE;
+			return true;
+		}
+		
+	}
+	
+	// dec x; mov r, x; test r, r; jnz -> dec x; jnz, since the arithmetic already set the zero flag for x
+	if (((a->op == ASM_OP_INC) || (a->op == ASM_OP_DEC) || (a->op == ASM_OP_ADD) || (a->op == ASM_OP_SUB)) && (b) && (b->op == ASM_OP_MOV) &&
+		(b->operands[0].type == ASM_OPERAND_REGISTER) && (operand_equals(&a->operands[0], &b->operands[1])) && (operand_is32(&a->operands[0])) && (operand_is32(&b->operands[0]))) {
+		
+		int64_t indexC = instruction_next(pAssm, indexB);
+		instruction* c = (indexC >= 0) ? &pAssm->text.buffer[indexC] : NULL;
+		
+		if ((c) && (c->op == ASM_OP_TEST) && (operand_equals(&c->operands[0], &b->operands[0])) && (operand_equals(&c->operands[1], &b->operands[0])) &&
+			(register_isDead(pAssm, indexC, operand_family(&b->operands[0]), 4))) {
+			b->op = ASM_OP_NONE;
+			c->op = ASM_OP_NONE;
+			return true;
+		}
+		
+	}
+	
+	// add x, 0
+	if (((a->op == ASM_OP_ADD) || (a->op == ASM_OP_SUB)) && (operand_isValue(&a->operands[1], 0)) && (!flags_needed(pAssm, index))) {
+		a->op = ASM_OP_NONE;
+		return true;
+	}
+	
+	// add x, 1 -> inc x; inc leaves the carry flag alone, so only when nothing reads the flags
+	if (((a->op == ASM_OP_ADD) || (a->op == ASM_OP_SUB)) && (operand_isValue(&a->operands[1], 1)) && (!flags_needed(pAssm, index))) {
+		a->op = (a->op == ASM_OP_ADD) ? ASM_OP_INC : ASM_OP_DEC;
+		a->operands[1] = (asm_operand){};
+		return true;
+	}
+	
+	// mov r, 0 -> xor r, r
+	if ((a->op == ASM_OP_MOV) && (a->operands[0].type == ASM_OPERAND_REGISTER) && (operand_isValue(&a->operands[1], 0)) && (!flags_needed(pAssm, index))) {
+		char* name32 = registerTable[register_find(a->operands[0].value, strlen(a->operands[0].value))].name32;
+		a->op = ASM_OP_XOR;
+		strcpy(a->operands[0].value, name32);
+		a->operands[1] = a->operands[0];
+		return true;
+	}
+	
+	return false;
+	
+}
+
+static void text_optimize(assm* pAssm) {
+	
+	// Slide the window over the text until nothing more changes
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int64_t i = 0; i < (int64_t)pAssm->text.size; i++) {
+			if (pAssm->text.buffer[i].op == ASM_OP_NONE) continue;
+			if (text_optimize_window(pAssm, i)) changed = true;
+		}
+	}
+	
+	// Close up the gaps left by removed instructions
+	size_t size = 0;
+	for (size_t i = 0; i < pAssm->text.size; i++) {
+		if (pAssm->text.buffer[i].op != ASM_OP_NONE) pAssm->text.buffer[size++] = pAssm->text.buffer[i];
+	}
+	pAssm->text.size = size;
+	
+}
+
+/*////////*/
+
+static bool text_insert(assm* pAssm, int64_t index, instruction* pList, size_t count) {
+	
+	for (size_t i = 0; i < count; i++) {
+		
+		// Resize if needed
+		if (!text_resize(pAssm)) return false;
+		
+		// Shift everything after the insertion point along by one
+		instruction* pInstruction = &pAssm->text.buffer[index + i];
+		memmove(&pInstruction[1], pInstruction, ((pAssm->text.size - (index + i)) * sizeof(instruction)));
+		*pInstruction = pList[i];
+		
+		(pAssm->text.size)++;
+		
+	}
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static bool loop_writes(assm* pAssm, int64_t start, int64_t end, int64_t skip, int64_t offset, int64_t size) {
+	
+	for (int64_t i = instruction_next(pAssm, start); (i >= 0) && (i < end); i = instruction_next(pAssm, i)) {
+		
+		instruction* pInstruction = &pAssm->text.buffer[i];
+		
+		if ((i == skip) || (!instruction_writesFirst(pInstruction->op)) || (pInstruction->operands[0].type != ASM_OPERAND_MEMORY)) continue;
+		if (slot_overlaps(&pInstruction->operands[0], offset, size)) return true;
+		
+	}
+	
+	return false;
+	
+}
+
+static bool loop_reads(assm* pAssm, int64_t start, int64_t end, int64_t offset, int64_t size) {
+	
+	for (int64_t i = instruction_next(pAssm, start); (i >= 0) && (i < end); i = instruction_next(pAssm, i)) {
+		for (size_t operand = 0; operand < 3; operand++) {
+			if ((instruction_readsMemory(&pAssm->text.buffer[i], operand)) && (slot_overlaps(&pAssm->text.buffer[i].operands[operand], offset, size))) return true;
+		}
+	}
+	
+	return false;
+	
+}
+
+static bool loop_isSimple(assm* pAssm, int64_t start, int64_t end) {
+	
+	// Only loops whose body runs straight through from the top to the branch back
+	for (int64_t i = instruction_next(pAssm, start); (i >= 0) && (i < end); i = instruction_next(pAssm, i)) {
+		
+		instruction* pInstruction = &pAssm->text.buffer[i];
+		
+		switch (pInstruction->op) {
+			case (ASM_OP_LABEL)
+			case (ASM_OP_ALIGN)
+			case (ASM_OP_JMP)
+			case (ASM_OP_JZ)
+			case (ASM_OP_JNZ)
+			case (ASM_OP_JA)
+			case (ASM_OP_JL)
+			case (ASM_OP_JLE)
+			case (ASM_OP_JG)
+			case (ASM_OP_JGE)
+			case (ASM_OP_CALL)
+			case (ASM_OP_RET)
+			case (ASM_OP_PUSH)
+			case (ASM_OP_POP)
+				return false;
+			default: break;
+		}
+		
+		if (instruction_writes(pInstruction) & ((1 << ASM_REGISTER_RBP) | (1 << ASM_REGISTER_RSP))) return false;
+		
+	}
+	
+	// Nothing else can jump into the top of the loop
+	size_t references = 0;
+	for (size_t i = 0; i < pAssm->text.size; i++) {
+		instruction* pInstruction = &pAssm->text.buffer[i];
+		if ((pInstruction->op != ASM_OP_LABEL) && (pInstruction->operands[0].type == ASM_OPERAND_LABEL) && (strcmp(pInstruction->operands[0].value, pAssm->text.buffer[start].operands[0].value) == 0)) references++;
+	}
+	
+	return (references == 1);
+	
+}
+
+static bool loop_hoist(assm* pAssm, int64_t* pStart, int64_t* pEnd) {
+	
+	int64_t start = *pStart;
+	int64_t end = *pEnd;
+	uint32_t frame = (1 << ASM_REGISTER_RBP) | (1 << ASM_REGISTER_RSP);
+	
+	for (int64_t last = instruction_next(pAssm, start); (last >= 0) && (last < end); last = instruction_next(pAssm, last)) {
+		
+		// Look for a store to a local
+		int64_t offset = 0;
+		int64_t size = 0;
+		if ((pAssm->text.buffer[last].op != ASM_OP_MOV) || (!operand_slot(&pAssm->text.buffer[last].operands[0], &offset, &size))) continue;
+		
+		// Walk back to the instruction that starts computing the stored value
+		uint32_t needed = instruction_reads(&pAssm->text.buffer[last]) & ~frame;
+		uint32_t written = 0;
+		int64_t first = last;
+		size_t length = 1;
+		
+		while (needed) {
+			
+			first = instruction_previous(pAssm, first);
+			if (first <= start) break;
+			
+			instruction* pInstruction = &pAssm->text.buffer[first];
+			uint32_t writes = instruction_writes(pInstruction);
+			
+			// The chain has to be unbroken and only do plain arithmetic
+			switch (pInstruction->op) {
+				case (ASM_OP_MOV)
+				case (ASM_OP_LEA)
+				case (ASM_OP_XOR)
+				case (ASM_OP_ADD)
+				case (ASM_OP_SUB)
+				case (ASM_OP_INC)
+				case (ASM_OP_DEC)
+				case (ASM_OP_IMUL)
+					break;
+				default: writes = 0;
+			}
+			if (!(writes & needed)) break;
+			
+			if (instruction_defines(pInstruction)) needed &= ~writes;
+			needed |= instruction_reads(pInstruction) & ~frame;
+			written |= writes;
+			length++;
+			
+		}
+		
+		if ((needed) || (length > LOOP_MAX_HOIST)) continue;
+		
+		// Everything the chain reads from memory has to stay the same for the whole loop
+		bool invariant = true;
+		for (int64_t i = first; (i >= 0) && (i <= last); i = instruction_next(pAssm, i)) {
+			for (size_t operand = 0; operand < 3; operand++) {
+				
+				if (!instruction_readsMemory(&pAssm->text.buffer[i], operand)) continue;
+				
+				int64_t readOffset = 0;
+				int64_t readSize = 0;
+				if ((!operand_slot(&pAssm->text.buffer[i].operands[operand], &readOffset, &readSize)) || (loop_writes(pAssm, start, end, -1, readOffset, readSize))) invariant = false;
+				
+			}
+		}
+		if (!invariant) continue;
+		
+		// The stored local can only be written here, and nothing earlier in the loop can see its old value
+		if ((loop_writes(pAssm, start, end, last, offset, size)) || (loop_reads(pAssm, start, first, offset, size))) continue;
+		
+		// Nothing after the chain can depend on its flags or registers
+		if (flags_needed(pAssm, last)) continue;
+		
+		bool dead = true;
+		for (asm_register family = ASM_REGISTER_RAX; family <= ASM_REGISTER_RSP; family++) {
+			if ((written & (1 << family)) && (!register_isDead(pAssm, last, family, 4))) dead = false;
+		}
+		if (!dead) continue;
+		
+		// Take the chain out of the loop
+		instruction chain[LOOP_MAX_HOIST];
+		size_t count = 0;
+		for (int64_t i = first; (i >= 0) && (i <= last); i = instruction_next(pAssm, i)) {
+			chain[count++] = pAssm->text.buffer[i];
+			pAssm->text.buffer[i].op = ASM_OP_NONE;
+		}
+		
+		// The loop can't read the registers it sets on the way in either
+		for (asm_register family = ASM_REGISTER_RAX; family <= ASM_REGISTER_RSP; family++) {
+			if ((written & (1 << family)) && (!register_isDead(pAssm, start, family, 4))) dead = false;
+		}
+		if (!dead) {
+			count = 0;
+			for (int64_t i = first; i <= last; i++) {
+				if ((count < length) && (pAssm->text.buffer[i].op == ASM_OP_NONE) && (memcmp(&pAssm->text.buffer[i].operands, &chain[count].operands, sizeof(chain[count].operands)) == 0)) pAssm->text.buffer[i] = chain[count++];
+			}
+			continue;
+		}
+		
+		// And put it in front of the loop, where it runs once
+		if (!text_insert(pAssm, start, chain, count)) return false;
+		*pStart = start + count;
+		*pEnd = end + count;
+		
+		return true;
+		
+	}
+	
+	return false;
+	
+}
+
+static bool loop_reduce(assm* pAssm, int64_t* pStart, int64_t* pEnd) {
+	
+	int64_t start = *pStart;
+	int64_t end = *pEnd;
+	
+	for (int64_t update = instruction_next(pAssm, start); (update >= 0) && (update < end); update = instruction_next(pAssm, update)) {
+		
+		// Find a local that steps by a constant once per iteration
+		instruction* pUpdate = &pAssm->text.buffer[update];
+		int64_t offset = 0;
+		int64_t size = 0;
+		int64_t step = 0;
+		
+		if ((!operand_slot(&pUpdate->operands[0], &offset, &size)) || (size != 4)) continue;
+		
+		switch (pUpdate->op) {
+			case (ASM_OP_INC) step = 1; break;
+			case (ASM_OP_DEC) step = -1; break;
+			case (ASM_OP_ADD)
+			case (ASM_OP_SUB)
+				if (pUpdate->operands[1].type != ASM_OPERAND_IMMEDIATE) continue;
+				step = strtoll(pUpdate->operands[1].value, NULL, 0);
+				if (pUpdate->op == ASM_OP_SUB) step = -step;
+				break;
+			default: continue;
+		}
+		
+		if (loop_writes(pAssm, start, end, update, offset, size)) continue;
+		
+		// Find the multiplications of it by a constant
+		int64_t factor = 0;
+		for (int64_t i = instruction_next(pAssm, start); (i >= 0) && (i < end); i = instruction_next(pAssm, i)) {
+			instruction* pInstruction = &pAssm->text.buffer[i];
+			if ((pInstruction->op == ASM_OP_IMUL) && (pInstruction->operands[2].type == ASM_OPERAND_IMMEDIATE) && (operand_equals(&pInstruction->operands[1], &pUpdate->operands[0])) && (operand_is32(&pInstruction->operands[0]))) {
+				factor = strtoll(pInstruction->operands[2].value, NULL, 0);
+				break;
+			}
+		}
+		
+		if ((factor == 0) || ((step * factor) > INT32_MAX) || ((step * factor) < INT32_MIN)) continue;
+		
+		// Find a register that nothing in or after the loop uses
+		static asm_register candidates[] = { ASM_REGISTER_R9, ASM_REGISTER_R8, ASM_REGISTER_RDX, ASM_REGISTER_RCX, ASM_REGISTER_RAX };
+		int64_t found = -1;
+		
+		for (size_t c = 0; (c < (sizeof(candidates) / sizeof(candidates[0]))) && (found < 0); c++) {
+			
+			bool used = !register_isDead(pAssm, end, candidates[c], 4);
+			for (int64_t i = instruction_next(pAssm, start); (!used) && (i >= 0) && (i < end); i = instruction_next(pAssm, i)) {
+				instruction* pInstruction = &pAssm->text.buffer[i];
+				if (operand_uses(&pInstruction->operands[0], candidates[c]) || operand_uses(&pInstruction->operands[1], candidates[c]) || operand_uses(&pInstruction->operands[2], candidates[c])) used = true;
+				if (((candidates[c] == ASM_REGISTER_RDX) || (candidates[c] == ASM_REGISTER_RAX)) && ((pInstruction->op == ASM_OP_MUL) || (pInstruction->op == ASM_OP_DIV) || (pInstruction->op == ASM_OP_IDIV) || (pInstruction->op == ASM_OP_CDQ))) used = true;
+			}
+			
+			if (!used) found = candidates[c];
+			
+		}
+		
+		if (found < 0) continue;
+		
+		char* reg = register_name32(found);
+		
+		// Every multiplication now just reads the running product
+		for (int64_t i = instruction_next(pAssm, start); (i >= 0) && (i < end); i = instruction_next(pAssm, i)) {
+			instruction* pInstruction = &pAssm->text.buffer[i];
+			if ((pInstruction->op == ASM_OP_IMUL) && (pInstruction->operands[2].type == ASM_OPERAND_IMMEDIATE) && (operand_equals(&pInstruction->operands[1], &pUpdate->operands[0])) && (strtoll(pInstruction->operands[2].value, NULL, 0) == factor)) {
+				pInstruction->op = ASM_OP_MOV;
+				strcpy(pInstruction->operands[1].value, reg);
+				pInstruction->operands[1].type = ASM_OPERAND_REGISTER;
+				pInstruction->operands[2] = (asm_operand){};
+			}
+		}
+		
+		// Which is stepped along with the variable, just before it so the flags of the step itself survive
+		instruction stepped = { ((step * factor) < 0) ? ASM_OP_SUB : ASM_OP_ADD };
+		strcpy(stepped.operands[0].value, reg);
+		stepped.operands[0].type = ASM_OPERAND_REGISTER;
+		text_signed(stepped.operands[1].value, llabs(step * factor));
+		stepped.operands[1].type = ASM_OPERAND_IMMEDIATE;
+		
+		if (!text_insert(pAssm, update, &stepped, 1)) return false;
+		
+		// And is worked out once in front of the loop
+		instruction product = { ASM_OP_IMUL };
+		product.operands[0] = stepped.operands[0];
+		product.operands[1] = pAssm->text.buffer[update + 1].operands[0];
+		text_signed(product.operands[2].value, factor);
+		product.operands[2].type = ASM_OPERAND_IMMEDIATE;
+		
+		if (!text_insert(pAssm, start, &product, 1)) return false;
+		
+		*pStart = start + 1;
+		*pEnd = end + 2;
+		
+		return true;
+		
+	}
+	
+	return false;
+	
+}
+
+static void text_loops(assm* pAssm) {
+	
+	// Every loop is rotated, so it ends in a branch back up to its first instruction
+	for (int64_t end = 0; end < (int64_t)pAssm->text.size; end++) {
+		
+		if (!instruction_isBranch(pAssm->text.buffer[end].op)) continue;
+		
+		int64_t start = label_find(pAssm, pAssm->text.buffer[end].operands[0].value);
+		if ((start < 0) || (start >= end) || (!loop_isSimple(pAssm, start, end))) continue;
+		
+		// Hoist what doesn't change, then reduce what changes steadily
+		while (loop_hoist(pAssm, &start, &end));
+		while (loop_reduce(pAssm, &start, &end));
+		
+	}
+	
+}
+
+static void text_write(asm_writer* pWriter, instruction* pInstruction, size_t count) {
+	
+	// The mnemonic, then the operands separated by commas
+	writer_append(pWriter, opTable[pInstruction->op].name, opTable[pInstruction->op].length);
+	for (size_t i = 0; i < count; i++) {
+		writer_append(pWriter, (i == 0) ? " " : ", ", (i == 0) ? 1 : 2);
+		writer_string(pWriter, pInstruction->operands[i].value);
+	}
+	writer_append(pWriter, "\n", 1);
+	
+}
+
+static void text_render(assm* pAssm) {
+	
+	asm_writer* pWriter = &pAssm->output;
+	
+	for (size_t i = 0; i < pAssm->text.size; i++) {
+		
+		instruction* pInstruction = &pAssm->text.buffer[i];
+		
+		switch (pInstruction->op) {
+			
+			case (ASM_OP_NONE) break;
+			
+			case (ASM_OP_LABEL) {
+				writer_string(pWriter, pInstruction->operands[0].value);
+				writer_append(pWriter, ":\n", 2);
+			} break;
+			
+			case (ASM_OP_ALIGN) {
+				writer_append(pWriter, "align ", 6);
+				writer_line(pWriter, pInstruction->operands[0].value);
+			} break;
+			
+			// These always take two operands, even if one of them came out empty
+			case (ASM_OP_MOV)
+			case (ASM_OP_LEA)
+			case (ASM_OP_XOR)
+			case (ASM_OP_ADD)
+			case (ASM_OP_SUB)
+			case (ASM_OP_IMUL)
+			case (ASM_OP_TEST)
+			case (ASM_OP_CMP) {
+				text_write(pWriter, pInstruction, (pInstruction->operands[2].type != ASM_OPERAND_NONE) ? 3 : 2);
+			} break;
+			
+			default: {
+				if (pInstruction->operands[1].type != ASM_OPERAND_NONE) text_write(pWriter, pInstruction, 2);
+				else if (pInstruction->operands[0].type != ASM_OPERAND_NONE) text_write(pWriter, pInstruction, 1);
+				else text_write(pWriter, pInstruction, 0);
+			} break;
+			
+		}
+		
+	}
+	
+}
+
+/*////////*/
+
+static asm_data* data_add(asm_section* pSection, asm_data_kind kind, size_t size, char* name) {
+	
+	// Double the section whenever it fills up
+	if (pSection->size == pSection->memSize) {
+		
+		size_t newMemSize = (pSection->memSize == 0) ? 16 : (pSection->memSize * 2);
+		asm_data* newBuffer = realloc(pSection->buffer, newMemSize * sizeof(asm_data));
+		if (!newBuffer) return NULL;
+		
+		pSection->buffer = newBuffer;
+		pSection->memSize = newMemSize;
+		
+	}
+	
+	asm_data* pData = &pSection->buffer[(pSection->size)++];
+	*pData = (asm_data){};
+	pData->kind = kind;
+	pData->size = size;
+	if (name) strncpy(pData->name, name, MAX_VALUE_LEN - 1);
+	
+	return pData;
+	
+}
+
+static void data_value(asm_data* pData, char* value) {
+	
+	if ((!pData) || (pData->count == ASM_DATA_MAX_VALUES)) return;
+	
+	// Strings are kept as they were written, quotes and all
+	asm_operand* pValue = &pData->values[(pData->count)++];
+	strncpy(pValue->value, value, MAX_VALUE_LEN - 1);
+	pValue->type = (pData->kind == ASM_DATA_STRING) ? ASM_OPERAND_NONE : operand_classify(value);
+	
+}
+
+static void data_render(asm_writer* pWriter, asm_section* pSection) {
+	
+	static char* directives[] = { "dd", "db", "dw", "dd", "dd", "dd", "dd", "dd", "dq" };
+	
+	for (size_t i = 0; i < pSection->size; i++) {
+		
+		asm_data* pData = &pSection->buffer[i];
+		
+		switch (pData->kind) {
+			
+			case (ASM_DATA_ALIGN) {
+				char number[24];
+				writer_append(pWriter, "align ", 6);
+				writer_append(pWriter, number, text_decimal(number, pData->size));
+				writer_append(pWriter, "\n", 1);
+			} break;
+			
+			case (ASM_DATA_LABEL) {
+				writer_string(pWriter, pData->name);
+				writer_append(pWriter, ":\n", 2);
+			} break;
+			
+			case (ASM_DATA_STRING) {
+				if (pData->name[0]) {
+					writer_string(pWriter, pData->name);
+					writer_append(pWriter, " ", 1);
+				}
+				writer_append(pWriter, "db ", 3);
+				writer_string(pWriter, pData->values[0].value);
+				writer_append(pWriter, ", 0\n", 4);
+			} break;
+			
+			case (ASM_DATA_VALUES) {
+				if (pData->name[0]) {
+					writer_string(pWriter, pData->name);
+					writer_append(pWriter, " ", 1);
+				}
+				writer_string(pWriter, directives[(pData->size <= 8) ? pData->size : 0]);
+				for (size_t j = 0; j < pData->count; j++) {
+					writer_append(pWriter, (j == 0) ? " " : ", ", (j == 0) ? 1 : 2);
+					writer_string(pWriter, pData->values[j].value);
+				}
+				writer_append(pWriter, "\n", 1);
 			} break;
 			
-			case (UNIT_TYPE_KW_CALL) {
+		}
+		
+	}
+	
+}
+
+/*////////*/
+
+static bool select_isImmediate(select_tree* pTree, int64_t index) {
+	
+	return (pTree->nodes[index].op == ASM_OP_NONE) && (pTree->nodes[index].operand.type == ASM_OPERAND_IMMEDIATE);
+	
+}
+
+static bool select_isMemory(select_tree* pTree, int64_t index) {
+	
+	return (pTree->nodes[index].op == ASM_OP_NONE) && (pTree->nodes[index].operand.type == ASM_OPERAND_MEMORY);
+	
+}
+
+static bool select_fits(int64_t value) {
+	
+	return (value >= INT32_MIN) && (value <= INT32_MAX);
+	
+}
+
+static int64_t select_leaf(assm* pAssm, select_tree* pTree, unit* pUnit) {
+	
+	if (pTree->size >= SELECT_MAX_NODES) return -1;
+	
+	select_node* pNode = &pTree->nodes[pTree->size];
+	*pNode = (select_node){};
+	pNode->op = ASM_OP_NONE;
+	pNode->left = -1;
+	pNode->right = -1;
+	
+	strncpy(pNode->operand.value, to_reg(pAssm, pUnit), MAX_VALUE_LEN - 1);
+	pNode->operand.type = operand_classify(pNode->operand.value);
+	
+	// Only variables and 32-bit literals can be leaves
+	if (pNode->operand.type == ASM_OPERAND_IMMEDIATE) {
+		char* end = NULL;
+		pNode->value = strtoll(pNode->operand.value, &end, 0);
+		if ((*end != '\0') || (!select_fits(pNode->value))) return -1;
+	} else if (pNode->operand.type != ASM_OPERAND_MEMORY) {
+		return -1;
+	}
+	
+	return (pTree->size)++;
+	
+}
+
+static int64_t select_operation(select_tree* pTree, asm_op op, int64_t left, int64_t right) {
+	
+	// Keep immediates on the right of commutative operations, which is the only place x86 takes them
+	if ((op != ASM_OP_SUB) && (select_isImmediate(pTree, left)) && (!select_isImmediate(pTree, right))) {
+		int64_t swap = left;
+		left = right;
+		right = swap;
+	}
+	
+	// x + 0, x - 0 and x * 1 don't need an instruction at all
+	if (select_isImmediate(pTree, right)) {
+		if (((op == ASM_OP_ADD) || (op == ASM_OP_SUB)) && (pTree->nodes[right].value == 0)) return left;
+		if ((op == ASM_OP_IMUL) && (pTree->nodes[right].value == 1)) return left;
+	}
+	
+	if (pTree->size >= SELECT_MAX_NODES) return -1;
+	
+	select_node* pNode = &pTree->nodes[pTree->size];
+	*pNode = (select_node){};
+	pNode->op = op;
+	pNode->left = left;
+	pNode->right = right;
+	
+	return (pTree->size)++;
+	
+}
+
+/*////////*/
+
+static void select_address_add(select_node* pNode, select_address address) {
+	
+	if ((pNode->addressCount >= SELECT_MAX_ADDRESSES) || (!select_fits(address.disp))) return;
+	
+	for (size_t i = 0; i < pNode->addressCount; i++) {
+		if (memcmp(&pNode->addresses[i], &address, sizeof(address)) == 0) return;
+	}
+	
+	pNode->addresses[(pNode->addressCount)++] = address;
+	
+}
+
+static bool select_address_merge(select_address* pFirst, select_address* pSecond, select_address* pOut) {
+	
+	// Gather up the registers both sides need, with their scales
+	int64_t nodes[4] = {};
+	int64_t scales[4] = {};
+	size_t count = 0;
+	
+	select_address* sides[2] = { pFirst, pSecond };
+	for (size_t i = 0; i < 2; i++) {
+		if (sides[i]->base >= 0) {
+			nodes[count] = sides[i]->base;
+			scales[count++] = 1;
+		}
+		if (sides[i]->index >= 0) {
+			nodes[count] = sides[i]->index;
+			scales[count++] = sides[i]->scale;
+		}
+	}
+	
+	// An address has room for one base and one scaled index
+	if ((count == 0) || (count > 2)) return false;
+	if ((count == 2) && (scales[0] != 1) && (scales[1] != 1)) return false;
+	
+	*pOut = (select_address){ -1, -1, 1, pFirst->disp + pSecond->disp };
+	
+	if (count == 1) {
+		if (scales[0] == 1) pOut->base = nodes[0];
+		else {
+			pOut->index = nodes[0];
+			pOut->scale = scales[0];
+		}
+	} else {
+		size_t base = (scales[0] == 1) ? 0 : 1;
+		pOut->base = nodes[base];
+		pOut->index = nodes[1 - base];
+		pOut->scale = scales[1 - base];
+	}
+	
+	return true;
+	
+}
+
+static void select_addresses(select_tree* pTree, int64_t index) {
+	
+	select_node* pNode = &pTree->nodes[index];
+	
+	// Any value can be used as a base once it is in a register
+	select_address_add(pNode, (select_address){ index, -1, 1, 0 });
+	
+	if (pNode->op == ASM_OP_NONE) return;
+	
+	select_node* pLeft = &pTree->nodes[pNode->left];
+	select_node* pRight = &pTree->nodes[pNode->right];
+	bool immediate = select_isImmediate(pTree, pNode->right);
+	
+	// x + c and x - c fold the constant into the displacement
+	if (((pNode->op == ASM_OP_ADD) || (pNode->op == ASM_OP_SUB)) && (immediate)) {
+		int64_t disp = (pNode->op == ASM_OP_ADD) ? pRight->value : -(pRight->value);
+		for (size_t i = 0; i < pLeft->addressCount; i++) {
+			select_address address = pLeft->addresses[i];
+			address.disp += disp;
+			select_address_add(pNode, address);
+		}
+	}
+	
+	// x * 2, 4 or 8 is a scaled index, and x * 3, 5 or 9 uses x as both the base and the index
+	if ((pNode->op == ASM_OP_IMUL) && (immediate)) {
+		int64_t scale = pRight->value;
+		for (size_t i = 0; i < pLeft->addressCount; i++) {
+			select_address* pAddress = &pLeft->addresses[i];
+			if ((pAddress->base < 0) || (pAddress->index >= 0)) continue;
+			if ((scale == 2) || (scale == 4) || (scale == 8)) {
+				select_address_add(pNode, (select_address){ -1, pAddress->base, scale, pAddress->disp * scale });
+			}
+			if (((scale == 3) || (scale == 5) || (scale == 9)) && (pAddress->disp == 0)) {
+				select_address_add(pNode, (select_address){ pAddress->base, pAddress->base, scale - 1, 0 });
+			}
+		}
+	}
+	
+	// x + y merges the two sides when they fit in one address together
+	if ((pNode->op == ASM_OP_ADD) && (!immediate)) {
+		for (size_t i = 0; i < pLeft->addressCount; i++) {
+			for (size_t j = 0; j < pRight->addressCount; j++) {
+				select_address address;
+				if (select_address_merge(&pLeft->addresses[i], &pRight->addresses[j], &address)) select_address_add(pNode, address);
+			}
+		}
+	}
+	
+}
+
+/*////////*/
+
+static size_t select_cost(size_t first, size_t second) {
+	
+	// Anything that can't be covered stays that way
+	if ((first == SIZE_MAX) || (second == SIZE_MAX)) return SIZE_MAX;
+	
+	return first + second;
+	
+}
+
+static void select_consider(select_plan* pBest, select_plan plan) {
+	
+	if (plan.cost == SIZE_MAX) return;
+	
+	// Prefer the cheapest tile, then the one that needs fewer registers
+	if ((plan.cost < pBest->cost) || ((plan.cost == pBest->cost) && (plan.need < pBest->need))) *pBest = plan;
+	
+}
+
+static void select_label(select_tree* pTree, int64_t index) {
+	
+	select_node* pNode = &pTree->nodes[index];
+	
+	for (size_t bound = 1; bound <= SELECT_REGISTERS; bound++) {
+		
+		select_plan best = { SIZE_MAX, SIZE_MAX, SELECT_TILE_NONE, 0, false };
+		
+		if (pNode->op == ASM_OP_NONE) {
+			
+			select_consider(&best, (select_plan){ opCost[ASM_OP_MOV], 1, SELECT_TILE_LOAD });
+			
+		} else {
+			
+			select_node* pLeft = &pTree->nodes[pNode->left];
+			select_node* pRight = &pTree->nodes[pNode->right];
+			size_t cost = opCost[pNode->op];
+			
+			if ((pNode->op == ASM_OP_IMUL) && (select_isImmediate(pTree, pNode->right))) {
+				
+				// imul can read its source straight from memory
+				if (select_isMemory(pTree, pNode->left))
+					select_consider(&best, (select_plan){ cost, 1, SELECT_TILE_IMMEDIATE });
+				else
+					select_consider(&best, (select_plan){ select_cost(pLeft->plans[bound].cost, cost), pLeft->plans[bound].need, SELECT_TILE_IMMEDIATE });
+				
+			} else if (pRight->op == ASM_OP_NONE) {
+				
+				select_consider(&best, (select_plan){ select_cost(pLeft->plans[bound].cost, cost), pLeft->plans[bound].need, SELECT_TILE_OPERAND });
+				
+			}
+			
+			// A commutative operation can take its left side from memory instead
+			if ((pNode->op != ASM_OP_SUB) && (select_isMemory(pTree, pNode->left)) && (pRight->op != ASM_OP_NONE)) {
+				select_consider(&best, (select_plan){ select_cost(pRight->plans[bound].cost, cost), pRight->plans[bound].need, SELECT_TILE_SWAPPED });
+			}
+			
+			// Both sides in registers, evaluating whichever needs more first
+			if (bound >= 2) {
+				select_consider(&best, (select_plan){ select_cost(select_cost(pLeft->plans[2].cost, pRight->plans[1].cost), cost), 2, SELECT_TILE_REGISTERS, 0, false });
+				select_consider(&best, (select_plan){ select_cost(select_cost(pRight->plans[2].cost, pLeft->plans[1].cost), cost), 2, SELECT_TILE_REGISTERS, 0, true });
+			}
+			
+			// Any address this value can be written as is a single lea; the first one is just the value itself
+			for (size_t i = 1; i < pNode->addressCount; i++) {
+				
+				select_address* pAddress = &pNode->addresses[i];
+				
+				if ((pAddress->base >= 0) && (pAddress->index >= 0) && (pAddress->base != pAddress->index)) {
+					
+					if (bound < 2) continue;
+					
+					select_node* pBase = &pTree->nodes[pAddress->base];
+					select_node* pIndex = &pTree->nodes[pAddress->index];
+					
+					select_consider(&best, (select_plan){ select_cost(select_cost(pBase->plans[2].cost, pIndex->plans[1].cost), opCost[ASM_OP_LEA]), 2, SELECT_TILE_ADDRESS, i, false });
+					select_consider(&best, (select_plan){ select_cost(select_cost(pIndex->plans[2].cost, pBase->plans[1].cost), opCost[ASM_OP_LEA]), 2, SELECT_TILE_ADDRESS, i, true });
+					
+				} else {
+					
+					// A bare register is not worth an instruction
+					if ((pAddress->index < 0) && (pAddress->disp == 0)) continue;
+					
+					select_node* pOnly = &pTree->nodes[(pAddress->base >= 0) ? pAddress->base : pAddress->index];
+					select_consider(&best, (select_plan){ select_cost(pOnly->plans[bound].cost, opCost[ASM_OP_LEA]), pOnly->plans[bound].need, SELECT_TILE_ADDRESS, i });
+					
+				}
+				
+			}
+			
+		}
+		
+		pNode->plans[bound] = best;
+		
+	}
+	
+}
+
+/*////////*/
+
+static void select_emit(assm* pAssm, select_tree* pTree, int64_t index, size_t bound, size_t target);
+
+static void select_emit_pair(assm* pAssm, select_tree* pTree, int64_t first, int64_t second, bool secondFirst, size_t target) {
+	
+	// The side evaluated first may use both registers, the other only the one it ends up in
+	if (secondFirst) {
+		select_emit(pAssm, pTree, second, 2, 1 - target);
+		select_emit(pAssm, pTree, first, 1, target);
+	} else {
+		select_emit(pAssm, pTree, first, 2, target);
+		select_emit(pAssm, pTree, second, 1, 1 - target);
+	}
+	
+}
+
+static void select_emit(assm* pAssm, select_tree* pTree, int64_t index, size_t bound, size_t target) {
+	
+	select_node* pNode = &pTree->nodes[index];
+	select_plan* pPlan = &pNode->plans[bound];
+	
+	char* reg = selectRegisters[target].name32;
+	char* other = selectRegisters[1 - target].name32;
+	
+	switch (pPlan->tile) {
+		
+		case (SELECT_TILE_LOAD) {
+			instruction_add(pAssm, ASM_OP_MOV, reg, pNode->operand.value);
+		} break;
+		
+		case (SELECT_TILE_OPERAND) {
+			select_emit(pAssm, pTree, pNode->left, bound, target);
+			instruction_add(pAssm, pNode->op, reg, pTree->nodes[pNode->right].operand.value);
+		} break;
+		
+		case (SELECT_TILE_SWAPPED) {
+			select_emit(pAssm, pTree, pNode->right, bound, target);
+			instruction_add(pAssm, pNode->op, reg, pTree->nodes[pNode->left].operand.value);
+		} break;
+		
+		case (SELECT_TILE_IMMEDIATE) {
+			if (select_isMemory(pTree, pNode->left)) {
+				instruction_add3(pAssm, ASM_OP_IMUL, reg, pTree->nodes[pNode->left].operand.value, pTree->nodes[pNode->right].operand.value);
+			} else {
+				select_emit(pAssm, pTree, pNode->left, bound, target);
+				instruction_add3(pAssm, ASM_OP_IMUL, reg, reg, pTree->nodes[pNode->right].operand.value);
+			}
+		} break;
+		
+		case (SELECT_TILE_REGISTERS) {
+			select_emit_pair(pAssm, pTree, pNode->left, pNode->right, pPlan->rightFirst, target);
+			instruction_add(pAssm, pNode->op, reg, other);
+		} break;
+		
+		case (SELECT_TILE_ADDRESS) {
+			
+			select_address* pAddress = &pNode->addresses[pPlan->address];
+			char* base = NULL;
+			char* scaled = NULL;
+			
+			// Get the base and index into registers
+			if ((pAddress->base >= 0) && (pAddress->index >= 0) && (pAddress->base != pAddress->index)) {
+				select_emit_pair(pAssm, pTree, pAddress->base, pAddress->index, pPlan->rightFirst, target);
+				base = selectRegisters[target].name64;
+				scaled = selectRegisters[1 - target].name64;
+			} else if (pAddress->base >= 0) {
+				select_emit(pAssm, pTree, pAddress->base, bound, target);
+				base = selectRegisters[target].name64;
+				if (pAddress->index >= 0) scaled = base;
+			} else {
+				select_emit(pAssm, pTree, pAddress->index, bound, target);
+				scaled = selectRegisters[target].name64;
+			}
+			
+			// Write out the address
+			char address[MAX_VALUE_LEN] = {};
+			char number[24];
+			size_t length = text_append(address, sizeof(address), 0, "[");
+			if (base) length = text_append(address, sizeof(address), length, base);
+			if (scaled) {
+				if (base) length = text_append(address, sizeof(address), length, " + ");
+				length = text_append(address, sizeof(address), length, scaled);
+				if (pAddress->scale != 1) {
+					text_signed(number, pAddress->scale);
+					length = text_append(address, sizeof(address), length, "*");
+					length = text_append(address, sizeof(address), length, number);
+				}
+			}
+			if (pAddress->disp != 0) {
+				text_decimal(number, (pAddress->disp < 0) ? (0 - (uint64_t)pAddress->disp) : (uint64_t)pAddress->disp);
+				length = text_append(address, sizeof(address), length, (pAddress->disp < 0) ? " - " : " + ");
+				length = text_append(address, sizeof(address), length, number);
+			}
+			text_append(address, sizeof(address), length, "]");
+			
+			instruction_add(pAssm, ASM_OP_LEA, reg, address);
+			
+		} break;
+		
+		default: break;
+		
+	}
+	
+}
+
+static bool expr_select(assm* pAssm, ir* pIR) {
+	
+	size_t start = pIR->index;
+	size_t statements = 0;
+	
+	select_tree tree = {};
+	int64_t registers[SELECT_REGISTERS] = { -1, -1 };
+	
+	// Build a tree out of the run of 32-bit moves and arithmetic on the general purpose registers
+	while (1) {
+		
+		unit_type kind = peek(0).type;
+		if ((kind != UNIT_TYPE_KW_MOVE) && (kind != UNIT_TYPE_KW_ADD) && (kind != UNIT_TYPE_KW_SUB) && (kind != UNIT_TYPE_KW_MUL)) break;
+		
+		// Signed multiplication only; unsigned goes through mul and the accumulator
+		if ((peek(1).type != UNIT_TYPE_TP_S32) || (peek(3).type != UNIT_TYPE_PT_COMMA)) break;
+		if ((peek(2).type != UNIT_TYPE_RG_RG1) && (peek(2).type != UNIT_TYPE_RG_RG2)) break;
+		
+		size_t reg = (peek(2).type == UNIT_TYPE_RG_RG1) ? 0 : 1;
+		
+		// The source is either a variable or literal, or the second register
+		int64_t source = -1;
+		size_t length = 0;
+		bool fromRegister = false;
+		
+		if ((peek(4).type == UNIT_TYPE_IDENTIFIER) || (peek(4).type == UNIT_TYPE_LITERAL)) {
+			source = select_leaf(pAssm, &tree, ppeek(4));
+			length = 6;
+		} else if ((peek(4).type == UNIT_TYPE_TP_S32) && (peek(5).type == UNIT_TYPE_RG_RG2) && (reg == 0)) {
+			source = registers[1];
+			fromRegister = true;
+			length = 7;
+		}
+		
+		if (source < 0) break;
+		
+		// Loading over a value that is still held would lose it, so that starts a new run
+		if ((kind == UNIT_TYPE_KW_MOVE) && (registers[reg] >= 0)) break;
+		if ((kind != UNIT_TYPE_KW_MOVE) && (registers[reg] < 0)) break;
+		
+		int64_t value = (kind == UNIT_TYPE_KW_MOVE) ? source : select_operation(&tree, to_arith(ppeek(0)), registers[reg], source);
+		if (value < 0) break;
+		
+		registers[reg] = value;
+		if (fromRegister) registers[1] = -1;
+		
+		advance(length);
+		statements++;
+		
+	}
+	
+	// Only take over a run that computes something and leaves its result in the first register alone
+	if ((statements < 2) || (registers[0] < 0) || (registers[1] >= 0)) {
+		jump(start);
+		return false;
+	}
+	
+	// Work out the cheapest cover from the leaves up
+	for (int64_t i = 0; i < (int64_t)tree.size; i++) {
+		select_addresses(&tree, i);
+		select_label(&tree, i);
+	}
+	
+	if (tree.nodes[registers[0]].plans[SELECT_REGISTERS].tile == SELECT_TILE_NONE) {
+		jump(start);
+		return false;
+	}
+	
+	select_emit(pAssm, &tree, registers[0], SELECT_REGISTERS, 0);
+	
+	return true;
+	
+}
+
+static int switch_compare(const void* pFirst, const void* pSecond) {
+	
+	const switch_case* a = pFirst;
+	const switch_case* b = pSecond;
+	
+	// By value, and the same value in the order it was written
+	if (a->value != b->value) return (a->value < b->value) ? -1 : 1;
+	return (a->order < b->order) ? -1 : (a->order > b->order);
+	
+}
+
+static void switch_linear(assm* pAssm, switch_case cases[], size_t count, char* fallback) {
+	
+	// Compare against every case in turn
+	char value[32];
+	for (size_t i = 0; i < count; i++) {
+		text_signed(value, cases[i].value);
+		instruction_add(pAssm, ASM_OP_CMP, "eax", value);
+		instruction_add(pAssm, ASM_OP_JZ, cases[i].label, NULL);
+	}
+	
+	instruction_add(pAssm, ASM_OP_JMP, fallback, NULL);
+	
+}
+
+static bool switch_table(assm* pAssm, switch_case cases[], size_t count, char* fallback, size_t* pLabels) {
+	
+	int64_t low = cases[0].value;
+	int64_t range = cases[count - 1].value - low + 1;
+	
+	// Only worth it for enough cases that are close enough together
+	if ((count <= SWITCH_MAX_LINEAR) || (range > SWITCH_MAX_TABLE) || ((count * 100) < (range * SWITCH_MIN_DENSITY))) return false;
+	
+	// The table is named after where the switch goes by default, which is unique to it
+	char table[MAX_VALUE_LEN];
+	char address[MAX_VALUE_LEN];
+	char number[24];
+	text_decimal(number, *pLabels);
+	size_t length = text_append(table, sizeof(table), 0, fallback);
+	length = text_append(table, sizeof(table), length, "_t");
+	if (text_append(table, sizeof(table), length, number) >= sizeof(table)) return false;
+	length = text_append(address, sizeof(address), 0, "[rel ");
+	length = text_append(address, sizeof(address), length, table);
+	if (text_append(address, sizeof(address), length, "]") >= sizeof(address)) return false;
+	(*pLabels)++;
+	
+	// Bring the value down to an index, and anything past the end of the table (including what was below it) goes to the default
+	char value[32];
+	if (low != 0) {
+		text_signed(value, low);
+		instruction_add(pAssm, ASM_OP_SUB, "eax", value);
+	}
+	text_signed(value, range - 1);
+	instruction_add(pAssm, ASM_OP_CMP, "eax", value);
+	instruction_add(pAssm, ASM_OP_JA, fallback, NULL);
+	
+	// Writing eax cleared the top of rax, so it indexes the table as it is
+	instruction_add(pAssm, ASM_OP_LEA, "r11", address);
+	instruction_add(pAssm, ASM_OP_JMP, "[r11 + rax*8]", NULL);
+	
+	// Every value in the range has an entry; the gaps go to the default
+	data_add(&pAssm->rodata, ASM_DATA_ALIGN, 8, NULL);
+	data_add(&pAssm->rodata, ASM_DATA_LABEL, 0, table);
+	size_t next = 0;
+	for (int64_t i = 0; i < range; i++) {
+		char* label = fallback;
+		if (cases[next].value == (low + i)) label = cases[next++].label;
+		data_value(data_add(&pAssm->rodata, ASM_DATA_VALUES, 8, NULL), label);
+	}
+	
+	return true;
+	
+}
+
+static void switch_lower(assm* pAssm, switch_case cases[], size_t count, char* fallback, size_t* pLabels) {
+	
+	// A few cases are compared in turn, and many cases close together go through a table
+	if (count <= SWITCH_MAX_LINEAR) {
+		switch_linear(pAssm, cases, count, fallback);
+		return;
+	}
+	if (switch_table(pAssm, cases, count, fallback, pLabels)) return;
+	
+	// Anything else is split on its middle case, so that finding a case takes a logarithmic number of compares
+	char upper[MAX_VALUE_LEN];
+	char number[24];
+	text_decimal(number, *pLabels);
+	size_t length = text_append(upper, sizeof(upper), 0, fallback);
+	length = text_append(upper, sizeof(upper), length, "_b");
+	if (text_append(upper, sizeof(upper), length, number) >= sizeof(upper)) {
+		switch_linear(pAssm, cases, count, fallback);
+		return;
+	}
+	(*pLabels)++;
+	
+	size_t middle = count / 2;
+	char value[32];
+	text_signed(value, cases[middle].value);
+	instruction_add(pAssm, ASM_OP_CMP, "eax", value);
+	instruction_add(pAssm, ASM_OP_JZ, cases[middle].label, NULL);
+	instruction_add(pAssm, ASM_OP_JG, upper, NULL);
+	
+	switch_lower(pAssm, cases, middle, fallback, pLabels);
+	
+	instruction_add(pAssm, ASM_OP_LABEL, upper, NULL);
+	switch_lower(pAssm, &cases[middle + 1], count - middle - 1, fallback, pLabels);
+	
+}
+
+/*////////*/
+
+static size_t compare_find(unit_type compare) {
+	
+	for (size_t i = 0; i < (sizeof(compareTable) / sizeof(compareTable[0])); i++) {
+		if (compareTable[i].compare == compare) return i;
+	}
+	
+	return 0;
+	
+}
+
+static bool compare_literal(char* value, int64_t* pValue) {
+	
+	char* end = NULL;
+	*pValue = strtoll(value, &end, 0);
+	
+	return (end != value) && (*end == '\0');
+	
+}
+
+static void operand_parse(assm* pAssm, ir* pIR, char* value) {
+	
+	// Registers come with their size
+	if ((peek(0).type != UNIT_TYPE_IDENTIFIER) && (peek(0).type != UNIT_TYPE_LITERAL)) advance(1);
+	
+	strncpy(value, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
+	advance(1);
+	
+}
+
+static void compare_parse(assm* pAssm, ir* pIR, asm_compare* pCompare) {
+	
+	// Comparisons look like: value compare [value]
+	operand_parse(pAssm, pIR, pCompare->left);
+	pCompare->compare = peek(0).type;
+	advance(1);
+	
+	bool single = (pCompare->compare == UNIT_TYPE_KW_CMP_Z) || (pCompare->compare == UNIT_TYPE_KW_CMP_NZ);
+	if (!single) operand_parse(pAssm, pIR, pCompare->right);
+	
+	// Literals on both sides always come out the same way
+	int64_t a = 0;
+	int64_t b = 0;
+	pCompare->constant = -1;
+	if ((!compare_literal(pCompare->left, &a)) || ((!single) && (!compare_literal(pCompare->right, &b)))) return;
+	
+	switch (pCompare->compare) {
+		case (UNIT_TYPE_KW_CMP_Z) pCompare->constant = (a == 0); break;
+		case (UNIT_TYPE_KW_CMP_NZ) pCompare->constant = (a != 0); break;
+		case (UNIT_TYPE_KW_CMP_E) pCompare->constant = (a == b); break;
+		case (UNIT_TYPE_KW_CMP_NE) pCompare->constant = (a != b); break;
+		case (UNIT_TYPE_KW_CMP_L) pCompare->constant = (a < b); break;
+		case (UNIT_TYPE_KW_CMP_LE) pCompare->constant = (a <= b); break;
+		case (UNIT_TYPE_KW_CMP_G) pCompare->constant = (a > b); break;
+		case (UNIT_TYPE_KW_CMP_GE) pCompare->constant = (a >= b); break;
+		default: break;
+	}
+	
+}
+
+static size_t compare_emit(assm* pAssm, asm_compare* pCompare, char* scratch) {
+	
+	char* left = pCompare->left;
+	char* right = pCompare->right;
+	unit_type compare = pCompare->compare;
+	
+	// A test against zero goes through a register, since test can't take memory on both sides
+	if ((compare == UNIT_TYPE_KW_CMP_Z) || (compare == UNIT_TYPE_KW_CMP_NZ)) {
+		instruction_add(pAssm, ASM_OP_MOV, scratch, left);
+		instruction_add(pAssm, ASM_OP_TEST, scratch, scratch);
+		return compare_find(compare);
+	}
+	
+	// cmp can't take an immediate on the left, so the sides are swapped around
+	if (operand_classify(left) == ASM_OPERAND_IMMEDIATE) {
+		left = pCompare->right;
+		right = pCompare->left;
+		compare = compareTable[compare_find(compare)].swapped;
+	}
+	
+	// Both sides are compared at the widest size either of them has
+	bool wide = false;
+	char* sides[2] = { left, right };
+	for (size_t i = 0; i < 2; i++) {
+		asm_operand_type kind = operand_classify(sides[i]);
+		if ((kind == ASM_OPERAND_MEMORY) && (strncmp(sides[i], "qword", 5) == 0)) wide = true;
+		if ((kind == ASM_OPERAND_REGISTER) && (strcmp(registerTable[register_find(sides[i], strlen(sides[i]))].name32, sides[i]) != 0)) wide = true;
+	}
+	
+	char names[2][MAX_VALUE_LEN] = {};
+	for (size_t i = 0; i < 2; i++) {
+		strcpy(names[i], sides[i]);
+		if (operand_classify(sides[i]) != ASM_OPERAND_REGISTER) continue;
+		asm_register family = registerTable[register_find(sides[i], strlen(sides[i]))].family;
+		strcpy(names[i], (wide) ? register_name64(family) : register_name32(family));
+	}
+	
+	// Nor memory on both sides
+	if ((operand_classify(names[0]) != ASM_OPERAND_REGISTER) && (operand_classify(names[1]) != ASM_OPERAND_REGISTER) && (operand_classify(names[1]) != ASM_OPERAND_IMMEDIATE)) {
+		asm_register family = registerTable[register_find(scratch, strlen(scratch))].family;
+		strcpy(names[0], (wide) ? register_name64(family) : register_name32(family));
+		instruction_add(pAssm, ASM_OP_MOV, names[0], left);
+	}
+	
+	instruction_add(pAssm, ASM_OP_CMP, names[0], names[1]);
+	
+	return compare_find(compare);
+	
+}
+
+/*////////*/
+
+static bool divide_isPower(uint64_t value, int* pShift) {
+	
+	// Only powers of two past one
+	if ((value < 2) || (value & (value - 1))) return false;
+	
+	*pShift = 0;
+	while ((1ull << *pShift) != value) (*pShift)++;
+	
+	return true;
+	
+}
+
+static void divide_magic(int32_t divisor, int32_t* pMagic, int* pShift) {
+	
+	// The smallest multiplier and shift whose product with any 32-bit value has the quotient in its high half (Hacker's Delight, 10-1)
+	uint32_t two31 = 0x80000000u;
+	uint32_t magnitude = (divisor < 0) ? (0u - (uint32_t)divisor) : (uint32_t)divisor;
+	uint32_t t = two31 + ((uint32_t)divisor >> 31);
+	uint32_t anc = t - 1 - (t % magnitude);
+	
+	int p = 31;
+	uint32_t q1 = two31 / anc;
+	uint32_t r1 = two31 - (q1 * anc);
+	uint32_t q2 = two31 / magnitude;
+	uint32_t r2 = two31 - (q2 * magnitude);
+	uint32_t delta = 0;
+	
+	do {
+		
+		p++;
+		
+		q1 *= 2;
+		r1 *= 2;
+		if (r1 >= anc) {
+			q1++;
+			r1 -= anc;
+		}
+		
+		q2 *= 2;
+		r2 *= 2;
+		if (r2 >= magnitude) {
+			q2++;
+			r2 -= magnitude;
+		}
+		
+		delta = magnitude - r2;
+		
+	} while ((q1 < delta) || ((q1 == delta) && (r1 == 0)));
+	
+	int32_t magic = (int32_t)(q2 + 1);
+	*pMagic = (divisor < 0) ? -magic : magic;
+	*pShift = p - 32;
+	
+}
+
+static void divide_signed(assm* pAssm, asm_operand* pTarget, int32_t divisor, bool remainder) {
+	
+	char* target = pTarget->value;
+	char value[32];
+	
+	// Dividing by one or minus one only changes the sign, and leaves nothing over
+	if ((divisor == 1) || (divisor == -1)) {
+		if (remainder)
+			instruction_add(pAssm, ASM_OP_MOV, target, "0");
+		else if (divisor == -1)
+			instruction_add(pAssm, ASM_OP_NEG, target, NULL);
+		return;
+	}
+	
+	// The work is done in rax, unless that is what is being divided; then rdx is borrowed and given back afterwards, since it may hold an argument
+	bool borrow = operand_uses(pTarget, ASM_REGISTER_RAX);
+	char* work = (borrow) ? "edx" : "eax";
+	char* work64 = (borrow) ? "rdx" : "rax";
+	if (borrow) instruction_add(pAssm, ASM_OP_MOV, "qword [rsp+8]", "rdx");
+	
+	uint32_t magnitude = (divisor < 0) ? (0u - (uint32_t)divisor) : (uint32_t)divisor;
+	int shift = 0;
+	if (divide_isPower(magnitude, &shift)) {
+		
+		// Shifting rounds down rather than toward zero, so a negative value is brought up by the divisor less one first
+		instruction_add(pAssm, ASM_OP_MOV, work, target);
+		instruction_add(pAssm, ASM_OP_SAR, work, "31");
+		text_signed(value, 32 - shift);
+		instruction_add(pAssm, ASM_OP_SHR, work, value);
+		instruction_add(pAssm, ASM_OP_ADD, work, target);
+		
+		// The remainder is what clearing the low bits takes away
+		if (remainder) {
+			text_signed(value, -(int64_t)magnitude);
+			instruction_add(pAssm, ASM_OP_AND, work, value);
+			instruction_add(pAssm, ASM_OP_SUB, target, work);
+		} else {
+			text_signed(value, shift);
+			instruction_add(pAssm, ASM_OP_SAR, work, value);
+			if (divisor < 0) instruction_add(pAssm, ASM_OP_NEG, work, NULL);
+			instruction_add(pAssm, ASM_OP_MOV, target, work);
+		}
+		
+	} else {
+		
+		int32_t magic = 0;
+		int post = 0;
+		divide_magic(divisor, &magic, &post);
+		
+		// The high half of the full product with the magic number is the quotient, once it has been corrected and shifted
+		instruction_add(pAssm, ASM_OP_MOVSXD, work64, target);
+		text_signed(value, magic);
+		instruction_add3(pAssm, ASM_OP_IMUL, work64, work64, value);
+		instruction_add(pAssm, ASM_OP_SAR, work64, "32");
+		
+		if ((divisor > 0) && (magic < 0)) instruction_add(pAssm, ASM_OP_ADD, work, target);
+		if ((divisor < 0) && (magic > 0)) instruction_add(pAssm, ASM_OP_SUB, work, target);
+		
+		if (post > 0) {
+			text_signed(value, post);
+			instruction_add(pAssm, ASM_OP_SAR, work, value);
+		}
+		
+		// Add one to a negative quotient so that it rounds toward zero; the compare only carries for one that isn't negative
+		instruction_add(pAssm, ASM_OP_CMP, work, "0x80000000");
+		instruction_add(pAssm, ASM_OP_SBB, work, "-1");
+		
+		if (remainder) {
+			text_signed(value, divisor);
+			instruction_add3(pAssm, ASM_OP_IMUL, work, work, value);
+			instruction_add(pAssm, ASM_OP_SUB, target, work);
+		} else {
+			instruction_add(pAssm, ASM_OP_MOV, target, work);
+		}
+		
+	}
+	
+	if (borrow) instruction_add(pAssm, ASM_OP_MOV, "rdx", "qword [rsp+8]");
+	
+}
+
+static void divide_hardware(assm* pAssm, char* target, char* divisor, bool isUnsigned, bool remainder) {
+	
+	// Division is extremely weird; the dividend is in the accumulator, and the quotient ends up in the accumulator...
+	// Yeah, strange. Oh, and you have to sign extend the register with cdq or zero it out depending if it's signed or unsigned.
+	// The remainder ends up in edx.
+	char* result = (remainder) ? "edx" : "eax";
+	
+	// Depending on the type, we need to handle some special x86 quirks
+	if (isUnsigned) {
+		
+		// We need to load the dividend into the accumulator register
+		instruction_add(pAssm, ASM_OP_MOV, "eax", target);
+		
+		// Move the divisor into the counter, since you can't divide by literals for some reason...
+		instruction_add(pAssm, ASM_OP_MOV, "ecx", divisor);
+		
+		// Zero out the upper bits of edx
+		instruction_add(pAssm, ASM_OP_XOR, "edx", "edx");
+		
+		// Divide the accumulator by the divisor
+		instruction_add(pAssm, ASM_OP_DIV, "ecx", NULL);
+		
+		// Move this back into the register we pulled from
+		instruction_add(pAssm, ASM_OP_MOV, target, result);
+		
+	} else {
+		
+		// Save rcx and rdx to the shadow space since they are function arguments
+		// eax is non-volatile in this implementation, so no concerns with preserving it
+		instruction_add(pAssm, ASM_OP_MOV, "qword [rsp+0]", "rcx");
+		instruction_add(pAssm, ASM_OP_MOV, "qword [rsp+8]", "rdx");
+		
+		// We need to load the dividend into eax
+		instruction_add(pAssm, ASM_OP_MOV, "eax", target);
+		
+		// Sign extend
+		instruction_add(pAssm, ASM_OP_CDQ, NULL, NULL);
+		
+		// Move the divisor into ecx
+		instruction_add(pAssm, ASM_OP_MOV, "ecx", divisor);
+		
+		// Divide the accumulator by the register or literal
+		instruction_add(pAssm, ASM_OP_IDIV, "ecx", NULL);
+		
+		// Move the quotient or remainder back into the register
+		instruction_add(pAssm, ASM_OP_MOV, target, result);
+		
+		// Restore rdx and rcx
+		instruction_add(pAssm, ASM_OP_MOV, "rcx", "qword [rsp+0]");
+		instruction_add(pAssm, ASM_OP_MOV, "rdx", "qword [rsp+8]");
+		
+	}
+	
+}
+
+/*////////*/
+
+static void function_scan(assm* pAssm, ir* pIR) {
+	
+	// Read the parameters, which end on a semicolon
+	pAssm->params.count = 0;
+	while ((peek(0).type != UNIT_TYPE_PT_SEMICOLON) && (peek(0).type != UNIT_TYPE_KW_END)) {
+		
+		if ((peek(0).type == UNIT_TYPE_IDENTIFIER) && (pAssm->params.count < ASM_MAX_PARAMS)) {
+			pAssm->params.names[pAssm->params.count] = upeek(0).value;
+			pAssm->params.types[pAssm->params.count] = peek(-1).type;
+			pAssm->params.referenced[pAssm->params.count] = false;
+			(pAssm->params.count)++;
+		}
+		
+		advance(1);
+		
+	}
+	
+	// Look over the body up to the free that belongs to its alloc
+	pAssm->params.inRegisters = true;
+	size_t maxArgs = 0;
+	size_t depth = 0;
+	for (size_t i = pIR->index; i < pIR->size; i++) {
+		
+		unit* pUnit = &pIR->buffer[i];
+		
+		if (pUnit->type == UNIT_TYPE_KW_ALLOC) depth++;
+		if ((pUnit->type == UNIT_TYPE_KW_FREE) && (--depth == 0)) break;
+		
+		// A call overwrites the argument registers, and division uses two of them
+		if ((pUnit->type == UNIT_TYPE_KW_CALL) || (pUnit->type == UNIT_TYPE_KW_DIV) || (pUnit->type == UNIT_TYPE_KW_MOD)) pAssm->params.inRegisters = false;
+		if ((pUnit->type == UNIT_TYPE_KW_MUL) && (unit_isUnsigned(pUnit[1].type))) pAssm->params.inRegisters = false;
+		
+		// Arguments are numbered from zero
+		if ((pUnit->type == UNIT_TYPE_KW_ARG) && ((strtoull(pUnit[2].value, NULL, 10) + 1) > maxArgs)) maxArgs = strtoull(pUnit[2].value, NULL, 10) + 1;
+		
+		if (pUnit->type == UNIT_TYPE_IDENTIFIER)
+			for (size_t j = 0; j < pAssm->params.count; j++)
+				if (strcmp(pUnit->value, pAssm->params.names[j]) == 0) pAssm->params.referenced[j] = true;
+		
+	}
+	
+	// Arguments past the fourth are stored above the shadow space, which stays aligned to 16 bytes
+	pAssm->outgoing = (maxArgs > 4) ? ((((maxArgs - 4) * 8) + 15) & ~15) : 0;
+	
+}
+
+static char* return_sibling(assm* pAssm, ir* pIR) {
+	
+	// The return has to come right after: call name arg_pop move type retval , type retval ;
+	if ((pIR->index < 10) || (peek(-10).type != UNIT_TYPE_KW_CALL) || (peek(-8).type != UNIT_TYPE_KW_ARG_POP) || (peek(-7).type != UNIT_TYPE_KW_MOVE) ||
+		(peek(-5).type != UNIT_TYPE_RG_RETVAL) || (peek(-2).type != UNIT_TYPE_RG_RETVAL)) return NULL;
+	
+	// Arguments on the stack live in our frame, which is about to go away
+	for (int64_t i = -11; (((int64_t)pIR->index + i) >= 0) && (peek(i).type != UNIT_TYPE_KW_ARG_PUSH); i--)
+		if ((peek(i).type == UNIT_TYPE_KW_ARG) && (strtoull(peek(i + 2).value, NULL, 10) >= 4)) return NULL;
+	
+	// The text has to end on the call and the move of its result onto itself
+	size_t size = pAssm->text.size;
+	if ((size < 2) || (pAssm->text.buffer[size - 2].op != ASM_OP_CALL) || (pAssm->text.buffer[size - 1].op != ASM_OP_MOV)) return NULL;
+	if (!operand_equals(&pAssm->text.buffer[size - 1].operands[0], &pAssm->text.buffer[size - 1].operands[1])) return NULL;
+	
+	pAssm->text.buffer[size - 2].op = ASM_OP_NONE;
+	pAssm->text.buffer[size - 1].op = ASM_OP_NONE;
+	
+	return upeek(-9).value;
+	
+}
+
+static void section_scan(assm* pAssm, ir* pIR, size_t index) {
+	
+	unit* pUnit = &pIR->buffer[index];
+	
+	// Functions, statics and descriptors are named by the first identifier after their keyword
+	if ((pUnit->type != UNIT_TYPE_KW_FUNC) && (pUnit->type != UNIT_TYPE_KW_STATIC) && (pUnit->type != UNIT_TYPE_KW_REFLECT)) return;
+	
+	size_t name = index;
+	while ((name < pIR->size) && (pIR->buffer[name].type != UNIT_TYPE_IDENTIFIER)) name++;
+	if (name >= pIR->size) return;
+	
+	char* value = pIR->buffer[name].value;
+	
+	switch (pUnit->type) {
+		
+		// Functions that are imported or exported are declared up front
+		case (UNIT_TYPE_KW_FUNC) {
+			
+			if (index == 0) break;
+			
+			if (strcmp(value, "main") == 0) {
+				pAssm->foundMain = true;
+				break;
+			}
+			
+			unit_type linkage = pIR->buffer[index - 1].type;
+			if (linkage == UNIT_TYPE_KW_EXPORT) writer_string(&pAssm->directives, "global ");
+			else if (linkage == UNIT_TYPE_KW_IMPORT) writer_string(&pAssm->directives, "extern ");
+			
+			writer_line(&pAssm->directives, value);
+			
+		} break;
+		
+		// Statics are written into the data section, strings as bytes and values at their own size: name : "value" ;
+		case (UNIT_TYPE_KW_STATIC) {
+			
+			if ((name + 2) >= pIR->size) break;
+			
+			if (pIR->buffer[name + 2].value[0] == '"') {
+				data_value(data_add(&pAssm->data, ASM_DATA_STRING, 1, value), pIR->buffer[name + 2].value);
+				break;
+			}
+			
+			// Anything that isn't a byte, a word or a quadword takes a doubleword
+			size_t size = to_size(&pIR->buffer[name - 1]);
+			data_value(data_add(&pAssm->data, ASM_DATA_VALUES, ((size == 1) || (size == 2) || (size == 8)) ? size : 4, value), pIR->buffer[name + 2].value);
+			
+			// Code reads and writes it where it is
+			symbol_add(&pAssm->staticTable, value, SYMBOL_TYPE_VARIABLE, (size <= 8) ? size : 4, 0, SYMBOL_CLASS_VARIABLE);
+			
+		} break;
+		
+		// Descriptors are read only, and hold the address of the type's name, its size and its pointer depth: name : "type" , size , pointers ;
+		case (UNIT_TYPE_KW_REFLECT) {
+			
+			if ((name + 6) >= pIR->size) break;
+			
+			char typeName[MAX_VALUE_LEN];
+			size_t length = text_append(typeName, sizeof(typeName), 0, value);
+			text_append(typeName, sizeof(typeName), length, "_name");
+			
+			data_add(&pAssm->rodata, ASM_DATA_ALIGN, 8, NULL);
+			data_add(&pAssm->rodata, ASM_DATA_LABEL, 0, value);
+			
+			asm_data* pData = data_add(&pAssm->rodata, ASM_DATA_VALUES, 8, NULL);
+			data_value(pData, typeName);
+			data_value(pData, pIR->buffer[name + 4].value);
+			data_value(pData, pIR->buffer[name + 6].value);
+			
+			data_value(data_add(&pAssm->rodata, ASM_DATA_STRING, 1, typeName), pIR->buffer[name + 2].value);
+			
+		} break;
+		
+		default: break;
+		
+	}
+	
+}
+
+/*////////*/
+
+static bool fragment_reserve(void** ppBuffer, size_t* pMemSize, size_t size, size_t elementSize) {
+	
+	if (size <= *pMemSize) return true;
+	
+	// Double the buffer until it fits
+	size_t newMemSize = (*pMemSize == 0) ? 64 : (*pMemSize * 2);
+	while (newMemSize < size) newMemSize *= 2;
+	
+	void* newBuffer = realloc(*ppBuffer, newMemSize * elementSize);
+	if (!newBuffer) return false;
+	
+	*ppBuffer = newBuffer;
+	*pMemSize = newMemSize;
+	
+	return true;
+	
+}
+
+static size_t function_end(ir* pIR, size_t index) {
+	
+	// A function with a body runs up to the free that belongs to its alloc, and the semicolon after it
+	size_t depth = 0;
+	for (size_t i = index + 1; i < pIR->size; i++) {
+		
+		unit_type type = pIR->buffer[i].type;
+		
+		if ((depth == 0) && ((type == UNIT_TYPE_KW_FUNC) || (type == UNIT_TYPE_KW_END))) return 0;
+		
+		if (type == UNIT_TYPE_KW_ALLOC) depth++;
+		if ((type == UNIT_TYPE_KW_FREE) && (depth > 0) && (--depth == 0)) return ((i + 2) <= pIR->size) ? (i + 2) : 0;
+		
+	}
+	
+	return 0;
+	
+}
+
+static bool function_reuse(assm* pAssm, ir* pIR, assm_info* pInfo) {
+	
+	asm_fragments* pFragments = &pAssm->fragments;
+	asm_fragments* pPrevious = pInfo->pPrevious;
+	
+	// Only functions with a body are kept
+	if ((!pInfo->incremental) || (peek(0).type != UNIT_TYPE_KW_FUNC) || (peek(-1).type == UNIT_TYPE_KW_IMPORT)) return false;
+	
+	pAssm->function.recording = false;
+	
+	size_t start = pIR->index;
+	size_t end = function_end(pIR, start);
+	if (end == 0) return false;
+	
+	size_t count = end - start;
+	if (!fragment_reserve((void**)&pFragments->units.buffer, &pFragments->units.memSize, pFragments->units.size + count, sizeof(asm_fragment_unit))) return false;
+	if (!fragment_reserve((void**)&pFragments->buffer, &pFragments->memSize, pFragments->size + 1, sizeof(asm_fragment))) return false;
+	
+	// It is found by its units, and by the statics they name as things stand before it, which is all selecting it depends on; FNV-1a
+	asm_fragment_unit* pUnits = &pFragments->units.buffer[pFragments->units.size];
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < count; i++) {
+		
+		unit* pUnit = &pIR->buffer[start + i];
+		symbol* pSym = (pUnit->type == UNIT_TYPE_IDENTIFIER) ? symbol_find(&pAssm->staticTable, pUnit->value, SYMBOL_CLASS_VARIABLE) : NULL;
+		
+		pUnits[i].unit = *pUnit;
+		pUnits[i].staticSize = (pSym) ? pSym->size : 0;
+		
+		hash = (hash ^ (uint64_t)pUnit->type) * 0x100000001b3ULL;
+		hash = (hash ^ (uint64_t)pUnits[i].staticSize) * 0x100000001b3ULL;
+		for (char* pChar = pUnit->value; *pChar; pChar++) hash = (hash ^ (uint8_t)*pChar) * 0x100000001b3ULL;
+		
+	}
+	
+	// Start recording it, whether it is copied in or selected again
+	asm_fragment* pFragment = &pFragments->buffer[pFragments->size];
+	*pFragment = (asm_fragment){};
+	pFragment->hash = hash;
+	pFragment->unitStart = pFragments->units.size;
+	pFragment->unitSize = count;
+	pFragment->textStart = pAssm->text.size;
+	pFragment->rodataStart = pAssm->rodata.size;
+	
+	pAssm->function.recording = true;
+	pAssm->function.end = end;
+	
+	if ((!pPrevious) || (pPrevious->size == 0)) return false;
+	
+	// Look for it among last time's, starting after the one found last
+	for (size_t n = 0; n < pPrevious->size; n++) {
+		
+		size_t index = (pPrevious->cursor + n) % pPrevious->size;
+		asm_fragment* pOld = &pPrevious->buffer[index];
+		if ((pOld->hash != hash) || (pOld->unitSize != count)) continue;
+		
+		asm_fragment_unit* pOldUnits = &pPrevious->units.buffer[pOld->unitStart];
+		size_t i = 0;
+		while ((i < count) && (pOldUnits[i].unit.type == pUnits[i].unit.type) && (pOldUnits[i].staticSize == pUnits[i].staticSize) && (strcmp(pOldUnits[i].unit.value, pUnits[i].unit.value) == 0)) i++;
+		if (i < count) continue;
+		
+		// Copy its instructions and jump tables in; if there is no room, select it after all
+		bool copied = text_insert(pAssm, pAssm->text.size, &pPrevious->text.buffer[pOld->textStart], pOld->textSize);
+		for (size_t j = 0; (copied) && (j < pOld->rodataSize); j++) {
+			
+			asm_data* pData = data_add(&pAssm->rodata, ASM_DATA_ALIGN, 0, NULL);
+			if (pData) *pData = pPrevious->rodata.buffer[pOld->rodataStart + j];
+			else copied = false;
+			
+		}
+		
+		if (!copied) {
+			pAssm->text.size = pFragment->textStart;
+			pAssm->rodata.size = pFragment->rodataStart;
+			return false;
+		}
+		
+		// Leave the walk as the function would have, past its free
+		pAssm->currentFunc = upeek(2).value;
+		pAssm->params.count = 0;
+		pAssm->outgoing = 0;
+		pAssm->offset = pOld->offset;
+		pPrevious->cursor = index + 1;
+		jump(end);
+		
+		// Return success
+		return true;
+		
+	}
+	
+	return false;
+	
+}
+
+static void function_record(assm* pAssm, ir* pIR) {
+	
+	if ((!pAssm->function.recording) || (pIR->index < pAssm->function.end)) return;
+	pAssm->function.recording = false;
+	
+	// A walk that went past the end of the function didn't select it on its own
+	if (pIR->index != pAssm->function.end) return;
+	
+	asm_fragments* pFragments = &pAssm->fragments;
+	asm_fragment* pFragment = &pFragments->buffer[pFragments->size];
+	
+	// Keep what it added to the text and the read only data; a function that doesn't fit is selected again next time
+	size_t textSize = pAssm->text.size - pFragment->textStart;
+	size_t rodataSize = pAssm->rodata.size - pFragment->rodataStart;
+	if (!fragment_reserve((void**)&pFragments->text.buffer, &pFragments->text.memSize, pFragments->text.size + textSize, sizeof(instruction))) return;
+	if (!fragment_reserve((void**)&pFragments->rodata.buffer, &pFragments->rodata.memSize, pFragments->rodata.size + rodataSize, sizeof(asm_data))) return;
+	
+	memcpy(&pFragments->text.buffer[pFragments->text.size], &pAssm->text.buffer[pFragment->textStart], textSize * sizeof(instruction));
+	memcpy(&pFragments->rodata.buffer[pFragments->rodata.size], &pAssm->rodata.buffer[pFragment->rodataStart], rodataSize * sizeof(asm_data));
+	
+	pFragment->textStart = pFragments->text.size;
+	pFragment->textSize = textSize;
+	pFragment->rodataStart = pFragments->rodata.size;
+	pFragment->rodataSize = rodataSize;
+	pFragment->offset = pAssm->offset;
+	
+	pFragments->text.size += textSize;
+	pFragments->rodata.size += rodataSize;
+	pFragments->units.size += pFragment->unitSize;
+	(pFragments->size)++;
+	
+}
+
+static void instruction_parse(assm* pAssm, ir* pIR) {
+	
+	// Get the current unit
+	unit* currentUnit = &pIR->buffer[pIR->index];
+	
+	// Check the current unit and emit the appropriate instruction
+	switch (currentUnit->type) {
+		
+		case (UNIT_TYPE_KW_RETURN) {
+			
+			// Destroy the stack frame
+			if (strcmp(pAssm->currentFunc, "main") != 0) {
+				
+				// Returning what a call returns can jump to it instead, so that it returns straight to our caller
+				char* sibling = return_sibling(pAssm, pIR);
+				
+				instruction_add(pAssm, ASM_OP_MOV, "rsp", "rbp");
+				instruction_add(pAssm, ASM_OP_POP, "rbp", NULL);
+				
+				if (sibling) {
+					instruction_add(pAssm, ASM_OP_JMP, sibling, NULL);
+					advance(2);
+					break;
+				}
+				
+			}
+			
+			// Advance past the return keyword
+			advance(1);
+			
+			// Search backwards for the index of the retval unit
+			int64_t index = 0;
+			while (peek(index).type != UNIT_TYPE_RG_RETVAL) index--;
+			
+			// Return; the value is already in the return value register
+			if (strcmp(pAssm->currentFunc, "main") == 0) {
+				
+				instruction_add(pAssm, ASM_OP_MOV, "ecx", to_reg(pAssm, ppeek(index)));
+				instruction_add(pAssm, ASM_OP_CALL, "ExitProcess", NULL);
+				
+			} else {
+				
+				instruction_add(pAssm, ASM_OP_RET, NULL, NULL);
+				
+			}
+			
+			// Advance past the semicolon
+			advance(1);
+			
+		} break;
+		
+		// Nothing is held in a register across a call; parameters were stored away on entry, and results of other calls wait in temporaries
+		case (UNIT_TYPE_KW_ARG_PUSH)
+		case (UNIT_TYPE_KW_ARG_POP) {
+			
+			// Advance
+			advance(1);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_ARG) {
+			
+			// Arguments look like: arg type index , value ;
+			bool wide = (to_size(ppeek(1)) == 8);
+			size_t index = strtoull(peek(2).value, NULL, 10);
+			
+			// Advance to the value, past its size if it is a register
+			advance(4);
+			if ((peek(0).type != UNIT_TYPE_IDENTIFIER) && (peek(0).type != UNIT_TYPE_LITERAL)) advance(1);
+			
+			char value[MAX_VALUE_LEN] = {};
+			strncpy(value, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
+			
+			if (index < 4) {
+				
+				// The first four go in registers
+				instruction_add(pAssm, ASM_OP_MOV, (wide) ? argRegisters[index].name64 : argRegisters[index].name32, value);
+				
+			} else {
+				
+				// The rest go above the shadow space, in order
+				char slot[MAX_VALUE_LEN] = {};
+				char number[24];
+				text_decimal(number, 32 + ((index - 4) * 8));
+				size_t length = text_append(slot, sizeof(slot), 0, (wide) ? "qword [rsp + " : "dword [rsp + ");
+				length = text_append(slot, sizeof(slot), length, number);
+				text_append(slot, sizeof(slot), length, "]");
+				
+				// Memory can't be copied to memory, and only a 32-bit immediate can be stored directly, so those go through the accumulator
+				asm_operand_type kind = operand_classify(value);
+				int64_t literal = strtoll(value, NULL, 0);
+				
+				if ((kind == ASM_OPERAND_MEMORY) || (kind == ASM_OPERAND_LABEL) || ((kind == ASM_OPERAND_IMMEDIATE) && ((literal > INT32_MAX) || (literal < INT32_MIN)))) {
+					instruction_add(pAssm, ASM_OP_MOV, (wide) ? "rax" : "eax", value);
+					instruction_add(pAssm, ASM_OP_MOV, slot, (wide) ? "rax" : "eax");
+				} else {
+					instruction_add(pAssm, ASM_OP_MOV, slot, value);
+				}
+				
+			}
+			
+			// Advance past the value and the semicolon
+			advance(2);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_CALL) {
+			
+			// Call the function
+			instruction_add(pAssm, ASM_OP_CALL, peek(1).value, NULL);
+			
+			// Advance
+			advance(1);
+			
+		} break;
+		
+		case (UNIT_TYPE_LABEL) {
+			
+			// Check if this is a jump or a declaration
+			if (peek(-1).type == UNIT_TYPE_KW_JUMP)
+				instruction_add(pAssm, ASM_OP_JMP, peek(0).value, NULL);
+			else
+				instruction_add(pAssm, ASM_OP_LABEL, peek(0).value, NULL);
+			
+			// Advance past this and the semicolon
+			advance(2);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_IF) {
+			
+			// Conditions look like: if value compare [value] : label ;
+			advance(1);
+			
+			asm_compare compare = {};
+			compare_parse(pAssm, pIR, &compare);
+			
+			// Advance past the colon to the label
+			advance(1);
+			
+			// Compare and jump on the flags; a literal condition always goes the same way
+			if (compare.constant < 0)
+				instruction_add(pAssm, compareTable[compare_emit(pAssm, &compare, "eax")].jump, peek(0).value, NULL);
+			else if (compare.constant)
+				instruction_add(pAssm, ASM_OP_JMP, peek(0).value, NULL);
+			
+			// Advance past this and the semicolon
+			advance(2);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_SET) {
+			
+			// Sets look like: set type register , value compare [value] ;
+			advance(2);
+			
+			char target[MAX_VALUE_LEN] = {};
+			strncpy(target, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
+			
+			// Advance past the register and the comma
+			advance(2);
+			
+			asm_compare compare = {};
+			compare_parse(pAssm, pIR, &compare);
+			
+			if (compare.constant >= 0) {
+				
+				instruction_add(pAssm, ASM_OP_MOV, target, (compare.constant) ? "1" : "0");
+				
+			} else {
+				
+				// The whole register is cleared before the comparison, since clearing it after would lose the flags
+				instruction_add(pAssm, ASM_OP_MOV, "eax", "0");
+				
+				size_t entry = compare_emit(pAssm, &compare, "r11d");
+				instruction_add(pAssm, compareTable[entry].set, "al", NULL);
+				instruction_add(pAssm, ASM_OP_MOV, target, "eax");
+				
+			}
+			
+			// Advance past the semicolon
+			advance(1);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_SELECT) {
+			
+			// Selects look like: select type variable , value : value compare [value] ; and only write the variable when the comparison holds
+			advance(2);
+			
+			char target[MAX_VALUE_LEN] = {};
+			strncpy(target, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
+			
+			// Advance past the variable and the comma
+			advance(2);
+			
+			char value[MAX_VALUE_LEN] = {};
+			operand_parse(pAssm, pIR, value);
+			
+			// Advance past the colon
+			advance(1);
+			
+			asm_compare compare = {};
+			compare_parse(pAssm, pIR, &compare);
+			
+			if (compare.constant > 0) {
+				
+				instruction_add(pAssm, ASM_OP_MOV, "eax", value);
+				instruction_add(pAssm, ASM_OP_MOV, target, "eax");
+				
+			} else if (compare.constant < 0) {
+				
+				instruction_add(pAssm, ASM_OP_MOV, "eax", target);
+				
+				// cmov can't take an immediate
+				if (operand_classify(value) == ASM_OPERAND_IMMEDIATE) {
+					instruction_add(pAssm, ASM_OP_MOV, "r10d", value);
+					strcpy(value, "r10d");
+				}
+				
+				size_t entry = compare_emit(pAssm, &compare, "r11d");
+				instruction_add(pAssm, compareTable[entry].move, "eax", value);
+				instruction_add(pAssm, ASM_OP_MOV, target, "eax");
+				
+			}
+			
+			// Advance past the semicolon
+			advance(1);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_SWITCH) {
+			
+			// Advance to the value
+			if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
+				advance(1);
+			else
+				advance(2);
+			
+			char value[MAX_VALUE_LEN] = {};
+			strncpy(value, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
+			char* fallback = upeek(2).value;
+			
+			// Advance past the value, the default label and the semicolon
+			advance(4);
+			
+			// Gather the cases; only a value that fits in the 32 bits being switched on can ever match
+			size_t count = 0;
+			while (peek(count * 5).type == UNIT_TYPE_KW_CASE) count++;
+			
+			switch_case* cases = calloc(count + 1, sizeof(switch_case));
+			if (!cases) {
+				advance(count * 5);
+				break;
+			}
+			
+			size_t kept = 0;
+			for (size_t i = 0; i < count; i++) {
 				
-				// Call the function
-				instruction_push(pAssm, "call %s\n", peek(1).value);
+				char* end = NULL;
+				int64_t literal = strtoll(peek(1).value, &end, 0);
+				if ((end != peek(1).value) && (*end == '\0') && (literal >= INT32_MIN) && (literal <= INT32_MAX))
+					cases[kept++] = (switch_case){ literal, upeek(3).value, i };
 				
-				// Advance
-				advance(1);
+				// Advance past the case, its value, the colon, its label and the semicolon
+				advance(5);
 				
-			} break;
+			}
+			
+			// Sort the cases, keeping only the first of any that are repeated
+			qsort(cases, kept, sizeof(switch_case), switch_compare);
+			size_t unique = 0;
+			for (size_t i = 0; i < kept; i++)
+				if ((unique == 0) || (cases[i].value != cases[unique - 1].value)) cases[unique++] = cases[i];
 			
-			case (UNIT_TYPE_LABEL) {
+			// A literal value always goes the same way
+			char* end = NULL;
+			int64_t literal = strtoll(value, &end, 0);
+			if ((end != value) && (*end == '\0')) {
 				
-				// Check if this is a jump or a declaration
-				if (peek(-1).type == UNIT_TYPE_KW_JUMP)
-					instruction_push(pAssm, "jmp %s\n", peek(0).value);
-				else
-					instruction_push(pAssm, "%s:\n", peek(0).value);
+				char* target = fallback;
+				for (size_t i = 0; i < unique; i++)
+					if (cases[i].value == literal) target = cases[i].label;
 				
-				// Advance past this and the semicolon
-				advance(2);
+				instruction_add(pAssm, ASM_OP_JMP, target, NULL);
 				
-			} break;
-			
-			case (UNIT_TYPE_KW_IF) {
+			} else {
 				
-				// Advance past this keyword
-				if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
-					advance(1);
-				else
-					advance(2);
+				// Only the low 32 bits are switched on
+				asm_operand_type kind = operand_classify(value);
+				if (kind == ASM_OPERAND_REGISTER)
+					strcpy(value, registerTable[register_find(value, strlen(value))].name32);
+				else if ((kind == ASM_OPERAND_MEMORY) && (strncmp(value, "qword", 5) == 0))
+					memcpy(value, "dword", 5);
 				
-				// Check if this is a zero comparison
-				if (peek(1).type == UNIT_TYPE_KW_CMP_Z) {
-					
-					// Emit the variable / register / literal; we need to move into a register because mem-to-mem ops aren't allowed on "test"
-					instruction_push(pAssm, "mov eax, %s\n", to_reg(pAssm, ppeek(0)));
-					
-					// Emit a comparison
-					instruction_push(pAssm, "test eax, eax\n");
-					
-					// Advance to the label
-					advance(3);
-					
-					// And perform the jump
-					instruction_push(pAssm, "jz %s\n", peek(0).value);
-					
-					// Advance past this and the semicolon
-					advance(2);
-					
-				} else {
+				instruction_add(pAssm, ASM_OP_MOV, "eax", value);
+				
+				size_t labels = 0;
+				switch_lower(pAssm, cases, unique, fallback, &labels);
+				
+			}
+			
+			free(cases);
+			
+		} break;
+		
+		// Variables!
+		case (UNIT_TYPE_KW_LOCAL) {
+			
+			// Add to the offset
+			pAssm->offset += to_size(ppeek(1));
+			
+			// Add this variable to the offset table
+			symbol* pSym = symbol_add(&pAssm->offsetTable, peek(2).value, SYMBOL_TYPE_VARIABLE, to_size(ppeek(1)), pAssm->offset, SYMBOL_CLASS_VARIABLE);
+			
+			// Advance past this, the size, and the semicolon
+			advance(3);
+			
+		} break;
+		
+		// Handle stack frame setup and destruction
+		case (UNIT_TYPE_KW_ALLOC) {
+			
+			// Create a new offset table for storing variable offsets
+			symbol_table_create(&pAssm->offsetTable);
+			pAssm->offset = 0;
+			
+			// Create the stack frame
+			instruction_add(pAssm, ASM_OP_PUSH, "rbp", NULL);
+			instruction_add(pAssm, ASM_OP_MOV, "rbp", "rsp");
+			
+			// Advance to the literal holding the stack allocation size
+			advance(1);
+			
+			// Subtract the stack pointer by X bytes, including 32 bytes of shadow space and room for arguments passed on the stack
+			instruction_add(pAssm, ASM_OP_SUB, "rsp", "32");
+			instruction_add(pAssm, ASM_OP_SUB, "rsp", peek(0).value);
+			
+			char outgoing[32] = {};
+			text_decimal(outgoing, pAssm->outgoing);
+			if (pAssm->outgoing) instruction_add(pAssm, ASM_OP_SUB, "rsp", outgoing);
+			
+			// Parameters that can't stay in their registers are stored in the space our caller left for them, if they are used at all
+			if (!pAssm->params.inRegisters) {
+				for (size_t i = 0; (i < pAssm->params.count) && (i < 4); i++) {
 					
+					if (!pAssm->params.referenced[i]) continue;
 					
+					instruction_add(pAssm, ASM_OP_MOV, to_slot(8, '+', 16 + (i * 8)), argRegisters[i].name64);
 					
 				}
-				
-			} break;
+			}
+			
+			// Advance past this and the semicolon
+			advance(2);
 			
-			// Variables!
-			case (UNIT_TYPE_KW_LOCAL) {
+		} break;
+		
+		case (UNIT_TYPE_KW_FREE) {
+			
+			// Destroy the offset table, as we're done with our variables
+			symbol_table_destroy(&pAssm->offsetTable);
+			
+			// Search backwards for our linked alloc unit and emit its stack size
+			int64_t index = 0;
+			int64_t depth = 0;
+			while ((pIR->index + index) > 0) {
 				
-				// Add to the offset
-				pAssm->offset += to_size(ppeek(1));
+				index--;
 				
-				// Add this variable to the offset table
-				symbol* pSym = symbol_add(&pAssm->offsetTable, peek(2).value, SYMBOL_TYPE_VARIABLE, to_size(ppeek(1)), pAssm->offset, SYMBOL_CLASS_VARIABLE);
+				if (peek(index).type == UNIT_TYPE_KW_FREE) depth++;
+				if (peek(index).type == UNIT_TYPE_KW_ALLOC) depth--;
 				
-				// Advance past this, the size, and the semicolon
-				advance(3);
+				if (depth < 0) break;
 				
-			} break;
+			}
 			
-			// Handle stack frame setup and destruction
-			case (UNIT_TYPE_KW_ALLOC) {
-				
-				// Create a new offset table for storing variable offsets
-				symbol_table_create(&pAssm->offsetTable);
-				pAssm->offset = 0;
-				
-				// Create the stack frame
-				instruction_push(pAssm, "push rbp\n");
-				instruction_push(pAssm, "mov rbp, rsp\n");
+			// Add back X bytes to the stack pointer, including the 32 bytes of shadow space and the arguments
+			instruction_add(pAssm, ASM_OP_ADD, "rsp", "32");
+			instruction_add(pAssm, ASM_OP_ADD, "rsp", peek(index + 1).value);
+			
+			char outgoing[32] = {};
+			text_decimal(outgoing, pAssm->outgoing);
+			if (pAssm->outgoing) instruction_add(pAssm, ASM_OP_ADD, "rsp", outgoing);
+			
+			// The parameters go with the frame
+			pAssm->params.count = 0;
+			pAssm->outgoing = 0;
+			
+			// Advance past this and the semicolon
+			advance(2);
+			
+		} break;
+		
+		// Functions are handled in bulk
+		case (UNIT_TYPE_KW_FUNC) {
+			
+			// If this is an import, it doesn't have a body
+			if (peek(-1).type == UNIT_TYPE_KW_IMPORT) {
 				
-				// Advance to the literal holding the stack allocation size
 				advance(1);
 				
-				// Subtract the stack pointer by X bytes, including 32 bytes of shadow space
-				instruction_push(pAssm, "sub rsp, 32 ; This should be optimized later to merge with below\n");
-				instruction_push(pAssm, "sub rsp, %s\n", peek(0).value);
+				break;
 				
-				// Advance past this and the semicolon
+			}
+			
+			// Advance past function keyword and the type
+			advance(2);
+			
+			// Windows expects 16-byte alignment, so emit that to comply
+			instruction_add(pAssm, ASM_OP_ALIGN, "16", NULL);
+			
+			// Push the identifier
+			instruction_add(pAssm, ASM_OP_LABEL, peek(0).value, NULL);
+			
+			// Set the current function
+			pAssm->currentFunc = ppeek(0)->value;
+			
+			// Advance past the identifier
+			advance(1);
+			
+			// Work out where the parameters live and how much room the calls in the body need
+			function_scan(pAssm, pIR);
+			advance(1);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_MOVE) {
+			
+			// Runs of arithmetic go through the instruction selector
+			if (expr_select(pAssm, pIR)) break;
+			
+			// Advance past this keyword
+			if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
+				advance(1);
+			else
 				advance(2);
-				
-			} break;
 			
-			case (UNIT_TYPE_KW_FREE) {
-				
-				// Destroy the offset table, as we're done with our variables
-				symbol_table_destroy(&pAssm->offsetTable);
-				
-				// Search backwards for our linked alloc unit and emit its stack size
-				int64_t index = 0;
-				int64_t depth = 0;
-				while ((pIR->index + index) > 0) {
-					
-					index--;
-					
-					if (peek(index).type == UNIT_TYPE_KW_FREE) depth++;
-					if (peek(index).type == UNIT_TYPE_KW_ALLOC) depth--;
-					
-					if (depth < 0) break;
-					
-				}
-				
-				// Add back X bytes to the stack pointer, including the 32 bytes of shadow space
-				instruction_push(pAssm, "add rsp, 32 ; Same thing\n");
-				instruction_push(pAssm, "add rsp, %s\n", peek(index + 1).value);
-				
-				// Advance past this and the semicolon
+			// Hold the first register
+			char first[MAX_VALUE_LEN] = {};
+			strncpy(first, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
+			
+			// Advance past the comma
+			advance(1);
+			
+			// Advance past this keyword
+			if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
+				advance(1);
+			else
 				advance(2);
-				
-			} break;
 			
-			// Functions are handled in bulk
-			case (UNIT_TYPE_KW_FUNC) {
-				
-				// If this is an import, it doesn't have a body
-				if (peek(-1).type == UNIT_TYPE_KW_IMPORT) {
-					
-					advance(1);
-					
-					break;
-					
-				}
-				
-				// Advance past function keyword and the type
+			// Push the move with the second register or literal
+			instruction_add(pAssm, ASM_OP_MOV, first, to_reg(pAssm, ppeek(0)));
+			
+			// Advance past this second register or literal and the semicolon
+			advance(2);
+			
+		} break;
+		
+		// Arithmetic
+		case (UNIT_TYPE_KW_ADD)
+		case (UNIT_TYPE_KW_SUB) {
+			
+			// Hold this operation
+			asm_op op = to_arith(ppeek(0));
+			
+			// Advance past this keyword and the type of the register
+			if (peek(1).type == UNIT_TYPE_IDENTIFIER)
+				advance(1);
+			else
 				advance(2);
+			
+			// Hold the first register
+			char first[MAX_VALUE_LEN] = {};
+			strncpy(first, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
+			
+			// Advance past the register and the comma
+			advance(2);
+			
+			// Push the operation with the second register or literal
+			instruction_add(pAssm, op, first, to_reg(pAssm, ppeek(0)));
+			
+			// Advance past this second register or literal and the semicolon
+			advance(2);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_MUL) {
+			
+			// Depending on the type, we need to handle some special x86 quirks
+			if (unit_isUnsigned(peek(1).type)) {
 				
-				// Windows expects 16-byte alignment, so emit that to comply
-				instruction_push(pAssm, "align 16\n");
+				// Hold the register we're pulling from to move back into later
+				char* reg = to_reg(pAssm, ppeek(0));
 				
-				// Push the identifier
-				instruction_push(pAssm, "%s:\n", peek(0).value);
+				// We need to load the multiplicand into the accumulator register
+				instruction_add(pAssm, ASM_OP_MOV, "eax", to_reg(pAssm, ppeek(0)));
 				
-				// Set the current function
-				pAssm->currentFunc = peek(0).value;
+				// Advance past the register, comma, and the type
+				advance(3);
 				
-				// Advance past the identifier
-				advance(1);
+				// Multiply the multiplier on the accumulator register
+				instruction_add(pAssm, ASM_OP_MUL, to_reg(pAssm, ppeek(0)), NULL);
 				
-				// For the time being, skip all function parameters
-				while (peek(0).type != UNIT_TYPE_PT_SEMICOLON) advance(1);
-				advance(1);
+				// Move this back into the register we pulled from
+				instruction_add(pAssm, ASM_OP_MOV, reg, "eax");
 				
-			} break;
-			
-			case (UNIT_TYPE_KW_MOVE) {
+				// Advance past this second register or literal and the semicolon
+				advance(2);
 				
-				instruction_push(pAssm, "mov ");
+			} else {
+				
+				// There are no quirks for signed division
 				
 				// Advance past this keyword
 				if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
@@ -591,8 +3354,9 @@ static void instruction_parse(assm* pAssm, ir* pIR) {
 				else
 					advance(2);
 				
-				// Push the first register
-				instruction_push(pAssm, "%s, ", to_reg(pAssm, ppeek(0)));
+				// Hold the first register
+				char first[MAX_VALUE_LEN] = {};
+				strncpy(first, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
 				
 				// Advance past the comma
 				advance(1);
@@ -603,223 +3367,92 @@ static void instruction_parse(assm* pAssm, ir* pIR) {
 				else
 					advance(2);
 				
-				// Push the second register or literal
-				instruction_push(pAssm, "%s\n", to_reg(pAssm, ppeek(0)));
+				// Push the multiplication with the second register or literal
+				instruction_add(pAssm, ASM_OP_IMUL, first, to_reg(pAssm, ppeek(0)));
 				
 				// Advance past this second register or literal and the semicolon
 				advance(2);
 				
-			} break;
+			}
 			
-			// Arithmetic
-			case (UNIT_TYPE_KW_ADD)
-			case (UNIT_TYPE_KW_SUB) {
-				
-				// Emit this operation
-				instruction_push(pAssm, "%s ", to_arith(ppeek(0)));
-				
-				// Advance past this keyword and the type of the register
-				if (peek(1).type == UNIT_TYPE_IDENTIFIER)
-					advance(1);
-				else
-					advance(2);
-				
-				// Push the first register
-				instruction_push(pAssm, "%s, ", to_reg(pAssm, ppeek(0)));
-				
-				// Advance past the register and the comma
-				advance(2);
-				
-				// Push the second register or literal
-				instruction_push(pAssm, "%s\n", to_reg(pAssm, ppeek(0)));
-				
-				// Advance past this second register or literal and the semicolon
+		} break;
+		
+		case (UNIT_TYPE_KW_DIV)
+		case (UNIT_TYPE_KW_MOD) {
+			
+			bool remainder = (peek(0).type == UNIT_TYPE_KW_MOD);
+			bool isUnsigned = unit_isUnsigned(peek(1).type);
+			
+			// Divisions look like: div type register , value ;
+			if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
+				advance(1);
+			else
 				advance(2);
-				
-			} break;
 			
-			case (UNIT_TYPE_KW_MUL) {
-				
-				// Depending on the type, we need to handle some special x86 quirks
-				if (unit_isUnsigned(peek(1).type)) {
-					
-					// Hold the register we're pulling from to move back into later
-					char* reg = to_reg(pAssm, ppeek(0));
-					
-					// We need to load the multiplicand into the accumulator register
-					instruction_push(pAssm, "mov eax, %s\n", to_reg(pAssm, ppeek(0)));
-					
-					// Advance past the register, comma, and the type
-					advance(3);
-					
-					// Multiply the multiplier on the accumulator register
-					instruction_push(pAssm, "mul %s\n", to_reg(pAssm, ppeek(0)));
-					
-					// Move this back into the register we pulled from
-					instruction_push(pAssm, "mov %s, eax\n", reg);
-					
-					// Advance past this second register or literal and the semicolon
-					advance(2);
-					
-				} else {
-					
-					// There are no quirks for signed division
-					
-					instruction_push(pAssm, "imul ");
-					
-					// Advance past this keyword
-					if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
-						advance(1);
-					else
-						advance(2);
-					
-					// Push the first register
-					instruction_push(pAssm, "%s, ", to_reg(pAssm, ppeek(0)));
-					
-					// Advance past the comma
-					advance(1);
-					
-					// Advance past this keyword
-					if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
-						advance(1);
-					else
-						advance(2);
-					
-					// Push the second register or literal
-					instruction_push(pAssm, "%s\n", to_reg(pAssm, ppeek(0)));
-					
-					// Advance past this second register or literal and the semicolon
-					advance(2);
-					
-				}
-				
-			} break;
+			char target[MAX_VALUE_LEN] = {};
+			strncpy(target, to_reg(pAssm, ppeek(0)), MAX_VALUE_LEN - 1);
 			
-			case (UNIT_TYPE_KW_DIV) {
-				
-				// Division is extremely weird; the dividend is in the accumulator, and the quotient ends up in the accumulator...
-				// Yeah, strange. Oh, and you have to sign extend the register with cdq or zero it out depending if it's signed or unsigned.
-				
-				// Depending on the type, we need to handle some special x86 quirks
-				if (unit_isUnsigned(peek(1).type)) {
-					
-					// Advance past the type
-					advance(1);
-					
-					// Hold the register we're pulling from to move back into later
-					char* reg = to_reg(pAssm, ppeek(0));
-					
-					// We need to load the dividend into the accumulator register
-					instruction_push(pAssm, "mov eax, %s\n", to_reg(pAssm, ppeek(0)));
-					
-					// Advance past the register, comma, and the type
-					advance(3);
-					
-					// Move the divisor into the counter, since you can't divide by literals for some reason...
-					instruction_push(pAssm, "mov ecx, %s\n", to_reg(pAssm, ppeek(0)));
-					
-					// Zero out the upper bits of edx
-					instruction_push(pAssm, "xor edx, edx\n");
-					
-					// Divide the accumulator by the divisor
-					instruction_push(pAssm, "div ecx\n");
-					
-					// Move this back into the register we pulled from
-					instruction_push(pAssm, "mov %s, eax\n", reg);
-					
-					// Advance past this second register or literal and the semicolon
-					advance(2);
-					
-				} else {
-					
-					// Advance past this keyword
-					if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
-						advance(1);
-					else
-						advance(2);
-					
-					// Hold the register we're pulling from to move back into later
-					char* reg = to_reg(pAssm, ppeek(0));
-					
-					// Save rcx and rdx to the shadow space since they are function arguments
-					// eax is non-volatile in this implementation, so no concerns with preserving it
-					instruction_push(pAssm, "mov qword [rsp+0], rcx\n");
-					instruction_push(pAssm, "mov qword [rsp+8], rdx\n");
-					
-					// We need to load the dividend into eax
-					instruction_push(pAssm, "mov eax, %s\n", reg);
-					
-					// Advance past the comma
-					advance(1);
-					
-					// Advance past this keyword
-					if ((peek(1).type == UNIT_TYPE_IDENTIFIER) || (peek(1).type == UNIT_TYPE_LITERAL))
-						advance(1);
-					else
-						advance(2);
-					
-					// Sign extend
-					instruction_push(pAssm, "cdq\n");
-					
-					// Move the divisor into edx
-					instruction_push(pAssm, "mov ecx, %s\n", to_reg(pAssm, ppeek(0)));
-					
-					// Divide the accumulator by the register or literal
-					instruction_push(pAssm, "idiv ecx\n");
-					
-					// Move the quotient back into the register
-					instruction_push(pAssm, "mov %s, eax\n", reg);
-					
-					// Restore rdx and rcx
-					instruction_push(pAssm, "mov rcx, qword [rsp+0]\n");
-					instruction_push(pAssm, "mov rdx, qword [rsp+8]\n");
-					
-					// Advance past this second register or literal and the semicolon
-					advance(2);
-					
-				}
-				
-			} break;
+			// Advance past the register and the comma
+			advance(2);
 			
-			case (UNIT_TYPE_KW_INC) {
-				
-				// Advance to the register or identifier
-				if (peek(1).type == UNIT_TYPE_IDENTIFIER)
-					advance(1);
-				else
-					advance(2);
-				
-				// Push the variable or register
-				instruction_push(pAssm, "inc %s\n", to_reg(pAssm, ppeek(0)));
-				
-				// Advance past this and the semicolon
-				advance(2);
-				
-			} break;
+			char divisor[MAX_VALUE_LEN] = {};
+			operand_parse(pAssm, pIR, divisor);
 			
-			case (UNIT_TYPE_KW_DEC) {
-				
-				// Advance to the register or identifier
-				if (peek(1).type == UNIT_TYPE_IDENTIFIER)
-					advance(1);
-				else
-					advance(2);
-				
-				// Push the variable or register
-				instruction_push(pAssm, "dec %s\n", to_reg(pAssm, ppeek(0)));
-				
-				// Advance past this and the semicolon
+			// Advance past the semicolon
+			advance(1);
+			
+			// A literal divisor is multiplied by instead; anything else, including zero, is left to the hardware
+			asm_operand operand = { operand_classify(target) };
+			strcpy(operand.value, target);
+			
+			int64_t value = 0;
+			bool constant = (compare_literal(divisor, &value)) && (value != 0) && (operand_is32(&operand));
+			
+			// Only signed division is multiplied by, as the frontend has no unsigned types to divide yet
+			if ((constant) && (!isUnsigned) && (value > INT32_MIN) && (value <= INT32_MAX))
+				divide_signed(pAssm, &operand, (int32_t)value, remainder);
+			else
+				divide_hardware(pAssm, target, divisor, isUnsigned, remainder);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_INC) {
+			
+			// Advance to the register or identifier
+			if (peek(1).type == UNIT_TYPE_IDENTIFIER)
+				advance(1);
+			else
 				advance(2);
-				
-			} break;
 			
-			default: {
-				
+			// Push the variable or register
+			instruction_add(pAssm, ASM_OP_INC, to_reg(pAssm, ppeek(0)), NULL);
+			
+			// Advance past this and the semicolon
+			advance(2);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_DEC) {
+			
+			// Advance to the register or identifier
+			if (peek(1).type == UNIT_TYPE_IDENTIFIER)
 				advance(1);
-				
-			} break;
+			else
+				advance(2);
 			
-		}
+			// Push the variable or register
+			instruction_add(pAssm, ASM_OP_DEC, to_reg(pAssm, ppeek(0)), NULL);
+			
+			// Advance past this and the semicolon
+			advance(2);
+			
+		} break;
+		
+		default: {
+			
+			advance(1);
+			
+		} break;
 		
 	}
 	
@@ -829,68 +3462,110 @@ static void instruction_parse(assm* pAssm, ir* pIR) {
 
 void assm_print(assm* pAssm) {
 	
-	print_utf8(pAssm->buffer);
-	print_utf8("\n");
+	// Each chunk is handed over as it is, rather than being joined up first
+	for (asm_chunk* pChunk = pAssm->output.pFirst; pChunk; pChunk = pChunk->pNext) print_bytes(pChunk->buffer, pChunk->size);
+	
+}
+
+bool assm_write(assm* pAssm, char* fileName) {
+	
+	FILE* file = fopen(fileName, "wb");
+	if (file == NULL) return false;
+	
+	// The chunks go to the file one after the other, without being joined up first
+	bool succeeded = true;
+	for (asm_chunk* pChunk = pAssm->output.pFirst; pChunk; pChunk = pChunk->pNext) {
+		if (fwrite(pChunk->buffer, 1, pChunk->size, file) != pChunk->size) succeeded = false;
+	}
+	
+	if (fclose(file) != 0) succeeded = false;
+	
+	// Don't leave half a file behind for a build tool to pick up
+	if (!succeeded) remove(fileName);
+	
+	return succeeded;
 	
 }
 
 bool assm_generate(assm* pAssm, assm_info* pInfo) {
 	
-	// Allocate a buffer for the Assembly
-	if (assm_resize(pAssm, 0) == false) return false;
+	ir* pIR = pInfo->pIR;
 	
-	// Add new instructions until we reach the end of the unit stream
-	(pAssm->mode) = ASM_MODE_VISIBILITY;
-	(pInfo->pIR->index) = 0;
+	// Walk the unit stream once; the units each step passes over are also scanned for declarations and data
+	// Functions that were selected the same way last time are copied in whole instead
+	size_t scanned = 0;
+	(pIR->index) = 0;
 	while (1) {
-		if ((pAssm->size) >= pAssm->memSize)  if (!assm_resize(pAssm, 0)) return false;
-		instruction_parse(pAssm, pInfo->pIR);
-		if (pInfo->pIR->buffer[pInfo->pIR->index].type == UNIT_TYPE_KW_END) break;
-		if (pInfo->pIR->index > pInfo->pIR->size) break;
+		if (!function_reuse(pAssm, pIR, pInfo)) instruction_parse(pAssm, pIR);
+		for (; (scanned < pIR->index) && (scanned < pIR->size); scanned++) section_scan(pAssm, pIR, scanned);
+		function_record(pAssm, pIR);
+		if (pIR->buffer[pIR->index].type == UNIT_TYPE_KW_END) break;
+		if (pIR->index > pIR->size) break;
 	}
 	
 	// Push ExitProcess
 	if (pAssm->foundMain) {
-		instruction_push(pAssm, "extern ExitProcess\n");
-		instruction_push(pAssm, "global _main\n");
-	}
-	
-	// Emit the text section
-	instruction_push(pAssm, "section .data\n");
-	
-	// Add new instructions until we reach the end of the unit stream
-	(pAssm->mode) = ASM_MODE_LITERALS;
-	(pInfo->pIR->index) = 0;
-	while (1) {
-		if ((pAssm->size) >= pAssm->memSize)  if (!assm_resize(pAssm, 0)) return false;
-		instruction_parse(pAssm, pInfo->pIR);
-		if (pInfo->pIR->buffer[pInfo->pIR->index].type == UNIT_TYPE_KW_END) break;
-		if (pInfo->pIR->index > pInfo->pIR->size) break;
+		writer_string(&pAssm->directives, "extern ExitProcess\n");
+		writer_string(&pAssm->directives, "global _main\n");
 	}
 	
-	// Emit the text section
-	instruction_push(pAssm, "section .text\n");
+	// The sections are joined in order by linking their chunks together
+	writer_join(&pAssm->output, &pAssm->directives);
+	writer_string(&pAssm->output, "section .data\n");
+	data_render(&pAssm->output, &pAssm->data);
+	writer_string(&pAssm->output, "section .text\n");
 	
-	// Add new instructions until we reach the end of the unit stream
-	(pAssm->mode) = ASM_MODE_PARSE;
-	(pInfo->pIR->index) = 0;
-	while (1) {
-		if ((pAssm->size) >= pAssm->memSize)  if (!assm_resize(pAssm, 0)) return false;
-		instruction_parse(pAssm, pInfo->pIR);
-		if (pInfo->pIR->buffer[pInfo->pIR->index].type == UNIT_TYPE_KW_END) break;
-		if (pInfo->pIR->index > pInfo->pIR->size) break;
-	}
+	// Clean up the text section, work on the loops once their tests have been folded, clean up after that and write it out
+	text_optimize(pAssm);
+	text_loops(pAssm);
+	text_optimize(pAssm);
+	text_render(pAssm);
 	
 	// Push ExitProcess
 	if (pAssm->foundMain) {
-		instruction_push(pAssm, "_main:\n");
-		instruction_push(pAssm, "jmp main\n");
+		writer_string(&pAssm->output, "_main:\n");
+		writer_string(&pAssm->output, "jmp main\n");
 	}
 	
-	// Null terminate the string
-	pAssm->buffer[pAssm->size - 1] = '\0';
+	// Emit the jump tables; .rdata is the read only data section on Windows
+	if (pAssm->rodata.size) {
+		writer_string(&pAssm->output, "section .rdata\n");
+		data_render(&pAssm->output, &pAssm->rodata);
+	}
 	
-	// Return success
-	return true;
+	// Return success, unless a chunk could not be allocated along the way
+	return !pAssm->output.failed;
+	
+}
+
+void assm_destroy(assm* pAssm) {
+	
+	// Free memory
+	writer_destroy(&pAssm->output);
+	writer_destroy(&pAssm->directives);
+	free(pAssm->data.buffer);
+	free(pAssm->rodata.buffer);
+	free(pAssm->text.buffer);
+	assm_fragments_destroy(&pAssm->fragments);
+	pAssm->function.recording = false;
+	pAssm->data = (asm_section){};
+	pAssm->rodata = (asm_section){};
+	symbol_table_destroy(&pAssm->offsetTable);
+	symbol_table_destroy(&pAssm->staticTable);
+	pAssm->text.buffer = NULL;
+	pAssm->text.memSize = 0;
+	pAssm->text.size = 0;
+	pAssm->index = 0;
+	
+}
+
+void assm_fragments_destroy(asm_fragments* pFragments) {
+	
+	// Free memory
+	free(pFragments->buffer);
+	free(pFragments->units.buffer);
+	free(pFragments->text.buffer);
+	free(pFragments->rodata.buffer);
+	*pFragments = (asm_fragments){};
 	
 }
\ No newline at end of file
@@ -1,33 +1,226 @@
 #pragma once
 
+// [ MACROS ] //
+
+#define ASM_MAX_PARAMS 16
+#define ASM_CHUNK_SIZE 16384
+#define ASM_DATA_MAX_VALUES 3
+
 // [ DEFINING ] //
 
+typedef enum {
+	
+	ASM_OP_NONE,
+	
+	// Directives
+	ASM_OP_LABEL,
+	ASM_OP_ALIGN,
+	
+	// Data movement
+	ASM_OP_MOV,
+	ASM_OP_MOVSXD,
+	ASM_OP_LEA,
+	ASM_OP_PUSH,
+	ASM_OP_POP,
+	
+	// Arithmetic
+	ASM_OP_XOR,
+	ASM_OP_AND,
+	ASM_OP_ADD,
+	ASM_OP_SUB,
+	ASM_OP_SBB,
+	ASM_OP_NEG,
+	ASM_OP_SHR,
+	ASM_OP_SAR,
+	ASM_OP_INC,
+	ASM_OP_DEC,
+	ASM_OP_MUL,
+	ASM_OP_IMUL,
+	ASM_OP_DIV,
+	ASM_OP_IDIV,
+	ASM_OP_CDQ,
+	ASM_OP_TEST,
+	ASM_OP_CMP,
+	
+	// Conditional data movement
+	ASM_OP_SETZ,
+	ASM_OP_SETNZ,
+	ASM_OP_SETL,
+	ASM_OP_SETLE,
+	ASM_OP_SETG,
+	ASM_OP_SETGE,
+	ASM_OP_CMOVZ,
+	ASM_OP_CMOVNZ,
+	ASM_OP_CMOVL,
+	ASM_OP_CMOVLE,
+	ASM_OP_CMOVG,
+	ASM_OP_CMOVGE,
+	
+	// Control flow
+	ASM_OP_JMP,
+	ASM_OP_JZ,
+	ASM_OP_JNZ,
+	ASM_OP_JA,
+	ASM_OP_JL,
+	ASM_OP_JLE,
+	ASM_OP_JG,
+	ASM_OP_JGE,
+	ASM_OP_CALL,
+	ASM_OP_RET,
+	
+} asm_op;
+
+typedef enum {
+	ASM_OPERAND_NONE,
+	ASM_OPERAND_REGISTER,
+	ASM_OPERAND_MEMORY,
+	ASM_OPERAND_IMMEDIATE,
+	ASM_OPERAND_LABEL,
+} asm_operand_type;
+
 typedef struct {
-	ir* pIR;
-} assm_info;
+	asm_operand_type type;
+	char value[MAX_VALUE_LEN];
+} asm_operand;
+
+typedef struct {
+	asm_op op;
+	asm_operand operands[3];
+} instruction;
 
 typedef enum {
+	ASM_DATA_ALIGN,
+	ASM_DATA_LABEL,
+	ASM_DATA_STRING,
+	ASM_DATA_VALUES,
+} asm_data_kind;
+
+// Data is kept as entries until the end as well, so that it can be written out or laid out in memory
+typedef struct {
+	asm_data_kind kind;
+	size_t size; // The alignment, or how many bytes each value takes
+	char name[MAX_VALUE_LEN];
+	size_t count;
+	asm_operand values[ASM_DATA_MAX_VALUES];
+} asm_data;
+
+typedef struct {
+	size_t memSize;
+	size_t size;
+	asm_data* buffer;
+} asm_section;
+
+/*////////*/
+
+// A unit of a function, with the size of the static it names if it names one
+typedef struct {
+	unit unit;
+	size_t staticSize;
+} asm_fragment_unit;
+
+// The instructions a function was selected into and the jump tables it added, so the same units can be copied in next time
+typedef struct {
+	uint64_t hash;
+	size_t unitStart;
+	size_t unitSize;
+	size_t textStart;
+	size_t textSize;
+	size_t rodataStart;
+	size_t rodataSize;
+	size_t offset;
+} asm_fragment;
+
+// Each kind of entry is kept in one buffer for every fragment
+typedef struct {
+	size_t memSize;
+	size_t size;
+	asm_fragment* buffer;
+	size_t cursor; // Where the next function is looked for first, as they tend to come in the same order
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		asm_fragment_unit* buffer;
+	} units;
 	
-	ASM_MODE_VISIBILITY,
-	ASM_MODE_LITERALS,
-	ASM_MODE_PARSE,
+	struct {
+		size_t memSize;
+		size_t size;
+		instruction* buffer;
+	} text;
 	
-} assm_mode;
+	asm_section rodata;
+} asm_fragments;
 
 typedef struct {
-	size_t memSize;
+	ir* pIR;
+	bool incremental;
+	asm_fragments* pPrevious;
+} assm_info;
+
+/*////////*/
+
+// Written Assembly is kept in a list of fixed size chunks, so growing it never moves what is already there
+typedef struct asm_chunk {
+	struct asm_chunk* pNext;
 	size_t size;
+	char buffer[ASM_CHUNK_SIZE];
+} asm_chunk;
+
+typedef struct {
+	asm_chunk* pFirst;
+	asm_chunk* pLast;
+	bool failed;
+} asm_writer;
+
+/*////////*/
+
+typedef struct {
 	size_t index;
 	bool foundMain;
 	char* currentFunc;
 	char* stackSize;
-	assm_mode mode;
-	char* buffer;
+	asm_writer output;
 	symbol_table offsetTable;
+	symbol_table staticTable;
 	size_t offset;
+	
+	// The parameters of the current function; a function that makes no calls keeps the first four in the registers they came in
+	struct {
+		size_t count;
+		char* names[ASM_MAX_PARAMS];
+		unit_type types[ASM_MAX_PARAMS];
+		bool referenced[ASM_MAX_PARAMS];
+		bool inRegisters;
+	} params;
+	
+	// Bytes below the shadow space for the arguments of calls that don't fit in registers
+	size_t outgoing;
+	
+	// The text section is kept as instructions until it has been optimized
+	struct {
+		size_t memSize;
+		size_t size;
+		instruction* buffer;
+	} text;
+	
+	// Everything is generated in one walk, so each section collects its own entries and they are joined at the end
+	asm_writer directives;
+	asm_section data;
+	asm_section rodata;
+	
+	// What each function was selected into, and the one being selected now until the walk reaches its end
+	asm_fragments fragments;
+	struct {
+		bool recording;
+		size_t end;
+	} function;
 } assm;
 
 // [ FUNCTIONS ] //
 
 bool assm_generate(assm* pAsm, assm_info* pInfo);
-void assm_print(assm* pAsm);
\ No newline at end of file
+void assm_destroy(assm* pAsm);
+void assm_fragments_destroy(asm_fragments* pFragments);
+void assm_print(assm* pAsm);
+bool assm_write(assm* pAsm, char* fileName);
\ No newline at end of file
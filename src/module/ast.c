@@ -18,6 +18,12 @@
 #define upeek(x) (pStream->buffer[pStream->index + (x)])
 #define ppeek(x) ((pStream->index >= pStream->size + (x)) ? (token[]){(token){TOKEN_TYPE_EOF, ""}} : &(pStream->buffer[pStream->index + (x)]))
 
+// Every nested statement or expression costs a stack frame, so nesting is capped well before the stack runs out
+#define AST_MAX_DEPTH 512
+
+// Lists end at their closing token, or at the end of the stream if it never shows up
+#define until(x) ((peek(0).type != (x)) && (peek(0).type != TOKEN_TYPE_EOF))
+
 // #define panic(x) for (; (pStream->index < pStream->size) && (pStream->buffer[pStream->index].type != x); (pStream->index)++)
 
 #define panic(...) \
@@ -41,83 +47,58 @@
 static struct {
 	
 	bool inExpr;
+	token* pFirst;
 	
 } resolve;
 
+static struct {
+	
+	size_t depth;
+	
+} nesting;
+
 // [ FUNCTIONS ] //
 
 static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable, size_t* pScopeIndex);
 
 /*////////*/
 
-bool token_isKeyword(token_type tokenType) {
-	size_t index = 0;
-	while (token_kw_table[index].type != TOKEN_TYPE_UNDEFINED) {
-		if (token_kw_table[index].type == tokenType) return true;
-		index++;
-	}
-	return false;
-}
+uint8_t token_class_table[TOKEN_TYPE_COUNT] = {};
 
-bool token_isLiteral(token_type tokenType) {
-	switch (tokenType) {
-		case (TOKEN_TYPE_LITERAL_CHAR) return true;
-		case (TOKEN_TYPE_LITERAL_STR) return true;
-		case (TOKEN_TYPE_LITERAL_INT) return true;
-		case (TOKEN_TYPE_LITERAL_INT_HEX) return true;
-		case (TOKEN_TYPE_LITERAL_FLOAT) return true;
-		default: return false;
-	}
-}
-
-bool token_isIdentifier(token_type tokenType) {
-	
-	// Immediately return true for actual identifiers
-	if (tokenType == TOKEN_TYPE_IDENTIFIER) return true;
-	return false;
-	
-}
-
-bool token_isOperator(token_type tokenType) {
-	size_t index = 0;
-	while (token_op_table[index].type != TOKEN_TYPE_UNDEFINED) {
-		if (token_op_table[index].type == tokenType) return true;
-		index++;
-	}
-	return false;
-}
-
-bool token_isPunctuator(token_type tokenType) {
+static void token_class_mark(struct token_table* pTable, token_class class) {
 	size_t index = 0;
-	while (token_pt_table[index].type != TOKEN_TYPE_UNDEFINED) {
-		if (token_pt_table[index].type == tokenType) return true;
+	while (pTable[index].type != TOKEN_TYPE_UNDEFINED) {
+		token_class_table[pTable[index].type] |= class;
 		index++;
 	}
-	return false;
 }
 
-bool token_isTypeSpecifier(token_type tokenType) {
-	size_t index = 0;
-	while (token_sp_table[index].type != TOKEN_TYPE_UNDEFINED) {
-		if (token_sp_table[index].type == tokenType) return true;
-		index++;
-	}
-	return false;
-}
-
-bool token_isTypeQualifier(token_type tokenType) {
-	size_t index = 0;
-	while (token_qu_table[index].type != TOKEN_TYPE_UNDEFINED) {
-		if (token_qu_table[index].type == tokenType) return true;
-		index++;
-	}
-	return false;
+__attribute__((constructor)) static void token_class_build() {
+	
+	// Mark every token type found in the token tables
+	token_class_mark(token_kw_table, TOKEN_CLASS_KEYWORD);
+	token_class_mark(token_op_table, TOKEN_CLASS_OPERATOR);
+	token_class_mark(token_pt_table, TOKEN_CLASS_PUNCTUATOR);
+	token_class_mark(token_sp_table, TOKEN_CLASS_TYPE_SPECIFIER);
+	token_class_mark(token_qu_table, TOKEN_CLASS_TYPE_QUALIFIER);
+	
+	// Literals have no table of their own
+	token_class_table[TOKEN_TYPE_LITERAL_CHAR] |= TOKEN_CLASS_LITERAL;
+	token_class_table[TOKEN_TYPE_LITERAL_STR] |= TOKEN_CLASS_LITERAL;
+	token_class_table[TOKEN_TYPE_LITERAL_INT] |= TOKEN_CLASS_LITERAL;
+	token_class_table[TOKEN_TYPE_LITERAL_INT_HEX] |= TOKEN_CLASS_LITERAL;
+	token_class_table[TOKEN_TYPE_LITERAL_FLOAT] |= TOKEN_CLASS_LITERAL;
+	
 }
 
 /*////////*/
 
 static void token_resolve(token* pToken, node* pParent, symbol_table* pSymbolTable) {
 	
+	// The first token of the stream has nothing before it to look at
+	static token none;
+	token* pPrevious = (pToken == resolve.pFirst) ? &none : &pToken[-1];
+	
 	if (pToken->type == TOKEN_TYPE_INVALID) {
 		
 		// Set beforehand
@@ -130,7 +111,7 @@ static void token_resolve(token* pToken, node* pParent, symbol_table* pSymbolTab
 		if (pToken[1].type == TOKEN_TYPE_PT_OPEN_PAREN) return;
 		
 		// If this follows a type specifier or a type qualifier, it is most likely a type
-		if (token_isTypeSpecifier(pToken[-1].type) || token_isTypeQualifier(pToken[-1].type)) return;
+		if (token_isTypeSpecifier(pPrevious->type) || token_isTypeQualifier(pPrevious->type)) return;
 		
 		if (pParent->type == NODE_TYPE_CONDITION) return;
 		
@@ -162,22 +143,22 @@ static void token_resolve(token* pToken, node* pParent, symbol_table* pSymbolTab
 		if (foundSymbol) return;
 		
 		// Check surrounding tokens to see if it's an identifier
-		foundSymbol = symbol_find(pSymbolTable, pToken[-1].value, SYMBOL_CLASS_TYPE);
+		foundSymbol = symbol_find(pSymbolTable, pPrevious->value, SYMBOL_CLASS_TYPE);
 		if (foundSymbol) return;
 		
-		if ((pToken[-1].type == TOKEN_TYPE_KW_MODULE) || (pToken[-1].type == TOKEN_TYPE_KW_HEADER)) return;
+		if ((pPrevious->type == TOKEN_TYPE_KW_MODULE) || (pPrevious->type == TOKEN_TYPE_KW_HEADER)) return;
 		
 		// If nothing was valid, return to the original value
 		pToken->type = TOKEN_TYPE_INVALID;
 		
 	} else if (pToken->type == TOKEN_TYPE_PT_AMPERSAND) {
-		printf("%d\n", resolve.inExpr);
+		print_utf8("%d\n", resolve.inExpr);
 		
-		if (token_isLiteral(pToken[-1].type) || token_isOperator(pToken[-1].type) || resolve.inExpr) {
+		if (token_isLiteral(pPrevious->type) || token_isOperator(pPrevious->type) || resolve.inExpr) {
 			
 			pToken->type = TOKEN_TYPE_OP_MUL;
 			
-		} else if (token_isIdentifier(pToken[-1].type) || (pToken[-1].type == TOKEN_TYPE_SP_PTR)) {
+		} else if (token_isIdentifier(pPrevious->type) || (pPrevious->type == TOKEN_TYPE_SP_PTR)) {
 			
 			pToken->type = TOKEN_TYPE_SP_PTR;
 			
@@ -208,87 +189,326 @@ static node* node_new(node_type type, node* parent) {
 	
 }
 
-static void node_delete(node* pNode) {
+static bool node_walk_resize(node_walk* pWalk) {
+	
+	// If the buffer can hold more elements, just return
+	if (pWalk->size < pWalk->memSize) return true;
+	
+	// If there is no buffer, allocate a new buffer
+	if (pWalk->memSize == 0) {
+		
+		// Set default buffer size
+		pWalk->memSize = 32;
+		pWalk->size = 0;
+		
+		// Allocate a new buffer
+		node_frame* newBuffer = calloc(pWalk->memSize, sizeof(node_frame));
+		if (!newBuffer) return false;
+		
+		// Assign the new buffer to the old one
+		pWalk->buffer = newBuffer;
+		
+		// Return success
+		return true;
+		
+	}
+	
+	// Allocate a new buffer
+	node_frame* newBuffer = calloc((pWalk->memSize * 2), sizeof(node_frame));
+	if (!newBuffer) return false;
+	
+	// Copy the new memory in and free the old buffer
+	memcpy(newBuffer, pWalk->buffer, (pWalk->memSize * sizeof(node_frame)));
+	free(pWalk->buffer);
+	
+	// Assign the new buffer to the old one
+	pWalk->memSize *= 2;
+	pWalk->buffer = newBuffer;
+	
+	// Return success
+	return true;
+	
+}
+
+static bool node_walk_push(node_walk* pWalk, node_id id) {
+	
+	// Resize if needed
+	if (!node_walk_resize(pWalk)) return false;
+	
+	// Add a new frame for this node; it has not been entered yet
+	node_frame* pFrame = &pWalk->buffer[pWalk->size];
+	pFrame->id = id;
+	pFrame->depth = pWalk->size;
+	pFrame->entered = false;
+	pFrame->state = 0;
+	(pWalk->size)++;
+	
+	// Return success
+	return true;
+	
+}
+
+bool node_walk_tree(node_pool* pPool, node_id root, node_enter enter, node_leave leave, void* pData) {
+	
+	if (root >= pPool->size) return true;
 	
-	// Check if the node has children
-	if (pNode->firstChild) {
-		node_delete(pNode->firstChild);
+	// The explicit stack holds the path from the root to the current node, so the C stack stays flat however deep the tree is
+	node_walk walk = {};
+	if (!node_walk_push(&walk, root)) return false;
+	
+	while (walk.size > 0) {
+		
+		node_frame* pFrame = &walk.buffer[walk.size - 1];
+		
+		// Visit this node on the way down, and descend into its children if asked to
+		if (!pFrame->entered) {
+			
+			pFrame->entered = true;
+			
+			bool descend = (enter) ? enter(pFrame, pData) : true;
+			
+			if ((descend) && (pPool->firstChild[pFrame->id] != NODE_ID_NONE)) {
+				if (!node_walk_push(&walk, pPool->firstChild[pFrame->id])) {
+					free(walk.buffer);
+					return false;
+				}
+				continue;
+			}
+			
+		}
+		
+		// The root's siblings are not part of the walk
+		node_id nextNode = (walk.size > 1) ? pPool->nextSibling[pFrame->id] : NODE_ID_NONE;
+		
+		// Visit this node on the way up
+		if (leave) leave(pFrame, pData);
+		
+		// Pop this node and move across to its sibling
+		(walk.size)--;
+		
+		if (nextNode != NODE_ID_NONE) {
+			if (!node_walk_push(&walk, nextNode)) {
+				free(walk.buffer);
+				return false;
+			}
+		}
+		
 	}
 	
-	// Check if the node has siblings
-	if (pNode->nextSibling) {
-		node_delete(pNode->nextSibling);
+	// Free memory
+	free(walk.buffer);
+	
+	// Return success
+	return true;
+	
+}
+
+/*////////*/
+
+static bool node_each(node* pRoot, void (*visit)(node* pNode, void* pData), void* pData) {
+	
+	if (!pRoot) return true;
+	
+	// Nodes still to be visited; a node's child and sibling are taken before it is visited, so the visit may free it
+	size_t memSize = 0;
+	size_t size = 0;
+	node** buffer = NULL;
+	
+	if (!buffer_resize((void**)&buffer, &memSize, 1, sizeof(node*))) return false;
+	buffer[size++] = pRoot;
+	
+	while (size > 0) {
+		
+		node* pNode = buffer[--size];
+		
+		if (!buffer_resize((void**)&buffer, &memSize, size + 2, sizeof(node*))) {
+			free(buffer);
+			return false;
+		}
+		
+		// The root's siblings are not part of it
+		if ((pNode != pRoot) && (pNode->nextSibling)) buffer[size++] = pNode->nextSibling;
+		if (pNode->firstChild) buffer[size++] = pNode->firstChild;
+		
+		visit(pNode, pData);
+		
 	}
 	
-	// Free the node
+	// Free memory
+	free(buffer);
+	
+	// Return success
+	return true;
+	
+}
+
+static void node_delete_visit(node* pNode, void* pData) {
 	free(pNode);
+}
+
+static void node_delete(node* pNode) {
+	
+	// Free the node and everything under it
+	node_each(pNode, node_delete_visit, NULL);
+	
+}
+
+static void node_count_visit(node* pNode, void* pData) {
+	(*(size_t*)pData)++;
+}
+
+/*////////*/
+
+static void node_pool_destroy(node_pool* pPool) {
+	
+	// Every array lives in the block that starts at the token indices
+	free(pPool->tokenIndex);
+	*pPool = (node_pool){};
 	
 }
 
-static void node_print(node* pNode, unsigned int depth) {
+static bool node_pool_create(node_pool* pPool, node* pRoot, stream* pStream) {
+	
+	*pPool = (node_pool){};
+	pPool->tokenBase = pStream->buffer;
+	if (!pRoot) return true;
+	
+	// Count the nodes first so every array is allocated exactly once
+	size_t count = 0;
+	if (!node_each(pRoot, node_count_visit, &count)) return false;
+	if ((count >= NODE_ID_NONE) || (pStream->size >= UINT32_MAX)) return false;
+	
+	// Allocate one block for all of the arrays, widest elements first
+	uint32_t* newBuffer = malloc(count * ((sizeof(uint32_t) * 6) + sizeof(uint8_t)));
+	if (!newBuffer) return false;
+	
+	pPool->tokenIndex = newBuffer;
+	pPool->tokenCount = pPool->tokenIndex + count;
+	pPool->scopeIndex = pPool->tokenCount + count;
+	pPool->parent = pPool->scopeIndex + count;
+	pPool->firstChild = pPool->parent + count;
+	pPool->nextSibling = pPool->firstChild + count;
+	pPool->type = (uint8_t*)(pPool->nextSibling + count);
+	
+	// Nodes still to be numbered, with the nodes they are linked to
+	size_t memSize = 0;
+	size_t size = 0;
+	node_pending* buffer = NULL;
+	
+	if (!buffer_resize((void**)&buffer, &memSize, 1, sizeof(node_pending))) {
+		node_pool_destroy(pPool);
+		return false;
+	}
+	buffer[size++] = (node_pending){ pRoot, NODE_ID_NONE, NODE_ID_NONE };
+	
+	while (size > 0) {
+		
+		node_pending pending = buffer[--size];
+		node* pNode = pending.pNode;
+		
+		node_id id = (node_id)(pPool->size)++;
+		pPool->type[id] = (uint8_t)pNode->type;
+		pPool->scopeIndex[id] = (uint32_t)pNode->scopeIndex;
+		pPool->tokenCount[id] = (uint32_t)pNode->tokenCount;
+		
+		// Tokens are kept as where they are in the stream; a node with none of its own in it gets the end of the file, which the stream finishes with
+		bool inside = (pNode->tokenList >= pStream->buffer) && (pNode->tokenList < pStream->buffer + pStream->size);
+		pPool->tokenIndex[id] = (inside) ? (uint32_t)(pNode->tokenList - pStream->buffer) : (uint32_t)pStream->size;
+		
+		// Link the node to the one before it, or to its parent if it is the first child
+		pPool->parent[id] = pending.parent;
+		pPool->firstChild[id] = NODE_ID_NONE;
+		pPool->nextSibling[id] = NODE_ID_NONE;
+		if (pending.previous != NODE_ID_NONE) pPool->nextSibling[pending.previous] = id;
+		else if (pending.parent != NODE_ID_NONE) pPool->firstChild[pending.parent] = id;
+		
+		if (!buffer_resize((void**)&buffer, &memSize, size + 2, sizeof(node_pending))) {
+			free(buffer);
+			node_pool_destroy(pPool);
+			return false;
+		}
+		
+		// The first child is pushed last so it is numbered next, and the sibling only once the whole subtree has been
+		if ((pNode != pRoot) && (pNode->nextSibling)) buffer[size++] = (node_pending){ pNode->nextSibling, pending.parent, id };
+		if (pNode->firstChild) buffer[size++] = (node_pending){ pNode->firstChild, id, NODE_ID_NONE };
+		
+	}
+	
+	// Free memory
+	free(buffer);
+	
+	// Return success
+	return true;
+	
+}
+
+static bool node_print_enter(node_frame* pFrame, void* pData) {
+	
+	node_pool* pPool = pData;
+	node_id id = pFrame->id;
+	size_t depth = pFrame->depth;
 	
 	if (depth > 0) {
-		node* currentNode = pNode;
-		int currentDepth = depth - 1;
+		node_id currentId = id;
+		int64_t currentDepth = depth - 1;
 		unsigned short treeGraph[depth + 1] = {};
 		treeGraph[depth] = L'\0';
-		while ((currentNode->parent) && (currentDepth >= 0)) {
+		while ((pPool->parent[currentId] != NODE_ID_NONE) && (currentDepth >= 0)) {
 			if (currentDepth == (depth - 1)) {
-				if (currentNode->nextSibling) {
+				if (pPool->nextSibling[currentId] != NODE_ID_NONE) {
 					treeGraph[currentDepth] = L'├';
 				} else {
 					treeGraph[currentDepth] = L'└';
 				}
 			} else {
-				if (currentNode->nextSibling) {
+				if (pPool->nextSibling[currentId] != NODE_ID_NONE) {
 					treeGraph[currentDepth] = L'│';
 				} else {
 					treeGraph[currentDepth] = L' ';
 				}
 			}
-			currentNode = currentNode->parent;
+			currentId = pPool->parent[currentId];
 			currentDepth--;
 		}
 		print_utf16(treeGraph);
 	}
 	
+	node_type type = (node_type)pPool->type[id];
 	print_utf8("%s ",
-		(pNode->type == NODE_TYPE_FILE) ? "FILE" :
-		(pNode->type == NODE_TYPE_INVALID) ? "INVALID" :
-		(pNode->type == NODE_TYPE_UNDEFINED) ? "UNDEFINED" :
-		(pNode->type == NODE_TYPE_IDENTIFIER) ? "IDENTIFIER" :
-		(pNode->type == NODE_TYPE_LITERAL) ? "LITERAL" :
-		(pNode->type == NODE_TYPE_DECL_FUNCTION) ? "DECL_FUNC" :
-		(pNode->type == NODE_TYPE_DECL_VARIABLE) ? "DECL_VAR" :
-		(pNode->type == NODE_TYPE_DECL_PARAMETER) ? "DECL_PARAM" :
-		(pNode->type == NODE_TYPE_SCOPE) ? "SCOPE" :
-		(pNode->type == NODE_TYPE_CONDITION) ? "CONDITION" :
-		(pNode->type == NODE_TYPE_CONDITION_ELSE) ? "CONDITION_ELSE" :
-		(pNode->type == NODE_TYPE_OPERATION) ? "OPERATION" :
-		(pNode->type == NODE_TYPE_STATEMENT) ? "STATEMENT" :
-		(pNode->type == NODE_TYPE_EXPRESSION) ? "EXPRESSION" :
-		(pNode->type == NODE_TYPE_CALL_FUNCTION) ? "CALL_FUNC" :
+		(type == NODE_TYPE_FILE) ? "FILE" :
+		(type == NODE_TYPE_INVALID) ? "INVALID" :
+		(type == NODE_TYPE_UNDEFINED) ? "UNDEFINED" :
+		(type == NODE_TYPE_IDENTIFIER) ? "IDENTIFIER" :
+		(type == NODE_TYPE_LITERAL) ? "LITERAL" :
+		(type == NODE_TYPE_DECL_FUNCTION) ? "DECL_FUNC" :
+		(type == NODE_TYPE_DECL_VARIABLE) ? "DECL_VAR" :
+		(type == NODE_TYPE_DECL_PARAMETER) ? "DECL_PARAM" :
+		(type == NODE_TYPE_SCOPE) ? "SCOPE" :
+		(type == NODE_TYPE_CONDITION) ? "CONDITION" :
+		(type == NODE_TYPE_CONDITION_ELSE) ? "CONDITION_ELSE" :
+		(type == NODE_TYPE_OPERATION) ? "OPERATION" :
+		(type == NODE_TYPE_STATEMENT) ? "STATEMENT" :
+		(type == NODE_TYPE_EXPRESSION) ? "EXPRESSION" :
+		(type == NODE_TYPE_CALL_FUNCTION) ? "CALL_FUNC" :
+		(type == NODE_TYPE_REFLECT) ? "REFLECT" :
 		"EOF"
 	);
 	
-	if (pNode->tokenCount > 0) {
+	uint32_t tokenCount = pPool->tokenCount[id];
+	if (tokenCount > 0) {
+		token* tokenList = node_tokens(pPool, id);
 		print_utf8("[");
-		for (size_t i = 0; i < pNode->tokenCount; i++) {
-			print_utf8("%s", pNode->tokenList[i].value);
-			if (i < pNode->tokenCount - 1) print_utf8(" ");
+		for (uint32_t i = 0; i < tokenCount; i++) {
+			print_utf8("%s", tokenList[i].value);
+			if (i < tokenCount - 1) print_utf8(" ");
 		}
 		print_utf8("]");
 	}
 	
 	print_utf8("\n");
 	
-	if (pNode->firstChild) {
-		node_print(pNode->firstChild, depth + 1);
-	}
-	
-	if (pNode->nextSibling) {
-		node_print(pNode->nextSibling, depth);
-	}
+	// Always print the children
+	return true;
 	
 }
 
@@ -372,7 +592,41 @@ static void expr_parse_merge_bi(node** nodeList, bool* nodeConsumed, size_t i) {
 	
 }
 
-static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable) {
+static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable);
+
+static void expr_parse_arguments(stream* pStream, node* pCall, symbol_table* pSymbolTable, error_table* pErrorTable) {
+	
+	// Every argument is an expression of its own, ending on a comma or on the closing paren
+	node* lastNode = NULL;
+	while (until(TOKEN_TYPE_PT_CLOSE_PAREN)) {
+		
+		node* argNode = expr_parse(pStream, pCall, pSymbolTable, pErrorTable);
+		if (!argNode) {
+			error_table_push(pErrorTable, ERROR_SYNTACTIC_EXPECTED_IDENTIFIER, pCall);
+			while (until(TOKEN_TYPE_PT_CLOSE_PAREN) && (peek(0).type != TOKEN_TYPE_PT_SEMICOLON)) advance(1);
+			return;
+		}
+		
+		if (lastNode)
+			lastNode->nextSibling = argNode;
+		else
+			pCall->firstChild = argNode;
+		lastNode = argNode;
+		
+		// We expect a comma between arguments; in the case there isn't one, push an error
+		if (peek(0).type == TOKEN_TYPE_PT_COMMA) {
+			advance(1);
+		} else if (peek(0).type != TOKEN_TYPE_PT_CLOSE_PAREN) {
+			error_table_push(pErrorTable, ERROR_SYNTACTIC_MISSING_COMMA, pCall);
+			while (until(TOKEN_TYPE_PT_CLOSE_PAREN) && (peek(0).type != TOKEN_TYPE_PT_SEMICOLON)) advance(1);
+			return;
+		}
+		
+	}
+	
+}
+
+static node* expr_parse_body(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable) {
 	
 	// Mark that we're in an expression
 	resolve.inExpr = true;
@@ -383,7 +637,7 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 	// Get the range of the expression
 	size_t range = 0;
 	int64_t currentDepth = 0;
-	while (token_isOperator(peek(range).type) || token_isLiteral(peek(range).type) || token_isIdentifier(peek(range).type) || (peek(range).type == TOKEN_TYPE_PT_OPEN_PAREN) || (peek(range).type == TOKEN_TYPE_PT_CLOSE_PAREN)) {
+	while (token_isOperator(peek(range).type) || token_isLiteral(peek(range).type) || token_isIdentifier(peek(range).type) || (peek(range).type == TOKEN_TYPE_KW_REFLECT) || (peek(range).type == TOKEN_TYPE_PT_OPEN_PAREN) || (peek(range).type == TOKEN_TYPE_PT_CLOSE_PAREN) || ((peek(range).type == TOKEN_TYPE_PT_COMMA) && (currentDepth > 0))) {
 		
 		if (peek(range).type == TOKEN_TYPE_PT_OPEN_PAREN) {
 			currentDepth++;
@@ -402,7 +656,13 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 		
 	}
 	
-	for (size_t i = 0; i < range; i++) printf("%s ", peek(i).value);
+	// There has to be something to parse
+	if (range == 0) {
+		resolve.inExpr = false;
+		return NULL;
+	}
+	
+	for (size_t i = 0; i < range; i++) print_utf8("%s ", peek(i).value);
 	print_utf8("\n");
 	
 	// Placeholder open and close paren operators
@@ -455,7 +715,54 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 	size_t startIndex = (pStream->index);
 	for (size_t i = 0; i < range; i++) {
 		
-		if (nodeList[i] == openParen) {
+		// Reflect takes a type rather than an expression: reflect ( name * ... )
+		if ((nodeList[i] == openParen) && (i > 0) && (peek(i - 1).type == TOKEN_TYPE_KW_REFLECT) && (nodeList[i - 1]->tokenList == ppeek(i - 1))) {
+			
+			node* reflectNode = nodeList[i - 1];
+			reflectNode->type = NODE_TYPE_REFLECT;
+			
+			// The node holds the type's tokens, which have to be a type name and its pointer levels
+			size_t close = i + 1;
+			while ((close < range) && (peek(close).type != TOKEN_TYPE_PT_CLOSE_PAREN)) close++;
+			
+			reflectNode->tokenList = ppeek(i + 1);
+			reflectNode->tokenCount = close - (i + 1);
+			
+			bool valid = (reflectNode->tokenCount > 0) && (token_isIdentifier(peek(i + 1).type)) && (symbol_find(pSymbolTable, peek(i + 1).value, SYMBOL_CLASS_TYPE));
+			for (size_t j = i + 2; j < close; j++) if (peek(j).type != TOKEN_TYPE_OP_MUL) valid = false;
+			
+			if (close >= range) {
+				error_table_push(pErrorTable, ERROR_SYNTACTIC_MISSING_PAREN, reflectNode);
+				reflectNode->tokenCount = 0;
+			} else if (!valid) {
+				error_table_push(pErrorTable, ERROR_SYNTACTIC_EXPECTED_TYPE, reflectNode);
+			}
+			
+			// The reflection takes the place of the keyword and everything up to the closing paren
+			for (size_t j = i - 1; (j <= close) && (j < range); j++) {
+				nodeList[j] = reflectNode;
+				nodeConsumed[j] = true;
+			}
+			
+		} else if ((nodeList[i] == openParen) && (i > 0) && (token_isIdentifier(peek(i - 1).type)) && (nodeList[i - 1]->tokenList == ppeek(i - 1))) {
+			
+			node* callNode = nodeList[i - 1];
+			callNode->type = NODE_TYPE_CALL_FUNCTION;
+			
+			// Parse the arguments, which leaves us on the closing paren
+			advance(i + 1);
+			expr_parse_arguments(pStream, callNode, pSymbolTable, pErrorTable);
+			
+			// The call takes the place of its name and everything up to the closing paren
+			size_t callRange = (pStream->index + 1) - (startIndex + i - 1);
+			for (size_t j = i - 1; (j < i - 1 + callRange) && (j < range); j++) {
+				nodeList[j] = callNode;
+				nodeConsumed[j] = true;
+			}
+			
+			jump(startIndex);
+			
+		} else if (nodeList[i] == openParen) {
 			
 			// Jump to the start of the expression
 			advance(i + 1);
@@ -532,7 +839,7 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 			
 		}
 		
-		// Evaluate binary multiplication and division
+		// Evaluate binary multiplication, division and modulo
 		currentDepth = 0;
 		for (size_t i = 0; i < range; i++) {
 			
@@ -541,7 +848,7 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 			else if (nodeList[i] == closeParen)
 				currentDepth--;
 			
-			if ((nodeList[i]->tokenList->type == TOKEN_TYPE_OP_MUL) || (nodeList[i]->tokenList->type == TOKEN_TYPE_OP_DIV)) {
+			if ((nodeList[i]->tokenList->type == TOKEN_TYPE_OP_MUL) || (nodeList[i]->tokenList->type == TOKEN_TYPE_OP_DIV) || (nodeList[i]->tokenList->type == TOKEN_TYPE_OP_MOD)) {
 				if ((nodeList[i]->type == NODE_TYPE_OPERATION) && (!nodeConsumed[i]) && (currentDepth == 0)) {
 					
 					// Merge the operands into the operator
@@ -586,6 +893,52 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 		
 		merged = false;
 		
+		// Evaluate relational comparisons
+		currentDepth = 0;
+		for (size_t i = 0; i < range; i++) {
+			
+			if (nodeList[i] == openParen)
+				currentDepth++;
+			else if (nodeList[i] == closeParen)
+				currentDepth--;
+			
+			if ((nodeList[i]->tokenList->type == TOKEN_TYPE_OP_CMP_LESS) || (nodeList[i]->tokenList->type == TOKEN_TYPE_OP_CMP_LESS_EQUAL) || (nodeList[i]->tokenList->type == TOKEN_TYPE_OP_CMP_GREATER) || (nodeList[i]->tokenList->type == TOKEN_TYPE_OP_CMP_GREATER_EQUAL)) {
+				if ((nodeList[i]->type == NODE_TYPE_OPERATION) && (!nodeConsumed[i]) && (currentDepth == 0)) {
+					
+					// Merge the operands into the operator
+					expr_parse_merge_bi(nodeList, nodeConsumed, i);
+					
+					// Note that a merge occurred
+					merged = true;
+					
+				}
+			}
+			
+		}
+		
+		// Evaluate equality comparisons
+		currentDepth = 0;
+		for (size_t i = 0; i < range; i++) {
+			
+			if (nodeList[i] == openParen)
+				currentDepth++;
+			else if (nodeList[i] == closeParen)
+				currentDepth--;
+			
+			if ((nodeList[i]->tokenList->type == TOKEN_TYPE_OP_CMP_EQUAL) || (nodeList[i]->tokenList->type == TOKEN_TYPE_OP_CMP_NOT_EQUAL)) {
+				if ((nodeList[i]->type == NODE_TYPE_OPERATION) && (!nodeConsumed[i]) && (currentDepth == 0)) {
+					
+					// Merge the operands into the operator
+					expr_parse_merge_bi(nodeList, nodeConsumed, i);
+					
+					// Note that a merge occurred
+					merged = true;
+					
+				}
+			}
+			
+		}
+		
 		// Evaluate conditional and
 		currentDepth = 0;
 		for (size_t i = 0; i < range; i++) {
@@ -640,7 +993,9 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 	
 	advance(range);
 	
-	node_print(rootNode, 0);
+	node_pool exprPool = {};
+	if (node_pool_create(&exprPool, rootNode, pStream)) node_walk_tree(&exprPool, 0, node_print_enter, NULL, &exprPool);
+	node_pool_destroy(&exprPool);
 	
 	// Free the temporary open and closing paren nodes
 	node_delete(openParen);
@@ -657,7 +1012,47 @@ static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 	
 }
 
-static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable, size_t* pScopeIndex) {
+static bool nesting_enter(stream* pStream, node* pParent, error_table* pErrorTable) {
+	
+	// Past the limit, report it once and skip the rest of the stream so every caller unwinds
+	if (nesting.depth >= AST_MAX_DEPTH) {
+		while ((pParent) && (pParent->tokenCount == 0) && (pParent->parent)) pParent = pParent->parent;
+		if (pStream->index < pStream->size) error_table_push(pErrorTable, ERROR_SYNTACTIC_TOO_DEEP, pParent);
+		jump(pStream->size);
+		return false;
+	}
+	
+	(nesting.depth)++;
+	return true;
+	
+}
+
+static node* expr_parse(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable) {
+	
+	if (!nesting_enter(pStream, pParent, pErrorTable)) return NULL;
+	
+	node* exprNode = expr_parse_body(pStream, pParent, pSymbolTable, pErrorTable);
+	(nesting.depth)--;
+	
+	return exprNode;
+	
+}
+
+/*////////*/
+
+static node* condition_parse(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable, size_t* pScopeIndex) {
+	
+	// Anything more than a single token before the closing paren is a whole expression, which may include calls and comparisons
+	if (peek(1).type != TOKEN_TYPE_PT_CLOSE_PAREN) return expr_parse(pStream, pParent, pSymbolTable, pErrorTable);
+	
+	return node_parse(pStream, pParent, pSymbolTable, pErrorTable, pScopeIndex);
+	
+}
+
+static node* node_parse_body(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable, size_t* pScopeIndex) {
+	
+	// Once the error limit is reached, skip the rest of the stream so every caller unwinds
+	if (error_table_full(pErrorTable)) jump(pStream->size);
 	
 	// This current node
 	node* currentNode = node_new(NODE_TYPE_UNDEFINED, pParent);
@@ -691,6 +1086,15 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 		
 	}
 	
+	// A reflection is parsed as an expression, even when it stands alone
+	if (startToken->type == TOKEN_TYPE_KW_REFLECT) {
+		
+		node_delete(currentNode);
+		
+		return expr_parse(pStream, pParent, pSymbolTable, pErrorTable);
+		
+	}
+	
 	// Resolve literals
 	if (token_isLiteral(startToken->type)) {
 		
@@ -761,6 +1165,25 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 	// Handle declarations
 	if (token_isTypeQualifier(startToken->type) || token_isTypeSpecifier(startToken->type) || token_isIdentifier(startToken->type)) {
 		
+		// A return can hand back a whole expression, including a call
+		if ((pParent->type == NODE_TYPE_STATEMENT) && (pParent->tokenList[0].type == TOKEN_TYPE_KW_RETURN)) {
+			
+			token_resolve(ppeek(1), pParent, pSymbolTable);
+			
+			if (token_isOperator(peek(1).type) || (peek(1).type == TOKEN_TYPE_PT_OPEN_PAREN)) {
+				
+				// Parse this expression
+				node* exprNode = expr_parse(pStream, pParent, pSymbolTable, pErrorTable);
+				
+				// We are part of an expression and can be discarded
+				node_delete(currentNode);
+				
+				return exprNode;
+				
+			}
+			
+		}
+		
 		// Check if this is a simple, unmodified identifier
 		if (pParent->type == NODE_TYPE_STATEMENT) {
 			
@@ -857,31 +1280,8 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 			// Advance past the identifier and the open paren
 			advance(2);
 			
-			node* thisNode = NULL;
-				
-			// Get the function arguments; if there are none, skip the closing paren
-			if (peek(0).type != TOKEN_TYPE_PT_CLOSE_PAREN) {
-				
-				// Get the first child of this node
-				currentNode->firstChild = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
-				thisNode = currentNode->firstChild;
-				
-				// Get the rest of the arguments
-				while (peek(0).type != TOKEN_TYPE_PT_CLOSE_PAREN) {
-					
-					// We expect a comma; in the case it isnt, push an error
-					if (peek(0).type != TOKEN_TYPE_PT_COMMA)
-						error_table_push(pErrorTable, ERROR_SYNTACTIC_MISSING_COMMA, currentNode);
-					else
-						advance(1);
-					
-					// Get the next sibling
-					thisNode->nextSibling = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
-					thisNode = thisNode->nextSibling;
-					
-				}
-				
-			}
+			// Get the function arguments; if there are none, this stops on the closing paren straight away
+			expr_parse_arguments(pStream, currentNode, pSymbolTable, pErrorTable);
 			
 			// Advance past the closing paren
 			advance(1);
@@ -1051,7 +1451,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 					thisNode = currentNode->firstChild;
 					
 					// Get the rest of the parameters
-					while (peek(0).type != TOKEN_TYPE_PT_CLOSE_PAREN) {
+					while (until(TOKEN_TYPE_PT_CLOSE_PAREN)) {
 						
 						// We expect a comma; in the case it isnt, push an error
 						if (peek(0).type != TOKEN_TYPE_PT_COMMA)
@@ -1094,7 +1494,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 					thisNode = scopeNode->firstChild;
 					
 					// Get the remaining children
-					while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+					while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 						
 						thisNode->nextSibling = node_parse(pStream, scopeNode, pSymbolTable, pErrorTable, pScopeIndex);
 						thisNode = thisNode->nextSibling;
@@ -1298,11 +1698,13 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 				// Get the function, variable, or module associated with this keyword
 				currentNode->firstChild = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
 				
-				// We expect a semicolon; in the case it isn't, push an error
-				if (peek(0).type != TOKEN_TYPE_PT_SEMICOLON)
-					error_table_push(pErrorTable, ERROR_SYNTACTIC_MISSING_SEMICOLON, currentNode);
-				else
-					advance(1);
+				// We only expect a semicolon in the case of modules; functions and variables handle themselves
+				if (currentNode->firstChild->tokenList[0].type == TOKEN_TYPE_KW_MODULE) {
+					if (peek(0).type != TOKEN_TYPE_PT_SEMICOLON)
+						error_table_push(pErrorTable, ERROR_SYNTACTIC_MISSING_SEMICOLON, currentNode);
+					else
+						advance(1);
+				}
 				
 			} break;
 			
@@ -1346,7 +1748,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 				currentNode->firstChild = conditionNode;
 				
 				// Get the condition
-				conditionNode->firstChild = node_parse(pStream, conditionNode, pSymbolTable, pErrorTable, pScopeIndex);
+				conditionNode->firstChild = condition_parse(pStream, conditionNode, pSymbolTable, pErrorTable, pScopeIndex);
 				
 				// We expect a closing paren; in the case it isn't, push an error and panic
 				if (peek(0).type != TOKEN_TYPE_PT_CLOSE_PAREN) {
@@ -1380,7 +1782,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 						node* bodyNode = scopeNode->firstChild;
 						
 						// Get the rest of the children
-						while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+						while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 							
 							bodyNode->nextSibling = node_parse(pStream, scopeNode, pSymbolTable, pErrorTable, pScopeIndex);
 							bodyNode = bodyNode->nextSibling;
@@ -1446,7 +1848,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 							advance(1);
 						
 						// Get the condition
-						conditionNode->firstChild = node_parse(pStream, conditionNode, pSymbolTable, pErrorTable, pScopeIndex);
+						conditionNode->firstChild = condition_parse(pStream, conditionNode, pSymbolTable, pErrorTable, pScopeIndex);
 						
 						// We expect a closing paren; in the case that it isn't, push an error and panic
 						if (peek(0).type != TOKEN_TYPE_PT_CLOSE_PAREN) {
@@ -1484,7 +1886,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 							node* bodyNode = scopeNode->firstChild;
 							
 							// Get the rest of the children
-							while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+							while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 								
 								bodyNode->nextSibling = node_parse(pStream, scopeNode, pSymbolTable, pErrorTable, pScopeIndex);
 								bodyNode = bodyNode->nextSibling;
@@ -1564,15 +1966,16 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 				} else
 					advance(1);
 				
-				// Create a new identifier node
-				node* expressionNode = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
-				currentNode->firstChild = expressionNode;
+				// Create a new condition node holding the value being switched on, the same as a loop condition
+				node* conditionNode = node_new(NODE_TYPE_CONDITION, currentNode);
+				currentNode->firstChild = conditionNode;
+				conditionNode->firstChild = condition_parse(pStream, conditionNode, pSymbolTable, pErrorTable, pScopeIndex);
 				
 				advance(1);
 				
 				// Create a new scope node
 				node* scopeNode = node_new(NODE_TYPE_SCOPE, currentNode);
-				expressionNode->nextSibling = scopeNode;
+				conditionNode->nextSibling = scopeNode;
 				
 				// Increment the scope index
 				(*pScopeIndex)++;
@@ -1592,7 +1995,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 						node* thisNode = scopeNode->firstChild;
 						
 						// Get the rest of the children
-						while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+						while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 							
 							thisNode->nextSibling = node_parse(pStream, scopeNode, pSymbolTable, pErrorTable, pScopeIndex);
 							thisNode = thisNode->nextSibling;
@@ -1645,16 +2048,26 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 				} else
 					advance(1);
 				
-				// Parse the expression node
-				node* expressionNode = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
+				// Parse the expression node, which can be a whole constant expression
+				node* expressionNode = condition_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
 				currentNode->firstChild = expressionNode;
 				
+				// Cases are told apart at compile time, so their values have to be constant
+				int64_t caseValue = 0;
+				node_pool casePool = {};
+				bool constant = (expressionNode) && (node_pool_create(&casePool, expressionNode, pStream)) && (eval_constant(&casePool, 0, &caseValue));
+				node_pool_destroy(&casePool);
+				if (!constant) error_table_push(pErrorTable, ERROR_SEMANTIC_CASE_NOT_CONSTANT, (expressionNode) ? expressionNode : currentNode);
+				
 				// Advance past the closing paren
 				advance(1);
 				
-				// Create a new scope node
+				// Create a new scope node; the case value comes before it
 				node* scopeNode = node_new(NODE_TYPE_SCOPE, currentNode);
-				currentNode->firstChild = scopeNode;
+				if (expressionNode)
+					expressionNode->nextSibling = scopeNode;
+				else
+					currentNode->firstChild = scopeNode;
 				
 				// Increment the scope index
 				(*pScopeIndex)++;
@@ -1674,7 +2087,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 						node* bodyNode = scopeNode->firstChild;
 						
 						// Get the rest of the children
-						while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+						while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 							
 							bodyNode->nextSibling = node_parse(pStream, scopeNode, pSymbolTable, pErrorTable, pScopeIndex);
 							bodyNode = bodyNode->nextSibling;
@@ -1733,7 +2146,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 						node* bodyNode = scopeNode->firstChild;
 						
 						// Get the rest of the children
-						while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+						while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 							
 							bodyNode->nextSibling = node_parse(pStream, scopeNode, pSymbolTable, pErrorTable, pScopeIndex);
 							bodyNode = bodyNode->nextSibling;
@@ -1785,7 +2198,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 						currentNode->firstChild = bodyNode;
 						
 						// Get the rest of the children
-						while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+						while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 							
 							bodyNode->nextSibling = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
 							bodyNode = bodyNode->nextSibling;
@@ -1957,7 +2370,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 						node* bodyNode = scopeNode->firstChild;
 						
 						// Get the rest of the children
-						while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+						while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 							
 							bodyNode->nextSibling = node_parse(pStream, scopeNode, pSymbolTable, pErrorTable, pScopeIndex);
 							bodyNode = bodyNode->nextSibling;
@@ -2058,7 +2471,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 					currentNode->firstChild = bodyNode;
 					
 					// Get the rest of the children
-					while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+					while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 						
 						bodyNode->nextSibling = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
 						bodyNode = bodyNode->nextSibling;
@@ -2129,7 +2542,7 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 			node* bodyNode = currentNode->firstChild;
 			
 			// Get the rest of the children
-			while (peek(0).type != TOKEN_TYPE_PT_CLOSE_BRACE) {
+			while (until(TOKEN_TYPE_PT_CLOSE_BRACE)) {
 				
 				bodyNode->nextSibling = node_parse(pStream, currentNode, pSymbolTable, pErrorTable, pScopeIndex);
 				bodyNode = bodyNode->nextSibling;
@@ -2161,34 +2574,478 @@ static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTab
 	
 }
 
+static node* node_parse(stream* pStream, node* pParent, symbol_table* pSymbolTable, error_table* pErrorTable, size_t* pScopeIndex) {
+	
+	if (!nesting_enter(pStream, pParent, pErrorTable)) return NULL;
+	
+	node* currentNode = node_parse_body(pStream, pParent, pSymbolTable, pErrorTable, pScopeIndex);
+	(nesting.depth)--;
+	
+	return currentNode;
+	
+}
+
+/*////////*/
+
+typedef struct {
+	token* oldBase;
+	token* newBase;
+	size_t oldSize;
+	int64_t scopeDelta;
+} node_rebase;
+
+// The first symbol of each identifier, and the first that is a type, found by the identifier's hash
+typedef struct {
+	uint64_t hash;
+	size_t first; // SIZE_MAX in an empty slot
+	size_t firstType;
+} ast_symbol_slot;
+
+typedef struct {
+	symbol_table* pSymbolTable;
+	size_t indexed; // Symbols of the table already in the slots
+	size_t memSize;
+	size_t size;
+	ast_symbol_slot* buffer;
+} ast_symbol_index;
+
+static bool ast_decl_resize(ast* pAST) {
+	
+	// If the buffer can hold more elements, just return
+	if (pAST->decls.size < pAST->decls.memSize) return true;
+	
+	// If there is no buffer, allocate a new buffer
+	if (pAST->decls.memSize == 0) {
+		
+		// Set default buffer size
+		pAST->decls.memSize = 16;
+		pAST->decls.size = 0;
+		
+		// Allocate a new buffer
+		ast_decl* newBuffer = calloc(pAST->decls.memSize, sizeof(ast_decl));
+		if (!newBuffer) return false;
+		
+		// Assign the new buffer to the old one
+		pAST->decls.buffer = newBuffer;
+		
+		// Return success
+		return true;
+		
+	}
+	
+	// Allocate a new buffer
+	ast_decl* newBuffer = calloc((pAST->decls.memSize * 2), sizeof(ast_decl));
+	if (!newBuffer) return false;
+	
+	// Copy the new memory in and free the old buffer
+	memcpy(newBuffer, pAST->decls.buffer, (pAST->decls.memSize * sizeof(ast_decl)));
+	free(pAST->decls.buffer);
+	
+	// Assign the new buffer to the old one
+	pAST->decls.memSize *= 2;
+	pAST->decls.buffer = newBuffer;
+	
+	// Return success
+	return true;
+	
+}
+
+static uint64_t ast_hash_string(uint64_t hash, char* string) {
+	
+	// FNV-1a, including the null terminator so neighbouring strings can't run together
+	do {
+		hash ^= (uint8_t)*string;
+		hash *= 0x100000001b3ULL;
+	} while (*(string++));
+	
+	return hash;
+	
+}
+
+static uint64_t ast_hash_power(size_t exponent) {
+	
+	uint64_t base = 0x9e3779b97f4a7c15ULL;
+	uint64_t result = 1;
+	
+	while (exponent) {
+		if (exponent & 1) result *= base;
+		base *= base;
+		exponent >>= 1;
+	}
+	
+	return result;
+	
+}
+
+static uint64_t ast_hash_range(uint64_t* prefixBuffer, size_t start, size_t end) {
+	
+	// Polynomial hash of the token values in [start, end), found from the prefix hashes in constant time
+	return prefixBuffer[end] - (prefixBuffer[start] * ast_hash_power(end - start));
+	
+}
+
+static ast_symbol_slot* ast_symbol_slot_find(ast_symbol_index* pIndex, uint64_t hash, char* identifier) {
+	
+	// Open addressing; the table is never more than half full, so there is always an empty slot to stop on
+	size_t mask = pIndex->memSize - 1;
+	for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+		ast_symbol_slot* pSlot = &pIndex->buffer[i];
+		if (pSlot->first == SIZE_MAX) return pSlot;
+		if ((pSlot->hash == hash) && (strcmp(pIndex->pSymbolTable->buffer[pSlot->first].identifier, identifier) == 0)) return pSlot;
+	}
+	
+}
+
+static bool ast_symbol_index_update(ast_symbol_index* pIndex) {
+	
+	symbol_table* pSymbolTable = pIndex->pSymbolTable;
+	
+	// Symbols are only ever added, so only the new ones have to be put in
+	for (; pIndex->indexed < pSymbolTable->size; (pIndex->indexed)++) {
+		
+		// Keep the table at most half full, putting every identifier in again when it grows
+		if (((pIndex->size + 1) * 2) > pIndex->memSize) {
+			
+			ast_symbol_slot* oldBuffer = pIndex->buffer;
+			size_t oldMemSize = pIndex->memSize;
+			
+			size_t newMemSize = (oldMemSize == 0) ? 64 : (oldMemSize * 2);
+			ast_symbol_slot* newBuffer = malloc(newMemSize * sizeof(ast_symbol_slot));
+			if (!newBuffer) return false;
+			for (size_t i = 0; i < newMemSize; i++) newBuffer[i].first = SIZE_MAX;
+			
+			pIndex->buffer = newBuffer;
+			pIndex->memSize = newMemSize;
+			for (size_t i = 0; i < oldMemSize; i++) {
+				if (oldBuffer[i].first == SIZE_MAX) continue;
+				*ast_symbol_slot_find(pIndex, oldBuffer[i].hash, pSymbolTable->buffer[oldBuffer[i].first].identifier) = oldBuffer[i];
+			}
+			free(oldBuffer);
+			
+		}
+		
+		symbol* pSymbol = &pSymbolTable->buffer[pIndex->indexed];
+		uint64_t hash = ast_hash_string(0xcbf29ce484222325ULL, pSymbol->identifier);
+		ast_symbol_slot* pSlot = ast_symbol_slot_find(pIndex, hash, pSymbol->identifier);
+		
+		if (pSlot->first == SIZE_MAX) {
+			pSlot->hash = hash;
+			pSlot->first = pIndex->indexed;
+			pSlot->firstType = SIZE_MAX;
+			(pIndex->size)++;
+		}
+		if ((pSymbol->class == SYMBOL_CLASS_TYPE) && (pSlot->firstType == SIZE_MAX)) pSlot->firstType = pIndex->indexed;
+		
+	}
+	
+	return true;
+	
+}
+
+static bool ast_symbol_known(ast_symbol_index* pIndex, size_t limit, char* identifier, symbol_class class) {
+	
+	// Same as symbol_find, but only over the first few symbols of the table
+	ast_symbol_slot* pSlot = ast_symbol_slot_find(pIndex, ast_hash_string(0xcbf29ce484222325ULL, identifier), identifier);
+	if (pSlot->first == SIZE_MAX) return false;
+	
+	return (((class == SYMBOL_CLASS_TYPE) ? pSlot->firstType : pSlot->first) < limit);
+	
+}
+
+static uint64_t ast_hash_lookups(stream* pStream, size_t start, size_t end, ast_symbol_index* pIndex, size_t limit) {
+	
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	
+	// The symbol table only changes a parse through token_resolve, so hash the answers it would get for every identifier
+	for (size_t i = start; i < end; i++) {
+		
+		// The lexer only ever produces invalid tokens for identifiers, which are resolved into identifiers in place
+		if ((pStream->buffer[i].type != TOKEN_TYPE_INVALID) && (pStream->buffer[i].type != TOKEN_TYPE_IDENTIFIER)) continue;
+		
+		uint64_t answer = ast_symbol_known(pIndex, limit, pStream->buffer[i].value, SYMBOL_CLASS_ALL) ? 1 : 0;
+		if ((i > 0) && ast_symbol_known(pIndex, limit, pStream->buffer[i - 1].value, SYMBOL_CLASS_TYPE)) answer |= 2;
+		
+		hash ^= answer;
+		hash *= 0x100000001b3ULL;
+		
+	}
+	
+	return hash;
+	
+}
+
+static uint64_t ast_hash_symbols(ast_info* pInfo, ast_decl* pDecl, ast_symbol_index* pIndex) {
+	
+	stream* pStream = pInfo->pStream;
+	symbol_table* pSymbolTable = pInfo->pSymbolTable;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	
+	// Lowering looks names up in the finished table, which later declarations add to, so hash the first symbol of every name as it stands
+	for (size_t i = pDecl->tokenStart; (i < pDecl->tokenEnd) && (i < pStream->size); i++) {
+		
+		ast_symbol_slot* pSlot = ast_symbol_slot_find(pIndex, ast_hash_string(0xcbf29ce484222325ULL, pStream->buffer[i].value), pStream->buffer[i].value);
+		
+		uint64_t answer = 0;
+		if (pSlot->first != SIZE_MAX) {
+			symbol* pSymbol = &pSymbolTable->buffer[pSlot->first];
+			answer = ((uint64_t)pSymbol->size << 16) | ((uint64_t)pSymbol->class << 8) | ((uint64_t)pSymbol->type << 1) | 1;
+			if (pSlot->firstType != SIZE_MAX) answer ^= (uint64_t)pSymbolTable->buffer[pSlot->firstType].size << 40;
+		}
+		
+		hash ^= answer;
+		hash *= 0x100000001b3ULL;
+		
+	}
+	
+	// And how much room the variables of each of its scopes take up
+	for (size_t i = pDecl->scopeStart + 1; i <= pDecl->scopeEnd; i++) {
+		hash ^= (i < pSymbolTable->indicesSize) ? pSymbolTable->indicesBuffer[i] : 0;
+		hash *= 0x100000001b3ULL;
+	}
+	
+	return hash;
+	
+}
+
+static void node_rebase_visit(node* pNode, void* pData) {
+	
+	node_rebase* pRebase = (node_rebase*)pData;
+	
+	// Point tokens at the new stream; tokens that were never in the old stream are left alone
+	if ((pNode->tokenList >= pRebase->oldBase) && (pNode->tokenList <= pRebase->oldBase + pRebase->oldSize)) {
+		pNode->tokenList = pRebase->newBase + (pNode->tokenList - pRebase->oldBase);
+	}
+	
+	// Scope indices only ever count up, so everything in the declaration moves by the same amount
+	pNode->scopeIndex += pRebase->scopeDelta;
+	
+}
+
+static ast_decl* ast_decl_match(ast_info* pInfo, uint64_t* prefixBuffer, ast_symbol_index* pIndex, size_t tokenStart, size_t* pCursor) {
+	
+	ast* pPrevious = pInfo->pPrevious;
+	stream* pStream = pInfo->pStream;
+	stream* pPreviousStream = pInfo->pPreviousStream;
+	
+	// Edits are usually local, so start looking where the last match left off and wrap around
+	for (size_t n = 0; n < pPrevious->decls.size; n++) {
+		
+		size_t i = (*pCursor + n) % pPrevious->decls.size;
+		ast_decl* pDecl = &pPrevious->decls.buffer[i];
+		
+		if ((!pDecl->reusable) || (!pDecl->pNode)) continue;
+		
+		size_t tokenCount = pDecl->tokenEnd - pDecl->tokenStart;
+		if ((tokenStart + tokenCount) > pStream->size) continue;
+		if (pDecl->tokenHash != ast_hash_range(prefixBuffer, tokenStart, tokenStart + tokenCount)) continue;
+		
+		// The parser peeks one token either side of a declaration, so those have to match too
+		if ((tokenStart == 0) != (pDecl->tokenStart == 0)) continue;
+		if ((tokenStart > 0) && (strcmp(pStream->buffer[tokenStart - 1].value, pPreviousStream->buffer[pDecl->tokenStart - 1].value) != 0)) continue;
+		if (strcmp(pStream->buffer[tokenStart + tokenCount].value, pPreviousStream->buffer[pDecl->tokenEnd].value) != 0) continue;
+		
+		// Rule out a hash collision
+		bool same = true;
+		for (size_t j = 0; (same) && (j < tokenCount); j++) {
+			same = (strcmp(pStream->buffer[tokenStart + j].value, pPreviousStream->buffer[pDecl->tokenStart + j].value) == 0);
+		}
+		if (!same) continue;
+		
+		// Every identifier has to resolve the same way it did last time
+		if (pDecl->lookupHash != ast_hash_lookups(pStream, tokenStart, tokenStart + tokenCount, pIndex, pInfo->pSymbolTable->size)) continue;
+		
+		*pCursor = i + 1;
+		return pDecl;
+		
+	}
+	
+	// Return NULL if we found nothing
+	return NULL;
+	
+}
+
+static node* ast_decl_reuse(ast_info* pInfo, ast_decl* pDecl, node* pParent, size_t tokenStart, size_t scopeStart) {
+	
+	stream* pStream = pInfo->pStream;
+	stream* pPreviousStream = pInfo->pPreviousStream;
+	size_t tokenCount = pDecl->tokenEnd - pDecl->tokenStart;
+	
+	// Take the old tokens, as the parser resolved their types in place, but keep the new offsets
+	for (size_t i = 0; i < tokenCount; i++) {
+		uint32_t offset = pStream->buffer[tokenStart + i].offset;
+		pStream->buffer[tokenStart + i] = pPreviousStream->buffer[pDecl->tokenStart + i];
+		pStream->buffer[tokenStart + i].offset = offset;
+	}
+	
+	// Move the subtree across
+	node_rebase rebase = {};
+	rebase.oldBase = pPreviousStream->buffer;
+	rebase.newBase = pStream->buffer + ((int64_t)tokenStart - (int64_t)pDecl->tokenStart);
+	rebase.oldSize = pPreviousStream->size;
+	rebase.scopeDelta = (int64_t)scopeStart - (int64_t)pDecl->scopeStart;
+	if (!node_each(pDecl->pNode, node_rebase_visit, &rebase)) return NULL;
+	
+	// Add the declaration's symbols again, moved the same way
+	for (size_t i = pDecl->symbolStart; i < pDecl->symbolEnd; i++) {
+		
+		symbol* pOld = &pInfo->pPreviousSymbolTable->buffer[i];
+		symbol* pNew = symbol_add(pInfo->pSymbolTable, pOld->identifier, pOld->type, pOld->size, pOld->scopeIndex + rebase.scopeDelta, pOld->class);
+		if (!pNew) return NULL;
+		
+		pNew->linkage = pOld->linkage;
+		pNew->location = pOld->location;
+		pNew->typeTokenList = ((pOld->typeTokenList >= rebase.oldBase) && (pOld->typeTokenList <= rebase.oldBase + rebase.oldSize)) ? rebase.newBase + (pOld->typeTokenList - rebase.oldBase) : pOld->typeTokenList;
+		pNew->paramTokenList = ((pOld->paramTokenList >= rebase.oldBase) && (pOld->paramTokenList <= rebase.oldBase + rebase.oldSize)) ? rebase.newBase + (pOld->paramTokenList - rebase.oldBase) : pOld->paramTokenList;
+		
+	}
+	
+	// The node now belongs to the new tree
+	node* pNode = pDecl->pNode;
+	pDecl->pNode = NULL;
+	pNode->parent = pParent;
+	pNode->nextSibling = NULL;
+	
+	return pNode;
+	
+}
+
 /*////////*/
 
 void ast_print(ast* pAST) {
 	
-	node_print(pAST->root, 0);
+	node_walk_tree(&pAST->pool, 0, node_print_enter, NULL, &pAST->pool);
 	
 }
 
 bool ast_create(ast* pAST, ast_info* pInfo) {
 	
+	stream* pStream = pInfo->pStream;
+	
 	// Create the file node, or the root node
 	node* fileNode = node_new(NODE_TYPE_FILE, NULL);
 	if (!fileNode) return false;
 	
+	// A parse that won't be kept has nothing to record for the next one
+	bool incremental = pInfo->incremental;
+	
+	// Hash every prefix of the token values, so any range of tokens can be compared against the last parse
+	uint64_t* prefixBuffer = NULL;
+	if (incremental) {
+		prefixBuffer = malloc((pStream->size + 1) * sizeof(uint64_t));
+		if (!prefixBuffer) return false;
+		prefixBuffer[0] = 0;
+		for (size_t i = 0; i < pStream->size; i++) {
+			prefixBuffer[i + 1] = (prefixBuffer[i] * 0x9e3779b97f4a7c15ULL) + ast_hash_string(0xcbf29ce484222325ULL, pStream->buffer[i].value);
+		}
+	}
+	
+	// Identifiers are looked up by hash to find out how they resolve
+	ast_symbol_index symbolIndex = {};
+	symbolIndex.pSymbolTable = pInfo->pSymbolTable;
+	
+	// Declarations are moved out of the last parse, so it no longer owns any of them
+	bool reusing = (incremental) && (pInfo->pPrevious) && (pInfo->pPreviousStream) && (pInfo->pPreviousSymbolTable) && (pInfo->pPrevious->root);
+	if (reusing) pInfo->pPrevious->root->firstChild = NULL;
+	size_t cursor = 0;
+	
 	// Parse the stream into the AST
-	pInfo->pStream->index = 0;
+	pStream->index = 0;
+	resolve.pFirst = pStream->buffer;
 	pAST->scopeIndex = 0;
+	pAST->decls.size = 0;
+	pAST->decls.reused = 0;
 	
-	// Parse the first node
-	node* thisNode = node_parse(pInfo->pStream, fileNode, pInfo->pSymbolTable, pInfo->pErrorTable, &pAST->scopeIndex);
-	if (!thisNode) return false;
-	fileNode->firstChild = thisNode;
+	node** ppLink = &fileNode->firstChild;
+	
+	// Parse every top-level node, always parsing at least one
+	do {
+		
+		if ((!ast_decl_resize(pAST)) || ((incremental) && (!ast_symbol_index_update(&symbolIndex)))) {
+			free(prefixBuffer);
+			free(symbolIndex.buffer);
+			return false;
+		}
+		
+		ast_decl* pDecl = &pAST->decls.buffer[pAST->decls.size];
+		pDecl->tokenStart = pStream->index;
+		pDecl->scopeStart = pAST->scopeIndex;
+		pDecl->symbolStart = pInfo->pSymbolTable->size;
+		
+		size_t errorCount = pInfo->pErrorTable->size;
+		bool errorFull = error_table_full(pInfo->pErrorTable);
+		
+		// Take the declaration from the last parse if nothing it depends on has changed
+		ast_decl* pMatch = (reusing) ? ast_decl_match(pInfo, prefixBuffer, &symbolIndex, pStream->index, &cursor) : NULL;
+		
+		node* thisNode = NULL;
+		if (pMatch) {
+			
+			thisNode = ast_decl_reuse(pInfo, pMatch, fileNode, pStream->index, pAST->scopeIndex);
+			
+			// Carry on from the end of the declaration, past any scopes it opened
+			advance(pMatch->tokenEnd - pMatch->tokenStart);
+			pAST->scopeIndex += (pMatch->scopeEnd - pMatch->scopeStart);
+			(pAST->decls.reused)++;
+			
+		} else {
+			
+			thisNode = node_parse(pStream, fileNode, pInfo->pSymbolTable, pInfo->pErrorTable, &pAST->scopeIndex);
+			
+		}
+		
+		if ((!thisNode) || ((incremental) && (!ast_symbol_index_update(&symbolIndex)))) {
+			free(prefixBuffer);
+			free(symbolIndex.buffer);
+			return false;
+		}
+		
+		pDecl->pNode = thisNode;
+		pDecl->previous = (pMatch) ? (size_t)(pMatch - pInfo->pPrevious->decls.buffer) : SIZE_MAX;
+		pDecl->tokenEnd = pStream->index;
+		pDecl->scopeEnd = pAST->scopeIndex;
+		pDecl->symbolEnd = pInfo->pSymbolTable->size;
+		
+		// Declarations that reported errors are always parsed again, so their errors are reported again; so are any the parser ran off the end of the stream in
+		pDecl->reusable = (incremental) && (!errorFull) && (pInfo->pErrorTable->size == errorCount) && (pDecl->tokenEnd > pDecl->tokenStart) && (pDecl->tokenEnd <= pStream->size);
+		if (pDecl->reusable) {
+			pDecl->tokenHash = ast_hash_range(prefixBuffer, pDecl->tokenStart, pDecl->tokenEnd);
+			pDecl->lookupHash = ast_hash_lookups(pStream, pDecl->tokenStart, pDecl->tokenEnd, &symbolIndex, pDecl->symbolStart);
+		}
+		(pAST->decls.size)++;
+		
+		// Link the node in
+		*ppLink = thisNode;
+		ppLink = &thisNode->nextSibling;
+		
+	} while (pStream->index < pStream->size);
+	
+	// Only now is the symbol table finished
+	if (incremental) {
+		for (size_t i = 0; i < pAST->decls.size; i++) pAST->decls.buffer[i].symbolHash = ast_hash_symbols(pInfo, &pAST->decls.buffer[i], &symbolIndex);
+	}
+	
+	free(prefixBuffer);
+	free(symbolIndex.buffer);
+	
+	// Free whatever was not carried over from the last parse
+	if (reusing) {
+		for (size_t i = 0; i < pInfo->pPrevious->decls.size; i++) {
+			node_delete(pInfo->pPrevious->decls.buffer[i].pNode);
+			pInfo->pPrevious->decls.buffer[i].pNode = NULL;
+		}
+	}
+	
+	// Lay the tree out flat for every pass after this one
+	if (!node_pool_create(&pAST->pool, fileNode, pStream)) {
+		pAST->root = fileNode;
+		return false;
+	}
 	
-	// Parse every other node
-	while (pInfo->pStream->index < pInfo->pStream->size) {
-		thisNode->nextSibling = node_parse(pInfo->pStream, fileNode, pInfo->pSymbolTable, pInfo->pErrorTable, &pAST->scopeIndex);
-		if (!thisNode->nextSibling) return false;
-		thisNode = thisNode->nextSibling;
+	// Only the next parse reads the nodes themselves, so a parse that won't be kept frees them now
+	if (!incremental) {
+		node_delete(fileNode);
+		fileNode = NULL;
+		for (size_t i = 0; i < pAST->decls.size; i++) pAST->decls.buffer[i].pNode = NULL;
 	}
 	
 	// Assign the file node to the AST
@@ -2203,6 +3060,12 @@ void ast_destroy(ast* pAST) {
 	
 	// Free memory
 	node_delete(pAST->root);
+	node_pool_destroy(&pAST->pool);
+	free(pAST->decls.buffer);
+	pAST->root = NULL;
+	pAST->decls.buffer = NULL;
+	pAST->decls.memSize = 0;
+	pAST->decls.size = 0;
 	pAST->size = 0;
 	
 }
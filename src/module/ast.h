@@ -1,5 +1,12 @@
 #pragma once
 
+// [ MACROS ] //
+
+#define NODE_ID_NONE UINT32_MAX
+
+// The tokens of a node in the pool, which are a range of the stream it was parsed from
+#define node_tokens(pPool, id) (&(pPool)->tokenBase[(pPool)->tokenIndex[id]])
+
 // [ DEFINING ] //
 
 typedef enum {
@@ -27,6 +34,9 @@ typedef enum {
 	// Call nodes
 	NODE_TYPE_CALL_FUNCTION,
 	
+	// Compile time nodes
+	NODE_TYPE_REFLECT,
+	
 } node_type;
 
 typedef struct node {
@@ -46,20 +56,107 @@ typedef struct node {
 
 /*////////*/
 
+typedef uint32_t node_id;
+
+// The tree laid out flat once it has been parsed; nodes are numbered in pre-order, so a walk over the tree moves forward through these arrays
+typedef struct {
+	size_t size;
+	token* tokenBase;
+	uint32_t* tokenIndex;
+	uint32_t* tokenCount;
+	uint32_t* scopeIndex;
+	node_id* parent;
+	node_id* firstChild;
+	node_id* nextSibling;
+	uint8_t* type;
+} node_pool;
+
+/*////////*/
+
+typedef struct {
+	node_id id;
+	size_t depth;
+	bool entered;
+	size_t state;
+} node_frame;
+
+typedef struct {
+	size_t memSize;
+	size_t size;
+	node_frame* buffer;
+} node_walk;
+
+// A node waiting to be numbered, with the nodes it is linked to in the pool
+typedef struct {
+	node* pNode;
+	node_id parent;
+	node_id previous;
+} node_pending;
+
+// Called on the way down; returning false skips the node's children
+typedef bool (*node_enter)(node_frame* pFrame, void* pData);
+
+// Called on the way up, after all of the node's children
+typedef void (*node_leave)(node_frame* pFrame, void* pData);
+
+/*////////*/
+
+// Where a top-level node came from, so it can be kept when the file is parsed again
+typedef struct {
+	node* pNode;
+	size_t tokenStart;
+	size_t tokenEnd;
+	size_t scopeStart;
+	size_t scopeEnd;
+	size_t symbolStart;
+	size_t symbolEnd;
+	uint64_t tokenHash;
+	uint64_t lookupHash;
+	bool reusable;
+	
+	// Where it was in the last parse if it was carried over, or SIZE_MAX; and what the passes after parsing look up for it
+	size_t previous;
+	uint64_t symbolHash;
+} ast_decl;
+
+/*////////*/
+
+typedef struct ast ast;
+
 typedef struct {
 	stream* pStream;
 	symbol_table* pSymbolTable;
 	error_table* pErrorTable;
+	
+	// The parse is kept for the next one, so every declaration records what it has to match
+	bool incremental;
+	
+	// The last parse of this file, if there is one; unchanged declarations are moved out of it
+	ast* pPrevious;
+	stream* pPreviousStream;
+	symbol_table* pPreviousSymbolTable;
 } ast_info;
 
-typedef struct {
+struct ast {
 	size_t size;
-	node* root;
+	node* root; // Only kept for the next parse; every pass after parsing reads the pool
+	node_pool pool;
 	size_t scopeIndex;
-} ast;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		size_t reused;
+		ast_decl* buffer;
+	} decls;
+};
 
 // [ FUNCTIONS ] //
 
+bool node_walk_tree(node_pool* pPool, node_id root, node_enter enter, node_leave leave, void* pData);
+
+/*////////*/
+
 void ast_print(ast* pAST);
 
 bool ast_create(ast* pAST, ast_info* pInfo);
@@ -9,6 +9,10 @@
 #include <stdbool.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
 // [ FUNCTIONS ] //
 
 void code_skipWhitespace(code* pCode) {
@@ -56,6 +60,82 @@ void code_skipComments(code* pCode) {
 	}
 }
 
+static size_t code_scanLines(code* pCode, size_t* pOut) {
+	
+	// The first line always starts at the beginning of the file
+	size_t count = 1;
+	if (pOut) pOut[0] = 0;
+	
+	size_t index = 0;
+	
+	// Compare sixteen characters at a time against a newline
+	#if defined(__SSE2__)
+	__m128i newline = _mm_set1_epi8('\n');
+	for (; (index + 16) <= pCode->size; index += 16) {
+		
+		__m128i chunk = _mm_loadu_si128((const __m128i*)&pCode->buffer[index]);
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+		
+		// Every set bit is a newline; the next line starts on the character after it
+		while (mask) {
+			if (pOut) pOut[count] = index + __builtin_ctz(mask) + 1;
+			count++;
+			mask &= (mask - 1);
+		}
+		
+	}
+	#endif
+	
+	// Handle whatever is left over one character at a time
+	for (; index < pCode->size; index++) {
+		if (pCode->buffer[index] == '\n') {
+			if (pOut) pOut[count] = index + 1;
+			count++;
+		}
+	}
+	
+	return count;
+	
+}
+
+void code_locate(code* pCode, size_t offset, size_t* pLine, size_t* pColumn) {
+	
+	// Build the line index the first time a location is asked for
+	if (pCode->lineBuffer == NULL) {
+		
+		size_t lineCount = code_scanLines(pCode, NULL);
+		
+		size_t* newBuffer = malloc(lineCount * sizeof(size_t));
+		if (!newBuffer) {
+			*pLine = 0;
+			*pColumn = 0;
+			return;
+		}
+		
+		code_scanLines(pCode, newBuffer);
+		
+		pCode->lineCount = lineCount;
+		pCode->lineBuffer = newBuffer;
+		
+	}
+	
+	// Binary search for the last line starting at or before the offset
+	size_t low = 0;
+	size_t high = pCode->lineCount;
+	while ((high - low) > 1) {
+		size_t middle = low + ((high - low) / 2);
+		if (pCode->lineBuffer[middle] <= offset)
+			low = middle;
+		else
+			high = middle;
+	}
+	
+	// Lines and columns are one-based
+	*pLine = low + 1;
+	*pColumn = (offset - pCode->lineBuffer[low]) + 1;
+	
+}
+
 void code_print(code* pCode) {
 	
 	print_utf8("%s\n", pCode->buffer);
@@ -92,8 +172,8 @@ bool code_create(code* pCode, code_info* pInfo) {
 	}
 	rewind(file);
 	
-	// Allocate a buffer for the file contents
-	newCode.buffer = malloc(fileSize * sizeof(char));
+	// Allocate a buffer for the file contents, and a newline after them; the lexer looks a character past the last token, and would otherwise read whatever is there
+	newCode.buffer = malloc((fileSize + 1) * sizeof(char));
 	if (newCode.buffer == NULL) {
 		fclose(file);
 		return false;
@@ -107,8 +187,14 @@ bool code_create(code* pCode, code_info* pInfo) {
 		return false;
 	}
 	
+	newCode.buffer[bytesRead] = '\n';
 	newCode.size = bytesRead;
 	newCode.index = 0;
+	newCode.fileName = pInfo->fileName;
+	
+	// The line index is only built once a diagnostic needs it
+	newCode.lineCount = 0;
+	newCode.lineBuffer = NULL;
 	
 	// Set the code to the new code
 	*pCode = newCode;
@@ -122,6 +208,9 @@ void code_destroy(code* pCode) {
 	
 	// Free memory
 	free(pCode->buffer);
+	free(pCode->lineBuffer);
+	pCode->lineBuffer = NULL;
+	pCode->lineCount = 0;
 	pCode->index = 0;
 	pCode->size = 0;
 	
@@ -10,6 +10,9 @@ typedef struct {
 	size_t size;
 	size_t index;
 	char* buffer;
+	char* fileName;
+	size_t lineCount;
+	size_t* lineBuffer;
 } code;
 
 // [ FUNCTIONS ] //
@@ -17,5 +20,7 @@ typedef struct {
 void code_skipWhitespace(code* pCode);
 void code_skipComments(code* pCode);
 
+void code_locate(code* pCode, size_t offset, size_t* pLine, size_t* pColumn);
+
 bool code_create(code* pCode, code_info* pInfo);
 void code_destroy(code* pCode);
\ No newline at end of file
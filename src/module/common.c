@@ -0,0 +1,29 @@
+// [ INCLUDING ] //
+
+#include "common.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+// [ FUNCTIONS ] //
+
+bool buffer_resize(void** ppBuffer, size_t* pMemSize, size_t needed, size_t elementSize) {
+	
+	// If the buffer can hold everything, just return
+	if (needed <= *pMemSize) return true;
+	
+	// Double the buffer until it fits
+	size_t newMemSize = (*pMemSize == 0) ? 16 : *pMemSize;
+	while (newMemSize < needed) newMemSize *= 2;
+	
+	void* newBuffer = realloc(*ppBuffer, newMemSize * elementSize);
+	if (!newBuffer) return false;
+	
+	// Assign the new buffer to the old one
+	*ppBuffer = newBuffer;
+	*pMemSize = newMemSize;
+	
+	// Return success
+	return true;
+	
+}
\ No newline at end of file
@@ -23,10 +23,14 @@
 #include "code.h"
 #include "symbol.h"
 #include "stream.h"
+#include "header.h"
+#include "preprocessor.h"
 #include "error.h"
 #include "ast.h"
 #include "irgen.h"
+#include "ir.h"
 #include "asmgen.h"
+#include "jit.h"
 
 // [ DEFINING ] //
 
@@ -38,7 +42,7 @@ struct token_table {
 // Token keyword table
 static struct token_table token_kw_table[] = {
 	
-	// ADD: reflect, alignas, alignof
+	// ADD: alignas, alignof
 	
 	{"return", TOKEN_TYPE_KW_RETURN},
 	
@@ -69,6 +73,8 @@ static struct token_table token_kw_table[] = {
 	{"module", TOKEN_TYPE_KW_MODULE},
 	{"header", TOKEN_TYPE_KW_HEADER},
 	
+	{"reflect", TOKEN_TYPE_KW_REFLECT},
+	
 	{"", TOKEN_TYPE_UNDEFINED}
 	
 };
@@ -117,6 +123,7 @@ static struct token_table token_op_table[] = {
 	{"&&", TOKEN_TYPE_OP_CMP_AND},
 	{"||", TOKEN_TYPE_OP_CMP_OR},
 	{"==", TOKEN_TYPE_OP_CMP_EQUAL},
+	{"!=", TOKEN_TYPE_OP_CMP_NOT_EQUAL},
 	{"<=", TOKEN_TYPE_OP_CMP_LESS_EQUAL},
 	{"<",  TOKEN_TYPE_OP_CMP_LESS},
 	{">=", TOKEN_TYPE_OP_CMP_GREATER_EQUAL},
@@ -176,19 +183,56 @@ static struct token_table token_qu_table[] = {
 	
 };
 
+// Token class flags, indexed by token type
+typedef enum {
+	TOKEN_CLASS_KEYWORD        = (1 << 0),
+	TOKEN_CLASS_LITERAL        = (1 << 1),
+	TOKEN_CLASS_OPERATOR       = (1 << 2),
+	TOKEN_CLASS_PUNCTUATOR     = (1 << 3),
+	TOKEN_CLASS_TYPE_SPECIFIER = (1 << 4),
+	TOKEN_CLASS_TYPE_QUALIFIER = (1 << 5),
+} token_class;
+
+// Built once from the tables above so that classifying a token is a single load
+extern uint8_t token_class_table[TOKEN_TYPE_COUNT];
+
 // [ FUNCTIONS ] //
 
-bool token_isKeyword(token_type tokenType);
-bool token_isIdentifier(token_type tokenType);
-bool token_isLiteral(token_type tokenType);
-bool token_isOperator(token_type tokenType);
-bool token_isPunctuator(token_type tokenType);
-bool token_isTypeSpecifier(token_type tokenType);
-bool token_isTypeQualifier(token_type tokenType);
+static inline bool token_isKeyword(token_type tokenType) {
+	return (token_class_table[tokenType] & TOKEN_CLASS_KEYWORD);
+}
+
+static inline bool token_isIdentifier(token_type tokenType) {
+	return (tokenType == TOKEN_TYPE_IDENTIFIER);
+}
+
+static inline bool token_isLiteral(token_type tokenType) {
+	return (token_class_table[tokenType] & TOKEN_CLASS_LITERAL);
+}
+
+static inline bool token_isOperator(token_type tokenType) {
+	return (token_class_table[tokenType] & TOKEN_CLASS_OPERATOR);
+}
+
+static inline bool token_isPunctuator(token_type tokenType) {
+	return (token_class_table[tokenType] & TOKEN_CLASS_PUNCTUATOR);
+}
+
+static inline bool token_isTypeSpecifier(token_type tokenType) {
+	return (token_class_table[tokenType] & TOKEN_CLASS_TYPE_SPECIFIER);
+}
+
+static inline bool token_isTypeQualifier(token_type tokenType) {
+	return (token_class_table[tokenType] & TOKEN_CLASS_TYPE_QUALIFIER);
+}
 
 static inline bool char_isWhitespace(char character) {
 	return ((character == ' ') || (character == '\n') || (character == '\t') || (character == '\r'));
 }
 
+// Grows a buffer of elementSize elements so that it holds at least needed of them
+bool buffer_resize(void** ppBuffer, size_t* pMemSize, size_t needed, size_t elementSize);
+
 void print_utf8(const char* msg, ...);
+void print_bytes(const char* text, size_t length);
 void print_utf16(const unsigned short* msg, ...);
\ No newline at end of file
@@ -19,18 +19,23 @@ bool error_table_resize(error_table* pErrorTable) {
 	// If there is no buffer, allocate a new buffer
 	if (pErrorTable->memSize == 0) {
 		
-		// Set default buffer size
-		pErrorTable->memSize = 8;
-		pErrorTable->size = 0;
-		
-		// Allocate a new buffer
-		error* newBuffer1 = calloc(pErrorTable->memSize, sizeof(error));
-		node** newBuffer2 = calloc(pErrorTable->memSize, sizeof(node*));
-		if ((!newBuffer1) || (!newBuffer2)) return false;
+		// Allocate a new buffer of the default size
+		error* newBuffer1 = calloc(8, sizeof(error));
+		node** newBuffer2 = calloc(8, sizeof(node*));
+		uint32_t* newBuffer3 = calloc(8, sizeof(uint32_t));
+		if ((!newBuffer1) || (!newBuffer2) || (!newBuffer3)) {
+			free(newBuffer1);
+			free(newBuffer2);
+			free(newBuffer3);
+			return false;
+		}
 		
 		// Assign the new buffer to the old one
+		pErrorTable->memSize = 8;
+		pErrorTable->size = 0;
 		pErrorTable->errorBuffer = newBuffer1;
 		pErrorTable->nodeBuffer = newBuffer2;
+		pErrorTable->offsetBuffer = newBuffer3;
 		
 		// Return success
 		return true;
@@ -38,20 +43,29 @@ bool error_table_resize(error_table* pErrorTable) {
 	}
 	
 	// Allocate a new buffer
-	error* newBuffer1 = calloc(pErrorTable->memSize, sizeof(error));
-	node** newBuffer2 = calloc(pErrorTable->memSize, sizeof(node*));
-	if ((!newBuffer1) || (!newBuffer2)) return false;
+	error* newBuffer1 = calloc((pErrorTable->memSize * 2), sizeof(error));
+	node** newBuffer2 = calloc((pErrorTable->memSize * 2), sizeof(node*));
+	uint32_t* newBuffer3 = calloc((pErrorTable->memSize * 2), sizeof(uint32_t));
+	if ((!newBuffer1) || (!newBuffer2) || (!newBuffer3)) {
+		free(newBuffer1);
+		free(newBuffer2);
+		free(newBuffer3);
+		return false;
+	}
 	
 	// Copy the new memory in and free the old buffer
 	memcpy(newBuffer1, pErrorTable->errorBuffer, (pErrorTable->memSize * sizeof(error)));
 	memcpy(newBuffer2, pErrorTable->nodeBuffer, (pErrorTable->memSize * sizeof(node*)));
+	memcpy(newBuffer3, pErrorTable->offsetBuffer, (pErrorTable->memSize * sizeof(uint32_t)));
 	free(pErrorTable->errorBuffer);
 	free(pErrorTable->nodeBuffer);
+	free(pErrorTable->offsetBuffer);
 	
 	// Assign the new buffer to the old one
 	pErrorTable->memSize *= 2;
 	pErrorTable->errorBuffer = newBuffer1;
 	pErrorTable->nodeBuffer = newBuffer2;
+	pErrorTable->offsetBuffer = newBuffer3;
 	
 	// Return success
 	return true;
@@ -62,12 +76,21 @@ bool error_table_resize(error_table* pErrorTable) {
 
 void error_table_push(error_table* pErrorTable, error thisError, node* pNode) {
 	
+	// Drop the error if we've already collected as many as we're allowed to
+	if (error_table_full(pErrorTable)) return;
+	
 	// Resize if needed
-	error_table_resize(pErrorTable);
+	if (!error_table_resize(pErrorTable)) return;
 	
 	// Add a new error and node to the buffers
 	pErrorTable->errorBuffer[pErrorTable->size] = thisError;
 	pErrorTable->nodeBuffer[pErrorTable->size] = pNode;
+	
+	// Keep the offset of the node's first token so the error can be located later
+	if ((pNode) && (pNode->tokenCount > 0))
+		pErrorTable->offsetBuffer[pErrorTable->size] = pNode->tokenList[0].offset;
+	else
+		pErrorTable->offsetBuffer[pErrorTable->size] = 0;
 	(pErrorTable->size)++;
 	
 	// Return a pointer to the new symbol
@@ -75,13 +98,24 @@ void error_table_push(error_table* pErrorTable, error thisError, node* pNode) {
 	
 }
 
+bool error_table_full(error_table* pErrorTable) {
+	
+	// A maximum size of zero means there is no limit
+	return ((pErrorTable->maxSize > 0) && (pErrorTable->size >= pErrorTable->maxSize));
+	
+}
+
 /*////////*/
 
-void error_table_print(error_table* pErrorTable) {
+void error_table_print(error_table* pErrorTable, code* pCode) {
 	
 	for (size_t i = 0; i < pErrorTable->size; i++) {
 		
-		print_utf8("error: %s\n",
+		// Convert the offset of the error into a line and column
+		size_t line, column;
+		code_locate(pCode, pErrorTable->offsetBuffer[i], &line, &column);
+		
+		print_utf8("%s:%llu:%llu: error: %s\n", pCode->fileName, (unsigned long long)line, (unsigned long long)column,
 			(pErrorTable->errorBuffer[i] == ERROR_SYNTACTIC_MISSING_SEMICOLON) ? "Missing semicolon" :
 			(pErrorTable->errorBuffer[i] == ERROR_SYNTACTIC_MISSING_COLON)    ? "Missing colon" :
 			(pErrorTable->errorBuffer[i] == ERROR_SYNTACTIC_MISSING_COMMA)   ? "Missing comma" :
@@ -93,15 +127,21 @@ void error_table_print(error_table* pErrorTable) {
 			(pErrorTable->errorBuffer[i] == ERROR_SYNTACTIC_EXPECTED_TYPE) ? "Expected type" :
 			(pErrorTable->errorBuffer[i] == ERROR_SYNTACTIC_EXPECTED_IDENTIFIER) ? "Expected identifier" :
 			(pErrorTable->errorBuffer[i] == ERROR_SYNTACTIC_EXPECTED_OPERATOR) ? "Expected operator" :
+			(pErrorTable->errorBuffer[i] == ERROR_SYNTACTIC_TOO_DEEP) ? "Nesting too deep" :
 			(pErrorTable->errorBuffer[i] == ERROR_SEMANTIC_TYPE_MISMATCH)   ? "Type mismatch" :
 			(pErrorTable->errorBuffer[i] == ERROR_SEMANTIC_REDECLARATION)   ? "Redeclaration" :
 			(pErrorTable->errorBuffer[i] == ERROR_SEMANTIC_ARG_MISMATCH)    ? "Argument mismatch" :
 			(pErrorTable->errorBuffer[i] == ERROR_SEMANTIC_CONST_MODIFY)    ? "Const modify" : 
+			(pErrorTable->errorBuffer[i] == ERROR_SEMANTIC_CASE_NOT_CONSTANT) ? "Case not constant" :
 			"Unknown error"
 		);
 		
 	}
 	
+	// Let the user know that the rest of the file was skipped
+	if (error_table_full(pErrorTable))
+		print_utf8("%s: too many errors emitted, stopping now [--max-errors=%llu]\n", pCode->fileName, (unsigned long long)pErrorTable->maxSize);
+	
 }
 
 bool error_table_create(error_table* pErrorTable) {
@@ -119,6 +159,7 @@ void error_table_destroy(error_table* pErrorTable) {
 	// Free memory
 	free(pErrorTable->errorBuffer);
 	free(pErrorTable->nodeBuffer);
+	free(pErrorTable->offsetBuffer);
 	pErrorTable->memSize = 0;
 	pErrorTable->size = 0;
 	
@@ -28,12 +28,14 @@ typedef enum {
 	ERROR_SYNTACTIC_EXPECTED_OPERATOR,
 	
 	ERROR_SYNTACTIC_MISSING_BODY,
+	ERROR_SYNTACTIC_TOO_DEEP,
 	
 	// Semantic errors
 	ERROR_SEMANTIC_TYPE_MISMATCH,
 	ERROR_SEMANTIC_REDECLARATION,
 	ERROR_SEMANTIC_ARG_MISMATCH,
 	ERROR_SEMANTIC_CONST_MODIFY,
+	ERROR_SEMANTIC_CASE_NOT_CONSTANT,
 	
 	ERROR_SEMANTIC_UNPOPULATED_BODY,
 	
@@ -44,17 +46,20 @@ typedef enum {
 typedef struct {
 	size_t memSize;
 	size_t size;
+	size_t maxSize;
 	error* errorBuffer;
 	node** nodeBuffer;
+	uint32_t* offsetBuffer;
 } error_table;
 
 // [ FUNCTIONS ] //
 
 void error_table_push(error_table* pErrorTable, error thisError, node* pNode);
+bool error_table_full(error_table* pErrorTable);
 
 /*////////*/
 
-void error_table_print(error_table* pErrorTable);
+void error_table_print(error_table* pErrorTable, code* pCode);
 
 bool error_table_create(error_table* pErrorTable);
 void error_table_destroy(error_table* pErrorTable);
\ No newline at end of file
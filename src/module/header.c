@@ -0,0 +1,1080 @@
+// [ INCLUDING ] //
+
+#include "common.h"
+
+#include <windows.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+// [ MACROS ] //
+
+#define HEADER_MAX_PATH 1024
+#define HEADER_MAX_LINE 4096 // The longest import declaration a header can turn into
+
+// [ DEFINING ] //
+
+typedef enum {
+	HEADER_TOKEN_WORD,
+	HEADER_TOKEN_NUMBER,
+	HEADER_TOKEN_STRING,
+	HEADER_TOKEN_PUNCTUATOR,
+} header_token_kind;
+
+typedef struct {
+	header_token_kind kind;
+	size_t start;
+	size_t length;
+} header_token;
+
+// A C type the way C* spells it; a NULL base is a type C* has nothing for, which can still be passed around by pointer
+typedef struct {
+	char* base;
+	size_t pointers;
+} header_type;
+
+typedef struct {
+	char name[MAX_VALUE_LEN];
+	header_type type;
+} header_typedef;
+
+typedef struct {
+	
+	char* source;
+	size_t sourceSize;
+	
+	header* pHeader;
+	size_t memSize;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		header_token* buffer;
+	} tokens;
+	
+	// The tokens of the declaration being read, without the bodies of anything it defines
+	struct {
+		size_t memSize;
+		size_t size;
+		header_token* buffer;
+	} declaration;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		header_typedef* buffer;
+	} typedefs;
+	
+	// Every branch of a conditional is read, so the same function can be declared more than once
+	struct {
+		size_t memSize;
+		size_t size;
+		char (*buffer)[MAX_VALUE_LEN];
+	} names;
+	
+} header_transpiler;
+
+/*////////*/
+
+// Types every header can use, since the headers that define them are not followed
+static struct {
+	char* name;
+	header_type type;
+} typedefTable[] = {
+	{ "size_t", { "long int", 0 } },    { "rsize_t", { "long int", 0 } },  { "ssize_t", { "long int", 0 } },
+	{ "ptrdiff_t", { "long int", 0 } }, { "intptr_t", { "long int", 0 } }, { "uintptr_t", { "long int", 0 } },
+	{ "time_t", { "long int", 0 } },    { "int64_t", { "long int", 0 } },  { "uint64_t", { "long int", 0 } },
+	{ "int32_t", { "int", 0 } },        { "uint32_t", { "int", 0 } },      { "errno_t", { "int", 0 } },
+	{ "int16_t", { "short int", 0 } },  { "uint16_t", { "short int", 0 } },
+	{ "wchar_t", { "short int", 0 } },  { "wint_t", { "short int", 0 } },  { "wctype_t", { "short int", 0 } },
+	{ "int8_t", { "byte", 0 } },        { "uint8_t", { "byte", 0 } },
+	{ "va_list", { "byte", 1 } },       { "__builtin_va_list", { "byte", 1 } }, { "__gnuc_va_list", { "byte", 1 } },
+};
+
+// Words that say nothing about what is declared, only how it is linked, called or checked
+static char* ignoredWords[] = {
+	"typedef", "extern", "const", "volatile", "restrict", "__restrict", "__restrict__", "register",
+	"inline", "__inline", "__inline__", "__forceinline", "_Noreturn", "__extension__",
+	"__cdecl", "_cdecl", "__stdcall", "__fastcall", "__vectorcall", "__ptr32", "__ptr64", "__unaligned",
+	"_ACRTIMP", "_CRTIMP", "_DCRTIMP", "__CRTDECL", "WINAPI", "WINBASEAPI", "__MINGW_NOTHROW", "__THROW", "__wur",
+};
+
+// Words that make up C types, and the parts of C++ that a header can't be transpiled through
+static char* typeWords[] = {
+	"void", "char", "short", "int", "long", "float", "double", "signed", "unsigned", "_Bool", "bool",
+	"__int8", "__int16", "__int32", "__int64", "struct", "union", "enum",
+};
+
+static char* cppWords[] = {
+	"template", "operator", "namespace", "using", "class",
+};
+
+// [ FUNCTIONS ] //
+
+static char* header_read(char* fileName, size_t* pSize) {
+	
+	FILE* file = fopen(fileName, "rb");
+	if (file == NULL) return NULL;
+	
+	// Get the file size
+	long fileSize = -1;
+	if (fseek(file, 0, SEEK_END) == 0) fileSize = ftell(file);
+	if (fileSize < 0) {
+		fclose(file);
+		return NULL;
+	}
+	rewind(file);
+	
+	// Keep a null terminator after the contents, so reading one character ahead is always safe
+	char* buffer = calloc(fileSize + 1, sizeof(char));
+	if (buffer == NULL) {
+		fclose(file);
+		return NULL;
+	}
+	
+	size_t bytesRead = fread(buffer, 1, fileSize, file);
+	fclose(file);
+	if (bytesRead != (size_t)fileSize) {
+		free(buffer);
+		return NULL;
+	}
+	
+	*pSize = bytesRead;
+	return buffer;
+	
+}
+
+static uint64_t header_hash(char* buffer, size_t size) {
+	
+	// FNV-1a over the contents, starting from the format version so a new format misses every old entry
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	hash ^= HEADER_CACHE_VERSION;
+	hash *= 0x100000001b3ULL;
+	
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (uint8_t)buffer[i];
+		hash *= 0x100000001b3ULL;
+	}
+	
+	return hash;
+	
+}
+
+static void header_store(header* pHeader, char* cacheDir, char* cacheName) {
+	
+	// The directory is made by the first header that is cached; it already being there is fine
+	CreateDirectoryA(cacheDir, NULL);
+	
+	// Written under a name of its own and then moved into place, so a job reading the cache never sees half of it
+	char tempName[HEADER_MAX_PATH + 32] = {};
+	snprintf(tempName, sizeof(tempName), "%s.%lu.tmp", cacheName, (unsigned long)GetCurrentProcessId());
+	
+	FILE* file = fopen(tempName, "wb");
+	if (file == NULL) return;
+	
+	bool written = (fwrite(pHeader->buffer, 1, pHeader->size, file) == pHeader->size);
+	if (fclose(file) != 0) written = false;
+	
+	// Two jobs caching the same header write the same thing, so whichever is moved last can win
+	if ((!written) || (!MoveFileExA(tempName, cacheName, MOVEFILE_REPLACE_EXISTING))) remove(tempName);
+	
+}
+
+/*////////*/
+
+static bool header_lex(header_transpiler* pTranspiler) {
+	
+	char* source = pTranspiler->source;
+	size_t size = pTranspiler->sourceSize;
+	size_t index = 0;
+	bool lineStart = true;
+	
+	while (index < size) {
+		
+		char character = source[index];
+		
+		// Preprocessor directives only start lines
+		if (character == '\n') {
+			lineStart = true;
+			index++;
+			continue;
+		}
+		
+		if (char_isWhitespace(character) || (character == '\f') || (character == '\v')) {
+			index++;
+			continue;
+		}
+		
+		// Skip comments
+		if ((character == '/') && (source[index + 1] == '/')) {
+			while ((index < size) && (source[index] != '\n')) index++;
+			continue;
+		}
+		
+		if ((character == '/') && (source[index + 1] == '*')) {
+			index += 2;
+			while ((index < size) && !((source[index] == '*') && (source[index + 1] == '/'))) index++;
+			index += 2;
+			continue;
+		}
+		
+		// Skip preprocessor lines, along with the lines they are continued onto; every branch of a conditional is read
+		if ((character == '#') && (lineStart)) {
+			while ((index < size) && (source[index] != '\n')) {
+				if ((source[index] == '\\') && (source[index + 1] == '\r') && (source[index + 2] == '\n')) index += 2;
+				else if ((source[index] == '\\') && (source[index + 1] == '\n')) index++;
+				index++;
+			}
+			continue;
+		}
+		
+		lineStart = false;
+		
+		header_token newToken = {};
+		newToken.start = index;
+		
+		if (isalpha((unsigned char)character) || (character == '_') || (character == '$')) {
+			newToken.kind = HEADER_TOKEN_WORD;
+			while ((index < size) && (isalnum((unsigned char)source[index]) || (source[index] == '_') || (source[index] == '$'))) index++;
+		} else if (isdigit((unsigned char)character)) {
+			newToken.kind = HEADER_TOKEN_NUMBER;
+			while ((index < size) && (isalnum((unsigned char)source[index]) || (source[index] == '_') || (source[index] == '.'))) index++;
+		} else if ((character == '"') || (character == '\'')) {
+			newToken.kind = HEADER_TOKEN_STRING;
+			index++;
+			while ((index < size) && (source[index] != character) && (source[index] != '\n')) index += (source[index] == '\\') ? 2 : 1;
+			index++;
+		} else if ((character == '.') && (source[index + 1] == '.') && (source[index + 2] == '.')) {
+			newToken.kind = HEADER_TOKEN_PUNCTUATOR;
+			index += 3;
+		} else if ((character == ':') && (source[index + 1] == ':')) {
+			newToken.kind = HEADER_TOKEN_PUNCTUATOR;
+			index += 2;
+		} else {
+			newToken.kind = HEADER_TOKEN_PUNCTUATOR;
+			index++;
+		}
+		
+		if (index > size) index = size;
+		newToken.length = index - newToken.start;
+		
+		if (!buffer_resize((void**)&pTranspiler->tokens.buffer, &pTranspiler->tokens.memSize, pTranspiler->tokens.size + 1, sizeof(header_token))) return false;
+		pTranspiler->tokens.buffer[(pTranspiler->tokens.size)++] = newToken;
+		
+	}
+	
+	return true;
+	
+}
+
+static bool header_is(header_transpiler* pTranspiler, header_token* pToken, char* text) {
+	size_t length = strlen(text);
+	return (pToken->length == length) && (memcmp(&pTranspiler->source[pToken->start], text, length) == 0);
+}
+
+static bool header_isAny(header_transpiler* pTranspiler, header_token* pToken, char** table, size_t count) {
+	if (pToken->kind != HEADER_TOKEN_WORD) return false;
+	for (size_t i = 0; i < count; i++) if (header_is(pTranspiler, pToken, table[i])) return true;
+	return false;
+}
+
+static bool header_copy(header_transpiler* pTranspiler, header_token* pToken, char* buffer) {
+	
+	// Names too long for a C* token are left out
+	if (pToken->length >= MAX_VALUE_LEN) return false;
+	
+	memcpy(buffer, &pTranspiler->source[pToken->start], pToken->length);
+	buffer[pToken->length] = '\0';
+	return true;
+	
+}
+
+static header_typedef* header_findTypedef(header_transpiler* pTranspiler, header_token* pToken) {
+	
+	if (pToken->kind != HEADER_TOKEN_WORD) return NULL;
+	
+	for (size_t i = 0; i < pTranspiler->typedefs.size; i++) {
+		if (header_is(pTranspiler, pToken, pTranspiler->typedefs.buffer[i].name)) return &pTranspiler->typedefs.buffer[i];
+	}
+	
+	// Return NULL if we found nothing
+	return NULL;
+	
+}
+
+static bool header_isIgnored(header_transpiler* pTranspiler, header_token* pToken) {
+	
+	if (header_isAny(pTranspiler, pToken, ignoredWords, sizeof(ignoredWords) / sizeof(ignoredWords[0]))) return true;
+	
+	// Source annotations are spelled like _In_, _Out_opt_ or _Check_return_
+	char* text = &pTranspiler->source[pToken->start];
+	return (pToken->kind == HEADER_TOKEN_WORD) && (pToken->length > 2) && (text[0] == '_') && isupper((unsigned char)text[1]) && (text[pToken->length - 1] == '_');
+	
+}
+
+static bool header_isAttribute(header_transpiler* pTranspiler, header_token* pToken) {
+	
+	// Compiler extensions that take arguments without declaring anything
+	char* text = &pTranspiler->source[pToken->start];
+	if (pToken->kind != HEADER_TOKEN_WORD) return false;
+	if ((pToken->length >= 11) && (strncmp(text, "__attribute", 11) == 0)) return true;
+	if ((pToken->length >= 10) && (strncmp(text, "__declspec", 10) == 0)) return true;
+	return header_is(pTranspiler, pToken, "__asm__") || header_is(pTranspiler, pToken, "__asm") || header_is(pTranspiler, pToken, "asm") || header_is(pTranspiler, pToken, "_Alignas");
+	
+}
+
+static bool header_isTypeWord(header_transpiler* pTranspiler, header_token* pToken) {
+	return header_isAny(pTranspiler, pToken, typeWords, sizeof(typeWords) / sizeof(typeWords[0])) || (header_findTypedef(pTranspiler, pToken) != NULL);
+}
+
+static bool header_isPunctuator(header_transpiler* pTranspiler, header_token* pToken, char* text) {
+	return (pToken->kind == HEADER_TOKEN_PUNCTUATOR) && header_is(pTranspiler, pToken, text);
+}
+
+static bool header_isReserved(char* name) {
+	
+	// Names C* already uses can't be declared again
+	struct token_table* tables[] = { token_kw_table, token_sp_table, token_qu_table };
+	for (size_t i = 0; i < (sizeof(tables) / sizeof(tables[0])); i++) {
+		for (size_t j = 0; tables[i][j].type != TOKEN_TYPE_UNDEFINED; j++) {
+			if (strcmp(tables[i][j].name, name) == 0) return true;
+		}
+	}
+	
+	char* builtins[] = { "byte", "int", "float", "decimal", "bool", "void", "true", "false", "null" };
+	for (size_t i = 0; i < (sizeof(builtins) / sizeof(builtins[0])); i++) {
+		if (strcmp(builtins[i], name) == 0) return true;
+	}
+	
+	return false;
+	
+}
+
+static size_t header_match(header_transpiler* pTranspiler, header_token* pTokens, size_t size, size_t open) {
+	
+	char* opening = header_isPunctuator(pTranspiler, &pTokens[open], "(") ? "(" : header_isPunctuator(pTranspiler, &pTokens[open], "[") ? "[" : "{";
+	char* closing = (opening[0] == '(') ? ")" : (opening[0] == '[') ? "]" : "}";
+	
+	// Find the closing token at the same depth, or the end if there isn't one
+	size_t depth = 0;
+	for (size_t i = open; i < size; i++) {
+		if (header_isPunctuator(pTranspiler, &pTokens[i], opening)) depth++;
+		else if (header_isPunctuator(pTranspiler, &pTokens[i], closing) && (--depth == 0)) return i;
+	}
+	
+	return size;
+	
+}
+
+/*////////*/
+
+static bool header_resolve(header_transpiler* pTranspiler, size_t first, size_t last, header_type* pType) {
+	
+	header_token* pTokens = pTranspiler->declaration.buffer;
+	
+	size_t chars = 0, shorts = 0, ints = 0, longs = 0, int64s = 0, floats = 0, doubles = 0, voids = 0, bools = 0;
+	bool record = false;
+	bool enumeration = false;
+	bool unknown = false;
+	header_typedef* pTypedef = NULL;
+	size_t pointers = 0;
+	
+	for (size_t i = first; i < last; i++) {
+		
+		header_token* pToken = &pTokens[i];
+		
+		if (header_isPunctuator(pTranspiler, pToken, "*")) {
+			pointers++;
+			continue;
+		}
+		
+		// Where a struct, union or enum had its body
+		if ((header_isPunctuator(pTranspiler, pToken, "{")) || (pToken->kind == HEADER_TOKEN_STRING)) continue;
+		
+		if (pToken->kind != HEADER_TOKEN_WORD) return false;
+		
+		// A word with arguments is an annotation
+		if (((i + 1) < last) && header_isPunctuator(pTranspiler, &pTokens[i + 1], "(")) {
+			i = header_match(pTranspiler, pTokens, last, i + 1);
+			continue;
+		}
+		
+		if (header_isIgnored(pTranspiler, pToken)) continue;
+		
+		if (header_is(pTranspiler, pToken, "char") || header_is(pTranspiler, pToken, "__int8")) chars++;
+		else if (header_is(pTranspiler, pToken, "short") || header_is(pTranspiler, pToken, "__int16")) shorts++;
+		else if (header_is(pTranspiler, pToken, "int") || header_is(pTranspiler, pToken, "__int32")) ints++;
+		else if (header_is(pTranspiler, pToken, "signed") || header_is(pTranspiler, pToken, "unsigned")) ints++;
+		else if (header_is(pTranspiler, pToken, "long")) longs++;
+		else if (header_is(pTranspiler, pToken, "__int64")) int64s++;
+		else if (header_is(pTranspiler, pToken, "float")) floats++;
+		else if (header_is(pTranspiler, pToken, "double")) doubles++;
+		else if (header_is(pTranspiler, pToken, "void")) voids++;
+		else if (header_is(pTranspiler, pToken, "_Bool") || header_is(pTranspiler, pToken, "bool")) bools++;
+		else if (header_is(pTranspiler, pToken, "struct") || header_is(pTranspiler, pToken, "union") || header_is(pTranspiler, pToken, "enum")) {
+			
+			if (header_is(pTranspiler, pToken, "enum")) enumeration = true;
+			else record = true;
+			
+			// Skip the tag
+			if (((i + 1) < last) && (pTokens[i + 1].kind == HEADER_TOKEN_WORD)) i++;
+			
+		} else {
+			
+			// An annotation without arguments looks the same as a type that was never declared
+			header_typedef* pFound = header_findTypedef(pTranspiler, pToken);
+			if ((pFound) && (!pTypedef)) pTypedef = pFound;
+			else unknown = true;
+			
+		}
+		
+	}
+	
+	// Windows keeps long at 32 bits, and long double at the size of a double
+	char* base = NULL;
+	if (voids) base = "void";
+	else if (bools) base = "bool";
+	else if (chars) base = "byte";
+	else if (floats) base = "short float";
+	else if (doubles) base = "float";
+	else if (shorts) base = "short int";
+	else if ((int64s) || (longs >= 2)) base = "long int";
+	else if ((ints) || (longs) || (enumeration)) base = "int";
+	else if (record) base = NULL;
+	else if (pTypedef) {
+		base = pTypedef->type.base;
+		pointers += pTypedef->type.pointers;
+	} else if (!unknown) return false;
+	
+	pType->base = base;
+	pType->pointers = pointers;
+	return true;
+	
+}
+
+static bool header_spell(header_type* pType, char* buffer, size_t size) {
+	
+	// Types C* has nothing for are only known by their address
+	if ((pType->base == NULL) && (pType->pointers == 0)) return false;
+	if (pType->pointers > 16) return false;
+	
+	int written = snprintf(buffer, size, "%s%.*s", (pType->base) ? pType->base : "void", (int)pType->pointers, "****************");
+	return (written > 0) && ((size_t)written < size);
+	
+}
+
+static bool header_parameter(header_transpiler* pTranspiler, size_t first, size_t last, size_t position, char* buffer, size_t size) {
+	
+	header_token* pTokens = pTranspiler->declaration.buffer;
+	
+	header_type parameterType = {};
+	char parameterName[MAX_VALUE_LEN] = {};
+	
+	// Arrays are passed as pointers
+	size_t arrays = 0;
+	for (size_t i = first; i < last; i++) {
+		if (!header_isPunctuator(pTranspiler, &pTokens[i], "[")) continue;
+		arrays++;
+		i = header_match(pTranspiler, pTokens, last, i);
+	}
+	for (size_t i = first; (arrays > 0) && (i < last); i++) {
+		if (header_isPunctuator(pTranspiler, &pTokens[i], "[")) last = i;
+	}
+	
+	// A function pointer is passed as a plain address, named by whatever follows its star
+	for (size_t i = first; i < last; i++) {
+		
+		if (!header_isPunctuator(pTranspiler, &pTokens[i], "(")) continue;
+		
+		size_t close = header_match(pTranspiler, pTokens, last, i);
+		if ((i > first) && (pTokens[i - 1].kind == HEADER_TOKEN_WORD) && (!header_isTypeWord(pTranspiler, &pTokens[i - 1]))) {
+			i = close;
+			continue;
+		}
+		
+		parameterType = (header_type){ "void", 1 };
+		for (size_t j = i + 1; j < close; j++) {
+			if ((pTokens[j].kind == HEADER_TOKEN_WORD) && header_isPunctuator(pTranspiler, &pTokens[j - 1], "*")) header_copy(pTranspiler, &pTokens[j], parameterName);
+		}
+		last = first;
+		break;
+		
+	}
+	
+	if (last > first) {
+		
+		// The name is the last word, as long as something before it gives the type
+		size_t end = last;
+		header_token* pLast = &pTokens[last - 1];
+		if ((pLast->kind == HEADER_TOKEN_WORD) && (!header_isTypeWord(pTranspiler, pLast)) && (!header_isIgnored(pTranspiler, pLast))) {
+			for (size_t i = first; i < (last - 1); i++) {
+				if ((header_isPunctuator(pTranspiler, &pTokens[i], "*")) || ((pTokens[i].kind == HEADER_TOKEN_WORD) && (!header_isIgnored(pTranspiler, &pTokens[i])))) {
+					header_copy(pTranspiler, pLast, parameterName);
+					end = last - 1;
+					break;
+				}
+			}
+		}
+		
+		if (!header_resolve(pTranspiler, first, end, &parameterType)) return false;
+		parameterType.pointers += arrays;
+		
+	}
+	
+	// Parameters without a usable name are named by their position
+	if ((parameterName[0] == '\0') || header_isReserved(parameterName)) snprintf(parameterName, sizeof(parameterName), "_%llu", (unsigned long long)position);
+	
+	char typeName[MAX_VALUE_LEN] = {};
+	if ((parameterType.base) && (strcmp(parameterType.base, "void") == 0) && (parameterType.pointers == 0)) return false;
+	if (!header_spell(&parameterType, typeName, sizeof(typeName))) return false;
+	
+	int written = snprintf(buffer, size, "%s %s", typeName, parameterName);
+	return (written > 0) && ((size_t)written < size);
+	
+}
+
+static bool header_write(header_transpiler* pTranspiler, char* text) {
+	
+	header* pHeader = pTranspiler->pHeader;
+	size_t length = strlen(text);
+	
+	if (!buffer_resize((void**)&pHeader->buffer, &pTranspiler->memSize, pHeader->size + length + 1, sizeof(char))) return false;
+	
+	memcpy(&pHeader->buffer[pHeader->size], text, length + 1);
+	pHeader->size += length;
+	
+	return true;
+	
+}
+
+static bool header_typedefs(header_transpiler* pTranspiler) {
+	
+	header_token* pTokens = pTranspiler->declaration.buffer;
+	size_t size = pTranspiler->declaration.size;
+	
+	// A pointer to a function is an address, whatever calling convention is given with the star
+	for (size_t i = 0; i < size; i++) {
+		
+		if (!header_isPunctuator(pTranspiler, &pTokens[i], "(")) continue;
+		
+		size_t star = i + 1;
+		while ((star < size) && header_isIgnored(pTranspiler, &pTokens[star])) star++;
+		
+		if (((star + 2) < size) && header_isPunctuator(pTranspiler, &pTokens[star], "*") && (pTokens[star + 1].kind == HEADER_TOKEN_WORD) && header_isPunctuator(pTranspiler, &pTokens[star + 2], ")")) {
+			header_typedef newTypedef = { .type = { "void", 1 } };
+			if ((header_findTypedef(pTranspiler, &pTokens[star + 1])) || (!header_copy(pTranspiler, &pTokens[star + 1], newTypedef.name))) return true;
+			if (!buffer_resize((void**)&pTranspiler->typedefs.buffer, &pTranspiler->typedefs.memSize, pTranspiler->typedefs.size + 1, sizeof(header_typedef))) return false;
+			pTranspiler->typedefs.buffer[(pTranspiler->typedefs.size)++] = newTypedef;
+			return true;
+		}
+	}
+	
+	// Arrays and function types have nothing to stand for; a word with arguments is an annotation
+	for (size_t i = 0; i < size; i++) {
+		if (header_isPunctuator(pTranspiler, &pTokens[i], "[")) return true;
+		if (!header_isPunctuator(pTranspiler, &pTokens[i], "(")) continue;
+		if ((i == 0) || (pTokens[i - 1].kind != HEADER_TOKEN_WORD) || header_isTypeWord(pTranspiler, &pTokens[i - 1])) return true;
+		if (header_isAttribute(pTranspiler, &pTokens[i - 1]) || header_isIgnored(pTranspiler, &pTokens[i - 1])) i = header_match(pTranspiler, pTokens, size, i);
+		else return true;
+	}
+	
+	// The first declarator carries the type, and every other one only adds its own stars
+	size_t end = 0;
+	while ((end < size) && (!header_isPunctuator(pTranspiler, &pTokens[end], ","))) end++;
+	if ((end == 0) || (pTokens[end - 1].kind != HEADER_TOKEN_WORD)) return true;
+	
+	header_type baseType = {};
+	if (!header_resolve(pTranspiler, 0, end - 1, &baseType)) return true;
+	
+	for (size_t i = 0; i < end; i++) if (header_isPunctuator(pTranspiler, &pTokens[i], "*")) baseType.pointers--;
+	
+	for (size_t start = 0; start < size; start = end + 1) {
+		
+		end = start;
+		while ((end < size) && (!header_isPunctuator(pTranspiler, &pTokens[end], ","))) end++;
+		if ((end == start) || (pTokens[end - 1].kind != HEADER_TOKEN_WORD)) continue;
+		
+		header_typedef newTypedef = { .type = baseType };
+		for (size_t i = start; i < end; i++) if (header_isPunctuator(pTranspiler, &pTokens[i], "*")) (newTypedef.type.pointers)++;
+		
+		// The first definition is kept, like the predefined ones and the branch a conditional would usually take
+		if ((header_findTypedef(pTranspiler, &pTokens[end - 1])) || (!header_copy(pTranspiler, &pTokens[end - 1], newTypedef.name))) continue;
+		
+		if (!buffer_resize((void**)&pTranspiler->typedefs.buffer, &pTranspiler->typedefs.memSize, pTranspiler->typedefs.size + 1, sizeof(header_typedef))) return false;
+		pTranspiler->typedefs.buffer[(pTranspiler->typedefs.size)++] = newTypedef;
+		
+	}
+	
+	return true;
+	
+}
+
+static bool header_declaration(header_transpiler* pTranspiler) {
+	
+	header_token* pTokens = pTranspiler->declaration.buffer;
+	size_t size = pTranspiler->declaration.size;
+	
+	// Leave out whatever only C++ can declare
+	for (size_t i = 0; i < size; i++) {
+		if (header_isAny(pTranspiler, &pTokens[i], cppWords, sizeof(cppWords) / sizeof(cppWords[0]))) return true;
+		if (header_isPunctuator(pTranspiler, &pTokens[i], "::") || header_isPunctuator(pTranspiler, &pTokens[i], "<") || header_isPunctuator(pTranspiler, &pTokens[i], "&") || header_isPunctuator(pTranspiler, &pTokens[i], "=")) return true;
+	}
+	
+	for (size_t i = 0; i < size; i++) {
+		if (header_is(pTranspiler, &pTokens[i], "typedef")) return header_typedefs(pTranspiler);
+		if (header_is(pTranspiler, &pTokens[i], "static")) return true;
+	}
+	
+	// The name is the first word with a parameter list after it that has a type before it; the words with arguments before that are annotations
+	size_t name = size;
+	bool typed = false;
+	for (size_t i = 0; i < size; i++) {
+		
+		header_token* pToken = &pTokens[i];
+		
+		if (header_isPunctuator(pTranspiler, pToken, "*")) typed = true;
+		
+		// Anything else in parentheses is a declarator C* can't spell, like a function returning a function pointer
+		if (header_isPunctuator(pTranspiler, pToken, "(")) return true;
+		
+		if (pToken->kind != HEADER_TOKEN_WORD) continue;
+		
+		if (((i + 1) < size) && header_isPunctuator(pTranspiler, &pTokens[i + 1], "(")) {
+			if ((typed) && (!header_isIgnored(pTranspiler, pToken)) && (!header_isTypeWord(pTranspiler, pToken))) {
+				name = i;
+				break;
+			}
+			i = header_match(pTranspiler, pTokens, size, i + 1);
+			continue;
+		}
+		
+		if (header_isTypeWord(pTranspiler, pToken)) typed = true;
+		
+	}
+	
+	// Variables are left out, as an import only brings in functions
+	if (name == size) return true;
+	
+	char functionName[MAX_VALUE_LEN] = {};
+	if ((!header_copy(pTranspiler, &pTokens[name], functionName)) || header_isReserved(functionName)) return true;
+	
+	for (size_t i = 0; i < pTranspiler->names.size; i++) {
+		if (strcmp(pTranspiler->names.buffer[i], functionName) == 0) return true;
+	}
+	
+	header_type returnType = {};
+	char returnName[MAX_VALUE_LEN] = {};
+	if ((!header_resolve(pTranspiler, 0, name, &returnType)) || (!header_spell(&returnType, returnName, sizeof(returnName)))) return true;
+	
+	char line[HEADER_MAX_LINE] = {};
+	int length = snprintf(line, sizeof(line), "import %s %s(", returnName, functionName);
+	
+	// Parameters are split at the commas between them
+	size_t open = name + 1;
+	size_t close = header_match(pTranspiler, pTokens, size, open);
+	size_t count = 0;
+	
+	for (size_t start = open + 1; start < close; start++) {
+		
+		size_t end = start;
+		while ((end < close) && (!header_isPunctuator(pTranspiler, &pTokens[end], ","))) {
+			if (header_isPunctuator(pTranspiler, &pTokens[end], "(") || header_isPunctuator(pTranspiler, &pTokens[end], "[")) end = header_match(pTranspiler, pTokens, close, end);
+			end++;
+		}
+		
+		// (void) takes nothing
+		bool onlyVoid = ((end - start) == 1) && header_is(pTranspiler, &pTokens[start], "void");
+		if ((onlyVoid) && (start == (open + 1)) && (end == close)) break;
+		
+		char parameter[HEADER_MAX_LINE] = {};
+		if (header_isPunctuator(pTranspiler, &pTokens[start], "...")) strcpy(parameter, "...");
+		else if (!header_parameter(pTranspiler, start, end, count + 1, parameter, sizeof(parameter))) return true;
+		
+		length += snprintf(&line[length], sizeof(line) - length, "%s%s", (count > 0) ? ", " : "", parameter);
+		if ((size_t)length >= sizeof(line)) return true;
+		
+		count++;
+		start = end;
+		
+	}
+	
+	length += snprintf(&line[length], sizeof(line) - length, ");\n");
+	if ((size_t)length >= sizeof(line)) return true;
+	
+	// Remember the name, so a later declaration of it is skipped
+	if (!buffer_resize((void**)&pTranspiler->names.buffer, &pTranspiler->names.memSize, pTranspiler->names.size + 1, sizeof(pTranspiler->names.buffer[0]))) return false;
+	strcpy(pTranspiler->names.buffer[(pTranspiler->names.size)++], functionName);
+	
+	return header_write(pTranspiler, line);
+	
+}
+
+static bool header_transpile(header_transpiler* pTranspiler) {
+	
+	// Start with the types the headers that aren't followed would have defined
+	for (size_t i = 0; i < (sizeof(typedefTable) / sizeof(typedefTable[0])); i++) {
+		if (!buffer_resize((void**)&pTranspiler->typedefs.buffer, &pTranspiler->typedefs.memSize, pTranspiler->typedefs.size + 1, sizeof(header_typedef))) return false;
+		header_typedef* pTypedef = &pTranspiler->typedefs.buffer[(pTranspiler->typedefs.size)++];
+		strcpy(pTypedef->name, typedefTable[i].name);
+		pTypedef->type = typedefTable[i].type;
+	}
+	
+	// The interface is never empty, so it always has a buffer
+	if (!header_write(pTranspiler, "")) return false;
+	
+	header_token* pTokens = pTranspiler->tokens.buffer;
+	size_t size = pTranspiler->tokens.size;
+	
+	// Collect each declaration up to its semicolon
+	for (size_t i = 0; i < size; i++) {
+		
+		header_token* pDeclaration = pTranspiler->declaration.buffer;
+		size_t declarationSize = pTranspiler->declaration.size;
+		
+		if (header_isPunctuator(pTranspiler, &pTokens[i], "{")) {
+			
+			// extern "C" only wraps what is inside it
+			if ((declarationSize == 2) && header_is(pTranspiler, &pDeclaration[0], "extern") && (pDeclaration[1].kind == HEADER_TOKEN_STRING)) {
+				pTranspiler->declaration.size = 0;
+				continue;
+			}
+			
+			size_t close = header_match(pTranspiler, pTokens, size, i);
+			
+			// A body after a parameter list is a function defined in the header, which has nothing to import
+			bool function = false;
+			if ((declarationSize > 0) && header_isPunctuator(pTranspiler, &pDeclaration[declarationSize - 1], ")")) {
+				size_t open = declarationSize - 1;
+				size_t depth = 0;
+				do {
+					if (header_isPunctuator(pTranspiler, &pDeclaration[open], ")")) depth++;
+					else if (header_isPunctuator(pTranspiler, &pDeclaration[open], "(")) depth--;
+				} while ((depth > 0) && (open-- > 0));
+				function = (open > 0) && (open < declarationSize) && (pDeclaration[open - 1].kind == HEADER_TOKEN_WORD) && (!header_isAttribute(pTranspiler, &pDeclaration[open - 1]));
+			}
+			
+			// The body of a struct, union or enum is left out, keeping a brace to show where it was
+			bool record = false;
+			for (size_t j = 0; j < declarationSize; j++) {
+				if (header_is(pTranspiler, &pDeclaration[j], "struct") || header_is(pTranspiler, &pDeclaration[j], "union") || header_is(pTranspiler, &pDeclaration[j], "enum")) record = true;
+			}
+			
+			if ((record) && (!function)) {
+				if (!buffer_resize((void**)&pTranspiler->declaration.buffer, &pTranspiler->declaration.memSize, declarationSize + 1, sizeof(header_token))) return false;
+				pTranspiler->declaration.buffer[(pTranspiler->declaration.size)++] = pTokens[i];
+			} else pTranspiler->declaration.size = 0;
+			
+			i = close;
+			continue;
+			
+		}
+		
+		// The end of an extern "C" block
+		if (header_isPunctuator(pTranspiler, &pTokens[i], "}")) {
+			pTranspiler->declaration.size = 0;
+			continue;
+		}
+		
+		if (header_isPunctuator(pTranspiler, &pTokens[i], ";")) {
+			if (!header_declaration(pTranspiler)) return false;
+			pTranspiler->declaration.size = 0;
+			continue;
+		}
+		
+		if (!buffer_resize((void**)&pTranspiler->declaration.buffer, &pTranspiler->declaration.memSize, declarationSize + 1, sizeof(header_token))) return false;
+		pTranspiler->declaration.buffer[(pTranspiler->declaration.size)++] = pTokens[i];
+		
+	}
+	
+	return true;
+	
+}
+
+/*////////*/
+
+bool header_create(header* pHeader, header_info* pInfo) {
+	
+	// Check if valid pointers were passed
+	if (pInfo == NULL) return false;
+	
+	*pHeader = (header){};
+	
+	// Read the header
+	size_t sourceSize = 0;
+	char* source = header_read(pInfo->fileName, &sourceSize);
+	if (source == NULL) return false;
+	
+	// Headers are found in the cache by what is in them, not by where they are
+	pHeader->hash = header_hash(source, sourceSize);
+	
+	char cacheName[HEADER_MAX_PATH] = {};
+	bool caching = (pInfo->cacheDir) && (pInfo->cacheDir[0] != '\0');
+	if (caching) {
+		int written = snprintf(cacheName, sizeof(cacheName), "%s/%016llx%s", pInfo->cacheDir, (unsigned long long)pHeader->hash, HEADER_CACHE_EXTENSION);
+		caching = (written > 0) && ((size_t)written < sizeof(cacheName));
+	}
+	
+	// A header that has been seen before costs a read
+	if (caching) {
+		pHeader->buffer = header_read(cacheName, &pHeader->size);
+		if (pHeader->buffer) {
+			pHeader->cached = true;
+			free(source);
+			return true;
+		}
+	}
+	
+	// Otherwise transpile it
+	header_transpiler transpiler = {};
+	transpiler.source = source;
+	transpiler.sourceSize = sourceSize;
+	transpiler.pHeader = pHeader;
+	
+	bool succeeded = header_lex(&transpiler) && header_transpile(&transpiler);
+	
+	free(transpiler.tokens.buffer);
+	free(transpiler.declaration.buffer);
+	free(transpiler.typedefs.buffer);
+	free(transpiler.names.buffer);
+	free(source);
+	
+	if (!succeeded) {
+		header_destroy(pHeader);
+		return false;
+	}
+	
+	if (caching) header_store(pHeader, pInfo->cacheDir, cacheName);
+	
+	// Return success
+	return true;
+	
+}
+
+void header_destroy(header* pHeader) {
+	
+	// Free memory
+	free(pHeader->buffer);
+	pHeader->buffer = NULL;
+	pHeader->size = 0;
+	
+}
+
+/*////////*/
+
+static void header_error(code* pCode, uint32_t offset, char* msg, char* name) {
+	
+	// Convert the offset of the import into a line and column
+	size_t line, column;
+	code_locate(pCode, offset, &line, &column);
+	
+	print_utf8("%s:%llu:%llu: error: %s%s%s\n", pCode->fileName, (unsigned long long)line, (unsigned long long)column, msg, (name) ? " " : "", (name) ? name : "");
+	
+}
+
+static bool header_try(char* buffer, size_t size, char* directory, size_t directoryLength, char* name) {
+	
+	// Directories from the environment might already end in a separator
+	char* separator = ((directoryLength == 0) || (directory[directoryLength - 1] == '/') || (directory[directoryLength - 1] == '\\')) ? "" : "/";
+	
+	int written = snprintf(buffer, size, "%.*s%s%s", (int)directoryLength, directory, separator, name);
+	if ((written <= 0) || ((size_t)written >= size)) return false;
+	
+	FILE* file = fopen(buffer, "rb");
+	if (file == NULL) return false;
+	
+	fclose(file);
+	return true;
+	
+}
+
+static bool header_search(char* buffer, size_t size, char* name, header_import_info* pInfo) {
+	
+	// Complete paths are used as they are
+	if ((name[0] == '/') || (name[0] == '\\') || ((name[0] != '\0') && (name[1] == ':'))) return header_try(buffer, size, "", 0, name);
+	
+	// Then look next to the file
+	char* fileName = pInfo->pCode->fileName;
+	size_t directoryLength = 0;
+	for (size_t i = 0; fileName[i] != '\0'; i++) if ((fileName[i] == '/') || (fileName[i] == '\\')) directoryLength = i + 1;
+	if (header_try(buffer, size, fileName, directoryLength, name)) return true;
+	
+	// Then in each directory given with -I
+	for (size_t i = 0; i < pInfo->includeCount; i++) {
+		if (header_try(buffer, size, pInfo->includePaths[i], strlen(pInfo->includePaths[i]), name)) return true;
+	}
+	
+	// Then where the C compiler would look
+	char* include = getenv("INCLUDE");
+	while ((include) && (*include != '\0')) {
+		char* next = strchr(include, ';');
+		size_t length = (next) ? (size_t)(next - include) : strlen(include);
+		if ((length > 0) && header_try(buffer, size, include, length, name)) return true;
+		include = (next) ? (next + 1) : NULL;
+	}
+	
+	return false;
+	
+}
+
+static bool header_push(stream* pStream, token newToken) {
+	
+	if (!stream_resize(pStream)) return false;
+	pStream->buffer[(pStream->size)++] = newToken;
+	return true;
+	
+}
+
+static bool header_splice(stream* pNewStream, stream* pStream, size_t importIndex, size_t semicolonIndex, header_import_info* pInfo) {
+	
+	code* pCode = pInfo->pCode;
+	token* pImport = &pStream->buffer[importIndex];
+	
+	if (semicolonIndex >= pStream->size) {
+		header_error(pCode, pImport->offset, "Missing semicolon after header", NULL);
+		return false;
+	}
+	
+	// Tokens split a path apart at every slash and period, so the name is put back together from all of them up to the semicolon
+	char name[HEADER_MAX_PATH] = {};
+	size_t length = 0;
+	for (size_t i = importIndex + 2; i < semicolonIndex; i++) {
+		size_t valueLength = strlen(pStream->buffer[i].value);
+		if ((length + valueLength) >= (sizeof(name) - 3)) {
+			header_error(pCode, pImport->offset, "Expected a header name", NULL);
+			return false;
+		}
+		memcpy(&name[length], pStream->buffer[i].value, valueLength);
+		length += valueLength;
+	}
+	
+	// It can be quoted or in angle brackets like in C
+	if ((length >= 2) && (((name[0] == '"') && (name[length - 1] == '"')) || ((name[0] == '<') && (name[length - 1] == '>')))) {
+		memmove(name, &name[1], length - 2);
+		length -= 2;
+		name[length] = '\0';
+	}
+	
+	if (length == 0) {
+		header_error(pCode, pImport->offset, "Expected a header name", NULL);
+		return false;
+	}
+	
+	// A bare name means the C header of that name
+	char* base = name;
+	for (char* c = name; *c; c++) if ((*c == '/') || (*c == '\\')) base = c + 1;
+	if (strchr(base, '.') == NULL) strcat(name, ".h");
+	
+	char path[HEADER_MAX_PATH] = {};
+	if (!header_search(path, sizeof(path), name, pInfo)) {
+		header_error(pCode, pImport->offset, "Could not find header", name);
+		return false;
+	}
+	
+	// Remember the header, since the output now depends on it
+	if (pInfo->pFound) {
+		char* foundPath = strdup(path);
+		if ((!foundPath) || (!buffer_resize((void**)&pInfo->pFound->buffer, &pInfo->pFound->memSize, pInfo->pFound->size + 1, sizeof(char*)))) {
+			free(foundPath);
+			return false;
+		}
+		pInfo->pFound->buffer[(pInfo->pFound->size)++] = foundPath;
+	}
+	
+	// Define header info
+	header_info headerInfo = {};
+	headerInfo.fileName = path;
+	headerInfo.cacheDir = pInfo->cacheDir;
+	
+	header newHeader = {};
+	if (!header_create(&newHeader, &headerInfo)) {
+		header_error(pCode, pImport->offset, "Could not read header", path);
+		return false;
+	}
+	
+	// Tokenize the interface the same way as the file
+	code interfaceCode = {};
+	interfaceCode.buffer = newHeader.buffer;
+	interfaceCode.size = newHeader.size;
+	interfaceCode.fileName = path;
+	
+	stream_info interfaceStreamInfo = {};
+	interfaceStreamInfo.pCode = &interfaceCode;
+	
+	stream interfaceStream = {};
+	bool succeeded = stream_create(&interfaceStream, &interfaceStreamInfo);
+	
+	// Everything that came from the header is reported at the import
+	for (size_t i = 0; (succeeded) && (i < interfaceStream.size); i++) {
+		token newToken = interfaceStream.buffer[i];
+		newToken.offset = pImport->offset;
+		succeeded = header_push(pNewStream, newToken);
+	}
+	
+	stream_destroy(&interfaceStream);
+	header_destroy(&newHeader);
+	
+	return succeeded;
+	
+}
+
+bool header_import(stream* pStream, header_import_info* pInfo) {
+	
+	// Most files import no headers, so look before copying anything
+	bool found = false;
+	for (size_t i = 0; (i + 1) < pStream->size; i++) {
+		if ((pStream->buffer[i].type == TOKEN_TYPE_KW_IMPORT) && (pStream->buffer[i + 1].type == TOKEN_TYPE_KW_HEADER)) found = true;
+	}
+	if (!found) return true;
+	
+	stream newStream = {};
+	bool succeeded = true;
+	
+	for (size_t i = 0; i < pStream->size; i++) {
+		
+		// Replace each import of a header, up to its semicolon, with the declarations from it
+		if (((i + 1) < pStream->size) && (pStream->buffer[i].type == TOKEN_TYPE_KW_IMPORT) && (pStream->buffer[i + 1].type == TOKEN_TYPE_KW_HEADER)) {
+			
+			size_t semicolonIndex = i + 2;
+			while ((semicolonIndex < pStream->size) && (pStream->buffer[semicolonIndex].type != TOKEN_TYPE_PT_SEMICOLON)) semicolonIndex++;
+			
+			// Every missing header is reported before giving up
+			if (!header_splice(&newStream, pStream, i, semicolonIndex, pInfo)) succeeded = false;
+			
+			i = semicolonIndex;
+			continue;
+			
+		}
+		
+		if (!header_push(&newStream, pStream->buffer[i])) succeeded = false;
+		
+	}
+	
+	// The stream still ends on the end of file token, one past its size
+	if ((succeeded) && (!stream_resize(&newStream))) succeeded = false;
+	
+	if (!succeeded) {
+		stream_destroy(&newStream);
+		return false;
+	}
+	
+	newStream.buffer[newStream.size] = pStream->buffer[pStream->size];
+	
+	stream_destroy(pStream);
+	*pStream = newStream;
+	
+	// Return success
+	return true;
+	
+}
+
+void header_paths_destroy(header_paths* pPaths) {
+	
+	for (size_t i = 0; i < pPaths->size; i++) free(pPaths->buffer[i]);
+	free(pPaths->buffer);
+	*pPaths = (header_paths){};
+	
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+// [ MACROS ] //
+
+#define HEADER_CACHE_VERSION 1 // Part of every cache key, so interfaces written in an older format are not picked up
+#define HEADER_CACHE_EXTENSION ".csri"
+
+// [ DEFINING ] //
+
+typedef struct {
+	char* fileName; // The C header to turn into a module interface
+	char* cacheDir; // Where interfaces are kept between builds; NULL transpiles the header every time
+} header_info;
+
+typedef struct {
+	
+	// The module interface, one import declaration per line
+	size_t size;
+	char* buffer;
+	
+	uint64_t hash; // Of the header's contents, which is what it is found by in the cache
+	bool cached; // The interface was read from the cache instead of transpiled
+	
+} header;
+
+/*////////*/
+
+// The path of every header an import found, for whoever needs to know what the output depends on
+typedef struct {
+	size_t memSize;
+	size_t size;
+	char** buffer;
+} header_paths;
+
+typedef struct {
+	code* pCode; // The file the stream was made from, for its directory and for locating errors
+	char* cacheDir;
+	char** includePaths; // Searched after the file's own directory and before the INCLUDE environment variable
+	size_t includeCount;
+	header_paths* pFound; // If given, every header that is imported is added to it
+} header_import_info;
+
+// [ FUNCTIONS ] //
+
+bool header_create(header* pHeader, header_info* pInfo);
+void header_destroy(header* pHeader);
+
+bool header_import(stream* pStream, header_import_info* pInfo);
+void header_paths_destroy(header_paths* pPaths);
\ No newline at end of file
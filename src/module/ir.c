@@ -0,0 +1,956 @@
+// [ INCLUDING ] //
+
+#include "common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// [ MACROS ] //
+
+#define advance(x) ((pIR->index) += (x))
+
+#define peek(x) (((pIR->index + (x)) >= pIR->size) ? (unit){UNIT_TYPE_KW_END, ""} : (pIR->buffer[pIR->index + (x)]))
+#define ppeek(x) ((pIR->index + (x) >= pIR->size) ? (unit[]){(unit){UNIT_TYPE_KW_END, ""}} : &(pIR->buffer[pIR->index + (x)]))
+
+#define RUN_REGISTERS (UNIT_TYPE_RG_ARG4 - UNIT_TYPE_RG_RETVAL + 1)
+#define RUN_RETVAL 0 // Where the return value register is kept
+
+#define RUN_ADDRESS_BASE 0x10000 // Strings and type descriptors are given made up addresses, well away from small numbers
+#define RUN_ADDRESS_STRIDE 0x100
+
+// [ DEFINING ] //
+
+typedef enum {
+	RUN_OPERAND_NONE,
+	RUN_OPERAND_CONSTANT,
+	RUN_OPERAND_REGISTER,
+	RUN_OPERAND_LOCAL,
+	RUN_OPERAND_GLOBAL,
+} run_operand_kind;
+
+typedef struct {
+	run_operand_kind kind;
+	unit_type type; // The width it is read and written at
+	int64_t value; // The constant itself, or which register, local or global it is
+} run_operand;
+
+typedef struct {
+	
+	unit_type op;
+	unit_type compare;
+	
+	run_operand target;
+	run_operand source;
+	run_operand left;
+	run_operand right;
+	
+	// Branches and calls name where they go, which is only known once everything has been decoded
+	char* label;
+	size_t next;
+	
+	// Switches keep their cases apart, and arguments keep their position in first
+	size_t first;
+	size_t count;
+	
+} run_step;
+
+typedef struct {
+	int64_t value;
+	char* label;
+	size_t next;
+} run_case;
+
+typedef struct {
+	char* name;
+	unit_type type;
+	int64_t value;
+} run_name;
+
+typedef struct {
+	size_t memSize;
+	size_t size;
+	run_name* buffer;
+} run_names;
+
+typedef struct {
+	
+	char* name;
+	bool imported;
+	unit_type retType;
+	
+	// The first step of the body, and the slots its frame needs, parameters first
+	size_t entry;
+	size_t slotCount;
+	
+	size_t paramCount;
+	unit_type paramTypes[IR_RUN_MAX_ARGS];
+	
+} run_function;
+
+typedef struct {
+	size_t function;
+	size_t base;
+	size_t ret;
+} run_frame;
+
+typedef struct {
+	
+	ir_run* pRun;
+	
+	// The program, decoded once so that running it never looks at a unit or a name again
+	struct {
+		size_t memSize;
+		size_t size;
+		run_step* buffer;
+	} steps;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		run_case* buffer;
+	} cases;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		run_function* buffer;
+	} functions;
+	
+	bool inside;
+	size_t function;
+	
+	// Globals hold their own values; locals only last while the function they belong to is decoded
+	run_names globals;
+	run_names locals;
+	run_names labels;
+	run_names addresses;
+	
+	// The machine; nothing is held in a register across a call, so there is only one set of them
+	int64_t registers[RUN_REGISTERS];
+	int64_t args[IR_RUN_MAX_ARGS];
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		int64_t* buffer;
+	} slots;
+	
+	run_frame frames[IR_RUN_MAX_DEPTH];
+	size_t depth;
+	
+} run_state;
+
+// [ FUNCTIONS ] //
+
+static bool run_fail(run_state* pState, ir_run_status status, char* detail) {
+	
+	// Only the first thing to go wrong is kept
+	if (pState->pRun->status == IR_RUN_STATUS_RETURNED) {
+		pState->pRun->status = status;
+		strncpy(pState->pRun->detail, (detail) ? detail : "", MAX_VALUE_LEN - 1);
+	}
+	
+	return false;
+	
+}
+
+static int64_t run_wrap(unit_type type, int64_t value) {
+	
+	// Values are kept at the width of whatever holds them
+	switch (type) {
+		case (UNIT_TYPE_TP_S8) return (int8_t)value;
+		case (UNIT_TYPE_TP_S16) return (int16_t)value;
+		case (UNIT_TYPE_TP_S32) return (int32_t)value;
+		case (UNIT_TYPE_TP_U8) return (uint8_t)value;
+		case (UNIT_TYPE_TP_U16) return (uint16_t)value;
+		case (UNIT_TYPE_TP_U32) return (uint32_t)value;
+		default: return value;
+	}
+	
+}
+
+static bool run_isUnsigned(unit_type type) {
+	return ((type >= UNIT_TYPE_TP_U8) && (type <= UNIT_TYPE_TP_U64));
+}
+
+/*////////*/
+
+static run_name* name_add(run_names* pNames, char* name, unit_type type, int64_t value) {
+	
+	if (!buffer_resize((void**)&pNames->buffer, &pNames->memSize, pNames->size + 1, sizeof(run_name))) return NULL;
+	
+	run_name* pName = &pNames->buffer[(pNames->size)++];
+	pName->name = name;
+	pName->type = type;
+	pName->value = value;
+	
+	return pName;
+	
+}
+
+static run_name* name_find(run_names* pNames, char* name) {
+	
+	// The newest declaration hides older ones with the same name
+	for (size_t i = pNames->size; i > 0; i--)
+		if (strcmp(pNames->buffer[i - 1].name, name) == 0) return &pNames->buffer[i - 1];
+	
+	return NULL;
+	
+}
+
+static run_function* function_find(run_state* pState, char* name) {
+	
+	for (size_t i = 0; i < pState->functions.size; i++)
+		if (strcmp(pState->functions.buffer[i].name, name) == 0) return &pState->functions.buffer[i];
+	
+	return NULL;
+	
+}
+
+/*////////*/
+
+static bool literal_decode(run_state* pState, char* value, int64_t* pValue) {
+	
+	// Numbers are taken as they are written
+	char* end = NULL;
+	*pValue = (int64_t)strtoull(value, &end, 0);
+	if ((end != value) && (*end == '\0')) return true;
+	
+	// Characters are their code
+	if ((value[0] == '\'') && (value[1] != '\0')) {
+		
+		char character = value[1];
+		if (character == '\\') {
+			switch (value[2]) {
+				case ('n') character = '\n'; break;
+				case ('t') character = '\t'; break;
+				case ('r') character = '\r'; break;
+				case ('0') character = '\0'; break;
+				default: character = value[2]; break;
+			}
+		}
+		
+		*pValue = character;
+		return true;
+		
+	}
+	
+	// Anything else names something in memory, such as a string or a type descriptor, and is given an address of its own
+	run_name* pName = name_find(&pState->addresses, value);
+	if (!pName) pName = name_add(&pState->addresses, value, UNIT_TYPE_TP_U64, RUN_ADDRESS_BASE + (pState->addresses.size * RUN_ADDRESS_STRIDE));
+	if (!pName) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, value);
+	
+	*pValue = pName->value;
+	return true;
+	
+}
+
+static bool operand_decode(run_state* pState, ir* pIR, run_operand* pOperand) {
+	
+	// Registers come with their size, and other values sometimes do
+	pOperand->type = UNIT_TYPE_TP_S64;
+	if ((peek(0).type > UNIT_TYPE_TP_UK) && (peek(0).type < UNIT_TYPE_RG_UK)) {
+		pOperand->type = peek(0).type;
+		advance(1);
+	}
+	
+	unit* pUnit = ppeek(0);
+	advance(1);
+	
+	if (pUnit->type == UNIT_TYPE_LITERAL) {
+		pOperand->kind = RUN_OPERAND_CONSTANT;
+		return literal_decode(pState, pUnit->value, &pOperand->value);
+	}
+	
+	if ((pUnit->type > UNIT_TYPE_RG_UK) && (pUnit->type <= UNIT_TYPE_RG_ARG4)) {
+		pOperand->kind = RUN_OPERAND_REGISTER;
+		pOperand->value = pUnit->type - UNIT_TYPE_RG_RETVAL;
+		return true;
+	}
+	
+	if (pUnit->type != UNIT_TYPE_IDENTIFIER) return run_fail(pState, IR_RUN_STATUS_MALFORMED, "operand");
+	
+	// Variables are always used at the size they were declared with, and locals hide globals
+	run_names* pNames = &pState->locals;
+	pOperand->kind = RUN_OPERAND_LOCAL;
+	
+	run_name* pName = name_find(pNames, pUnit->value);
+	if (!pName) {
+		pNames = &pState->globals;
+		pOperand->kind = RUN_OPERAND_GLOBAL;
+		pName = name_find(pNames, pUnit->value);
+	}
+	
+	if (!pName) return run_fail(pState, IR_RUN_STATUS_MALFORMED, pUnit->value);
+	
+	pOperand->type = pName->type;
+	pOperand->value = pName - pNames->buffer;
+	
+	return true;
+	
+}
+
+static bool compare_decode(run_state* pState, ir* pIR, run_step* pStep) {
+	
+	// Comparisons look like: value compare [value]
+	if (!operand_decode(pState, pIR, &pStep->left)) return false;
+	
+	pStep->compare = peek(0).type;
+	advance(1);
+	
+	if ((pStep->compare < UNIT_TYPE_KW_CMP_Z) || (pStep->compare > UNIT_TYPE_KW_CMP_NE)) return run_fail(pState, IR_RUN_STATUS_MALFORMED, "comparison");
+	
+	if ((pStep->compare == UNIT_TYPE_KW_CMP_Z) || (pStep->compare == UNIT_TYPE_KW_CMP_NZ)) return true;
+	
+	return operand_decode(pState, pIR, &pStep->right);
+	
+}
+
+/*////////*/
+
+static bool function_decode(run_state* pState, ir* pIR) {
+	
+	if (!buffer_resize((void**)&pState->functions.buffer, &pState->functions.memSize, pState->functions.size + 1, sizeof(run_function))) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+	
+	run_function* pFunc = &pState->functions.buffer[pState->functions.size];
+	memset(pFunc, 0, sizeof(run_function));
+	
+	// Functions look like: [linkage] func type name : (type param [,])* and only those with a body end in a semicolon
+	pFunc->imported = (peek(-1).type == UNIT_TYPE_KW_IMPORT);
+	pFunc->retType = peek(1).type;
+	pFunc->name = ppeek(2)->value;
+	pFunc->entry = pState->steps.size;
+	
+	// Advance past the function keyword, the type, the name and the colon
+	advance(4);
+	
+	// The parameters are the first locals of the frame
+	pState->locals.size = 0;
+	while ((peek(0).type > UNIT_TYPE_TP_UK) && (peek(0).type < UNIT_TYPE_RG_UK) && (peek(1).type == UNIT_TYPE_IDENTIFIER)) {
+		
+		if (pFunc->paramCount == IR_RUN_MAX_ARGS) return run_fail(pState, IR_RUN_STATUS_MALFORMED, pFunc->name);
+		
+		pFunc->paramTypes[(pFunc->paramCount)++] = peek(0).type;
+		if (!name_add(&pState->locals, ppeek(1)->value, peek(0).type, 0)) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+		
+		advance(2);
+		if (peek(0).type == UNIT_TYPE_PT_COMMA) advance(1);
+		
+	}
+	
+	pState->functions.size++;
+	
+	// Imports don't have a body to run
+	if (pFunc->imported) return true;
+	
+	pState->inside = true;
+	pState->function = pState->functions.size - 1;
+	
+	// Advance past the semicolon
+	advance(1);
+	
+	return true;
+	
+}
+
+static bool decl_decode(run_state* pState, ir* pIR) {
+	
+	switch (peek(0).type) {
+		
+		case (UNIT_TYPE_KW_FUNC) return function_decode(pState, pIR);
+		
+		// Statics look like: static type name : literal ;
+		case (UNIT_TYPE_KW_STATIC) {
+			
+			int64_t value = 0;
+			if (!literal_decode(pState, ppeek(4)->value, &value)) return false;
+			if (!name_add(&pState->globals, ppeek(2)->value, peek(1).type, run_wrap(peek(1).type, value))) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+			
+			advance(6);
+			
+		} break;
+		
+		// Type descriptors only need an address, which is shared with every use of their label
+		case (UNIT_TYPE_KW_REFLECT) {
+			
+			int64_t value = 0;
+			if (!literal_decode(pState, ppeek(1)->value, &value)) return false;
+			
+			// Advance past this, the label, the colon, the name, the size, the pointer depth, their commas and the semicolon
+			advance(9);
+			
+		} break;
+		
+		// Variables outside of any function start out as zero
+		case (UNIT_TYPE_KW_LOCAL) {
+			
+			if (!name_add(&pState->globals, ppeek(2)->value, peek(1).type, 0)) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+			
+			advance(4);
+			
+		} break;
+		
+		// Anything else outside of a function is never run by the Assembly either
+		default: {
+			advance(1);
+		} break;
+		
+	}
+	
+	return true;
+	
+}
+
+static bool step_decode(run_state* pState, ir* pIR) {
+	
+	// Declarations are the same inside a function, apart from locals
+	if ((peek(0).type == UNIT_TYPE_KW_STATIC) || (peek(0).type == UNIT_TYPE_KW_REFLECT)) return decl_decode(pState, pIR);
+	
+	// Units that only set things up don't become steps
+	switch (peek(0).type) {
+		
+		case (UNIT_TYPE_KW_LOCAL) {
+			if (!name_add(&pState->locals, ppeek(2)->value, peek(1).type, 0)) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+			advance(4);
+		} return true;
+		
+		case (UNIT_TYPE_LABEL) {
+			if (!name_add(&pState->labels, ppeek(0)->value, UNIT_TYPE_UNDEFINED, pState->steps.size)) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+			advance(2);
+		} return true;
+		
+		case (UNIT_TYPE_KW_ALLOC) {
+			advance(3);
+		} return true;
+		
+		// Arguments are placed by their position, so there is nothing to set up or take down around a call
+		case (UNIT_TYPE_KW_ARG_PUSH)
+		case (UNIT_TYPE_KW_ARG_POP)
+		case (UNIT_TYPE_KW_END) {
+			advance(1);
+		} return true;
+		
+		default: break;
+		
+	}
+	
+	if (!buffer_resize((void**)&pState->steps.buffer, &pState->steps.memSize, pState->steps.size + 1, sizeof(run_step))) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+	
+	run_step* pStep = &pState->steps.buffer[pState->steps.size];
+	memset(pStep, 0, sizeof(run_step));
+	pStep->op = peek(0).type;
+	
+	switch (pStep->op) {
+		
+		// Moves and arithmetic look like: op [type] target , [type] value ;
+		case (UNIT_TYPE_KW_MOVE)
+		case (UNIT_TYPE_KW_ADD)
+		case (UNIT_TYPE_KW_SUB)
+		case (UNIT_TYPE_KW_MUL)
+		case (UNIT_TYPE_KW_DIV)
+		case (UNIT_TYPE_KW_MOD) {
+			
+			advance(1);
+			if (!operand_decode(pState, pIR, &pStep->target)) return false;
+			
+			advance(1);
+			if (!operand_decode(pState, pIR, &pStep->source)) return false;
+			
+			advance(1);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_INC)
+		case (UNIT_TYPE_KW_DEC) {
+			
+			advance(1);
+			if (!operand_decode(pState, pIR, &pStep->target)) return false;
+			
+			advance(1);
+			
+		} break;
+		
+		// Conditions look like: if value compare [value] : label ;
+		case (UNIT_TYPE_KW_IF) {
+			
+			advance(1);
+			if (!compare_decode(pState, pIR, pStep)) return false;
+			
+			pStep->label = ppeek(1)->value;
+			advance(3);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_JUMP) {
+			
+			pStep->label = ppeek(1)->value;
+			advance(3);
+			
+		} break;
+		
+		// Sets look like: set type register , value compare [value] ;
+		case (UNIT_TYPE_KW_SET) {
+			
+			advance(1);
+			if (!operand_decode(pState, pIR, &pStep->target)) return false;
+			
+			advance(1);
+			if (!compare_decode(pState, pIR, pStep)) return false;
+			
+			advance(1);
+			
+		} break;
+		
+		// Selects look like: select type variable , value : value compare [value] ;
+		case (UNIT_TYPE_KW_SELECT) {
+			
+			advance(1);
+			if (!operand_decode(pState, pIR, &pStep->target)) return false;
+			
+			advance(1);
+			if (!operand_decode(pState, pIR, &pStep->source)) return false;
+			
+			advance(1);
+			if (!compare_decode(pState, pIR, pStep)) return false;
+			
+			advance(1);
+			
+		} break;
+		
+		// Switches look like: switch [type] value : default ; followed by case literal : label ; for each case
+		case (UNIT_TYPE_KW_SWITCH) {
+			
+			advance(1);
+			if (!operand_decode(pState, pIR, &pStep->left)) return false;
+			
+			pStep->label = ppeek(1)->value;
+			advance(3);
+			
+			pStep->first = pState->cases.size;
+			while (peek(0).type == UNIT_TYPE_KW_CASE) {
+				
+				if (!buffer_resize((void**)&pState->cases.buffer, &pState->cases.memSize, pState->cases.size + 1, sizeof(run_case))) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+				
+				run_case* pCase = &pState->cases.buffer[(pState->cases.size)++];
+				if (!literal_decode(pState, ppeek(1)->value, &pCase->value)) return false;
+				pCase->label = ppeek(3)->value;
+				pStep->count++;
+				
+				// Advance past the case, its value, the colon, its label and the semicolon
+				advance(5);
+				
+			}
+			
+		} break;
+		
+		// Arguments look like: arg type index , value ;
+		case (UNIT_TYPE_KW_ARG) {
+			
+			pStep->target.type = peek(1).type;
+			pStep->first = strtoull(ppeek(2)->value, NULL, 10);
+			if (pStep->first >= IR_RUN_MAX_ARGS) return run_fail(pState, IR_RUN_STATUS_MALFORMED, ppeek(2)->value);
+			
+			advance(4);
+			if (!operand_decode(pState, pIR, &pStep->source)) return false;
+			
+			advance(1);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_CALL) {
+			
+			pStep->label = ppeek(1)->value;
+			advance(2);
+			
+		} break;
+		
+		case (UNIT_TYPE_KW_RETURN) {
+			advance(2);
+		} break;
+		
+		// Running off the end of a function returns from it, and it is the end of its locals
+		case (UNIT_TYPE_KW_FREE) {
+			
+			pStep->op = UNIT_TYPE_KW_RETURN;
+			pState->functions.buffer[pState->function].slotCount = pState->locals.size;
+			pState->inside = false;
+			
+			advance(2);
+			
+		} break;
+		
+		default: return run_fail(pState, IR_RUN_STATUS_MALFORMED, "unit");
+		
+	}
+	
+	pState->steps.size++;
+	
+	return true;
+	
+}
+
+static bool run_decode(run_state* pState, ir* pIR) {
+	
+	(pIR->index) = 0;
+	
+	while (pIR->index < pIR->size) {
+		
+		bool decoded = (pState->inside) ? step_decode(pState, pIR) : decl_decode(pState, pIR);
+		if (!decoded) return false;
+		
+	}
+	
+	// A function that never ended can't be run
+	if (pState->inside) return run_fail(pState, IR_RUN_STATUS_MALFORMED, pState->functions.buffer[pState->function].name);
+	
+	// Now that everything is known, branches and calls find where they go
+	for (size_t i = 0; i < pState->steps.size; i++) {
+		
+		run_step* pStep = &pState->steps.buffer[i];
+		if (!pStep->label) continue;
+		
+		if (pStep->op == UNIT_TYPE_KW_CALL) {
+			
+			run_function* pFunc = function_find(pState, pStep->label);
+			if (!pFunc) return run_fail(pState, IR_RUN_STATUS_MALFORMED, pStep->label);
+			
+			pStep->next = pFunc - pState->functions.buffer;
+			
+		} else {
+			
+			run_name* pLabel = name_find(&pState->labels, pStep->label);
+			if (!pLabel) return run_fail(pState, IR_RUN_STATUS_MALFORMED, pStep->label);
+			
+			pStep->next = pLabel->value;
+			
+		}
+		
+	}
+	
+	for (size_t i = 0; i < pState->cases.size; i++) {
+		
+		run_name* pLabel = name_find(&pState->labels, pState->cases.buffer[i].label);
+		if (!pLabel) return run_fail(pState, IR_RUN_STATUS_MALFORMED, pState->cases.buffer[i].label);
+		
+		pState->cases.buffer[i].next = pLabel->value;
+		
+	}
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static int64_t operand_read(run_state* pState, run_frame* pFrame, run_operand* pOperand) {
+	
+	switch (pOperand->kind) {
+		case (RUN_OPERAND_CONSTANT) return pOperand->value;
+		case (RUN_OPERAND_REGISTER) return run_wrap(pOperand->type, pState->registers[pOperand->value]);
+		case (RUN_OPERAND_LOCAL) return pState->slots.buffer[pFrame->base + pOperand->value];
+		case (RUN_OPERAND_GLOBAL) return pState->globals.buffer[pOperand->value].value;
+		default: return 0;
+	}
+	
+}
+
+static void operand_write(run_state* pState, run_frame* pFrame, run_operand* pOperand, int64_t value) {
+	
+	switch (pOperand->kind) {
+		
+		// Like the hardware, writing the low half of a register clears the top half, and smaller writes leave the rest alone
+		case (RUN_OPERAND_REGISTER) {
+			
+			int64_t* pRegister = &pState->registers[pOperand->value];
+			
+			if ((pOperand->type == UNIT_TYPE_TP_S32) || (pOperand->type == UNIT_TYPE_TP_U32))
+				*pRegister = (uint32_t)value;
+			else if ((pOperand->type == UNIT_TYPE_TP_S16) || (pOperand->type == UNIT_TYPE_TP_U16))
+				*pRegister = (*pRegister & ~0xFFFFLL) | (uint16_t)value;
+			else if ((pOperand->type == UNIT_TYPE_TP_S8) || (pOperand->type == UNIT_TYPE_TP_U8))
+				*pRegister = (*pRegister & ~0xFFLL) | (uint8_t)value;
+			else
+				*pRegister = value;
+			
+		} break;
+		
+		case (RUN_OPERAND_LOCAL) pState->slots.buffer[pFrame->base + pOperand->value] = run_wrap(pOperand->type, value); break;
+		case (RUN_OPERAND_GLOBAL) pState->globals.buffer[pOperand->value].value = run_wrap(pOperand->type, value); break;
+		
+		default: break;
+		
+	}
+	
+}
+
+static bool compare_run(run_state* pState, run_frame* pFrame, run_step* pStep) {
+	
+	int64_t left = operand_read(pState, pFrame, &pStep->left);
+	int64_t right = operand_read(pState, pFrame, &pStep->right);
+	
+	// The left side decides whether the comparison is signed
+	if (run_isUnsigned(pStep->left.type)) {
+		switch (pStep->compare) {
+			case (UNIT_TYPE_KW_CMP_G) return ((uint64_t)left > (uint64_t)right);
+			case (UNIT_TYPE_KW_CMP_L) return ((uint64_t)left < (uint64_t)right);
+			case (UNIT_TYPE_KW_CMP_GE) return ((uint64_t)left >= (uint64_t)right);
+			case (UNIT_TYPE_KW_CMP_LE) return ((uint64_t)left <= (uint64_t)right);
+			default: break;
+		}
+	}
+	
+	switch (pStep->compare) {
+		case (UNIT_TYPE_KW_CMP_Z) return (left == 0);
+		case (UNIT_TYPE_KW_CMP_NZ) return (left != 0);
+		case (UNIT_TYPE_KW_CMP_E) return (left == right);
+		case (UNIT_TYPE_KW_CMP_NE) return (left != right);
+		case (UNIT_TYPE_KW_CMP_G) return (left > right);
+		case (UNIT_TYPE_KW_CMP_L) return (left < right);
+		case (UNIT_TYPE_KW_CMP_GE) return (left >= right);
+		case (UNIT_TYPE_KW_CMP_LE) return (left <= right);
+		default: return false;
+	}
+	
+}
+
+static bool arith_run(run_state* pState, run_frame* pFrame, run_step* pStep) {
+	
+	// Both sides are taken at the width of the target, and so is the result
+	unit_type type = pStep->target.type;
+	int64_t left = run_wrap(type, operand_read(pState, pFrame, &pStep->target));
+	int64_t right = run_wrap(type, operand_read(pState, pFrame, &pStep->source));
+	int64_t result = 0;
+	
+	switch (pStep->op) {
+		
+		case (UNIT_TYPE_KW_ADD) result = (int64_t)((uint64_t)left + (uint64_t)right); break;
+		case (UNIT_TYPE_KW_SUB) result = (int64_t)((uint64_t)left - (uint64_t)right); break;
+		case (UNIT_TYPE_KW_MUL) result = (int64_t)((uint64_t)left * (uint64_t)right); break;
+		case (UNIT_TYPE_KW_INC) result = (int64_t)((uint64_t)left + 1); break;
+		case (UNIT_TYPE_KW_DEC) result = (int64_t)((uint64_t)left - 1); break;
+		
+		// Division faults where the hardware would
+		case (UNIT_TYPE_KW_DIV)
+		case (UNIT_TYPE_KW_MOD) {
+			
+			bool remainder = (pStep->op == UNIT_TYPE_KW_MOD);
+			
+			if (right == 0) return run_fail(pState, IR_RUN_STATUS_DIVIDE_ERROR, pState->functions.buffer[pFrame->function].name);
+			
+			if (run_isUnsigned(type)) {
+				result = (remainder) ? (int64_t)((uint64_t)left % (uint64_t)right) : (int64_t)((uint64_t)left / (uint64_t)right);
+				break;
+			}
+			
+			bool overflows = (right == -1) && (((type == UNIT_TYPE_TP_S32) && (left == INT32_MIN)) || (left == INT64_MIN));
+			if (overflows) return run_fail(pState, IR_RUN_STATUS_DIVIDE_ERROR, pState->functions.buffer[pFrame->function].name);
+			
+			result = (remainder) ? (left % right) : (left / right);
+			
+		} break;
+		
+		default: break;
+		
+	}
+	
+	operand_write(pState, pFrame, &pStep->target, result);
+	
+	return true;
+	
+}
+
+static bool frame_push(run_state* pState, size_t function, size_t ret) {
+	
+	run_function* pFunc = &pState->functions.buffer[function];
+	
+	if (pState->depth == IR_RUN_MAX_DEPTH) return run_fail(pState, IR_RUN_STATUS_DEPTH_LIMIT, pFunc->name);
+	
+	// The frame goes on top of our caller's, with the parameters taken from the arguments and everything else cleared
+	size_t base = pState->slots.size;
+	if (!buffer_resize((void**)&pState->slots.buffer, &pState->slots.memSize, base + pFunc->slotCount, sizeof(int64_t))) return run_fail(pState, IR_RUN_STATUS_OUT_OF_MEMORY, NULL);
+	
+	memset(&pState->slots.buffer[base], 0, pFunc->slotCount * sizeof(int64_t));
+	for (size_t i = 0; i < pFunc->paramCount; i++) pState->slots.buffer[base + i] = run_wrap(pFunc->paramTypes[i], pState->args[i]);
+	
+	pState->slots.size += pFunc->slotCount;
+	pState->frames[(pState->depth)++] = (run_frame){ function, base, ret };
+	
+	return true;
+	
+}
+
+static bool run_execute(run_state* pState, size_t maxSteps) {
+	
+	ir_run* pRun = pState->pRun;
+	
+	// Start at main, with nothing passed to it
+	run_function* pMain = function_find(pState, "main");
+	if ((!pMain) || (pMain->imported)) return run_fail(pState, IR_RUN_STATUS_NO_MAIN, NULL);
+	
+	if (!frame_push(pState, pMain - pState->functions.buffer, 0)) return false;
+	size_t index = pMain->entry;
+	
+	while (true) {
+		
+		run_frame* pFrame = &pState->frames[pState->depth - 1];
+		
+		if (pRun->steps == maxSteps) return run_fail(pState, IR_RUN_STATUS_STEP_LIMIT, pState->functions.buffer[pFrame->function].name);
+		(pRun->steps)++;
+		
+		run_step* pStep = &pState->steps.buffer[index++];
+		
+		switch (pStep->op) {
+			
+			case (UNIT_TYPE_KW_MOVE) {
+				(pRun->moves)++;
+				operand_write(pState, pFrame, &pStep->target, operand_read(pState, pFrame, &pStep->source));
+			} break;
+			
+			case (UNIT_TYPE_KW_SET) {
+				(pRun->moves)++;
+				operand_write(pState, pFrame, &pStep->target, compare_run(pState, pFrame, pStep));
+			} break;
+			
+			case (UNIT_TYPE_KW_SELECT) {
+				(pRun->moves)++;
+				if (compare_run(pState, pFrame, pStep)) operand_write(pState, pFrame, &pStep->target, operand_read(pState, pFrame, &pStep->source));
+			} break;
+			
+			case (UNIT_TYPE_KW_ADD)
+			case (UNIT_TYPE_KW_SUB)
+			case (UNIT_TYPE_KW_MUL)
+			case (UNIT_TYPE_KW_DIV)
+			case (UNIT_TYPE_KW_MOD)
+			case (UNIT_TYPE_KW_INC)
+			case (UNIT_TYPE_KW_DEC) {
+				(pRun->arithmetic)++;
+				if (!arith_run(pState, pFrame, pStep)) return false;
+			} break;
+			
+			case (UNIT_TYPE_KW_IF) {
+				(pRun->branches)++;
+				if (compare_run(pState, pFrame, pStep)) index = pStep->next;
+			} break;
+			
+			case (UNIT_TYPE_KW_JUMP) {
+				(pRun->branches)++;
+				index = pStep->next;
+			} break;
+			
+			// Only the first of any repeated case is ever taken
+			case (UNIT_TYPE_KW_SWITCH) {
+				
+				(pRun->branches)++;
+				
+				int64_t value = operand_read(pState, pFrame, &pStep->left);
+				index = pStep->next;
+				
+				for (size_t i = pStep->first; i < (pStep->first + pStep->count); i++) {
+					if (run_wrap(pStep->left.type, pState->cases.buffer[i].value) != pState->cases.buffer[i].value) continue;
+					if (pState->cases.buffer[i].value != value) continue;
+					index = pState->cases.buffer[i].next;
+					break;
+				}
+				
+			} break;
+			
+			case (UNIT_TYPE_KW_ARG) {
+				pState->args[pStep->first] = run_wrap(pStep->target.type, operand_read(pState, pFrame, &pStep->source));
+			} break;
+			
+			case (UNIT_TYPE_KW_CALL) {
+				
+				(pRun->calls)++;
+				
+				// Nothing outside of the module can be run, and making up what an import returns would hide that
+				if (pState->functions.buffer[pStep->next].imported) {
+					(pRun->imports)++;
+					return run_fail(pState, IR_RUN_STATUS_IMPORT, pState->functions.buffer[pStep->next].name);
+				}
+				
+				if (!frame_push(pState, pStep->next, index)) return false;
+				index = pState->functions.buffer[pStep->next].entry;
+				
+			} break;
+			
+			case (UNIT_TYPE_KW_RETURN) {
+				
+				// Drop the frame and go back to our caller, or stop if this was main
+				pState->slots.size = pFrame->base;
+				(pState->depth)--;
+				
+				if (pState->depth == 0) {
+					pRun->value = run_wrap(pMain->retType, pState->registers[RUN_RETVAL]);
+					return true;
+				}
+				
+				index = pFrame->ret;
+				
+			} break;
+			
+			default: break;
+			
+		}
+		
+	}
+	
+}
+
+/*////////*/
+
+bool ir_interpret(ir_run* pRun, ir_run_info* pInfo) {
+	
+	memset(pRun, 0, sizeof(ir_run));
+	
+	// The state is kept off the stack, since it holds every frame that could be in progress
+	run_state* pState = calloc(1, sizeof(run_state));
+	if (!pState) {
+		pRun->status = IR_RUN_STATUS_OUT_OF_MEMORY;
+		return false;
+	}
+	
+	pState->pRun = pRun;
+	
+	size_t maxSteps = (pInfo->maxSteps) ? pInfo->maxSteps : IR_RUN_MAX_STEPS;
+	bool succeeded = (run_decode(pState, pInfo->pIR)) && (run_execute(pState, maxSteps));
+	
+	// Free memory
+	free(pState->steps.buffer);
+	free(pState->cases.buffer);
+	free(pState->functions.buffer);
+	free(pState->globals.buffer);
+	free(pState->locals.buffer);
+	free(pState->labels.buffer);
+	free(pState->addresses.buffer);
+	free(pState->slots.buffer);
+	free(pState);
+	
+	return succeeded;
+	
+}
+
+void ir_run_print(ir_run* pRun) {
+	
+	static char* reasons[] = {
+		[IR_RUN_STATUS_RETURNED] = "returned",
+		[IR_RUN_STATUS_NO_MAIN] = "There is no main function to run",
+		[IR_RUN_STATUS_MALFORMED] = "The IR could not be decoded at",
+		[IR_RUN_STATUS_DIVIDE_ERROR] = "Division fault in",
+		[IR_RUN_STATUS_STEP_LIMIT] = "Gave up on a program that does not stop, in",
+		[IR_RUN_STATUS_DEPTH_LIMIT] = "Calls nested too deeply, in",
+		[IR_RUN_STATUS_IMPORT] = "Cannot run the imported function",
+		[IR_RUN_STATUS_OUT_OF_MEMORY] = "Ran out of memory",
+	};
+	
+	if (pRun->status == IR_RUN_STATUS_RETURNED)
+		print_utf8("main returned %lld", (long long)pRun->value);
+	else
+		print_utf8("error: %s%s%s", reasons[pRun->status], (pRun->detail[0]) ? " " : "", pRun->detail);
+	
+	print_utf8(" after %llu instructions (%llu moves, %llu arithmetic, %llu branches, %llu calls, %llu of them imported)\n",
+		(unsigned long long)pRun->steps, (unsigned long long)pRun->moves, (unsigned long long)pRun->arithmetic,
+		(unsigned long long)pRun->branches, (unsigned long long)pRun->calls, (unsigned long long)pRun->imports);
+	
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+// [ MACROS ] //
+
+#define IR_RUN_MAX_STEPS 10000000 // Instructions run before a program is taken to be stuck
+#define IR_RUN_MAX_DEPTH 4096 // Calls that can be in progress at once
+#define IR_RUN_MAX_ARGS 32 // Arguments that can be passed to a single call
+
+// [ DEFINING ] //
+
+typedef struct {
+	ir* pIR;
+	size_t maxSteps; // Zero uses IR_RUN_MAX_STEPS
+} ir_run_info;
+
+typedef enum {
+	IR_RUN_STATUS_RETURNED,
+	IR_RUN_STATUS_NO_MAIN,
+	IR_RUN_STATUS_MALFORMED,
+	IR_RUN_STATUS_DIVIDE_ERROR,
+	IR_RUN_STATUS_STEP_LIMIT,
+	IR_RUN_STATUS_DEPTH_LIMIT,
+	IR_RUN_STATUS_IMPORT,
+	IR_RUN_STATUS_OUT_OF_MEMORY,
+} ir_run_status;
+
+typedef struct {
+	
+	ir_run_status status;
+	char detail[MAX_VALUE_LEN]; // What was being looked at when something went wrong
+	
+	// What main returned, at the width it returns
+	int64_t value;
+	
+	// Instructions run, in total and by kind
+	size_t steps;
+	size_t moves;
+	size_t arithmetic;
+	size_t branches;
+	size_t calls;
+	size_t imports; // Calls to imported functions, the first of which stops the run
+	
+} ir_run;
+
+// [ FUNCTIONS ] //
+
+bool ir_interpret(ir_run* pRun, ir_run_info* pInfo);
+void ir_run_print(ir_run* pRun);
\ No newline at end of file
@@ -10,14 +10,144 @@
 #include <string.h>
 #include <math.h>
 
+// [ MACROS ] //
+
+#define REFLECT_PREFIX "__reflect_"
+
+#define EVAL_MAX_STEPS 4096 // Nodes a constant expression may have
+#define EVAL_MAX_STACK 64 // Values it may have waiting at once
+
+#define INLINE_MAX_FUNCS 64
+#define INLINE_MAX_PARAMS 4
+#define INLINE_MAX_LOCALS 32
+#define INLINE_MAX_KNOWN 32
+#define INLINE_MAX_STATEMENT 16
+
+#define INLINE_MAX_DEPTH 3 // How deep expansions may nest
+#define INLINE_MAX_SIZE 12 // Statements a function may have to be expanded at every call site
+#define INLINE_MAX_SIZE_ONCE 64 // Statements a private function with a single call site may have
+#define INLINE_MAX_GROWTH 50 // Percentage the module may grow by
+#define INLINE_MIN_GROWTH 256 // Units the module may always grow by
+
 // [ DEFINING ] //
 
+typedef struct {
+	node_pool* pPool;
+	char* flat;
+	node_id* nodes;
+	size_t index;
+	size_t registers;
+} expr_flat;
+
+typedef struct {
+	unit left;
+	unit right;
+	unit_type compare;
+} unit_test;
+
+typedef struct {
+	node_pool* pPool;
+	int32_t stack[EVAL_MAX_STACK];
+	size_t depth;
+	size_t steps;
+	bool failed;
+} eval_state;
+
+typedef struct {
+	
+	char* name;
+	unit_type linkage;
+	
+	// Where the function lives: its first unit, its body, the move into the return value, and one past its free
+	size_t start;
+	size_t body;
+	size_t ret;
+	size_t end;
+	
+	// Frame size, statement count and number of call sites
+	size_t alloc;
+	size_t size;
+	size_t calls;
+	
+	size_t paramCount;
+	unit_type paramTypes[INLINE_MAX_PARAMS];
+	char* params[INLINE_MAX_PARAMS];
+	bool written[INLINE_MAX_PARAMS];
+	
+	size_t localCount;
+	char* locals[INLINE_MAX_LOCALS];
+	
+	bool inlinable;
+	
+} inline_func;
+
+typedef struct {
+	inline_func* pFunc;
+	size_t site;
+	unit args[INLINE_MAX_PARAMS];
+	bool substituted[INLINE_MAX_PARAMS]; // The parameter is replaced by its argument instead of getting a local
+} inline_site;
 
+typedef struct {
+	unit_type type;
+	char name[MAX_VALUE_LEN];
+	int64_t value;
+	bool known;
+} inline_value;
+
+typedef struct {
+	inline_value values[INLINE_MAX_KNOWN];
+	size_t count;
+} inline_known;
+
+typedef struct {
+	
+	unit* source;
+	size_t sourceSize;
+	
+	inline_func funcs[INLINE_MAX_FUNCS];
+	size_t funcCount;
+	
+	// The function everything is expanded into, and the functions being expanded right now, outermost first
+	inline_func* pCaller;
+	inline_func* stack[INLINE_MAX_DEPTH];
+	
+	size_t budget;
+	size_t sites;
+	size_t alloc;
+	
+} inline_state;
+
+typedef struct {
+	node_id id; // The top-level node, which is the import or export statement around the declaration if there is one
+	char* name;
+	uint64_t hash;
+	bool reached;
+} prune_decl;
+
+typedef struct {
+	
+	node_pool* pPool;
+	prune_decl* decls;
+	size_t count;
+	
+	// Declarations found by the hash of their name; empty slots hold SIZE_MAX
+	size_t* slots;
+	size_t slotCount;
+	
+	// Declarations that have been reached but not yet walked
+	size_t* pending;
+	size_t pendingCount;
+	
+} prune_state;
 
 // [ FUNCTIONS ] //
 
 unit* unit_push(ir* pIR, unit_type type);
-void unit_copy(ir* pIR, node* pNode, size_t index);
+void unit_copy(ir* pIR, node_id id, size_t index);
+static char* unit_reflect(ir* pIR, node_id id);
+static char* unit_called(ir* pIR, node_id id);
+static bool unit_isRegister(unit_type type);
 
 bool ir_resize(ir* pIR) { 
 	
@@ -79,17 +209,17 @@ unit_type eval_type_size_from_num(size_t size) {
 	
 }
 
-unit_type eval_type_size(node* pNode, symbol_table* pSymbolTable) {
+unit_type eval_type_size(node_pool* pPool, node_id id, symbol_table* pSymbolTable) {
 	
-	if ((pNode) && (pNode->tokenCount > 0)) {
+	if ((id != NODE_ID_NONE) && (pPool->tokenCount[id] > 0)) {
 		
-		if (pNode->type == NODE_TYPE_LITERAL) {
+		if (pPool->type[id] == NODE_TYPE_LITERAL) {
 			
-			switch (pNode->tokenList->type) {
+			switch (node_tokens(pPool, id)->type) {
 				
 				case (TOKEN_TYPE_LITERAL_INT) {
 					
-					size_t val = strtoull(pNode->tokenList->value, NULL, 0);
+					size_t val = strtoull(node_tokens(pPool, id)->value, NULL, 0);
 					
 					if (val <= UINT8_MAX) return UNIT_TYPE_TP_S8;
 					if (val <= UINT16_MAX) return UNIT_TYPE_TP_S16;
@@ -108,12 +238,12 @@ unit_type eval_type_size(node* pNode, symbol_table* pSymbolTable) {
 		
 		// Skip to the variable name
 		size_t index = 0;
-		while ((token_isTypeQualifier(pNode->tokenList[index].type) || token_isTypeSpecifier(pNode->tokenList[index].type))) index++;
+		while ((token_isTypeQualifier(node_tokens(pPool, id)[index].type) || token_isTypeSpecifier(node_tokens(pPool, id)[index].type))) index++;
 		index++;
-		while ((token_isTypeQualifier(pNode->tokenList[index].type) || token_isTypeSpecifier(pNode->tokenList[index].type))) index++;
+		while ((token_isTypeQualifier(node_tokens(pPool, id)[index].type) || token_isTypeSpecifier(node_tokens(pPool, id)[index].type))) index++;
 		
 		// Check that this symbol exists
-		symbol* foundSymbol = symbol_find(pSymbolTable, pNode->tokenList[index].value, SYMBOL_CLASS_ALL);
+		symbol* foundSymbol = symbol_find(pSymbolTable, node_tokens(pPool, id)[index].value, SYMBOL_CLASS_ALL);
 		if (foundSymbol) {
 			
 			return eval_type_size_from_num(foundSymbol->size);
@@ -127,12 +257,13 @@ unit_type eval_type_size(node* pNode, symbol_table* pSymbolTable) {
 	
 }
 
-unit_type eval_arithmetic (node* pNode) {
-	switch (pNode->tokenList->type) {
+unit_type eval_arithmetic (node_pool* pPool, node_id id) {
+	switch (node_tokens(pPool, id)->type) {
 		case (TOKEN_TYPE_OP_ADD) return UNIT_TYPE_KW_ADD;
 		case (TOKEN_TYPE_OP_SUB) return UNIT_TYPE_KW_SUB;
 		case (TOKEN_TYPE_OP_MUL) return UNIT_TYPE_KW_MUL;
 		case (TOKEN_TYPE_OP_DIV) return UNIT_TYPE_KW_DIV;
+		case (TOKEN_TYPE_OP_MOD) return UNIT_TYPE_KW_MOD;
 		default: return UNIT_TYPE_UNDEFINED;
 	}
 }
@@ -145,111 +276,258 @@ unit_type eval_register(size_t count) {
 	}
 }
 
+static bool eval_enter(node_frame* pFrame, void* pData) {
+	
+	eval_state* pState = pData;
+	node_pool* pPool = pState->pPool;
+	node_id id = pFrame->id;
+	
+	// Give up on anything too big to work out here; it is left to run as it would have
+	if ((pState->failed) || (++(pState->steps) > EVAL_MAX_STEPS)) {
+		pState->failed = true;
+		return false;
+	}
+	
+	switch (pPool->type[id]) {
+		
+		// Operations are worked out once their operands are on the stack
+		case (NODE_TYPE_OPERATION) return true;
+		
+		case (NODE_TYPE_LITERAL) {
+			
+			if (pState->depth >= EVAL_MAX_STACK) break;
+			
+			// Integers are taken at the width of an int, the same as the code would have
+			char* literal = node_tokens(pPool, id)[0].value;
+			switch (node_tokens(pPool, id)[0].type) {
+				case (TOKEN_TYPE_LITERAL_INT)
+				case (TOKEN_TYPE_LITERAL_INT_HEX) pState->stack[(pState->depth)++] = (int32_t)strtoull(literal, NULL, 0); return false;
+				case (TOKEN_TYPE_LITERAL_CHAR) pState->stack[(pState->depth)++] = (literal[0] == '\'') ? literal[1] : literal[0]; return false;
+				default: break;
+			}
+			
+		} break;
+		
+		default: break;
+		
+	}
+	
+	// Anything else, such as a variable or a call, can't be known ahead of time
+	pState->failed = true;
+	return false;
+	
+}
+
+static void eval_leave(node_frame* pFrame, void* pData) {
+	
+	eval_state* pState = pData;
+	node_pool* pPool = pState->pPool;
+	node_id id = pFrame->id;
+	
+	if ((pState->failed) || (pPool->type[id] != NODE_TYPE_OPERATION)) return;
+	
+	size_t operands = 0;
+	for (node_id thisNode = pPool->firstChild[id]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode]) operands++;
+	if ((operands == 0) || (operands > 2) || (operands > pState->depth)) {
+		pState->failed = true;
+		return;
+	}
+	
+	// Wrap around like a 32-bit register does, which unsigned arithmetic can do without overflowing
+	int32_t* pResult = &pState->stack[pState->depth - operands];
+	uint32_t left = (uint32_t)pResult[0];
+	uint32_t right = (uint32_t)pResult[operands - 1];
+	token_type op = node_tokens(pPool, id)->type;
+	
+	if (operands == 1) {
+		
+		switch (op) {
+			case (TOKEN_TYPE_OP_ASSIGN) break;
+			case (TOKEN_TYPE_OP_SUB) *pResult = (int32_t)(0u - left); break;
+			case (TOKEN_TYPE_OP_CMP_NOT) *pResult = (left == 0); break;
+			case (TOKEN_TYPE_OP_BIT_NOT) *pResult = (int32_t)(~left); break;
+			default: pState->failed = true; return;
+		}
+		
+		return;
+		
+	}
+	
+	// Division by zero and the one quotient that doesn't fit are left to fault at run time
+	if (((op == TOKEN_TYPE_OP_DIV) || (op == TOKEN_TYPE_OP_MOD)) && ((right == 0) || ((pResult[0] == INT32_MIN) && (pResult[1] == -1)))) {
+		pState->failed = true;
+		return;
+	}
+	
+	switch (op) {
+		case (TOKEN_TYPE_OP_ADD) *pResult = (int32_t)(left + right); break;
+		case (TOKEN_TYPE_OP_SUB) *pResult = (int32_t)(left - right); break;
+		case (TOKEN_TYPE_OP_MUL) *pResult = (int32_t)(left * right); break;
+		case (TOKEN_TYPE_OP_DIV) *pResult = pResult[0] / pResult[1]; break;
+		case (TOKEN_TYPE_OP_MOD) *pResult = pResult[0] % pResult[1]; break;
+		case (TOKEN_TYPE_OP_BIT_AND) *pResult = (int32_t)(left & right); break;
+		case (TOKEN_TYPE_OP_BIT_OR) *pResult = (int32_t)(left | right); break;
+		case (TOKEN_TYPE_OP_BIT_XOR) *pResult = (int32_t)(left ^ right); break;
+		case (TOKEN_TYPE_OP_BIT_SHIFT_LEFT) *pResult = (int32_t)(left << (right & 31)); break;
+		case (TOKEN_TYPE_OP_BIT_SHIFT_RIGHT) *pResult = pResult[0] >> (right & 31); break;
+		case (TOKEN_TYPE_OP_CMP_EQUAL) *pResult = (pResult[0] == pResult[1]); break;
+		case (TOKEN_TYPE_OP_CMP_NOT_EQUAL) *pResult = (pResult[0] != pResult[1]); break;
+		case (TOKEN_TYPE_OP_CMP_LESS) *pResult = (pResult[0] < pResult[1]); break;
+		case (TOKEN_TYPE_OP_CMP_LESS_EQUAL) *pResult = (pResult[0] <= pResult[1]); break;
+		case (TOKEN_TYPE_OP_CMP_GREATER) *pResult = (pResult[0] > pResult[1]); break;
+		case (TOKEN_TYPE_OP_CMP_GREATER_EQUAL) *pResult = (pResult[0] >= pResult[1]); break;
+		case (TOKEN_TYPE_OP_CMP_AND) *pResult = (pResult[0] != 0) && (pResult[1] != 0); break;
+		case (TOKEN_TYPE_OP_CMP_OR) *pResult = (pResult[0] != 0) || (pResult[1] != 0); break;
+		default: pState->failed = true; return;
+	}
+	
+	(pState->depth)--;
+	
+}
+
+bool eval_constant(node_pool* pPool, node_id id, int64_t* pValue) {
+	
+	// Interpret the expression on a small stack of its own; it is constant if it comes out as exactly one value
+	eval_state state = {};
+	state.pPool = pPool;
+	if (!node_walk_tree(pPool, id, eval_enter, eval_leave, &state)) return false;
+	if ((state.failed) || (state.depth != 1)) return false;
+	
+	*pValue = state.stack[0];
+	
+	return true;
+	
+}
+
 /*////////*/
 
-void expr_flatten(node* pNode, char flat[], node* nodes[], size_t* index, bool left, bool first) {
+static bool expr_flatten_enter(node_frame* pFrame, void* pData) {
 	
-	static size_t registers = 0;
+	expr_flat* pFlat = pData;
+	node_pool* pPool = pFlat->pPool;
+	node_id id = pFrame->id;
+	
+	// A node is the left operand if it is the first child of the operation above it on the walk stack
+	bool left = (pFrame->depth > 0) && (pPool->firstChild[pFrame[-1].id] == id);
 	
-	if (pNode->type == NODE_TYPE_OPERATION) {
+	if (pPool->type[id] == NODE_TYPE_OPERATION) {
 		
-		switch (pNode->tokenList->type) {
+		switch (node_tokens(pPool, id)->type) {
 			
 			case (TOKEN_TYPE_OP_INC) {
 				
-				flat[*index] = 'I';
-				nodes[*index] = pNode;
-				(*index)++;
-				
-			} break;
-			
-			case (TOKEN_TYPE_OP_DEC) {
+				pFlat->flat[pFlat->index] = 'I';
+				pFlat->nodes[pFlat->index] = id;
+				(pFlat->index)++;
 				
-				flat[*index] = 'D';
-				nodes[*index] = pNode;
-				(*index)++;
+				return false;
 				
-			} break;
+			}
 			
-			default: {
+			case (TOKEN_TYPE_OP_DEC) {
 				
-				if (pNode->firstChild) {
-					expr_flatten(pNode->firstChild, flat, nodes, index, true, false);
-					if (pNode->firstChild->nextSibling)
-						expr_flatten(pNode->firstChild->nextSibling, flat, nodes, index, false, false);
-				}
+				pFlat->flat[pFlat->index] = 'D';
+				pFlat->nodes[pFlat->index] = id;
+				(pFlat->index)++;
 				
-				if (registers == 2) {
-					
-					flat[*index] = '^';
-					(*index)++;
-					
-					flat[*index] = pNode->parent->tokenList->value[0];
-					(*index)++;
-					
-					registers--;
-					
-				}
+				return false;
 				
-			} break;
+			}
+			
+			// Flatten the operands first
+			default: return true;
 			
 		}
 		
-	} else if (pNode->type == NODE_TYPE_LITERAL) {
+	} else if ((pPool->type[id] == NODE_TYPE_LITERAL) || (pPool->type[id] == NODE_TYPE_REFLECT)) {
 		
 		if (left) {
 			
-			registers++;
+			(pFlat->registers)++;
 			
-			flat[*index] = '~';
-			(*index)++;
+			pFlat->flat[pFlat->index] = '~';
+			(pFlat->index)++;
 			
 		} else {
 			
-			flat[*index] = pNode->parent->tokenList->value[0];
-			(*index)++;
+			pFlat->flat[pFlat->index] = node_tokens(pPool, pPool->parent[id])->value[0];
+			(pFlat->index)++;
 			
 		}
 		
-		flat[*index] = 'l';
-		nodes[*index] = pNode;
-		(*index)++;
+		// A reflection is the address of its descriptor, which is as constant as any literal
+		pFlat->flat[pFlat->index] = (pPool->type[id] == NODE_TYPE_LITERAL) ? 'l' : 'r';
+		pFlat->nodes[pFlat->index] = id;
+		(pFlat->index)++;
 		
-	} else if (pNode->type == NODE_TYPE_IDENTIFIER) {
+	} else if ((pPool->type[id] == NODE_TYPE_IDENTIFIER) || (pPool->type[id] == NODE_TYPE_CALL_FUNCTION)) {
 		
+		// A call has already been made by now, and its result waits in a temporary
 		if (left) {
 			
-			registers++;
+			(pFlat->registers)++;
 			
-			flat[*index] = '~';
-			(*index)++;
+			pFlat->flat[pFlat->index] = '~';
+			(pFlat->index)++;
 			
 		} else {
 			
-			flat[*index] = pNode->parent->tokenList->value[0];
-			(*index)++;
+			pFlat->flat[pFlat->index] = node_tokens(pPool, pPool->parent[id])->value[0];
+			(pFlat->index)++;
 			
 		}
 		
-		flat[*index] = 'i';
-		nodes[*index] = pNode;
-		(*index)++;
+		pFlat->flat[pFlat->index] = (pPool->type[id] == NODE_TYPE_IDENTIFIER) ? 'i' : 'c';
+		pFlat->nodes[pFlat->index] = id;
+		(pFlat->index)++;
 		
 	}
 	
-	if (first) {
+	return false;
+	
+}
+
+static void expr_flatten_leave(node_frame* pFrame, void* pData) {
+	
+	expr_flat* pFlat = pData;
+	node_pool* pPool = pFlat->pPool;
+	node_id id = pFrame->id;
+	
+	if (pPool->type[id] != NODE_TYPE_OPERATION) return;
+	if ((node_tokens(pPool, id)->type == TOKEN_TYPE_OP_INC) || (node_tokens(pPool, id)->type == TOKEN_TYPE_OP_DEC)) return;
+	
+	// Once both operands are in registers, fold the right one into the left
+	if (pFlat->registers == 2) {
+		
+		pFlat->flat[pFlat->index] = '^';
+		(pFlat->index)++;
+		
+		pFlat->flat[pFlat->index] = node_tokens(pPool, pPool->parent[id])->value[0];
+		(pFlat->index)++;
 		
-		// Reset the register count for the next expression pass
-		registers = 0;
+		(pFlat->registers)--;
 		
 	}
 	
 }
 
-void expr_parse(ir* pIR, char flat[], node* nodes[], size_t index, node* pNode) {
+void expr_flatten(node_pool* pPool, node_id id, char flat[], node_id nodes[], size_t* index) {
+	
+	// The register count starts fresh for every expression
+	expr_flat state = {pPool, flat, nodes, *index, 0};
+	
+	node_walk_tree(pPool, id, expr_flatten_enter, expr_flatten_leave, &state);
+	
+	*index = state.index;
+	
+}
+
+void expr_parse(ir* pIR, char flat[], node_id nodes[], size_t index, node_id id) {
+	
+	node_pool* pPool = pIR->info.pPool;
 	
 	static size_t registers = 0;
-	unit* outReg = NULL;
+	size_t outIndex = 0;
 	
 	for (size_t i = 0; i < index; i++) {
 		
@@ -261,7 +539,8 @@ void expr_parse(ir* pIR, char flat[], node* nodes[], size_t index, node* pNode)
 				
 				unit_push(pIR, UNIT_TYPE_KW_MOVE);
 				unit_push(pIR, UNIT_TYPE_TP_S32);
-				outReg = unit_push(pIR, eval_register(registers));
+				unit_push(pIR, eval_register(registers));
+				outIndex = pIR->size - 1;
 				unit_push(pIR, UNIT_TYPE_PT_COMMA);
 				
 			} break;
@@ -274,6 +553,25 @@ void expr_parse(ir* pIR, char flat[], node* nodes[], size_t index, node* pNode)
 				
 			} break;
 			
+			case ('k') {
+				
+				int64_t value = 0;
+				eval_constant(pPool, nodes[i], &value);
+				
+				unit_push(pIR, UNIT_TYPE_LITERAL);
+				snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "%lld", (long long)value);
+				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+				
+			} break;
+			
+			case ('r') {
+				
+				unit_push(pIR, UNIT_TYPE_LITERAL);
+				strcpy(pIR->buffer[pIR->size - 1].value, unit_reflect(pIR, nodes[i]));
+				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+				
+			} break;
+			
 			case ('i') {
 				
 				unit_push(pIR, UNIT_TYPE_IDENTIFIER);
@@ -282,6 +580,14 @@ void expr_parse(ir* pIR, char flat[], node* nodes[], size_t index, node* pNode)
 				
 			} break;
 			
+			case ('c') {
+				
+				unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+				strcpy(pIR->buffer[pIR->size - 1].value, unit_called(pIR, nodes[i]));
+				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+				
+			} break;
+			
 			case ('+') {
 				
 				unit_push(pIR, UNIT_TYPE_KW_ADD);
@@ -331,20 +637,21 @@ void expr_parse(ir* pIR, char flat[], node* nodes[], size_t index, node* pNode)
 				unit_push(pIR, UNIT_TYPE_KW_INC);
 				unit_push(pIR, UNIT_TYPE_TP_S32);
 				unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-				unit_copy(pIR, pNode->parent, 0);
+				unit_copy(pIR, pPool->parent[id], 0);
 				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
 			} break;
 
 			case ('D') {
 				unit_push(pIR, UNIT_TYPE_KW_DEC);
 				unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-				unit_copy(pIR, pNode->parent, 0);
+				unit_copy(pIR, pPool->parent[id], 0);
 				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
 			} break;
 			
-			case ('/') {
+			case ('/')
+			case ('%') {
 				
-				unit_push(pIR, UNIT_TYPE_KW_DIV);
+				unit_push(pIR, (flat[i] == '/') ? UNIT_TYPE_KW_DIV : UNIT_TYPE_KW_MOD);
 				unit_push(pIR, UNIT_TYPE_TP_S32);
 				unit_push(pIR, eval_register(registers));
 				unit_push(pIR, UNIT_TYPE_PT_COMMA);
@@ -368,11 +675,12 @@ void expr_parse(ir* pIR, char flat[], node* nodes[], size_t index, node* pNode)
 	}
 	
 	// If we loaded an identifier into a register at the start of this expression, then reassign it this value
-	if ((pNode->parent->type == NODE_TYPE_IDENTIFIER) && (index > 1)) {
+	if ((pPool->type[pPool->parent[id]] == NODE_TYPE_IDENTIFIER) && (index > 1)) {
 		
 		unit_push(pIR, UNIT_TYPE_KW_MOVE);
-		outReg = unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-		unit_copy(pIR, pNode->parent, 0);
+		unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+		outIndex = pIR->size - 1;
+		unit_copy(pIR, pPool->parent[id], 0);
 		unit_push(pIR, UNIT_TYPE_PT_COMMA);
 		unit_push(pIR, UNIT_TYPE_TP_S32);
 		unit_push(pIR, eval_register(registers));
@@ -382,27 +690,44 @@ void expr_parse(ir* pIR, char flat[], node* nodes[], size_t index, node* pNode)
 	
 	registers = 0;
 	
-	// Set the last register; the result of an expression is always in AR1
-	pIR->info.pRet = outReg;
+	// Set the last register; the result of an expression is always in AR1. It is copied out, as the buffer moves when it grows
+	static unit result[2];
+	if (outIndex > 0) {
+		result[0] = pIR->buffer[outIndex - 1];
+		result[1] = pIR->buffer[outIndex];
+	}
+	pIR->info.pRet = (outIndex > 0) ? &result[1] : NULL;
 	
 }
 
-void emit_expr(ir* pIR, node* pNode, unit_type reg) {
+void emit_expr(ir* pIR, node_id id, unit_type reg) {
+	
+	node_pool* pPool = pIR->info.pPool;
 	
 	// IMPORTANT NOTE / TODO: Make these realloc instead
 	
 	char flat[256] = {};
-	node* nodes[256] = {};
+	node_id nodes[256] = {};
 	size_t index = 0;
 	
-	// Turn our expression into a register-like array
-	expr_flatten(pNode, flat, nodes, &index, false, true);
+	// An expression that can be worked out now is just its value, loaded into the first register
+	int64_t value = 0;
+	if ((pPool->type[id] == NODE_TYPE_OPERATION) && (eval_constant(pPool, id, &value))) {
+		flat[index++] = '~';
+		flat[index] = 'k';
+		nodes[index++] = id;
+	} else {
+		
+		// Turn our expression into a register-like array
+		expr_flatten(pPool, id, flat, nodes, &index);
+		
+	}
 	
 	for (size_t i = 0; i < index; i++) print_utf8("%c ", flat[i]);
 	print_utf8("\n");
 	
 	// Parse the expression into IR instructions
-	expr_parse(pIR, flat, nodes, index, pNode);
+	expr_parse(pIR, flat, nodes, index, id);
 	
 }
 
@@ -425,178 +750,1464 @@ unit* unit_push(ir* pIR, unit_type type) {
 	
 }
 
-void unit_copy(ir* pIR, node* pNode, size_t index) {
-	strcpy(pIR->buffer[pIR->size - 1].value, pNode->tokenList[index].value);
+void unit_copy(ir* pIR, node_id id, size_t index) {
+	strcpy(pIR->buffer[pIR->size - 1].value, node_tokens(pIR->info.pPool, id)[index].value);
+}
+
+static bool unit_isStatic(node_pool* pPool, node_id id) {
+	
+	// Variables assigned to a string literal are emitted statically
+	if ((pPool->firstChild[id] != NODE_ID_NONE) && (pPool->firstChild[pPool->firstChild[id]] != NODE_ID_NONE) && (node_tokens(pPool, pPool->firstChild[pPool->firstChild[id]])->type == TOKEN_TYPE_LITERAL_STR)) return true;
+	
+	// So are variables outside of any function whose value can be worked out now, rather than by code that would never run
+	int64_t value = 0;
+	return (pPool->parent[id] != NODE_ID_NONE) && (pPool->type[pPool->parent[id]] == NODE_TYPE_FILE) && (pPool->firstChild[id] != NODE_ID_NONE) && (eval_constant(pPool, pPool->firstChild[id], &value));
+	
+}
+
+static unit_type unit_argType(ir* pIR, node_id id) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// Variables are passed at their own size; everything else is worked out as a 32-bit value
+	if (pPool->type[id] == NODE_TYPE_IDENTIFIER) {
+		symbol* pSym = symbol_find(pIR->info.pSymbolTable, node_tokens(pPool, id)[0].value, SYMBOL_CLASS_ALL);
+		if ((pSym) && (pSym->size > 0)) return eval_type_size_from_num(pSym->size);
+	}
+	
+	return UNIT_TYPE_TP_S32;
+	
+}
+
+static char* unit_paramName(node_pool* pPool, node_id id) {
+	
+	// Skip the type to get to the parameter name
+	size_t index = 0;
+	while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+	index++;
+	while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+	
+	return node_tokens(pPool, id)[index].value;
+	
+}
+
+static char* unit_temp(ir* pIR, node_id id) {
+	
+	// Reuse the oldest slot; by the time it comes around again, the statement that used it is long done
+	size_t slot = pIR->info.tempCount % IR_MAX_CALLS;
+	char* name = pIR->info.temps[slot].name;
+	pIR->info.temps[slot].id = id;
+	snprintf(name, MAX_VALUE_LEN, "func_%s_tmp_%llu", pIR->info.thisFunc.name, (unsigned long long)pIR->info.tempCount);
+	(pIR->info.tempCount)++;
+	
+	// Declare it like any other local
+	unit_push(pIR, UNIT_TYPE_KW_LOCAL);
+	unit_push(pIR, UNIT_TYPE_TP_S32);
+	unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+	strcpy(pIR->buffer[pIR->size - 1].value, name);
+	unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+	
+	// Grow the stack frame to make room for it, keeping it aligned to 16 bytes
+	if (pIR->info.allocIndex > 0) {
+		pIR->info.allocBytes += 4;
+		snprintf(pIR->buffer[pIR->info.allocIndex].value, MAX_VALUE_LEN, "%llu", (unsigned long long)((pIR->info.allocBytes + 15) & ~15));
+	}
+	
+	return name;
+	
+}
+
+static char* unit_called(ir* pIR, node_id id) {
+	
+	// Look through the temporaries, newest first
+	size_t count = (pIR->info.tempCount < IR_MAX_CALLS) ? pIR->info.tempCount : IR_MAX_CALLS;
+	for (size_t i = 1; i <= count; i++) {
+		size_t slot = (pIR->info.tempCount - i) % IR_MAX_CALLS;
+		if (pIR->info.temps[slot].id == id) return pIR->info.temps[slot].name;
+	}
+	
+	return "";
+	
+}
+
+static char* unit_reflect(ir* pIR, node_id id) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// Every reflection of the same type shares one descriptor, named by the type and how many pointers deep it is
+	static char label[MAX_VALUE_LEN];
+	size_t pointers = (pPool->tokenCount[id] > 0) ? (pPool->tokenCount[id] - 1) : 0;
+	snprintf(label, MAX_VALUE_LEN, REFLECT_PREFIX "%s_%llu", (pPool->tokenCount[id] > 0) ? node_tokens(pPool, id)[0].value : "", (unsigned long long)pointers);
+	
+	// The symbol table keeps track of which descriptors have to be emitted
+	if (!symbol_find(pIR->info.pSymbolTable, label, SYMBOL_CLASS_LITERAL)) symbol_add(pIR->info.pSymbolTable, label, SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
+	
+	return label;
+	
 }
 
-void unit_parse(ir* pIR, node* pNode, symbol_table* pSymbolTable) {
+static void unit_reflect_tables(ir* pIR) {
+	
+	symbol_table* pTable = pIR->info.pSymbolTable;
+	size_t prefix = strlen(REFLECT_PREFIX);
 	
-	switch (pNode->type) {
+	// Emit every descriptor that was used: label : "name" , size , pointers ;
+	for (size_t i = 0; i < pTable->size; i++) {
 		
-		case (NODE_TYPE_SCOPE)
-		case (NODE_TYPE_FILE) {
-			
-			// If a stack frame should be allocated, then allocate one
-			bool allocFrame = pIR->info.allocFrame;
-			if (allocFrame) {
-				
-				if (pNode->type == NODE_TYPE_SCOPE) {
-				
-					// Check how many bytes of memory we're going to need to allocate for this scope based on its scope index
-					unit_push(pIR, UNIT_TYPE_KW_ALLOC);
-					unit_push(pIR, UNIT_TYPE_LITERAL);
-					
-					// Align up to the nearest 16 bytes, as expected by the ABI
-					uint64_t count = (((pSymbolTable->indicesBuffer[pNode->scopeIndex] + 7) >> 3) + 15) & ~15;
-					char buf[64];
-					itoa(count, buf, 10);
-					strcpy(pIR->buffer[pIR->size - 1].value, buf);
-					
-					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
-					
-				}
-				
-			}
-			
-			// Parse all of our children
-			for (node* thisNode = pNode->firstChild; thisNode; thisNode = thisNode->nextSibling)
-				unit_parse(pIR, thisNode, pSymbolTable);
-			
-			if (pNode->type == NODE_TYPE_FILE) {
-				unit_push(pIR, UNIT_TYPE_KW_END);
-			} else if (allocFrame) {
-				unit_push(pIR, UNIT_TYPE_KW_FREE);
-				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
-			}
-			
-		} break;
+		char* label = pTable->buffer[i].identifier;
+		if ((pTable->buffer[i].class != SYMBOL_CLASS_LITERAL) || (strncmp(label, REFLECT_PREFIX, prefix) != 0)) continue;
 		
-		case (NODE_TYPE_DECL_FUNCTION) {
-			
-			// Get the return type of this function
-			unit_type retType = eval_type_size(pNode, pSymbolTable);
-			
-			// Emit a function declaration node
-			unit_push(pIR, UNIT_TYPE_KW_FUNC);
-			
-			// Emit the function return type
-			unit_push(pIR, retType);
-			
-			// Emit the function name; we need to skip the type to get the variable name
-			size_t index = 0;
-			while (!token_isIdentifier(pNode->tokenList[index].type)) index++;
-			index++;
-			while (!token_isIdentifier(pNode->tokenList[index].type)) index++;
-			
-			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-			unit_copy(pIR, pNode, index);
-			
-			// Set the function info for later reference
-			pIR->info.thisFunc.name = pNode->tokenList[index].value;
-			pIR->info.thisFunc.retType = retType;
-			
-			// Emit a colon delimiter
-			unit_push(pIR, UNIT_TYPE_PT_COLON);
-			
-			// Emit the function parameters; if it has none, this loop will not run
-			node* thisNode = pNode->firstChild;
-			while ((thisNode) && (thisNode->type == NODE_TYPE_DECL_PARAMETER)) {
-				
-				// Emit the parameter type
-				unit_push(pIR, eval_type_size(thisNode, pSymbolTable));
-				
-				// Emit the variable name; we need to skip the type to get the variable name
-				
-				size_t index = 0;
-				while (!token_isIdentifier(thisNode->tokenList[index].type)) index++;
-				index++;
-				while (!token_isIdentifier(thisNode->tokenList[index].type)) index++;
-				
-				// Emit the identifier
-				unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-				unit_copy(pIR, thisNode, index);
-				
-				// Advance to the next node
-				thisNode = thisNode->nextSibling;
-				
-				// Emit the appropriate syntax
-				if (thisNode)
-					if (thisNode->type == NODE_TYPE_SCOPE)
-						unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
-					else
-						unit_push(pIR, UNIT_TYPE_PT_COMMA);
-				
-			}
-			
-			// Check if this function has a scope and emit it
-			if ((thisNode) && (thisNode->type == NODE_TYPE_SCOPE)) {
-				pIR->info.allocFrame = true;
-				unit_parse(pIR, thisNode, pSymbolTable);
-			}
-			
-		} break;
+		// Take the type's name and pointer depth back out of the label
+		char* depth = strrchr(label, '_');
+		char name[MAX_VALUE_LEN] = {};
+		memcpy(name, &label[prefix], depth - &label[prefix]);
+		size_t pointers = strtoull(depth + 1, NULL, 10);
 		
-		case (NODE_TYPE_LITERAL) {
-			
-			// Create a dummy unit to set the return register to
-			static unit temp;
-			temp.type = UNIT_TYPE_LITERAL;
-			strcpy(temp.value, pNode->tokenList[0].value);
-			
+		// Pointers are always 8 bytes, whatever they point at
+		symbol* pType = symbol_find(pTable, name, SYMBOL_CLASS_TYPE);
+		size_t size = (pointers > 0) ? 8 : (pType) ? (pType->size / 8) : 0;
+		
+		unit_push(pIR, UNIT_TYPE_KW_REFLECT);
+		unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+		strcpy(pIR->buffer[pIR->size - 1].value, label);
+		unit_push(pIR, UNIT_TYPE_PT_COLON);
+		
+		unit_push(pIR, UNIT_TYPE_LITERAL);
+		size_t length = snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "\"%s", name);
+		for (size_t j = 0; (j < pointers) && (length < MAX_VALUE_LEN - 2); j++) pIR->buffer[pIR->size - 1].value[length++] = '*';
+		pIR->buffer[pIR->size - 1].value[length++] = '"';
+		pIR->buffer[pIR->size - 1].value[length] = '\0';
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		
+		unit_push(pIR, UNIT_TYPE_LITERAL);
+		snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "%llu", (unsigned long long)size);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		
+		unit_push(pIR, UNIT_TYPE_LITERAL);
+		snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "%llu", (unsigned long long)pointers);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+	}
+	
+}
+
+static void unit_hoist(ir* pIR, node_id id);
+static bool unit_isCondition(node_pool* pPool, node_id id);
+static void unit_boolean(ir* pIR, node_id id);
+
+static void unit_call(ir* pIR, node_id id) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// Calls made by the arguments go first and leave their results in temporaries, so nothing is held in a register across a call; so do comparisons, which may branch
+	for (node_id thisNode = pPool->firstChild[id]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode]) {
+		
+		if (!unit_isCondition(pPool, thisNode)) {
+			unit_hoist(pIR, thisNode);
+			continue;
+		}
+		
+		unit_boolean(pIR, thisNode);
+		
+		char* name = unit_temp(pIR, thisNode);
+		unit_push(pIR, UNIT_TYPE_KW_MOVE);
+		unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+		strcpy(pIR->buffer[pIR->size - 1].value, name);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		unit_push(pIR, UNIT_TYPE_TP_S32);
+		unit_push(pIR, UNIT_TYPE_RG_RG1);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+	}
+	
+	unit_push(pIR, UNIT_TYPE_KW_ARG_PUSH);
+	
+	// Emit every argument by its position; where it ends up is for the target to decide
+	size_t index = 0;
+	for (node_id thisNode = pPool->firstChild[id]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode]) {
+		
+		unit_type type = unit_argType(pIR, thisNode);
+		bool waiting = (pPool->type[thisNode] == NODE_TYPE_CALL_FUNCTION) || (unit_isCondition(pPool, thisNode));
+		bool simple = (pPool->type[thisNode] == NODE_TYPE_LITERAL) || (pPool->type[thisNode] == NODE_TYPE_REFLECT) || (pPool->type[thisNode] == NODE_TYPE_IDENTIFIER) || (waiting);
+		
+		// Anything more than a single value is worked out in the first register
+		if (!simple) emit_expr(pIR, thisNode, UNIT_TYPE_UNDEFINED);
+		
+		unit_push(pIR, UNIT_TYPE_KW_ARG);
+		unit_push(pIR, type);
+		unit_push(pIR, UNIT_TYPE_LITERAL);
+		snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "%llu", (unsigned long long)index);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		
+		if (waiting) {
+			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+			strcpy(pIR->buffer[pIR->size - 1].value, unit_called(pIR, thisNode));
+		} else if (pPool->type[thisNode] == NODE_TYPE_REFLECT) {
+			unit_push(pIR, UNIT_TYPE_LITERAL);
+			strcpy(pIR->buffer[pIR->size - 1].value, unit_reflect(pIR, thisNode));
+		} else if (simple) {
+			unit_push(pIR, (pPool->type[thisNode] == NODE_TYPE_LITERAL) ? UNIT_TYPE_LITERAL : UNIT_TYPE_IDENTIFIER);
+			unit_copy(pIR, thisNode, 0);
+		} else {
+			unit_push(pIR, UNIT_TYPE_TP_S32);
+			unit_push(pIR, UNIT_TYPE_RG_RG1);
+		}
+		
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+		index++;
+		
+	}
+	
+	// Emit the call keyword
+	unit_push(pIR, UNIT_TYPE_KW_CALL);
+	
+	// Emit the function name
+	unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+	unit_copy(pIR, id, 0);
+	
+	unit_push(pIR, UNIT_TYPE_KW_ARG_POP);
+	
+	// The result is left in the return value register
+	static unit result[2] = { { UNIT_TYPE_TP_S32 }, { UNIT_TYPE_RG_RETVAL } };
+	pIR->info.pRet = &result[1];
+	
+}
+
+static bool unit_hoist_enter(node_frame* pFrame, void* pData) {
+	
+	ir* pIR = pData;
+	node_pool* pPool = pIR->info.pPool;
+	node_id id = pFrame->id;
+	
+	if (pPool->type[id] != NODE_TYPE_CALL_FUNCTION) return true;
+	
+	// Make the call and keep its result until the expression gets to it
+	unit_call(pIR, id);
+	
+	char* name = unit_temp(pIR, id);
+	unit_push(pIR, UNIT_TYPE_KW_MOVE);
+	unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+	strcpy(pIR->buffer[pIR->size - 1].value, name);
+	unit_push(pIR, UNIT_TYPE_PT_COMMA);
+	unit_push(pIR, UNIT_TYPE_TP_S32);
+	unit_push(pIR, UNIT_TYPE_RG_RETVAL);
+	unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+	
+	return false;
+	
+}
+
+static void unit_hoist(ir* pIR, node_id id) {
+	node_walk_tree(pIR->info.pPool, id, unit_hoist_enter, NULL, pIR);
+}
+
+static bool unit_isTailCall(ir* pIR, node_id id) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// A return of a call to the function we're in, with an argument for every parameter
+	if ((pPool->type[id] != NODE_TYPE_STATEMENT) || (node_tokens(pPool, id)->type != TOKEN_TYPE_KW_RETURN)) return false;
+	
+	node_id callNode = pPool->firstChild[id];
+	if ((callNode == NODE_ID_NONE) || (pPool->type[callNode] != NODE_TYPE_CALL_FUNCTION) || (strcmp(node_tokens(pPool, callNode)[0].value, pIR->info.thisFunc.name) != 0)) return false;
+	
+	size_t args = 0;
+	size_t params = 0;
+	for (node_id thisNode = pPool->firstChild[callNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode]) args++;
+	for (node_id thisNode = pPool->firstChild[pIR->info.thisFunc.id]; (thisNode != NODE_ID_NONE) && (pPool->type[thisNode] == NODE_TYPE_DECL_PARAMETER); thisNode = pPool->nextSibling[thisNode]) params++;
+	
+	return (args == params);
+	
+}
+
+static bool unit_tail_enter(node_frame* pFrame, void* pData) {
+	
+	ir* pIR = pData;
+	
+	if (unit_isTailCall(pIR, pFrame->id)) pIR->info.thisFunc.tailCalls = true;
+	
+	return true;
+	
+}
+
+static void unit_tail(ir* pIR, node_id callNode) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// Calls made by the arguments go first, as they would for any other call
+	for (node_id thisNode = pPool->firstChild[callNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode]) unit_hoist(pIR, thisNode);
+	
+	// The arguments may read the parameters, so every one of them is worked out before any parameter is written
+	node_id paramNode = pPool->firstChild[pIR->info.thisFunc.id];
+	for (node_id thisNode = pPool->firstChild[callNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode], paramNode = pPool->nextSibling[paramNode]) {
+		
+		if ((pPool->type[thisNode] == NODE_TYPE_LITERAL) || (pPool->type[thisNode] == NODE_TYPE_REFLECT) || (pPool->type[thisNode] == NODE_TYPE_CALL_FUNCTION)) continue;
+		if ((pPool->type[thisNode] == NODE_TYPE_IDENTIFIER) && (strcmp(node_tokens(pPool, thisNode)[0].value, unit_paramName(pPool, paramNode)) == 0)) continue;
+		
+		if (pPool->type[thisNode] == NODE_TYPE_IDENTIFIER) {
+			unit_push(pIR, UNIT_TYPE_KW_MOVE);
+			unit_push(pIR, UNIT_TYPE_TP_S32);
+			unit_push(pIR, UNIT_TYPE_RG_RG1);
+			unit_push(pIR, UNIT_TYPE_PT_COMMA);
+			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+			unit_copy(pIR, thisNode, 0);
+			unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		} else {
+			emit_expr(pIR, thisNode, UNIT_TYPE_UNDEFINED);
+		}
+		
+		char* name = unit_temp(pIR, thisNode);
+		unit_push(pIR, UNIT_TYPE_KW_MOVE);
+		unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+		strcpy(pIR->buffer[pIR->size - 1].value, name);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		unit_push(pIR, UNIT_TYPE_TP_S32);
+		unit_push(pIR, UNIT_TYPE_RG_RG1);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+	}
+	
+	// Then the parameters take their new values
+	paramNode = pPool->firstChild[pIR->info.thisFunc.id];
+	for (node_id thisNode = pPool->firstChild[callNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode], paramNode = pPool->nextSibling[paramNode]) {
+		
+		char* param = unit_paramName(pPool, paramNode);
+		if ((pPool->type[thisNode] == NODE_TYPE_IDENTIFIER) && (strcmp(node_tokens(pPool, thisNode)[0].value, param) == 0)) continue;
+		
+		if ((pPool->type[thisNode] != NODE_TYPE_LITERAL) && (pPool->type[thisNode] != NODE_TYPE_REFLECT)) {
+			unit_push(pIR, UNIT_TYPE_KW_MOVE);
+			unit_push(pIR, UNIT_TYPE_TP_S32);
+			unit_push(pIR, UNIT_TYPE_RG_RG1);
+			unit_push(pIR, UNIT_TYPE_PT_COMMA);
+			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+			strcpy(pIR->buffer[pIR->size - 1].value, unit_called(pIR, thisNode));
+			unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		}
+		
+		unit_push(pIR, UNIT_TYPE_KW_MOVE);
+		unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+		strcpy(pIR->buffer[pIR->size - 1].value, param);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		if (pPool->type[thisNode] == NODE_TYPE_LITERAL) {
+			unit_push(pIR, UNIT_TYPE_LITERAL);
+			unit_copy(pIR, thisNode, 0);
+		} else if (pPool->type[thisNode] == NODE_TYPE_REFLECT) {
+			unit_push(pIR, UNIT_TYPE_LITERAL);
+			strcpy(pIR->buffer[pIR->size - 1].value, unit_reflect(pIR, thisNode));
+		} else {
+			unit_push(pIR, UNIT_TYPE_TP_S32);
+			unit_push(pIR, UNIT_TYPE_RG_RG1);
+		}
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+	}
+	
+	// And instead of calling, we go back to the top of the function
+	unit_push(pIR, UNIT_TYPE_KW_JUMP);
+	unit_push(pIR, UNIT_TYPE_LABEL);
+	snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "func_%s_start", pIR->info.thisFunc.name);
+	unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+	
+}
+
+/*////////*/
+
+static void unit_label(ir* pIR, char* label) {
+	unit_push(pIR, UNIT_TYPE_LABEL);
+	strcpy(pIR->buffer[pIR->size - 1].value, label);
+	unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+}
+
+static void unit_jump(ir* pIR, char* label) {
+	unit_push(pIR, UNIT_TYPE_KW_JUMP);
+	unit_label(pIR, label);
+}
+
+static void unit_label_new(ir* pIR, char* label) {
+	
+	// Labels made up by a condition only have to be different from each other
+	pIR->info.lblIndex++;
+	snprintf(label, MAX_VALUE_LEN, "func_%s_cond_%llu", pIR->info.thisFunc.name, (unsigned long long)pIR->info.lblIndex);
+	
+}
+
+static void unit_constant(node_pool* pPool, node_id id, char* value) {
+	
+	// A character is used by its code
+	char* literal = node_tokens(pPool, id)[0].value;
+	if (node_tokens(pPool, id)[0].type == TOKEN_TYPE_LITERAL_CHAR)
+		snprintf(value, MAX_VALUE_LEN, "%d", (literal[0] == '\'') ? literal[1] : literal[0]);
+	else
+		strcpy(value, literal);
+	
+}
+
+static bool unit_isComparison(node_pool* pPool, node_id id) {
+	
+	if (pPool->type[id] != NODE_TYPE_OPERATION) return false;
+	
+	switch (node_tokens(pPool, id)->type) {
+		case (TOKEN_TYPE_OP_CMP_EQUAL)
+		case (TOKEN_TYPE_OP_CMP_NOT_EQUAL)
+		case (TOKEN_TYPE_OP_CMP_LESS)
+		case (TOKEN_TYPE_OP_CMP_LESS_EQUAL)
+		case (TOKEN_TYPE_OP_CMP_GREATER)
+		case (TOKEN_TYPE_OP_CMP_GREATER_EQUAL) return true;
+		default: return false;
+	}
+	
+}
+
+static bool unit_isCondition(node_pool* pPool, node_id id) {
+	
+	// Comparisons and the logical operators over them are either true or false
+	if (unit_isComparison(pPool, id)) return true;
+	
+	token_type type = node_tokens(pPool, id)->type;
+	return (pPool->type[id] == NODE_TYPE_OPERATION) && ((type == TOKEN_TYPE_OP_CMP_AND) || (type == TOKEN_TYPE_OP_CMP_OR) || (type == TOKEN_TYPE_OP_CMP_NOT));
+	
+}
+
+static bool unit_isLeaf(node_pool* pPool, node_id id) {
+	return (id != NODE_ID_NONE) && ((pPool->type[id] == NODE_TYPE_LITERAL) || (pPool->type[id] == NODE_TYPE_REFLECT) || ((pPool->type[id] == NODE_TYPE_IDENTIFIER) && (pPool->firstChild[id] == NODE_ID_NONE)));
+}
+
+static unit_type unit_compareType(node_pool* pPool, node_id id, bool negate) {
+	
+	// Each comparison, or the one that holds exactly when it doesn't; anything else is tested against zero
+	switch (node_tokens(pPool, id)->type) {
+		case (TOKEN_TYPE_OP_CMP_EQUAL) return (negate) ? UNIT_TYPE_KW_CMP_NE : UNIT_TYPE_KW_CMP_E;
+		case (TOKEN_TYPE_OP_CMP_NOT_EQUAL) return (negate) ? UNIT_TYPE_KW_CMP_E : UNIT_TYPE_KW_CMP_NE;
+		case (TOKEN_TYPE_OP_CMP_LESS) return (negate) ? UNIT_TYPE_KW_CMP_GE : UNIT_TYPE_KW_CMP_L;
+		case (TOKEN_TYPE_OP_CMP_LESS_EQUAL) return (negate) ? UNIT_TYPE_KW_CMP_G : UNIT_TYPE_KW_CMP_LE;
+		case (TOKEN_TYPE_OP_CMP_GREATER) return (negate) ? UNIT_TYPE_KW_CMP_LE : UNIT_TYPE_KW_CMP_G;
+		case (TOKEN_TYPE_OP_CMP_GREATER_EQUAL) return (negate) ? UNIT_TYPE_KW_CMP_L : UNIT_TYPE_KW_CMP_GE;
+		default: return (negate) ? UNIT_TYPE_KW_CMP_Z : UNIT_TYPE_KW_CMP_NZ;
+	}
+	
+}
+
+static void unit_operand(ir* pIR, node_id id, unit* pOut) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	*pOut = (unit){};
+	
+	// Single values are used where they are, and calls have already been made; anything else is worked out in the first register
+	if (pPool->type[id] == NODE_TYPE_LITERAL) {
+		pOut->type = UNIT_TYPE_LITERAL;
+		unit_constant(pPool, id, pOut->value);
+	} else if (pPool->type[id] == NODE_TYPE_REFLECT) {
+		pOut->type = UNIT_TYPE_LITERAL;
+		strcpy(pOut->value, unit_reflect(pIR, id));
+	} else if (pPool->type[id] == NODE_TYPE_IDENTIFIER) {
+		pOut->type = UNIT_TYPE_IDENTIFIER;
+		strcpy(pOut->value, node_tokens(pPool, id)[0].value);
+	} else if (pPool->type[id] == NODE_TYPE_CALL_FUNCTION) {
+		pOut->type = UNIT_TYPE_IDENTIFIER;
+		strcpy(pOut->value, unit_called(pIR, id));
+	} else {
+		emit_expr(pIR, id, UNIT_TYPE_UNDEFINED);
+		*pOut = *pIR->info.pRet;
+	}
+	
+}
+
+static void unit_test_prepare(ir* pIR, node_id id, bool negate, unit_test* pTest) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	*pTest = (unit_test){};
+	pTest->compare = unit_compareType(pPool, id, negate);
+	
+	// Calls go first, so nothing is held in a register across them
+	unit_hoist(pIR, id);
+	
+	// Anything other than a comparison is tested against zero on its own
+	if (!unit_isComparison(pPool, id)) {
+		unit_operand(pIR, id, &pTest->left);
+		return;
+	}
+	
+	node_id leftNode = pPool->firstChild[id];
+	node_id rightNode = pPool->nextSibling[leftNode];
+	unit_operand(pIR, leftNode, &pTest->left);
+	
+	// The second side is worked out in the same register, so the first has to be kept somewhere else until then
+	if ((unit_isRegister(pTest->left.type)) && (pPool->type[rightNode] != NODE_TYPE_LITERAL) && (pPool->type[rightNode] != NODE_TYPE_IDENTIFIER) && (pPool->type[rightNode] != NODE_TYPE_CALL_FUNCTION)) {
+		
+		char* name = unit_temp(pIR, leftNode);
+		unit_push(pIR, UNIT_TYPE_KW_MOVE);
+		unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+		strcpy(pIR->buffer[pIR->size - 1].value, name);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		unit_push(pIR, UNIT_TYPE_TP_S32);
+		unit_push(pIR, pTest->left.type);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+		pTest->left.type = UNIT_TYPE_IDENTIFIER;
+		strcpy(pTest->left.value, name);
+		
+	}
+	
+	unit_operand(pIR, rightNode, &pTest->right);
+	
+}
+
+static void unit_test_push(ir* pIR, unit_test* pTest) {
+	
+	// Registers carry their size
+	if (unit_isRegister(pTest->left.type)) unit_push(pIR, UNIT_TYPE_TP_S32);
+	unit_push(pIR, pTest->left.type);
+	strcpy(pIR->buffer[pIR->size - 1].value, pTest->left.value);
+	
+	unit_push(pIR, pTest->compare);
+	
+	// A test against zero has nothing on the other side
+	if ((pTest->compare == UNIT_TYPE_KW_CMP_Z) || (pTest->compare == UNIT_TYPE_KW_CMP_NZ)) return;
+	
+	if (unit_isRegister(pTest->right.type)) unit_push(pIR, UNIT_TYPE_TP_S32);
+	unit_push(pIR, pTest->right.type);
+	strcpy(pIR->buffer[pIR->size - 1].value, pTest->right.value);
+	
+}
+
+static void unit_branch(ir* pIR, node_id id, bool jumpIf, char* label) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	token_type type = node_tokens(pPool, id)->type;
+	bool operation = (pPool->type[id] == NODE_TYPE_OPERATION);
+	
+	// A not just jumps the other way
+	if ((operation) && (type == TOKEN_TYPE_OP_CMP_NOT)) {
+		unit_branch(pIR, pPool->firstChild[id], !jumpIf, label);
+		return;
+	}
+	
+	// The second side of a logical operator is only looked at when the first doesn't already decide it
+	if ((operation) && ((type == TOKEN_TYPE_OP_CMP_AND) || (type == TOKEN_TYPE_OP_CMP_OR))) {
+		
+		node_id firstNode = pPool->firstChild[id];
+		node_id secondNode = pPool->nextSibling[firstNode];
+		
+		// Jumping when an and holds, or when an or doesn't, needs both sides; the first side failing skips the second
+		if ((type == TOKEN_TYPE_OP_CMP_AND) == jumpIf) {
+			
+			char skip[MAX_VALUE_LEN] = {};
+			unit_label_new(pIR, skip);
+			
+			unit_branch(pIR, firstNode, !jumpIf, skip);
+			unit_branch(pIR, secondNode, jumpIf, label);
+			unit_label(pIR, skip);
+			
+		} else {
+			
+			unit_branch(pIR, firstNode, jumpIf, label);
+			unit_branch(pIR, secondNode, jumpIf, label);
+			
+		}
+		
+		return;
+		
+	}
+	
+	// Anything else is compared, and we jump on the result
+	unit_test test;
+	unit_test_prepare(pIR, id, !jumpIf, &test);
+	
+	unit_push(pIR, UNIT_TYPE_KW_IF);
+	unit_test_push(pIR, &test);
+	unit_push(pIR, UNIT_TYPE_PT_COLON);
+	unit_label(pIR, label);
+	
+}
+
+static void unit_boolean(ir* pIR, node_id id) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// A single comparison sets the first register straight from the flags
+	if (unit_isComparison(pPool, id)) {
+		
+		unit_test test;
+		unit_test_prepare(pIR, id, false, &test);
+		
+		unit_push(pIR, UNIT_TYPE_KW_SET);
+		unit_push(pIR, UNIT_TYPE_TP_S32);
+		unit_push(pIR, UNIT_TYPE_RG_RG1);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		unit_test_push(pIR, &test);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+		return;
+		
+	}
+	
+	// Anything else branches to one of the two values
+	char no[MAX_VALUE_LEN] = {};
+	char end[MAX_VALUE_LEN] = {};
+	unit_label_new(pIR, no);
+	unit_label_new(pIR, end);
+	
+	unit_branch(pIR, id, false, no);
+	
+	for (size_t i = 0; i < 2; i++) {
+		
+		if (i) unit_label(pIR, no);
+		
+		unit_push(pIR, UNIT_TYPE_KW_MOVE);
+		unit_push(pIR, UNIT_TYPE_TP_S32);
+		unit_push(pIR, UNIT_TYPE_RG_RG1);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		unit_push(pIR, UNIT_TYPE_LITERAL);
+		strcpy(pIR->buffer[pIR->size - 1].value, (i) ? "0" : "1");
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+		if (!i) unit_jump(pIR, end);
+		
+	}
+	
+	unit_label(pIR, end);
+	
+}
+
+/*////////*/
+
+static size_t unit_childIndex(node_pool* pPool, node_id id) {
+	
+	size_t index = 0;
+	for (node_id thisNode = pPool->firstChild[pPool->parent[id]]; thisNode != id; thisNode = pPool->nextSibling[thisNode]) index++;
+	
+	return index;
+	
+}
+
+static bool unit_isBranch(node_pool* pPool, node_id id) {
+	
+	// The scopes directly inside an if are its branches
+	node_id ifNode = pPool->parent[id];
+	return (pPool->type[id] == NODE_TYPE_SCOPE) && (ifNode != NODE_ID_NONE) && (pPool->type[ifNode] == NODE_TYPE_STATEMENT) && (node_tokens(pPool, ifNode)->type == TOKEN_TYPE_KW_IF);
+	
+}
+
+static void unit_if_label(ir* pIR, node_id scopeNode, size_t lblIndex, char* label) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// The last branch comes out at the end; the others at the next condition
+	if (pPool->nextSibling[scopeNode] != NODE_ID_NONE)
+		snprintf(label, MAX_VALUE_LEN, "func_%s_if_%llu_%llu", pIR->info.thisFunc.name, (unsigned long long)lblIndex, (unsigned long long)unit_childIndex(pPool, scopeNode));
+	else
+		snprintf(label, MAX_VALUE_LEN, "func_%s_ife_%llu", pIR->info.thisFunc.name, (unsigned long long)lblIndex);
+	
+}
+
+static void unit_if_enter(ir* pIR, node_id scopeNode, size_t lblIndex) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// Find the condition in front of this branch; an else always runs
+	node_id conditionNode = pPool->firstChild[pPool->parent[scopeNode]];
+	while (pPool->nextSibling[conditionNode] != scopeNode) conditionNode = pPool->nextSibling[conditionNode];
+	if ((pPool->type[conditionNode] != NODE_TYPE_CONDITION) || (pPool->firstChild[conditionNode] == NODE_ID_NONE)) return;
+	
+	// Go past the branch when the condition doesn't hold
+	char next[MAX_VALUE_LEN] = {};
+	unit_if_label(pIR, scopeNode, lblIndex, next);
+	unit_branch(pIR, pPool->firstChild[conditionNode], false, next);
+	
+}
+
+static void unit_if_leave(ir* pIR, node_id scopeNode, size_t lblIndex) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	if (pPool->nextSibling[scopeNode] == NODE_ID_NONE) return;
+	
+	// A branch that ran goes past the rest, which start with the next condition
+	char label[MAX_VALUE_LEN] = {};
+	snprintf(label, MAX_VALUE_LEN, "func_%s_ife_%llu", pIR->info.thisFunc.name, (unsigned long long)lblIndex);
+	unit_jump(pIR, label);
+	
+	unit_if_label(pIR, scopeNode, lblIndex, label);
+	unit_label(pIR, label);
+	
+}
+
+static node_id unit_select_assign(node_pool* pPool, node_id scopeNode) {
+	
+	// A branch of nothing but "x = y;", where y is a single value
+	node_id targetNode = (scopeNode != NODE_ID_NONE) ? pPool->firstChild[scopeNode] : NODE_ID_NONE;
+	if ((targetNode == NODE_ID_NONE) || (pPool->nextSibling[targetNode] != NODE_ID_NONE) || (pPool->type[targetNode] != NODE_TYPE_IDENTIFIER)) return NODE_ID_NONE;
+	
+	node_id assignNode = pPool->firstChild[targetNode];
+	if ((assignNode == NODE_ID_NONE) || (pPool->nextSibling[assignNode] != NODE_ID_NONE) || (pPool->type[assignNode] != NODE_TYPE_OPERATION) || (node_tokens(pPool, assignNode)->type != TOKEN_TYPE_OP_ASSIGN)) return NODE_ID_NONE;
+	
+	node_id valueNode = pPool->firstChild[assignNode];
+	if ((!unit_isLeaf(pPool, valueNode)) || (pPool->nextSibling[valueNode] != NODE_ID_NONE)) return NODE_ID_NONE;
+	
+	return targetNode;
+	
+}
+
+static bool unit_select(ir* pIR, node_id id) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	// Only "if (a < b) x = y;", with or without "else x = z;", where everything is a single value
+	node_id conditionNode = pPool->firstChild[id];
+	node_id thenNode = pPool->nextSibling[conditionNode];
+	node_id otherNode = (thenNode != NODE_ID_NONE) ? pPool->nextSibling[thenNode] : NODE_ID_NONE;
+	node_id elseNode = ((otherNode != NODE_ID_NONE) && (pPool->type[otherNode] == NODE_TYPE_CONDITION_ELSE)) ? pPool->nextSibling[otherNode] : NODE_ID_NONE;
+	if ((thenNode == NODE_ID_NONE) || ((otherNode != NODE_ID_NONE) && (elseNode == NODE_ID_NONE)) || ((elseNode != NODE_ID_NONE) && (pPool->nextSibling[elseNode] != NODE_ID_NONE))) return false;
+	
+	node_id testNode = pPool->firstChild[conditionNode];
+	if ((testNode == NODE_ID_NONE) || (!unit_isComparison(pPool, testNode)) || (!unit_isLeaf(pPool, pPool->firstChild[testNode])) || (!unit_isLeaf(pPool, pPool->nextSibling[pPool->firstChild[testNode]]))) return false;
+	
+	node_id firstNode = unit_select_assign(pPool, thenNode);
+	node_id secondNode = unit_select_assign(pPool, elseNode);
+	if ((firstNode == NODE_ID_NONE) || ((elseNode != NODE_ID_NONE) && ((secondNode == NODE_ID_NONE) || (strcmp(node_tokens(pPool, firstNode)[0].value, node_tokens(pPool, secondNode)[0].value) != 0)))) return false;
+	
+	// The else value is written before the test, so the test can't read what it overwrites
+	char* target = node_tokens(pPool, firstNode)[0].value;
+	if (elseNode != NODE_ID_NONE)
+		for (node_id thisNode = pPool->firstChild[testNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode])
+			if ((pPool->type[thisNode] == NODE_TYPE_IDENTIFIER) && (strcmp(node_tokens(pPool, thisNode)[0].value, target) == 0)) return false;
+	
+	unit value;
+	if (elseNode != NODE_ID_NONE) {
+		
+		unit_operand(pIR, pPool->firstChild[pPool->firstChild[secondNode]], &value);
+		
+		unit_push(pIR, UNIT_TYPE_KW_MOVE);
+		unit_push(pIR, UNIT_TYPE_TP_S32);
+		unit_push(pIR, UNIT_TYPE_RG_RG1);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		unit_push(pIR, value.type);
+		strcpy(pIR->buffer[pIR->size - 1].value, value.value);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+		unit_push(pIR, UNIT_TYPE_KW_MOVE);
+		unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+		strcpy(pIR->buffer[pIR->size - 1].value, target);
+		unit_push(pIR, UNIT_TYPE_PT_COMMA);
+		unit_push(pIR, UNIT_TYPE_TP_S32);
+		unit_push(pIR, UNIT_TYPE_RG_RG1);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+	}
+	
+	// Then the value is replaced when the test holds
+	unit_test test;
+	unit_test_prepare(pIR, testNode, false, &test);
+	unit_operand(pIR, pPool->firstChild[pPool->firstChild[firstNode]], &value);
+	
+	unit_push(pIR, UNIT_TYPE_KW_SELECT);
+	unit_push(pIR, UNIT_TYPE_TP_S32);
+	unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+	strcpy(pIR->buffer[pIR->size - 1].value, target);
+	unit_push(pIR, UNIT_TYPE_PT_COMMA);
+	unit_push(pIR, value.type);
+	strcpy(pIR->buffer[pIR->size - 1].value, value.value);
+	unit_push(pIR, UNIT_TYPE_PT_COLON);
+	unit_test_push(pIR, &test);
+	unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static bool unit_isSwitch(node_pool* pPool, node_id id) {
+	
+	// Cases and the default only mean something directly inside the body of a switch
+	node_id switchNode = (pPool->parent[id] != NODE_ID_NONE) ? pPool->parent[pPool->parent[id]] : NODE_ID_NONE;
+	return (switchNode != NODE_ID_NONE) && (pPool->type[switchNode] == NODE_TYPE_STATEMENT) && (node_tokens(pPool, switchNode)->type == TOKEN_TYPE_KW_SWITCH);
+	
+}
+
+static void unit_switch(ir* pIR, node_id id, size_t lblIndex) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	node_id valueNode = pPool->firstChild[pPool->firstChild[id]];
+	node_id scopeNode = pPool->nextSibling[pPool->firstChild[id]];
+	char* name = pIR->info.thisFunc.name;
+	
+	// Work out the value first; anything more than a single value ends up in a register
+	unit value = {};
+	bool isRegister = false;
+	if (pPool->type[valueNode] == NODE_TYPE_CALL_FUNCTION) {
+		
+		unit_call(pIR, valueNode);
+		value.type = UNIT_TYPE_RG_RETVAL;
+		isRegister = true;
+		
+	} else if (pPool->type[valueNode] == NODE_TYPE_OPERATION) {
+		
+		unit_hoist(pIR, valueNode);
+		emit_expr(pIR, valueNode, UNIT_TYPE_UNDEFINED);
+		value = *pIR->info.pRet;
+		isRegister = unit_isRegister(value.type);
+		
+	} else {
+		
+		value.type = (pPool->type[valueNode] == NODE_TYPE_LITERAL) ? UNIT_TYPE_LITERAL : UNIT_TYPE_IDENTIFIER;
+		strcpy(value.value, node_tokens(pPool, valueNode)[0].value);
+		
+	}
+	
+	// Without a default, a value that matches nothing goes straight to the end
+	char fallback[MAX_VALUE_LEN] = {};
+	snprintf(fallback, sizeof(fallback), "func_%s_switche_%llu", name, (unsigned long long)lblIndex);
+	for (node_id thisNode = pPool->firstChild[scopeNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode])
+		if ((pPool->type[thisNode] == NODE_TYPE_STATEMENT) && (node_tokens(pPool, thisNode)->type == TOKEN_TYPE_KW_ELSE))
+			snprintf(fallback, sizeof(fallback), "func_%s_switchd_%llu", name, (unsigned long long)lblIndex);
+	
+	unit_push(pIR, UNIT_TYPE_KW_SWITCH);
+	if (isRegister) unit_push(pIR, UNIT_TYPE_TP_S32);
+	unit_push(pIR, value.type);
+	strcpy(pIR->buffer[pIR->size - 1].value, value.value);
+	unit_push(pIR, UNIT_TYPE_PT_COLON);
+	unit_push(pIR, UNIT_TYPE_LABEL);
+	strcpy(pIR->buffer[pIR->size - 1].value, fallback);
+	unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+	
+	// Then every case with the label of its body; how they are told apart is for the target to decide
+	size_t index = 0;
+	for (node_id thisNode = pPool->firstChild[scopeNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode], index++) {
+		
+		if ((pPool->type[thisNode] != NODE_TYPE_STATEMENT) || (node_tokens(pPool, thisNode)->type != TOKEN_TYPE_KW_CASE)) continue;
+		
+		// Only constant cases can be dispatched on; the parser has already reported the rest
+		node_id caseNode = pPool->firstChild[thisNode];
+		int64_t caseValue = 0;
+		if ((caseNode == NODE_ID_NONE) || (pPool->type[caseNode] == NODE_TYPE_SCOPE) || (!eval_constant(pPool, caseNode, &caseValue))) continue;
+		
+		unit_push(pIR, UNIT_TYPE_KW_CASE);
+		unit_push(pIR, UNIT_TYPE_LITERAL);
+		snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "%lld", (long long)caseValue);
+		
+		unit_push(pIR, UNIT_TYPE_PT_COLON);
+		unit_push(pIR, UNIT_TYPE_LABEL);
+		snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "func_%s_case_%llu_%llu", name, (unsigned long long)lblIndex, (unsigned long long)index);
+		unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+		
+	}
+	
+}
+
+static void unit_switch_end(ir* pIR, size_t lblIndex) {
+	
+	// The end of a case goes past the rest of the switch; there is no falling through
+	char label[MAX_VALUE_LEN] = {};
+	snprintf(label, sizeof(label), "func_%s_switche_%llu", pIR->info.thisFunc.name, (unsigned long long)lblIndex);
+	unit_jump(pIR, label);
+	
+}
+
+static node_id unit_function(node_pool* pPool, node_id id) {
+	
+	// A top-level function may be exported or imported, which wraps it in a statement
+	if ((pPool->type[id] == NODE_TYPE_STATEMENT) && ((node_tokens(pPool, id)->type == TOKEN_TYPE_KW_EXPORT) || (node_tokens(pPool, id)->type == TOKEN_TYPE_KW_IMPORT))) id = pPool->firstChild[id];
+	
+	return ((id != NODE_ID_NONE) && (pPool->type[id] == NODE_TYPE_DECL_FUNCTION)) ? id : NODE_ID_NONE;
+	
+}
+
+static bool unit_fragment_reuse(ir* pIR, node_id id, size_t declIndex) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	ir_fragments* pPrevious = pIR->info.pPrevious;
+	
+	pIR->info.decl.start = pIR->size;
+	
+	// Only functions are kept, as everything else at the top level depends on what came before it
+	node_id funcNode = unit_function(pPool, id);
+	pIR->info.decl.recording = (pIR->fragments.buffer) && (declIndex < pIR->fragments.size) && (funcNode != NODE_ID_NONE);
+	if ((!pIR->info.decl.recording) || (!pPrevious)) return false;
+	
+	// The declaration has to have been carried over from the last parse, and look up the same symbols it did then
+	ast_decl* pDecl = &pIR->info.pAST->decls.buffer[declIndex];
+	if (pDecl->previous >= pPrevious->size) return false;
+	
+	ir_fragment* pFragment = &pPrevious->buffer[pDecl->previous];
+	if ((!pFragment->kept) || (pFragment->symbolHash != pDecl->symbolHash)) return false;
+	
+	// Copy its units in; if there is no room, lower it after all
+	for (size_t i = 0; i < pFragment->size; i++) {
+		
+		unit* pUnit = unit_push(pIR, UNIT_TYPE_UNDEFINED);
+		if (!pUnit) {
+			pIR->size = pIR->info.decl.start;
+			return false;
+		}
+		
+		*pUnit = pPrevious->units[pFragment->start + i];
+		
+	}
+	
+	// Leave lowering as the function would have
+	pIR->info.thisFunc.name = unit_paramName(pPool, funcNode);
+	pIR->info.thisFunc.retType = pFragment->retType;
+	pIR->info.thisFunc.id = funcNode;
+	pIR->info.thisFunc.tailCalls = pFragment->tailCalls;
+	pIR->info.lblIndex = pFragment->lblIndex;
+	pIR->info.tempCount = pFragment->tempCount;
+	pIR->info.allocFrame = pFragment->allocFrame;
+	if (pFragment->allocMoved) {
+		pIR->info.allocIndex = pIR->info.decl.start + pFragment->allocIndex;
+		pIR->info.allocBytes = pFragment->allocBytes;
+	}
+	
+	// The descriptors of the types it reflects are emitted from the symbol table at the end of the file
+	size_t prefix = strlen(REFLECT_PREFIX);
+	for (size_t i = pIR->info.decl.start; i < pIR->size; i++) {
+		
+		char* label = pIR->buffer[i].value;
+		if ((pIR->buffer[i].type != UNIT_TYPE_LITERAL) || (strncmp(label, REFLECT_PREFIX, prefix) != 0)) continue;
+		
+		if (!symbol_find(pIR->info.pSymbolTable, label, SYMBOL_CLASS_LITERAL)) symbol_add(pIR->info.pSymbolTable, label, SYMBOL_TYPE_LITERAL, SYMBOL_SIZE_BITS_0, 0, SYMBOL_CLASS_LITERAL);
+		
+	}
+	
+	// Return success
+	return true;
+	
+}
+
+static void unit_fragment_record(ir* pIR, size_t declIndex) {
+	
+	ir_fragments* pFragments = &pIR->fragments;
+	ir_fragment* pFragment = &pFragments->buffer[declIndex];
+	size_t start = pIR->info.decl.start;
+	size_t size = pIR->size - start;
+	
+	// Make room for the units; a function that doesn't fit is lowered again next time
+	if ((pFragments->unitSize + size) > pFragments->unitMemSize) {
+		
+		size_t newMemSize = (pFragments->unitMemSize == 0) ? 256 : (pFragments->unitMemSize * 2);
+		while (newMemSize < (pFragments->unitSize + size)) newMemSize *= 2;
+		
+		unit* newBuffer = realloc(pFragments->units, newMemSize * sizeof(unit));
+		if (!newBuffer) return;
+		
+		pFragments->units = newBuffer;
+		pFragments->unitMemSize = newMemSize;
+		
+	}
+	
+	memcpy(&pFragments->units[pFragments->unitSize], &pIR->buffer[start], size * sizeof(unit));
+	
+	pFragment->kept = true;
+	pFragment->symbolHash = pIR->info.pAST->decls.buffer[declIndex].symbolHash;
+	pFragment->start = pFragments->unitSize;
+	pFragment->size = size;
+	pFragments->unitSize += size;
+	
+	pFragment->retType = pIR->info.thisFunc.retType;
+	pFragment->tailCalls = pIR->info.thisFunc.tailCalls;
+	pFragment->lblIndex = pIR->info.lblIndex;
+	pFragment->tempCount = pIR->info.tempCount;
+	
+	// The size of the frame is only kept where the function allocated one
+	pFragment->allocFrame = pIR->info.allocFrame;
+	pFragment->allocMoved = (pIR->info.allocIndex > 0) && (pIR->info.allocIndex >= start);
+	pFragment->allocIndex = (pFragment->allocMoved) ? (pIR->info.allocIndex - start) : 0;
+	pFragment->allocBytes = pIR->info.allocBytes;
+	
+}
+
+static bool unit_enter(node_frame* pFrame, void* pData) {
+	
+	ir* pIR = pData;
+	node_pool* pPool = pIR->info.pPool;
+	node_id id = pFrame->id;
+	symbol_table* pSymbolTable = pIR->info.pSymbolTable;
+	
+	// Top-level declarations are counted as they come up, so each can be matched with what it was lowered to last time
+	bool topLevel = (pPool->parent[id] != NODE_ID_NONE) && (pPool->type[pPool->parent[id]] == NODE_TYPE_FILE);
+	size_t declIndex = 0;
+	if (topLevel) {
+		declIndex = (pIR->info.decl.count)++;
+		pIR->info.decl.recording = false;
+	}
+	
+	// Declarations nothing reachable uses are left out entirely; they come up in the same order they were found in
+	if ((topLevel) && (pIR->info.pruned.index < pIR->info.pruned.size) && (pIR->info.pruned.buffer[pIR->info.pruned.index] == id)) {
+		(pIR->info.pruned.index)++;
+		return false;
+	}
+	
+	// A function that hasn't changed is copied in whole from the last compile
+	if ((topLevel) && (unit_fragment_reuse(pIR, id, declIndex))) return false;
+	
+	// A case value was folded into the switch's dispatch, so there is nothing left of it to run
+	if ((pPool->type[id] != NODE_TYPE_SCOPE) && (pPool->parent[id] != NODE_ID_NONE) && (pPool->firstChild[pPool->parent[id]] == id) && (pPool->type[pPool->parent[id]] == NODE_TYPE_STATEMENT) && (node_tokens(pPool, pPool->parent[id])->type == TOKEN_TYPE_KW_CASE)) return false;
+	
+	switch (pPool->type[id]) {
+		
+		case (NODE_TYPE_SCOPE)
+		case (NODE_TYPE_FILE) {
+			
+			// The branches of an if test their condition on the way in
+			if (unit_isBranch(pPool, id)) unit_if_enter(pIR, id, pFrame[-1].state);
+			
+			// If a stack frame should be allocated, then allocate one; remember the choice so we know whether to free it on the way out
+			bool allocFrame = pIR->info.allocFrame;
+			pFrame->state = allocFrame;
+			if (allocFrame) {
+				
+				if (pPool->type[id] == NODE_TYPE_SCOPE) {
+				
+					// Check how many bytes of memory we're going to need to allocate for this scope based on its scope index
+					unit_push(pIR, UNIT_TYPE_KW_ALLOC);
+					unit_push(pIR, UNIT_TYPE_LITERAL);
+					
+					// Align up to the nearest 16 bytes, as expected by the ABI
+					uint64_t count = (((pSymbolTable->indicesBuffer[pPool->scopeIndex[id]] + 7) >> 3) + 15) & ~15;
+					char buf[64];
+					itoa(count, buf, 10);
+					strcpy(pIR->buffer[pIR->size - 1].value, buf);
+					
+					// Remember where the size went; temporaries grow it as they are made
+					pIR->info.allocIndex = pIR->size - 1;
+					pIR->info.allocBytes = (pSymbolTable->indicesBuffer[pPool->scopeIndex[id]] + 7) >> 3;
+					
+					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+					
+					// A function that returns a call to itself jumps back to here instead of making the call
+					if (pIR->info.thisFunc.tailCalls) {
+						unit_push(pIR, UNIT_TYPE_LABEL);
+						snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "func_%s_start", pIR->info.thisFunc.name);
+						unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+					}
+					
+				}
+				
+			}
+			
+			// Parse all of our children
+			return true;
+			
+		}
+		
+		case (NODE_TYPE_DECL_FUNCTION) {
+			
+			// Get the return type of this function
+			unit_type retType = eval_type_size(pPool, id, pSymbolTable);
+			
+			// Emit a function declaration node
+			unit_push(pIR, UNIT_TYPE_KW_FUNC);
+			
+			// Emit the function return type
+			unit_push(pIR, retType);
+			
+			// Emit the function name; we need to skip the type to get the variable name
+			size_t index = 0;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			index++;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			
+			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+			unit_copy(pIR, id, index);
+			
+			// Set the function info for later reference
+			pIR->info.thisFunc.name = node_tokens(pPool, id)[index].value;
+			pIR->info.thisFunc.retType = retType;
+			pIR->info.thisFunc.id = id;
+			
+			// Labels and temporaries are numbered within the function, so what it is lowered to doesn't depend on the functions before it
+			pIR->info.lblIndex = 0;
+			pIR->info.tempCount = 0;
+			
+			// Look for returns of a call to this function, which become jumps
+			pIR->info.thisFunc.tailCalls = false;
+			node_walk_tree(pPool, id, unit_tail_enter, NULL, pIR);
+			
+			// Emit a colon delimiter
+			unit_push(pIR, UNIT_TYPE_PT_COLON);
+			
+			// Emit the function parameters; if it has none, this loop will not run
+			node_id thisNode = pPool->firstChild[id];
+			while ((thisNode != NODE_ID_NONE) && (pPool->type[thisNode] == NODE_TYPE_DECL_PARAMETER)) {
+				
+				// Emit the parameter type
+				unit_push(pIR, eval_type_size(pPool, thisNode, pSymbolTable));
+				
+				// Emit the variable name; we need to skip the type to get the variable name
+				
+				size_t index = 0;
+				while (!token_isIdentifier(node_tokens(pPool, thisNode)[index].type)) index++;
+				index++;
+				while (!token_isIdentifier(node_tokens(pPool, thisNode)[index].type)) index++;
+				
+				// Emit the identifier
+				unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+				unit_copy(pIR, thisNode, index);
+				
+				// Advance to the next node
+				thisNode = pPool->nextSibling[thisNode];
+				
+				// Emit the appropriate syntax
+				if (thisNode != NODE_ID_NONE)
+					if (pPool->type[thisNode] == NODE_TYPE_SCOPE)
+						unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+					else
+						unit_push(pIR, UNIT_TYPE_PT_COMMA);
+				
+			}
+			
+			// Check if this function has a scope; the parameters were emitted above, so only the scope is lowered as a child
+			if ((thisNode != NODE_ID_NONE) && (pPool->type[thisNode] == NODE_TYPE_SCOPE)) {
+				if (pIR->buffer[pIR->size - 1].type == UNIT_TYPE_PT_COLON) unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+				pIR->info.allocFrame = true;
+				return true;
+			}
+			
+			return false;
+			
+		}
+		
+		case (NODE_TYPE_LITERAL) {
+			
+			// Create a dummy unit to set the return register to
+			static unit temp;
+			temp.type = UNIT_TYPE_LITERAL;
+			strcpy(temp.value, node_tokens(pPool, id)[0].value);
+			
+			// Set the return register to this literal
+			pIR->info.pRet = &temp;
+			
+			pIR->info.retNode = id;
+			pIR->info.retNodeIndex = 0;
+			
+			return false;
+			
+		}
+		
+		case (NODE_TYPE_REFLECT) {
+			
+			// A reflection is used like a literal, whose value is the address of its descriptor
+			static unit temp;
+			temp.type = UNIT_TYPE_LITERAL;
+			strcpy(temp.value, unit_reflect(pIR, id));
+			
+			pIR->info.pRet = &temp;
+			
+			pIR->info.retNode = id;
+			pIR->info.retNodeIndex = 0;
+			
+			return false;
+			
+		}
+		
+		case (NODE_TYPE_IDENTIFIER) {
+			
+			// Get the index of the identifier name
+			size_t index = 0;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			index++;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			
+			// Create a dummy unit to set the return register to
+			static unit temp;
+			temp.type = UNIT_TYPE_IDENTIFIER;
+			strcpy(temp.value, node_tokens(pPool, id)[index].value);
+			
 			// Set the return register to this literal
 			pIR->info.pRet = &temp;
 			
-			pIR->info.pRetNode = pNode;
-			pIR->info.pRetNodeIndex = 0;
+			pIR->info.retNode = id;
+			pIR->info.retNodeIndex = index;
+			
+			// If this has a child, then emit that operation
+			return true;
+			
+		}
+		
+		case (NODE_TYPE_STATEMENT) {
+			
+			switch (node_tokens(pPool, id)->type) {
+				
+				case (TOKEN_TYPE_KW_EXPORT) {
+					unit_push(pIR, UNIT_TYPE_KW_EXPORT);
+					return true;
+				}
+				
+				case (TOKEN_TYPE_KW_IMPORT) {
+					unit_push(pIR, UNIT_TYPE_KW_IMPORT);
+					return true;
+				}
+				
+				// Parse what is being returned; the return itself is emitted on the way out
+				case (TOKEN_TYPE_KW_RETURN) {
+					
+					// Returning a call to ourselves starts the function over with the new arguments, and returns nothing here
+					if (unit_isTailCall(pIR, id)) {
+						unit_tail(pIR, pPool->firstChild[id]);
+						pFrame->state = true;
+						return false;
+					}
+					
+					return true;
+					
+				}
+				
+				case (TOKEN_TYPE_KW_WHILE) {
+					
+					// Increment and save the label index; it is needed again on the way out
+					pIR->info.lblIndex++;
+					size_t lblIndex = pIR->info.lblIndex;
+					pFrame->state = lblIndex;
+					
+					char start[MAX_VALUE_LEN] = {};
+					char end[MAX_VALUE_LEN] = {};
+					snprintf(start, sizeof(start), "func_%s_wloops_%u", pIR->info.thisFunc.name, lblIndex);
+					snprintf(end, sizeof(end), "func_%s_wloope_%u", pIR->info.thisFunc.name, lblIndex);
+					
+					// The loop is rotated; skip it entirely if the condition fails the first time
+					unit_branch(pIR, pPool->firstChild[pPool->firstChild[id]], false, end);
+					
+					// Emit the start label, which is the top of the body
+					unit_push(pIR, UNIT_TYPE_LABEL);
+					strcpy(pIR->buffer[pIR->size - 1].value, start);
+					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+					
+					// Note that we shouldn't make a new stack frame
+					pIR->info.allocFrame = false;
+					
+					// Parse the body; the condition node has already been handled and is skipped
+					return true;
+					
+				}
+				
+				case (TOKEN_TYPE_KW_IF) {
+					
+					// Increment and save the label index; every branch and the way out need it
+					pIR->info.lblIndex++;
+					pFrame->state = pIR->info.lblIndex;
+					
+					// A single assignment either way is a select, and there is nothing to branch around
+					if (unit_select(pIR, id)) {
+						pFrame->state = 0;
+						return false;
+					}
+					
+					// Note that we shouldn't make a new stack frame
+					pIR->info.allocFrame = false;
+					
+					// Parse the branches; each one tests its condition on the way in
+					return true;
+					
+				}
+				
+				case (TOKEN_TYPE_KW_SWITCH) {
+					
+					// Increment and save the label index; the cases and the way out need it
+					pIR->info.lblIndex++;
+					size_t lblIndex = pIR->info.lblIndex;
+					pFrame->state = lblIndex;
+					
+					// Pick where to go once, up front
+					unit_switch(pIR, id, lblIndex);
+					
+					// Note that we shouldn't make a new stack frame
+					pIR->info.allocFrame = false;
+					
+					// Parse the cases; the value has already been handled and is skipped
+					return true;
+					
+				}
+				
+				case (TOKEN_TYPE_KW_CASE)
+				case (TOKEN_TYPE_KW_ELSE) {
+					
+					if (!unit_isSwitch(pPool, id)) return false;
+					
+					// The switch is two frames up, past the scope of its body
+					size_t lblIndex = pFrame[-2].state;
+					
+					// Emit the label that the switch jumps to
+					unit_push(pIR, UNIT_TYPE_LABEL);
+					if (node_tokens(pPool, id)->type == TOKEN_TYPE_KW_CASE)
+						snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "func_%s_case_%llu_%llu", pIR->info.thisFunc.name, (unsigned long long)lblIndex, (unsigned long long)unit_childIndex(pPool, id));
+					else
+						snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "func_%s_switchd_%llu", pIR->info.thisFunc.name, (unsigned long long)lblIndex);
+					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+					
+					return true;
+					
+				}
+				
+				default: return false;
+				
+			}
+			
+		}
+		
+		case (NODE_TYPE_OPERATION) {
+			
+			// An assignment straight from a call takes the return value as it is
+			node_id callNode = pPool->firstChild[id];
+			if ((node_tokens(pPool, id)->type == TOKEN_TYPE_OP_ASSIGN) && (callNode != NODE_ID_NONE) && (pPool->type[callNode] == NODE_TYPE_CALL_FUNCTION) && (pPool->nextSibling[callNode] == NODE_ID_NONE)) {
+				
+				unit_call(pIR, callNode);
+				
+				if (pPool->type[pPool->parent[id]] == NODE_TYPE_IDENTIFIER) {
+					unit_push(pIR, UNIT_TYPE_KW_MOVE);
+					unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+					unit_copy(pIR, pPool->parent[id], 0);
+					unit_push(pIR, UNIT_TYPE_PT_COMMA);
+					unit_push(pIR, UNIT_TYPE_TP_S32);
+					unit_push(pIR, UNIT_TYPE_RG_RETVAL);
+					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+				}
+				
+				return false;
+				
+			}
+			
+			// A comparison whose value is wanted is worked out into the first register, and assigned from there
+			node_id valueNode = (node_tokens(pPool, id)->type == TOKEN_TYPE_OP_ASSIGN) ? pPool->firstChild[id] : id;
+			if ((valueNode != NODE_ID_NONE) && (pPool->nextSibling[valueNode] == NODE_ID_NONE) && (unit_isCondition(pPool, valueNode))) {
+				
+				unit_boolean(pIR, valueNode);
+				
+				if ((valueNode != id) && (pPool->type[pPool->parent[id]] == NODE_TYPE_IDENTIFIER)) {
+					unit_push(pIR, UNIT_TYPE_KW_MOVE);
+					unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+					unit_copy(pIR, pPool->parent[id], 0);
+					unit_push(pIR, UNIT_TYPE_PT_COMMA);
+					unit_push(pIR, UNIT_TYPE_TP_S32);
+					unit_push(pIR, UNIT_TYPE_RG_RG1);
+					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+				}
+				
+				static unit result[2] = { { UNIT_TYPE_TP_S32 }, { UNIT_TYPE_RG_RG1 } };
+				pIR->info.pRet = &result[1];
+				
+				return false;
+				
+			}
+			
+			// Calls in the expression are made first, so nothing is held in a register across them
+			unit_hoist(pIR, id);
 			
-		} break;
+			// This is very likely an expression
+			emit_expr(pIR, id, UNIT_TYPE_UNDEFINED);
+			
+			return false;
+			
+		}
 		
-		case (NODE_TYPE_IDENTIFIER) {
+		case (NODE_TYPE_DECL_VARIABLE) {
 			
-			// Get the index of the identifier name
+			// Check if this variable is being assigned to a string literal; if it is, it should be emitted statically
+			bool literal = unit_isStatic(pPool, id);
+			if (literal) {
+				
+				unit_push(pIR, UNIT_TYPE_KW_STATIC);
+				
+			} else {
+				
+				// Emit the local keyword
+				unit_push(pIR, UNIT_TYPE_KW_LOCAL);
+				
+			}
+			
+			// Skip to the variable's type and emit its size
 			size_t index = 0;
-			while (!token_isIdentifier(pNode->tokenList[index].type)) index++;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			unit_push(pIR, eval_type_size(pPool, id, pSymbolTable));
+			
+			// Advance past the type and to the name
 			index++;
-			while (!token_isIdentifier(pNode->tokenList[index].type)) index++;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+			unit_copy(pIR, id, index);
 			
-			// Create a dummy unit to set the return register to
-			static unit temp;
-			temp.type = UNIT_TYPE_IDENTIFIER;
-			strcpy(temp.value, pNode->tokenList[index].value);
+			// If this should be emitted statically, then directly assign the value to the variable
+			if (literal) {
+				
+				// Emit a syntactic colon
+				unit_push(pIR, UNIT_TYPE_PT_COLON);
+				
+				// Emit the literal, or the value it works out to
+				int64_t value = 0;
+				unit_push(pIR, UNIT_TYPE_LITERAL);
+				if (eval_constant(pPool, pPool->firstChild[id], &value))
+					snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "%lld", (long long)value);
+				else
+					unit_copy(pIR, pPool->firstChild[pPool->firstChild[id]], 0);
+				
+				// Emit a semicolon
+				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+				
+				// Return to prevent further execution
+				return false;
+				
+			}
 			
-			// Set the return register to this literal
-			pIR->info.pRet = &temp;
+			// Emit a semicolon
+			unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
 			
-			pIR->info.pRetNode = pNode;
-			pIR->info.pRetNodeIndex = index;
+			// If this has a child, then emit that operation; the result is moved into the variable on the way out
+			return true;
 			
-			// If this has a child, then emit that operation
-			if (pNode->firstChild) {
-				
-				unit_parse(pIR, pNode->firstChild, pSymbolTable);
-				
+		}
+		
+		case (NODE_TYPE_CALL_FUNCTION) {
+			
+			unit_call(pIR, id);
+			
+			return false;
+			
+		}
+		
+		// Anything else is not lowered yet, and neither are its children
+		default: return false;
+		
+	}
+	
+}
+
+static void unit_leave(node_frame* pFrame, void* pData) {
+	
+	ir* pIR = pData;
+	node_pool* pPool = pIR->info.pPool;
+	node_id id = pFrame->id;
+	
+	switch (pPool->type[id]) {
+		
+		case (NODE_TYPE_SCOPE)
+		case (NODE_TYPE_FILE) {
+			
+			// Close the file, or free the stack frame if this scope allocated one
+			if (pPool->type[id] == NODE_TYPE_FILE) {
+				unit_reflect_tables(pIR);
+				unit_push(pIR, UNIT_TYPE_KW_END);
+			} else if (pFrame->state) {
+				unit_push(pIR, UNIT_TYPE_KW_FREE);
+				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
 			}
 			
+			// And go past the rest of the if once a branch has run
+			if (unit_isBranch(pPool, id)) unit_if_leave(pIR, id, pFrame[-1].state);
+			
 		} break;
 		
 		case (NODE_TYPE_STATEMENT) {
 			
-			switch (pNode->tokenList->type) {
-				
-				case (TOKEN_TYPE_KW_EXPORT) {
-					unit_push(pIR, UNIT_TYPE_KW_EXPORT);
-					unit_parse(pIR, pNode->firstChild, pSymbolTable);
-				} break;
-				
-				case (TOKEN_TYPE_KW_IMPORT) {
-					unit_push(pIR, UNIT_TYPE_KW_IMPORT);
-					unit_parse(pIR, pNode->firstChild, pSymbolTable);
-				} break;
+			switch (node_tokens(pPool, id)->type) {
 				
 				case (TOKEN_TYPE_KW_RETURN) {
 					
-					// Parse what is being returned
-					unit_parse(pIR, pNode->firstChild, pSymbolTable);
+					// A tail call has already jumped away
+					if (pFrame->state) break;
 					
 					// Check if this is a register
 					bool isRegister = false;
@@ -609,7 +2220,8 @@ void unit_parse(ir* pIR, node* pNode, symbol_table* pSymbolTable) {
 					unit_push(pIR, UNIT_TYPE_PT_COMMA);
 					if (isRegister) unit_push(pIR, pIR->info.thisFunc.retType);
 					unit_push(pIR, pIR->info.pRet[0].type);
-					if (!isRegister) unit_copy(pIR, pIR->info.pRetNode, pIR->info.pRetNodeIndex);
+					if ((!isRegister) && (pPool->type[pIR->info.retNode] == NODE_TYPE_REFLECT)) strcpy(pIR->buffer[pIR->size - 1].value, pIR->info.pRet[0].value);
+					else if (!isRegister) unit_copy(pIR, pIR->info.retNode, pIR->info.retNodeIndex);
 					
 					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
 					
@@ -621,183 +2233,927 @@ void unit_parse(ir* pIR, node* pNode, symbol_table* pSymbolTable) {
 				
 				case (TOKEN_TYPE_KW_WHILE) {
 					
-					// Increment and save the label index
-					pIR->info.lblIndex++;
-					size_t lblIndex = pIR->info.lblIndex;
+					size_t lblIndex = pFrame->state;
 					
-					// Emit the start label
-					unit_push(pIR, UNIT_TYPE_LABEL);
-					sprintf(pIR->buffer[pIR->size - 1].value, "func_%s_wloops_%u", pIR->info.thisFunc.name, lblIndex);
-					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+					// Test the condition at the bottom and go back to the top while it holds
+					char start[MAX_VALUE_LEN] = {};
+					snprintf(start, sizeof(start), "func_%s_wloops_%u", pIR->info.thisFunc.name, lblIndex);
+					unit_branch(pIR, pPool->firstChild[pPool->firstChild[id]], true, start);
 					
-					// Emit the condition
-					unit_push(pIR, UNIT_TYPE_KW_IF);
-					
-					// Check if there is only one identifier or literal; in that case, emit a zero check
-					if (pNode->firstChild)
-						if (pNode->firstChild->firstChild->type == NODE_TYPE_IDENTIFIER) {
-							
-							unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-							unit_copy(pIR, pNode->firstChild->firstChild, 0);
-							unit_push(pIR, UNIT_TYPE_KW_CMP_Z);
-							
-						} else if (pNode->firstChild->firstChild->type == NODE_TYPE_LITERAL) {
-							
-							unit_push(pIR, UNIT_TYPE_LITERAL);
-							unit_copy(pIR, pNode->firstChild->firstChild, 0);
-							unit_push(pIR, UNIT_TYPE_KW_CMP_Z);
-							
-						} else {
-							
-							// IMPORTANT NOTE: Implement me!
-							
-						}
-					
-					unit_push(pIR, UNIT_TYPE_PT_COLON);
+					// Emit the end label
 					unit_push(pIR, UNIT_TYPE_LABEL);
 					sprintf(pIR->buffer[pIR->size - 1].value, "func_%s_wloope_%u", pIR->info.thisFunc.name, lblIndex);
 					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
 					
-					// Note that we shouldn't make a new stack frame
-					pIR->info.allocFrame = false;
+				} break;
+				
+				case (TOKEN_TYPE_KW_IF) {
 					
-					// Parse the body
-					node* thisNode = pNode->firstChild;
-					while (thisNode->type != NODE_TYPE_SCOPE) thisNode = thisNode->nextSibling;
-					unit_parse(pIR, thisNode, pSymbolTable);
+					// Emit the end label, where every branch comes out; a select has none
+					if (!pFrame->state) break;
 					
-					// Make sure to jump back to the top!
-					unit_push(pIR, UNIT_TYPE_KW_JUMP);
-					unit_push(pIR, UNIT_TYPE_LABEL);
-					sprintf(pIR->buffer[pIR->size - 1].value, "func_%s_wloops_%u", pIR->info.thisFunc.name, lblIndex);
-					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+					char end[MAX_VALUE_LEN] = {};
+					snprintf(end, sizeof(end), "func_%s_ife_%llu", pIR->info.thisFunc.name, (unsigned long long)pFrame->state);
+					unit_label(pIR, end);
 					
-					// Emit the end label
+				} break;
+				
+				case (TOKEN_TYPE_KW_SWITCH) {
+					
+					// Emit the end label, where every case comes out
 					unit_push(pIR, UNIT_TYPE_LABEL);
-					sprintf(pIR->buffer[pIR->size - 1].value, "func_%s_wloope_%u", pIR->info.thisFunc.name, lblIndex);
+					snprintf(pIR->buffer[pIR->size - 1].value, MAX_VALUE_LEN, "func_%s_switche_%llu", pIR->info.thisFunc.name, (unsigned long long)pFrame->state);
 					unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
 					
 				} break;
 				
+				case (TOKEN_TYPE_KW_CASE)
+				case (TOKEN_TYPE_KW_ELSE) {
+					
+					if (unit_isSwitch(pPool, id)) unit_switch_end(pIR, pFrame[-2].state);
+					
+				} break;
+				
 			}
 			
 		} break;
 		
-		case (NODE_TYPE_OPERATION) {
-			
-			// This is very likely an expression
-			emit_expr(pIR, pNode, UNIT_TYPE_UNDEFINED);
-			
-		} break;
+		case (NODE_TYPE_DECL_VARIABLE) {
+			
+			// Static variables were emitted whole on the way in
+			if ((pPool->firstChild[id] == NODE_ID_NONE) || (unit_isStatic(pPool, id))) break;
+			
+			// Get the index of the variable name
+			size_t index = 0;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			index++;
+			while (!token_isIdentifier(node_tokens(pPool, id)[index].type)) index++;
+			
+			// Move the result of the last used register into the variable
+			unit_push(pIR, UNIT_TYPE_KW_MOVE);
+			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
+			unit_copy(pIR, id, index);
+			unit_push(pIR, UNIT_TYPE_PT_COMMA);
+			unit_push(pIR, pIR->info.pRet[-1].type);
+			unit_push(pIR, pIR->info.pRet[0].type);
+			unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+			
+		} break;
+		
+	}
+	
+	// Keep what a top-level function was lowered to for the next compile
+	if ((pIR->info.decl.recording) && (pPool->parent[id] != NODE_ID_NONE) && (pPool->type[pPool->parent[id]] == NODE_TYPE_FILE)) unit_fragment_record(pIR, pIR->info.decl.count - 1);
+	
+}
+
+void unit_parse(ir* pIR, node_id id, symbol_table* pSymbolTable) {
+	
+	// Lower the tree without recursing on the C stack
+	pIR->info.pSymbolTable = pSymbolTable;
+	node_walk_tree(pIR->info.pPool, id, unit_enter, unit_leave, pIR);
+	
+}
+
+/*////////*/
+
+static bool unit_isType(unit_type type) {
+	return ((type >= UNIT_TYPE_TP_UK) && (type <= UNIT_TYPE_TP_F128));
+}
+
+static bool unit_isRegister(unit_type type) {
+	return ((type >= UNIT_TYPE_RG_UK) && (type <= UNIT_TYPE_RG_ARG4));
+}
+
+static bool unit_isWrite(unit_type type) {
+	
+	// These keywords write to the unit that follows them
+	switch (type) {
+		case (UNIT_TYPE_KW_MOVE)
+		case (UNIT_TYPE_KW_ADD)
+		case (UNIT_TYPE_KW_SUB)
+		case (UNIT_TYPE_KW_MUL)
+		case (UNIT_TYPE_KW_DIV)
+		case (UNIT_TYPE_KW_MOD)
+		case (UNIT_TYPE_KW_INC)
+		case (UNIT_TYPE_KW_DEC)
+		case (UNIT_TYPE_KW_SET)
+		case (UNIT_TYPE_KW_SELECT) return true;
+		default: return false;
+	}
+	
+}
+
+static bool unit_literal(unit* pUnit, int64_t* pValue) {
+	
+	if (pUnit->type != UNIT_TYPE_LITERAL) return false;
+	
+	// Only whole numbers count; strings and names are passed around as literals too
+	char* end = NULL;
+	*pValue = strtoll(pUnit->value, &end, 0);
+	return ((end != pUnit->value) && (*end == '\0'));
+	
+}
+
+static bool unit_push_copy(ir* pIR, unit* pUnit) {
+	
+	unit* pNew = unit_push(pIR, pUnit->type);
+	if (!pNew) return false;
+	
+	strcpy(pNew->value, pUnit->value);
+	return true;
+	
+}
+
+static inline_func* inline_find(inline_func funcs[], size_t count, char* name) {
+	
+	for (size_t i = 0; i < count; i++)
+		if (strcmp(funcs[i].name, name) == 0) return &funcs[i];
+	
+	return NULL;
+	
+}
+
+static size_t inline_scan(unit* units, size_t size, inline_func funcs[]) {
+	
+	size_t count = 0;
+	
+	for (size_t i = 0; i < size; i++) {
+		
+		if (units[i].type != UNIT_TYPE_KW_FUNC) continue;
+		if (count == INLINE_MAX_FUNCS) break;
+		
+		inline_func* pFunc = &funcs[count++];
+		memset(pFunc, 0, sizeof(inline_func));
+		
+		// Functions are laid out as [linkage] func type name : params ; alloc size ; body free ;
+		pFunc->linkage = ((i > 0) && ((units[i - 1].type == UNIT_TYPE_KW_EXPORT) || (units[i - 1].type == UNIT_TYPE_KW_IMPORT))) ? units[i - 1].type : UNIT_TYPE_UNDEFINED;
+		pFunc->start = (pFunc->linkage == UNIT_TYPE_UNDEFINED) ? i : (i - 1);
+		pFunc->name = units[i + 2].value;
+		
+		// Read the parameters
+		bool simple = true;
+		size_t j = i + 4;
+		while (((j + 1) < size) && (unit_isType(units[j].type)) && (units[j + 1].type == UNIT_TYPE_IDENTIFIER)) {
+			
+			if (pFunc->paramCount < INLINE_MAX_PARAMS) {
+				pFunc->paramTypes[pFunc->paramCount] = units[j].type;
+				pFunc->params[pFunc->paramCount] = units[j + 1].value;
+			} else {
+				simple = false;
+			}
+			pFunc->paramCount++;
+			
+			j += 2;
+			if ((j < size) && ((units[j].type == UNIT_TYPE_PT_COMMA) || (units[j].type == UNIT_TYPE_PT_SEMICOLON))) j++;
+			
+		}
+		if ((j < size) && (units[j].type == UNIT_TYPE_PT_SEMICOLON)) j++;
+		
+		// Imports have no body
+		if ((j >= size) || (units[j].type != UNIT_TYPE_KW_ALLOC)) {
+			pFunc->end = j;
+			continue;
+		}
+		
+		pFunc->alloc = strtoull(units[j + 1].value, NULL, 10);
+		pFunc->body = j + 3;
+		
+		// Walk the body up to the free that belongs to our alloc, counting statements as we go
+		size_t returns = 0;
+		size_t depth = 0;
+		size_t run = 0;
+		for (j = pFunc->body; j < size; j++) {
+			
+			unit_type type = units[j].type;
+			
+			if (type == UNIT_TYPE_KW_ALLOC) {
+				depth++;
+				simple = false;
+			}
+			if (type == UNIT_TYPE_KW_FREE) {
+				if (depth == 0) break;
+				depth--;
+			}
+			
+			// Statics would be defined twice, and recursion never ends
+			if (type == UNIT_TYPE_KW_STATIC) simple = false;
+			if ((type == UNIT_TYPE_KW_CALL) && ((j + 1) < size) && (strcmp(units[j + 1].value, pFunc->name) == 0)) simple = false;
+			
+			if (type == UNIT_TYPE_KW_RETURN) returns++;
+			
+			if (type == UNIT_TYPE_KW_LOCAL) {
+				if (pFunc->localCount < INLINE_MAX_LOCALS)
+					pFunc->locals[pFunc->localCount++] = units[j + 2].value;
+				else
+					simple = false;
+			}
+			
+			// Statements end on a semicolon; a call counts as one statement of its own
+			run++;
+			if (run >= INLINE_MAX_STATEMENT) simple = false;
+			if ((type == UNIT_TYPE_PT_SEMICOLON) || (type == UNIT_TYPE_KW_ARG_PUSH) || (type == UNIT_TYPE_KW_ARG_POP)) run = 0;
+			if ((type == UNIT_TYPE_PT_SEMICOLON) || (type == UNIT_TYPE_KW_CALL)) pFunc->size++;
+			
+		}
+		
+		pFunc->end = (j < size) ? (j + 2) : size;
+		pFunc->ret = j;
+		
+		// The only return has to be the last statement, so that falling off the end of the body is the same as returning
+		if (returns > 1) simple = false;
+		if ((returns == 1) && ((j < 2) || (units[j - 2].type != UNIT_TYPE_KW_RETURN))) simple = false;
+		
+		if ((returns == 1) && (simple)) {
+			
+			// Find the move into the return value that comes right before it; that stays, as the caller may use the result
+			int64_t k = (int64_t)j - 4;
+			while ((k >= (int64_t)pFunc->body) && (units[k].type != UNIT_TYPE_PT_SEMICOLON) && (units[k].type != UNIT_TYPE_KW_MOVE)) k--;
+			
+			if ((k >= (int64_t)pFunc->body) && (units[k].type == UNIT_TYPE_KW_MOVE) && (units[k + 2].type == UNIT_TYPE_RG_RETVAL))
+				pFunc->ret = j - 2;
+			else
+				simple = false;
+			
+		}
+		
+		// Remember which parameters get written to; the rest can be replaced by their arguments
+		for (size_t p = 0; (p < pFunc->paramCount) && (p < INLINE_MAX_PARAMS); p++)
+			for (size_t k = pFunc->body; k < pFunc->ret; k++)
+				if (unit_isWrite(units[k].type)) {
+					size_t dst = (unit_isType(units[k + 1].type)) ? (k + 2) : (k + 1);
+					if ((units[dst].type == UNIT_TYPE_IDENTIFIER) && (strcmp(units[dst].value, pFunc->params[p]) == 0)) pFunc->written[p] = true;
+				}
+		
+		pFunc->inlinable = (simple) && (strcmp(pFunc->name, "main") != 0);
+		
+	}
+	
+	// Count the call sites of every function
+	for (size_t i = 0; (i + 1) < size; i++)
+		if (units[i].type == UNIT_TYPE_KW_CALL) {
+			inline_func* pFunc = inline_find(funcs, count, units[i + 1].value);
+			if (pFunc) pFunc->calls++;
+		}
+	
+	return count;
+	
+}
+
+static void inline_map(inline_site* pSite, unit* pIn, unit* pOut) {
+	
+	*pOut = *pIn;
+	if (!pSite) return;
+	
+	inline_func* pFunc = pSite->pFunc;
+	
+	// Labels and locals get a name that is unique to this call site
+	if (pIn->type == UNIT_TYPE_LABEL) {
+		snprintf(pOut->value, MAX_VALUE_LEN, "%s_inl%llu", pIn->value, (unsigned long long)pSite->site);
+		return;
+	}
+	
+	if ((pIn->type != UNIT_TYPE_IDENTIFIER) && (pIn->type != UNIT_TYPE_LITERAL)) return;
+	
+	// Parameters that can safely be read straight from their arguments become them
+	for (size_t i = 0; i < pFunc->paramCount; i++)
+		if (strcmp(pIn->value, pFunc->params[i]) == 0) {
+			if (pSite->substituted[i])
+				*pOut = pSite->args[i];
+			else
+				snprintf(pOut->value, MAX_VALUE_LEN, "%s_inl%llu", pIn->value, (unsigned long long)pSite->site);
+			return;
+		}
+	
+	for (size_t i = 0; i < pFunc->localCount; i++)
+		if (strcmp(pIn->value, pFunc->locals[i]) == 0) {
+			snprintf(pOut->value, MAX_VALUE_LEN, "%s_inl%llu", pIn->value, (unsigned long long)pSite->site);
+			return;
+		}
+	
+}
+
+static bool inline_fits(inline_state* pState, inline_func* pFunc, size_t site) {
+	
+	// Every renamed label and local has to fit in a unit
+	size_t suffix = snprintf(NULL, 0, "_inl%llu", (unsigned long long)site);
+	
+	for (size_t i = pFunc->body; i < pFunc->ret; i++)
+		if (((pState->source[i].type == UNIT_TYPE_LABEL) || (pState->source[i].type == UNIT_TYPE_IDENTIFIER)) && ((strlen(pState->source[i].value) + suffix) >= MAX_VALUE_LEN)) return false;
+	
+	for (size_t i = 0; i < pFunc->paramCount; i++)
+		if ((strlen(pFunc->params[i]) + suffix) >= MAX_VALUE_LEN) return false;
+	
+	return true;
+	
+}
+
+static bool inline_declared(inline_state* pState, inline_func* pFunc, char* name, unit_type* pType) {
+	
+	// Parameters and locals are the only names that live in the frame; anything else is a static or a function
+	for (size_t i = 0; (i < pFunc->paramCount) && (i < INLINE_MAX_PARAMS); i++)
+		if (strcmp(pFunc->params[i], name) == 0) {
+			*pType = pFunc->paramTypes[i];
+			return true;
+		}
+	
+	for (size_t i = pFunc->body; (pFunc->body > 0) && ((i + 2) < pFunc->end); i++)
+		if ((pState->source[i].type == UNIT_TYPE_KW_LOCAL) && (strcmp(pState->source[i + 2].value, name) == 0)) {
+			*pType = pState->source[i + 1].type;
+			return true;
+		}
+	
+	return false;
+	
+}
+
+static unit_type inline_static(inline_state* pState, char* name) {
+	
+	for (size_t i = 0; (i + 2) < pState->sourceSize; i++)
+		if ((pState->source[i].type == UNIT_TYPE_KW_STATIC) && (strcmp(pState->source[i + 2].value, name) == 0)) return pState->source[i + 1].type;
+	
+	return UNIT_TYPE_UNDEFINED;
+	
+}
+
+static bool inline_collides(inline_state* pState, inline_func* pFunc) {
+	
+	// Names we can't see all of might be anything
+	if ((!pState->pCaller) || (pState->pCaller->paramCount > INLINE_MAX_PARAMS)) return true;
+	
+	// A static the callee uses would be read as the caller's local of the same name
+	for (size_t i = pFunc->body; i < pFunc->ret; i++) {
+		
+		if (pState->source[i].type != UNIT_TYPE_IDENTIFIER) continue;
+		
+		unit_type type;
+		if (inline_declared(pState, pFunc, pState->source[i].value, &type)) continue;
+		if (inline_declared(pState, pState->pCaller, pState->source[i].value, &type)) return true;
+		
+	}
+	
+	return false;
+	
+}
+
+/*////////*/
+
+static inline_value* inline_lookup(inline_known* pKnown, unit* pUnit) {
+	
+	for (size_t i = 0; i < pKnown->count; i++)
+		if ((pKnown->values[i].type == pUnit->type) && (strcmp(pKnown->values[i].name, pUnit->value) == 0)) return &pKnown->values[i];
+	
+	return NULL;
+	
+}
+
+static inline_value* inline_track(inline_known* pKnown, unit* pUnit) {
+	
+	inline_value* pValue = inline_lookup(pKnown, pUnit);
+	if ((pValue) || (pKnown->count == INLINE_MAX_KNOWN)) return pValue;
+	
+	pValue = &pKnown->values[pKnown->count++];
+	pValue->type = pUnit->type;
+	strcpy(pValue->name, pUnit->value);
+	pValue->known = false;
+	
+	return pValue;
+	
+}
+
+static void inline_forget(inline_known* pKnown) {
+	for (size_t i = 0; i < pKnown->count; i++) pKnown->values[i].known = false;
+}
+
+static void inline_fold(inline_known* pKnown, unit stmt[], size_t* pLength) {
+	
+	unit_type op = stmt[0].type;
+	
+	// Declaring a whole number local lets us follow its value
+	if (op == UNIT_TYPE_KW_LOCAL) {
+		
+		if ((stmt[1].type == UNIT_TYPE_TP_S32) || (stmt[1].type == UNIT_TYPE_TP_S64)) {
+			inline_value* pValue = inline_track(pKnown, &stmt[2]);
+			if (pValue) pValue->known = false;
+		}
+		
+		return;
 		
-		case (NODE_TYPE_DECL_VARIABLE) {
-			
-			// Check if this variable is being assigned to a string literal; if it is, it should be emitted statically
-			bool literal = false;
-			if ((pNode->firstChild) && (pNode->firstChild->firstChild) && (pNode->firstChild->firstChild->tokenList->type == TOKEN_TYPE_LITERAL_STR)) {
-				
-				unit_push(pIR, UNIT_TYPE_KW_STATIC);
-				
-				literal = true;
-				
-			} else {
-				
-				// Emit the local keyword
-				unit_push(pIR, UNIT_TYPE_KW_LOCAL);
-				
-			}
+	}
+	
+	// Anything else that isn't a plain operation may be jumped to or call out, so forget everything
+	if ((!unit_isWrite(op)) && (op != UNIT_TYPE_KW_IF) && (op != UNIT_TYPE_KW_SWITCH)) {
+		inline_forget(pKnown);
+		return;
+	}
+	
+	// Find the destination and the source; a condition or a switch only has a source
+	size_t dst = (unit_isType(stmt[1].type)) ? 2 : 1;
+	size_t src = 0;
+	if ((op == UNIT_TYPE_KW_IF) || (op == UNIT_TYPE_KW_SWITCH)) {
+		src = dst;
+		dst = 0;
+	} else if (stmt[dst + 1].type == UNIT_TYPE_PT_COMMA) {
+		src = (unit_isType(stmt[dst + 2].type)) ? (dst + 3) : (dst + 2);
+	}
+	
+	// Replace a source we know the value of with the value itself, dropping the size that came with a register
+	if (src) {
+		
+		inline_value* pValue = inline_lookup(pKnown, &stmt[src]);
+		if ((pValue) && (pValue->known)) {
 			
-			// Skip to the variable's type and emit its size
-			size_t index = 0;
-			while (!token_isIdentifier(pNode->tokenList[index].type)) index++;
-			unit_push(pIR, eval_type_size(pNode, pSymbolTable));
+			size_t at = (unit_isType(stmt[src - 1].type)) ? (src - 1) : src;
+			stmt[at].type = UNIT_TYPE_LITERAL;
+			snprintf(stmt[at].value, MAX_VALUE_LEN, "%lld", (long long)pValue->value);
 			
-			// Advance past the type and to the name
-			index++;
-			while (!token_isIdentifier(pNode->tokenList[index].type)) index++;
-			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-			unit_copy(pIR, pNode, index);
+			memmove(&stmt[at + 1], &stmt[src + 1], (*pLength - src - 1) * sizeof(unit));
+			*pLength -= (src - at);
+			src = at;
 			
-			// If this should be emitted statically, then directly assign the value to the variable
-			if (literal) {
-				
-				// Emit a syntactic colon
-				unit_push(pIR, UNIT_TYPE_PT_COLON);
-				
-				// Emit the literal
-				unit_push(pIR, UNIT_TYPE_LITERAL);
-				unit_copy(pIR, pNode->firstChild->firstChild, 0);
-				
-				// Emit a semicolon
-				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
-				
-				// Break to prevent further execution
-				break;
-				
-			}
+		}
+		
+	}
+	
+	if ((op == UNIT_TYPE_KW_IF) || (op == UNIT_TYPE_KW_SWITCH)) return;
+	
+	// Registers are followed while they hold whole numbers, locals once they have been declared as one
+	inline_value* pDest = inline_lookup(pKnown, &stmt[dst]);
+	if (unit_isRegister(stmt[dst].type)) {
+		
+		bool whole = (dst == 2) && ((stmt[1].type == UNIT_TYPE_TP_S32) || (stmt[1].type == UNIT_TYPE_TP_S64));
+		if ((!pDest) && (whole)) pDest = inline_track(pKnown, &stmt[dst]);
+		
+		if ((pDest) && (!whole)) {
+			pDest->known = false;
+			return;
+		}
+		
+	}
+	
+	if (!pDest) return;
+	
+	// Work out the value the destination ends up holding
+	int64_t value = 0;
+	bool constant = (src) && (unit_literal(&stmt[src], &value));
+	bool known = pDest->known;
+	int64_t result = 0;
+	
+	switch (op) {
+		case (UNIT_TYPE_KW_MOVE) known = constant; result = value; break;
+		case (UNIT_TYPE_KW_ADD) known = (known) && (constant); result = pDest->value + value; break;
+		case (UNIT_TYPE_KW_SUB) known = (known) && (constant); result = pDest->value - value; break;
+		case (UNIT_TYPE_KW_MUL) known = (known) && (constant); result = pDest->value * value; break;
+		case (UNIT_TYPE_KW_DIV) known = (known) && (constant) && (value != 0); if (known) result = pDest->value / value; break;
+		case (UNIT_TYPE_KW_MOD) known = (known) && (constant) && (value != 0); if (known) result = pDest->value % value; break;
+		case (UNIT_TYPE_KW_INC) result = pDest->value + 1; break;
+		case (UNIT_TYPE_KW_DEC) result = pDest->value - 1; break;
+		default: known = false; break;
+	}
+	
+	// Values are only followed while every operation on them stays exact in 32 bits
+	if ((!known) || (result > INT32_MAX) || (result < INT32_MIN)) {
+		pDest->known = false;
+		return;
+	}
+	
+	pDest->known = true;
+	pDest->value = result;
+	
+	// An operation on a known value becomes a move of the result
+	if (op != UNIT_TYPE_KW_MOVE) {
+		
+		stmt[0].type = UNIT_TYPE_KW_MOVE;
+		stmt[dst + 1].type = UNIT_TYPE_PT_COMMA;
+		stmt[dst + 1].value[0] = '\0';
+		stmt[dst + 2].type = UNIT_TYPE_LITERAL;
+		snprintf(stmt[dst + 2].value, MAX_VALUE_LEN, "%lld", (long long)result);
+		stmt[dst + 3].type = UNIT_TYPE_PT_SEMICOLON;
+		stmt[dst + 3].value[0] = '\0';
+		*pLength = dst + 4;
+		
+	}
+	
+}
+
+static bool inline_emit(ir* pOut, inline_known* pKnown, unit stmt[], size_t length) {
+	
+	// Fold what we can, then push the statement
+	inline_fold(pKnown, stmt, &length);
+	
+	for (size_t i = 0; i < length; i++)
+		if (!unit_push_copy(pOut, &stmt[i])) return false;
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static bool inline_call(inline_state* pState, ir* pOut, size_t* pIndex, inline_site* pParent, size_t depth);
+
+static inline_func* inline_choose(inline_state* pState, char* name, size_t argCount, size_t depth) {
+	
+	// There has to be a frame to grow, and we don't go on forever
+	if ((!pState->alloc) || (depth >= INLINE_MAX_DEPTH)) return NULL;
+	
+	inline_func* pFunc = inline_find(pState->funcs, pState->funcCount, name);
+	if ((!pFunc) || (!pFunc->inlinable) || (pFunc->linkage == UNIT_TYPE_KW_IMPORT) || (pFunc->paramCount != argCount)) return NULL;
+	
+	// Never expand a function inside of itself
+	for (size_t i = 0; i < depth; i++)
+		if (pState->stack[i] == pFunc) return NULL;
+	
+	// Small functions are always worth it; a private function with a single call site goes away afterwards, so it may be larger
+	bool small = (pFunc->size <= INLINE_MAX_SIZE);
+	bool once = (pFunc->calls == 1) && (pFunc->linkage == UNIT_TYPE_UNDEFINED) && (pFunc->size <= INLINE_MAX_SIZE_ONCE);
+	if ((!small) && (!once)) return NULL;
+	
+	// Stay within the growth budget
+	size_t cost = pFunc->ret - pFunc->body;
+	if (cost > pState->budget) return NULL;
+	if (!inline_fits(pState, pFunc, pState->sites + 1)) return NULL;
+	if (inline_collides(pState, pFunc)) return NULL;
+	
+	pState->budget -= cost;
+	
+	return pFunc;
+	
+}
+
+static bool inline_expand(inline_state* pState, ir* pOut, inline_func* pFunc, unit args[], unit_type argTypes[], bool argLocal[], size_t depth) {
+	
+	inline_site site = {};
+	site.pFunc = pFunc;
+	site.site = ++(pState->sites);
+	memcpy(site.args, args, pFunc->paramCount * sizeof(unit));
+	
+	pState->stack[depth] = pFunc;
+	
+	// Only a literal, or a local of the same type that nothing but the caller can name, is read in place of a parameter that is never written
+	size_t copied = 0;
+	for (size_t i = 0; i < pFunc->paramCount; i++) {
+		site.substituted[i] = (!pFunc->written[i]) && ((args[i].type == UNIT_TYPE_LITERAL) || ((argLocal[i]) && (argTypes[i] == pFunc->paramTypes[i])));
+		if (!site.substituted[i]) copied++;
+	}
+	
+	// Every other parameter gets a local of its own, so grow the caller's frame by those and the callee's locals
+	unit* pAlloc = &pOut->buffer[pState->alloc];
+	uint64_t count = strtoull(pAlloc->value, NULL, 10) + pFunc->alloc + (((copied * 8) + 15) & ~15);
+	snprintf(pAlloc->value, MAX_VALUE_LEN, "%llu", (unsigned long long)count);
+	
+	inline_known known = {};
+	unit stmt[INLINE_MAX_STATEMENT];
+	
+	for (size_t i = 0; i < pFunc->paramCount; i++) {
+		
+		if (site.substituted[i]) continue;
+		
+		unit param = { UNIT_TYPE_IDENTIFIER };
+		strcpy(param.value, pFunc->params[i]);
+		unit name;
+		inline_map(&site, &param, &name);
+		
+		// The argument is read at its own width and stored at the parameter's
+		unit_type loadType = ((args[i].type == UNIT_TYPE_LITERAL) || (argTypes[i] == UNIT_TYPE_UNDEFINED)) ? pFunc->paramTypes[i] : argTypes[i];
+		
+		// Declare the local and move the argument into it, the same way a declaration is lowered
+		unit declare[] = { { UNIT_TYPE_KW_LOCAL }, { pFunc->paramTypes[i] }, name, { UNIT_TYPE_PT_SEMICOLON } };
+		unit load[] = { { UNIT_TYPE_KW_MOVE }, { loadType }, { UNIT_TYPE_RG_RG1 }, { UNIT_TYPE_PT_COMMA }, args[i], { UNIT_TYPE_PT_SEMICOLON } };
+		unit store[] = { { UNIT_TYPE_KW_MOVE }, name, { UNIT_TYPE_PT_COMMA }, { pFunc->paramTypes[i] }, { UNIT_TYPE_RG_RG1 }, { UNIT_TYPE_PT_SEMICOLON } };
+		
+		memcpy(stmt, declare, sizeof(declare));
+		if (!inline_emit(pOut, &known, stmt, 4)) return false;
+		memcpy(stmt, load, sizeof(load));
+		if (!inline_emit(pOut, &known, stmt, 6)) return false;
+		memcpy(stmt, store, sizeof(store));
+		if (!inline_emit(pOut, &known, stmt, 6)) return false;
+		
+	}
+	
+	// Copy the body up to the return
+	size_t length = 0;
+	size_t i = pFunc->body;
+	while (i < pFunc->ret) {
+		
+		if (pState->source[i].type == UNIT_TYPE_KW_ARG_PUSH) {
 			
-			// Emit a semicolon
-			unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
+			if ((length) && (!inline_emit(pOut, &known, stmt, length))) return false;
+			length = 0;
 			
-			// If this has a child, then emit that operation; otherwise, don't emit anything
-			if (pNode->firstChild) {
-				
-				unit_parse(pIR, pNode->firstChild, pSymbolTable);
-				
-				// Move the result of the last used register into the variable
-				unit_push(pIR, UNIT_TYPE_KW_MOVE);
-				unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-				unit_copy(pIR, pNode, index);
-				unit_push(pIR, UNIT_TYPE_PT_COMMA);
-				unit_push(pIR, pIR->info.pRet[-1].type);
-				unit_push(pIR, pIR->info.pRet[0].type);
-				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
-				
-			}
+			if (!inline_call(pState, pOut, &i, &site, depth + 1)) return false;
+			inline_forget(&known);
+			continue;
 			
-		} break;
+		}
 		
-		case (NODE_TYPE_CALL_FUNCTION) {
+		inline_map(&site, &pState->source[i], &stmt[length++]);
+		i++;
+		
+		if (stmt[length - 1].type == UNIT_TYPE_PT_SEMICOLON) {
+			if (!inline_emit(pOut, &known, stmt, length)) return false;
+			length = 0;
+		}
+		
+	}
+	
+	for (size_t j = 0; j < length; j++)
+		if (!unit_push_copy(pOut, &stmt[j])) return false;
+	
+	return true;
+	
+}
+
+static bool inline_call(inline_state* pState, ir* pOut, size_t* pIndex, inline_site* pParent, size_t depth) {
+	
+	unit* units = pState->source;
+	size_t start = *pIndex;
+	
+	// Arguments are looked up in the function the call was written in
+	inline_func* pContext = (pParent) ? pParent->pFunc : pState->pCaller;
+	
+	// A call looks like: arg_push (arg type index , value ;)* call name arg_pop; arguments that had to be worked out first leave it as it is
+	unit args[INLINE_MAX_PARAMS];
+	unit_type argTypes[INLINE_MAX_PARAMS] = {};
+	bool argLocal[INLINE_MAX_PARAMS] = {};
+	size_t argCount = 0;
+	bool plain = true;
+	size_t i = start + 1;
+	while ((i < pState->sourceSize) && (units[i].type == UNIT_TYPE_KW_ARG)) {
+		
+		size_t end = i;
+		while ((end < pState->sourceSize) && (units[end].type != UNIT_TYPE_PT_SEMICOLON)) end++;
+		if (end >= pState->sourceSize) break;
+		
+		if ((units[end - 1].type != UNIT_TYPE_IDENTIFIER) && (units[end - 1].type != UNIT_TYPE_LITERAL)) plain = false;
+		if (argCount < INLINE_MAX_PARAMS) {
 			
-			// Push the arguments onto the stack
-			unit_push(pIR, UNIT_TYPE_KW_ARG_PUSH);
+			inline_map(pParent, &units[end - 1], &args[argCount]);
 			
-			// Emit the function arguments into the appropriate registers
-			size_t index = 0;
-			node* thisNode = pNode->firstChild;
-			while (thisNode) {
-				
-				// Get the appropriate argument register
-				unit_type out = UNIT_TYPE_RG_ARG1 + index;
-				
-				// Emit the movement into the argument register
-				unit_push(pIR, UNIT_TYPE_KW_MOVE);
-				unit_push(pIR, eval_type_size(thisNode, pSymbolTable));
-				unit_push(pIR, out);
-				unit_push(pIR, UNIT_TYPE_PT_COMMA);
-				unit_push(pIR, UNIT_TYPE_LITERAL);
-				unit_copy(pIR, thisNode, 0);
-				unit_push(pIR, UNIT_TYPE_PT_SEMICOLON);
-				
-				// Advance to the next sibling
-				thisNode = thisNode->nextSibling;
-				
+			// Locals and parameters keep the type they were declared with; anything else is a static
+			if (units[end - 1].type == UNIT_TYPE_IDENTIFIER) {
+				argLocal[argCount] = (pContext) && inline_declared(pState, pContext, units[end - 1].value, &argTypes[argCount]);
+				if (!argLocal[argCount]) argTypes[argCount] = inline_static(pState, units[end - 1].value);
 			}
 			
-			// Emit the call keyword
-			unit_push(pIR, UNIT_TYPE_KW_CALL);
+		}
+		argCount++;
+		
+		i = end + 1;
+		
+	}
+	
+	bool shaped = (plain) && ((i + 2) < pState->sourceSize) && (units[i].type == UNIT_TYPE_KW_CALL) && (units[i + 2].type == UNIT_TYPE_KW_ARG_POP);
+	
+	inline_func* pFunc = NULL;
+	if ((shaped) && (argCount <= INLINE_MAX_PARAMS)) pFunc = inline_choose(pState, units[i + 1].value, argCount, depth);
+	
+	if (pFunc) {
+		*pIndex = i + 3;
+		return inline_expand(pState, pOut, pFunc, args, argTypes, argLocal, depth);
+	}
+	
+	// Otherwise keep the call as it is
+	if (!shaped) {
+		while ((i < pState->sourceSize) && (units[i].type != UNIT_TYPE_KW_ARG_POP)) i++;
+		if (i >= pState->sourceSize) i = pState->sourceSize - 1;
+	} else {
+		i += 2;
+	}
+	
+	for (size_t j = start; j <= i; j++) {
+		unit mapped;
+		inline_map(pParent, &units[j], &mapped);
+		if (!unit_push_copy(pOut, &mapped)) return false;
+	}
+	
+	*pIndex = i + 1;
+	return true;
+	
+}
+
+static size_t inline_references(unit* units, size_t size, inline_func* pFunc) {
+	
+	size_t count = 0;
+	
+	for (size_t i = 0; i < size; i++) {
+		if ((i >= pFunc->start) && (i < pFunc->end)) continue;
+		if (((units[i].type == UNIT_TYPE_IDENTIFIER) || (units[i].type == UNIT_TYPE_LITERAL)) && (strcmp(units[i].value, pFunc->name) == 0)) count++;
+	}
+	
+	return count;
+	
+}
+
+bool ir_inline(ir* pIR) {
+	
+	inline_state* pState = calloc(1, sizeof(inline_state));
+	if (!pState) return false;
+	
+	pState->source = pIR->buffer;
+	pState->sourceSize = pIR->size;
+	pState->funcCount = inline_scan(pIR->buffer, pIR->size, pState->funcs);
+	
+	// The module may only grow by so much
+	pState->budget = (pIR->size * INLINE_MAX_GROWTH) / 100;
+	if (pState->budget < INLINE_MIN_GROWTH) pState->budget = INLINE_MIN_GROWTH;
+	
+	// Copy everything over, expanding the calls we chose
+	ir out = {};
+	bool success = ir_resize(&out);
+	
+	size_t i = 0;
+	while ((success) && (i < pIR->size)) {
+		
+		if (pIR->buffer[i].type == UNIT_TYPE_KW_ARG_PUSH) {
+			success = inline_call(pState, &out, &i, NULL, 0);
+			continue;
+		}
+		
+		// Remember where the frame size of the current function ends up, as it grows with everything we expand into it
+		if (pIR->buffer[i].type == UNIT_TYPE_KW_ALLOC) pState->alloc = out.size + 1;
+		if (pIR->buffer[i].type == UNIT_TYPE_KW_FUNC) {
+			pState->alloc = 0;
+			pState->pCaller = ((i + 2) < pIR->size) ? inline_find(pState->funcs, pState->funcCount, pIR->buffer[i + 2].value) : NULL;
+		}
+		
+		success = unit_push_copy(&out, &pIR->buffer[i]);
+		i++;
+		
+	}
+	
+	if (!success) {
+		free(out.buffer);
+		free(pState);
+		return false;
+	}
+	
+	// Private functions that were expanded at every call site are no longer needed
+	inline_func* funcs = calloc(INLINE_MAX_FUNCS, sizeof(inline_func));
+	bool removed = (funcs != NULL);
+	while (removed) {
+		
+		removed = false;
+		size_t count = inline_scan(out.buffer, out.size, funcs);
+		
+		for (size_t j = 0; j < count; j++) {
+			
+			inline_func* pFunc = &funcs[j];
+			inline_func* pOriginal = inline_find(pState->funcs, pState->funcCount, pFunc->name);
 			
-			// Emit the function name
-			unit_push(pIR, UNIT_TYPE_IDENTIFIER);
-			unit_copy(pIR, pNode, 0);
+			if ((!pOriginal) || (pOriginal->calls == 0) || (pFunc->linkage != UNIT_TYPE_UNDEFINED) || (strcmp(pFunc->name, "main") == 0)) continue;
+			if (inline_references(out.buffer, out.size, pFunc) > 0) continue;
 			
-			// Pop the arguments from the stack
-			unit_push(pIR, UNIT_TYPE_KW_ARG_POP);
+			memmove(&out.buffer[pFunc->start], &out.buffer[pFunc->end], (out.size - pFunc->end) * sizeof(unit));
+			out.size -= (pFunc->end - pFunc->start);
+			removed = true;
+			break;
 			
-		} break;
+		}
+		
+	}
+	
+	free(funcs);
+	free(pState);
+	
+	// Swap the buffers
+	free(pIR->buffer);
+	pIR->buffer = out.buffer;
+	pIR->size = out.size;
+	pIR->memSize = out.memSize;
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static uint64_t prune_hash(char* name) {
+	
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; name[i] != '\0'; i++) {
+		hash ^= (uint8_t)name[i];
+		hash *= 1099511628211ULL;
+	}
+	
+	return hash;
+	
+}
+
+static void prune_reach(prune_state* pState, char* name) {
+	
+	// Every declaration with the name is reached, so a function declared ahead of its definition keeps both
+	uint64_t hash = prune_hash(name);
+	for (size_t slot = hash & (pState->slotCount - 1); pState->slots[slot] != SIZE_MAX; slot = (slot + 1) & (pState->slotCount - 1)) {
+		
+		prune_decl* pDecl = &pState->decls[pState->slots[slot]];
+		if ((pDecl->reached) || (pDecl->hash != hash) || (strcmp(pDecl->name, name) != 0)) continue;
+		
+		pDecl->reached = true;
+		pState->pending[(pState->pendingCount)++] = pState->slots[slot];
+		
+	}
+	
+}
+
+static bool prune_enter(node_frame* pFrame, void* pData) {
+	
+	prune_state* pState = pData;
+	node_pool* pPool = pState->pPool;
+	node_id id = pFrame->id;
+	
+	// A declaration only names its type and itself; calls and every other use of a name are what reach a declaration
+	if ((pPool->type[id] == NODE_TYPE_DECL_FUNCTION) || (pPool->type[id] == NODE_TYPE_DECL_VARIABLE) || (pPool->type[id] == NODE_TYPE_DECL_PARAMETER)) return true;
+	
+	for (size_t i = 0; i < pPool->tokenCount[id]; i++)
+		if (token_isIdentifier(node_tokens(pPool, id)[i].type)) prune_reach(pState, node_tokens(pPool, id)[i].value);
+	
+	return true;
+	
+}
+
+static bool ir_prune(ir* pIR, node_id rootNode) {
+	
+	node_pool* pPool = pIR->info.pPool;
+	
+	prune_state state = {};
+	state.pPool = pPool;
+	for (node_id thisNode = pPool->firstChild[rootNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode]) state.count++;
+	if (state.count == 0) return true;
+	
+	// Keep the table at most half full
+	state.slotCount = 16;
+	while (state.slotCount < (state.count * 2)) state.slotCount *= 2;
+	
+	state.decls = calloc(state.count, sizeof(prune_decl));
+	state.slots = malloc(state.slotCount * sizeof(size_t));
+	state.pending = malloc(state.count * sizeof(size_t));
+	if ((!state.decls) || (!state.slots) || (!state.pending)) {
+		free(state.decls);
+		free(state.slots);
+		free(state.pending);
+		return false;
+	}
+	memset(state.slots, 0xFF, state.slotCount * sizeof(size_t));
+	
+	// Private functions, imports and constant data can go; everything else is kept and walked for what it uses
+	bool rooted = false;
+	size_t index = 0;
+	for (node_id thisNode = pPool->firstChild[rootNode]; thisNode != NODE_ID_NONE; thisNode = pPool->nextSibling[thisNode], index++) {
+		
+		prune_decl* pDecl = &state.decls[index];
+		pDecl->id = thisNode;
+		
+		node_id declNode = thisNode;
+		token_type linkage = TOKEN_TYPE_UNDEFINED;
+		if ((pPool->type[thisNode] == NODE_TYPE_STATEMENT) && ((node_tokens(pPool, thisNode)->type == TOKEN_TYPE_KW_EXPORT) || (node_tokens(pPool, thisNode)->type == TOKEN_TYPE_KW_IMPORT))) {
+			linkage = node_tokens(pPool, thisNode)->type;
+			declNode = pPool->firstChild[thisNode];
+		}
+		
+		bool function = (declNode != NODE_ID_NONE) && (pPool->type[declNode] == NODE_TYPE_DECL_FUNCTION);
+		bool data = (declNode != NODE_ID_NONE) && (pPool->type[declNode] == NODE_TYPE_DECL_VARIABLE) && ((linkage == TOKEN_TYPE_KW_IMPORT) || (unit_isStatic(pPool, declNode)));
+		if ((function) || (data)) pDecl->name = unit_paramName(pPool, declNode);
+		
+		// The roots are main and everything exported
+		bool root = (linkage == TOKEN_TYPE_KW_EXPORT) || ((function) && (strcmp(pDecl->name, "main") == 0));
+		rooted |= root;
+		
+		if ((root) || ((!function) && (!data))) {
+			pDecl->reached = true;
+			state.pending[(state.pendingCount)++] = index;
+			continue;
+		}
+		
+		pDecl->hash = prune_hash(pDecl->name);
+		size_t slot = pDecl->hash & (state.slotCount - 1);
+		while (state.slots[slot] != SIZE_MAX) slot = (slot + 1) & (state.slotCount - 1);
+		state.slots[slot] = index;
+		
+	}
+	
+	// Walk everything reached for the names it uses, which reaches more; a file with nothing to start from is kept whole
+	bool success = true;
+	while ((rooted) && (success) && (state.pendingCount > 0))
+		success = node_walk_tree(pPool, state.decls[state.pending[--(state.pendingCount)]].id, prune_enter, NULL, &state);
+	
+	if ((rooted) && (success)) {
+		
+		pIR->info.pruned.buffer = malloc(state.count * sizeof(node_id));
+		success = (pIR->info.pruned.buffer != NULL);
+		
+		for (size_t i = 0; (success) && (i < state.count); i++)
+			if (!state.decls[i].reached) pIR->info.pruned.buffer[(pIR->info.pruned.size)++] = state.decls[i].id;
 		
 	}
 	
+	free(state.decls);
+	free(state.slots);
+	free(state.pending);
+	
+	return success;
+	
 }
 
 /*////////*/
@@ -831,13 +3187,27 @@ void ir_print(ir* pIR) {
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_JUMP) ? "KW_JUMP" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_LOCAL) ? "KW_LOCAL" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_STATIC) ? "KW_STATIC" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_REFLECT) ? "KW_REFLECT" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_ALLOC) ? "KW_ALLOC" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_FREE) ? "KW_FREE" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_IF) ? "KW_IF" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_SWITCH) ? "KW_SWITCH" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CASE) ? "KW_CASE" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_SET) ? "KW_SET" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_SELECT) ? "KW_SELECT" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_Z) ? "KW_CMP_Z" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_NZ) ? "KW_CMP_NZ" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_E) ? "KW_CMP_E" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_NE) ? "KW_CMP_NE" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_L) ? "KW_CMP_L" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_LE) ? "KW_CMP_LE" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_G) ? "KW_CMP_G" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_CMP_GE) ? "KW_CMP_GE" :
 			
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_INC) ? "KW_INC" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_DEC) ? "KW_DEC" :
 			
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_ARG) ? "KW_ARG" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_ARG_PUSH) ? "KW_ARG_PUSH" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_ARG_POP) ? "KW_ARG_POP" :
 			
@@ -845,6 +3215,7 @@ void ir_print(ir* pIR) {
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_SUB) ? "KW_SUB" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_MUL) ? "KW_MUL" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_DIV) ? "KW_DIV" :
+			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_MOD) ? "KW_MOD" :
 			
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_EXPORT) ? "KW_EXPORT" :
 			(pIR->buffer[pIR->index].type == UNIT_TYPE_KW_IMPORT) ? "KW_IMPORT" :
@@ -895,10 +3266,52 @@ bool ir_generate(ir* pIR, ir_info* pInfo) {
 	pIR->info.thisFunc.name = "";
 	pIR->info.allocFrame = true;
 	
+	// Everything after parsing reads the tree as laid out in its pool, starting at the file node
+	pIR->info.pPool = &pInfo->pAST->pool;
+	if (pIR->info.pPool->size == 0) return false;
+	
+	// Functions are copied from the last compile where they can be, and recorded for the next one
+	pIR->info.pAST = pInfo->pAST;
+	pIR->info.pPrevious = pInfo->pPrevious;
+	if ((pInfo->incremental) && (pInfo->pAST->decls.size > 0)) {
+		pIR->fragments.buffer = calloc(pInfo->pAST->decls.size, sizeof(ir_fragment));
+		if (!pIR->fragments.buffer) return false;
+		pIR->fragments.size = pInfo->pAST->decls.size;
+	}
+	
+	// Find what main and the exports can reach, so only that is lowered
+	if (ir_prune(pIR, 0) == false) return false;
+	
 	// Parse the file node and let it handle the rest
-	unit_parse(pIR, pInfo->pAST->root, pInfo->pSymbolTable);
+	unit_parse(pIR, 0, pInfo->pSymbolTable);
+	
+	// Expand small functions at their call sites
+	if (ir_inline(pIR) == false) return false;
 	
 	// Return success
 	return true;
 	
+}
+
+void ir_destroy(ir* pIR) {
+	
+	// Free memory
+	free(pIR->buffer);
+	free(pIR->info.pruned.buffer);
+	symbol_table_destroy(&pIR->info.varTable);
+	ir_fragments_destroy(&pIR->fragments);
+	memset(&pIR->info.pruned, 0, sizeof(pIR->info.pruned));
+	pIR->buffer = NULL;
+	pIR->memSize = 0;
+	pIR->size = 0;
+	pIR->index = 0;
+	
+}
+void ir_fragments_destroy(ir_fragments* pFragments) {
+	
+	// Free memory
+	free(pFragments->buffer);
+	free(pFragments->units);
+	*pFragments = (ir_fragments){};
+	
 }
\ No newline at end of file
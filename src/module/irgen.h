@@ -1,5 +1,9 @@
 #pragma once
 
+// [ MACROS ] //
+
+#define IR_MAX_CALLS 64 // Calls whose results can be waiting in temporaries at once
+
 // [ DEFINING ] //
 
 typedef enum {
@@ -25,6 +29,10 @@ typedef enum {
 	UNIT_TYPE_KW_CALL,
 	UNIT_TYPE_KW_JUMP,
 	UNIT_TYPE_KW_IF,
+	UNIT_TYPE_KW_SWITCH,
+	UNIT_TYPE_KW_CASE,
+	UNIT_TYPE_KW_SET,
+	UNIT_TYPE_KW_SELECT,
 	
 	UNIT_TYPE_KW_CMP_Z,
 	UNIT_TYPE_KW_CMP_G,
@@ -40,6 +48,7 @@ typedef enum {
 	
 	UNIT_TYPE_KW_STATIC,
 	UNIT_TYPE_KW_LOCAL,
+	UNIT_TYPE_KW_REFLECT,
 	
 	UNIT_TYPE_KW_MOVE,
 	
@@ -54,6 +63,7 @@ typedef enum {
 	UNIT_TYPE_KW_INC,
 	UNIT_TYPE_KW_DEC,
 	
+	UNIT_TYPE_KW_ARG,
 	UNIT_TYPE_KW_ARG_PUSH,
 	UNIT_TYPE_KW_ARG_POP,
 	
@@ -103,9 +113,44 @@ typedef struct {
 
 /*////////*/
 
+// What a top-level function was lowered to, and the state it left lowering in, so it can be copied in when nothing it depends on has changed
+typedef struct {
+	bool kept;
+	uint64_t symbolHash;
+	size_t start;
+	size_t size;
+	
+	unit_type retType;
+	bool tailCalls;
+	size_t lblIndex;
+	size_t tempCount;
+	
+	bool allocFrame;
+	bool allocMoved; // Whether it allocated a frame of its own, whose size is at allocIndex into its units
+	size_t allocIndex;
+	size_t allocBytes;
+} ir_fragment;
+
+// Fragments by the index of their declaration in the AST they were lowered from
+typedef struct {
+	size_t size;
+	ir_fragment* buffer;
+	size_t unitMemSize;
+	size_t unitSize;
+	unit* units;
+} ir_fragments;
+
+/*////////*/
+
 typedef struct {
 	ast* pAST;
 	symbol_table* pSymbolTable;
+	
+	// The IR is kept for the next compile, so every function records what it was lowered to
+	bool incremental;
+	
+	// What the functions of the last parse of this file were lowered to, if it was
+	ir_fragments* pPrevious;
 } ir_info;
 
 typedef struct {
@@ -115,22 +160,54 @@ typedef struct {
 	size_t size;
 	unit* buffer;
 	
+	ir_fragments fragments;
+	
 	struct {
 		
 		struct {
 			char* name;
 			unit_type retType;
+			node_id id;
+			bool tailCalls;
 		} thisFunc;
 		
 		size_t lblIndex;
 		
 		bool allocFrame;
+		size_t allocIndex;
+		size_t allocBytes;
+		
+		// Values worked out ahead of the statement that uses them, such as the results of calls
+		struct {
+			node_id id;
+			char name[MAX_VALUE_LEN];
+		} temps[IR_MAX_CALLS];
+		size_t tempCount;
 		
 		unit* pRet;
-		node* pRetNode;
-		size_t pRetNodeIndex;
+		node_id retNode;
+		size_t retNodeIndex;
 		
+		node_pool* pPool;
 		symbol_table varTable;
+		symbol_table* pSymbolTable;
+		
+		// Top-level declarations nothing reachable uses, in the order they appear; they are skipped instead of lowered
+		struct {
+			size_t size;
+			size_t index;
+			node_id* buffer;
+		} pruned;
+		
+		// The top-level declaration being lowered, and where its units start
+		struct {
+			size_t count;
+			size_t start;
+			bool recording;
+		} decl;
+		
+		ast* pAST;
+		ir_fragments* pPrevious;
 		
 	} info;
 	
@@ -138,5 +215,11 @@ typedef struct {
 
 // [ FUNCTIONS ] //
 
+bool eval_constant(node_pool* pPool, node_id id, int64_t* pValue);
+
+/*////////*/
+
 bool ir_generate(ir* pIR, ir_info* pInfo);
+void ir_destroy(ir* pIR);
+void ir_fragments_destroy(ir_fragments* pFragments);
 void ir_print(ir* pIR);
\ No newline at end of file
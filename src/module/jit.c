@@ -0,0 +1,1092 @@
+// [ INCLUDING ] //
+
+#include "common.h"
+
+#include <windows.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+// [ MACROS ] //
+
+#define JIT_REGISTER_NONE -1
+
+// Names the program can't use, for the pieces the JIT adds around it
+#define JIT_SAVED "$saved" // The stack pointer main was called with
+#define JIT_EXIT "$exit" // Where ExitProcess goes, which returns to the compiler instead of ending it
+
+// [ DEFINING ] //
+
+typedef enum {
+	JIT_OPERAND_NONE,
+	JIT_OPERAND_REGISTER,
+	JIT_OPERAND_MEMORY,
+	JIT_OPERAND_IMMEDIATE,
+	JIT_OPERAND_LABEL,
+} jit_operand_kind;
+
+typedef struct {
+	
+	jit_operand_kind kind;
+	size_t size; // In bytes; zero when memory doesn't say and the other operand has to
+	
+	int reg;
+	int64_t imm;
+	
+	// Memory is base + index * scale + displacement, or a label relative to the next instruction
+	int base;
+	int index;
+	int scale;
+	int32_t disp;
+	bool relative;
+	char label[MAX_VALUE_LEN];
+	
+} jit_operand;
+
+typedef struct {
+	char* name;
+	bool data;
+	size_t offset;
+} jit_label;
+
+typedef enum {
+	JIT_FIXUP_RELATIVE, // A 32-bit distance from the end of the instruction
+	JIT_FIXUP_ABSOLUTE, // A 64-bit address
+} jit_fixup_kind;
+
+typedef struct {
+	jit_fixup_kind kind;
+	bool data;
+	size_t offset;
+	size_t next;
+	char name[MAX_VALUE_LEN];
+} jit_fixup;
+
+typedef struct {
+	char* name; // Kept by the first fixup that needed it
+	size_t slot;
+} jit_import;
+
+typedef struct {
+	size_t memSize;
+	size_t size;
+	uint8_t* buffer;
+} jit_bytes;
+
+typedef struct {
+	
+	jit_run* pRun;
+	
+	// Code and read only data go in one buffer, writable data in the other; both are copied in once everything is known
+	jit_bytes code;
+	jit_bytes data;
+	jit_bytes* pOut;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		jit_label* buffer;
+	} labels;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		jit_fixup* buffer;
+	} fixups;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		jit_import* buffer;
+	} imports;
+	
+	// The fixups of the instruction being encoded, whose ends are only known once it is done
+	size_t pending;
+	
+	// Where it all ended up
+	uint8_t* pMemory;
+	size_t codeSize;
+	size_t memorySize;
+	
+	DWORD fault;
+	
+} jit_state;
+
+/*////////*/
+
+// Every register by the name and size it is used at
+static struct {
+	char* name;
+	int reg;
+	size_t size;
+} registerTable[] = {
+	{ "rax", 0, 8 },  { "rcx", 1, 8 },  { "rdx", 2, 8 },  { "rbx", 3, 8 },  { "rsp", 4, 8 },  { "rbp", 5, 8 },  { "rsi", 6, 8 },  { "rdi", 7, 8 },
+	{ "r8", 8, 8 },   { "r9", 9, 8 },   { "r10", 10, 8 }, { "r11", 11, 8 }, { "r12", 12, 8 }, { "r13", 13, 8 }, { "r14", 14, 8 }, { "r15", 15, 8 },
+	{ "eax", 0, 4 },  { "ecx", 1, 4 },  { "edx", 2, 4 },  { "ebx", 3, 4 },  { "esp", 4, 4 },  { "ebp", 5, 4 },  { "esi", 6, 4 },  { "edi", 7, 4 },
+	{ "r8d", 8, 4 },  { "r9d", 9, 4 },  { "r10d", 10, 4 }, { "r11d", 11, 4 }, { "r12d", 12, 4 }, { "r13d", 13, 4 }, { "r14d", 14, 4 }, { "r15d", 15, 4 },
+	{ "ax", 0, 2 },   { "cx", 1, 2 },   { "dx", 2, 2 },   { "bx", 3, 2 },   { "sp", 4, 2 },   { "bp", 5, 2 },   { "si", 6, 2 },   { "di", 7, 2 },
+	{ "r8w", 8, 2 },  { "r9w", 9, 2 },  { "r10w", 10, 2 }, { "r11w", 11, 2 }, { "r12w", 12, 2 }, { "r13w", 13, 2 }, { "r14w", 14, 2 }, { "r15w", 15, 2 },
+	{ "al", 0, 1 },   { "cl", 1, 1 },   { "dl", 2, 1 },   { "bl", 3, 1 },   { "spl", 4, 1 },  { "bpl", 5, 1 },  { "sil", 6, 1 },  { "dil", 7, 1 },
+	{ "r8b", 8, 1 },  { "r9b", 9, 1 },  { "r10b", 10, 1 }, { "r11b", 11, 1 }, { "r12b", 12, 1 }, { "r13b", 13, 1 }, { "r14b", 14, 1 }, { "r15b", 15, 1 },
+};
+
+// Memory operands say how much they touch before the brackets
+static struct {
+	char* name;
+	size_t length;
+	size_t size;
+} sizeTable[] = {
+	{ "byte ", 5, 1 },
+	{ "word ", 5, 2 },
+	{ "dword ", 6, 4 },
+	{ "qword ", 6, 8 },
+};
+
+// The arithmetic that shares one set of encodings, by the number each is told apart with
+static int aluTable[] = {
+	[ASM_OP_ADD] = 0,
+	[ASM_OP_SBB] = 3,
+	[ASM_OP_AND] = 4,
+	[ASM_OP_SUB] = 5,
+	[ASM_OP_XOR] = 6,
+	[ASM_OP_CMP] = 7,
+};
+
+// The condition each conditional instruction tests, as it is encoded
+static uint8_t conditionTable[] = {
+	[ASM_OP_SETZ] = 0x4,  [ASM_OP_CMOVZ] = 0x4,  [ASM_OP_JZ] = 0x4,
+	[ASM_OP_SETNZ] = 0x5, [ASM_OP_CMOVNZ] = 0x5, [ASM_OP_JNZ] = 0x5,
+	[ASM_OP_JA] = 0x7,
+	[ASM_OP_SETL] = 0xC,  [ASM_OP_CMOVL] = 0xC,  [ASM_OP_JL] = 0xC,
+	[ASM_OP_SETGE] = 0xD, [ASM_OP_CMOVGE] = 0xD, [ASM_OP_JGE] = 0xD,
+	[ASM_OP_SETLE] = 0xE, [ASM_OP_CMOVLE] = 0xE, [ASM_OP_JLE] = 0xE,
+	[ASM_OP_SETG] = 0xF,  [ASM_OP_CMOVG] = 0xF,  [ASM_OP_JG] = 0xF,
+};
+
+// Calls main with the stack the way a Windows function expects it, and keeps the stack pointer so ExitProcess can come back to it
+static instruction entryTable[] = {
+	{ ASM_OP_PUSH, { { ASM_OPERAND_REGISTER, "rbp" } } },
+	{ ASM_OP_SUB, { { ASM_OPERAND_REGISTER, "rsp" }, { ASM_OPERAND_IMMEDIATE, "32" } } },
+	{ ASM_OP_MOV, { { ASM_OPERAND_MEMORY, "qword [rel " JIT_SAVED "]" }, { ASM_OPERAND_REGISTER, "rsp" } } },
+	{ ASM_OP_CALL, { { ASM_OPERAND_LABEL, "main" } } },
+	{ ASM_OP_ADD, { { ASM_OPERAND_REGISTER, "rsp" }, { ASM_OPERAND_IMMEDIATE, "32" } } },
+	{ ASM_OP_POP, { { ASM_OPERAND_REGISTER, "rbp" } } },
+	{ ASM_OP_RET },
+	{ ASM_OP_LABEL, { { ASM_OPERAND_LABEL, JIT_EXIT } } },
+	{ ASM_OP_MOV, { { ASM_OPERAND_REGISTER, "eax" }, { ASM_OPERAND_REGISTER, "ecx" } } },
+	{ ASM_OP_MOV, { { ASM_OPERAND_REGISTER, "rsp" }, { ASM_OPERAND_MEMORY, "qword [rel " JIT_SAVED "]" } } },
+	{ ASM_OP_ADD, { { ASM_OPERAND_REGISTER, "rsp" }, { ASM_OPERAND_IMMEDIATE, "32" } } },
+	{ ASM_OP_POP, { { ASM_OPERAND_REGISTER, "rbp" } } },
+	{ ASM_OP_RET },
+};
+
+// Imported functions are looked up in the libraries a linked program would have used
+static char* libraryTable[] = {
+	"kernel32.dll",
+	"ucrtbase.dll",
+	"msvcrt.dll",
+};
+
+// The run in progress, so that a fault in its code can be turned into a return
+static jit_state* pFaulting = NULL;
+
+// [ FUNCTIONS ] //
+
+static bool jit_fail(jit_state* pState, jit_status status, char* detail) {
+	
+	// Only the first thing to go wrong is kept
+	if (pState->pRun->status == JIT_STATUS_RETURNED) {
+		pState->pRun->status = status;
+		strncpy(pState->pRun->detail, (detail) ? detail : "", MAX_VALUE_LEN - 1);
+	}
+	
+	return false;
+	
+}
+
+/*////////*/
+
+static bool bytes_put(jit_state* pState, uint64_t value, size_t count) {
+	
+	jit_bytes* pBytes = pState->pOut;
+	if (!buffer_resize((void**)&pBytes->buffer, &pBytes->memSize, pBytes->size + count, 1)) return jit_fail(pState, JIT_STATUS_OUT_OF_MEMORY, NULL);
+	
+	// Little endian, lowest byte first
+	for (size_t i = 0; i < count; i++) pBytes->buffer[(pBytes->size)++] = (uint8_t)(value >> (i * 8));
+	
+	return true;
+	
+}
+
+static bool bytes_align(jit_state* pState, size_t alignment, uint8_t fill) {
+	
+	if (alignment == 0) return true;
+	
+	while (pState->pOut->size % alignment) {
+		if (!bytes_put(pState, fill, 1)) return false;
+	}
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static bool label_add(jit_state* pState, char* name) {
+	
+	if (!buffer_resize((void**)&pState->labels.buffer, &pState->labels.memSize, pState->labels.size + 1, sizeof(jit_label))) return jit_fail(pState, JIT_STATUS_OUT_OF_MEMORY, NULL);
+	
+	jit_label* pLabel = &pState->labels.buffer[(pState->labels.size)++];
+	pLabel->name = name;
+	pLabel->data = (pState->pOut == &pState->data);
+	pLabel->offset = pState->pOut->size;
+	
+	return true;
+	
+}
+
+static jit_label* label_find(jit_state* pState, char* name) {
+	
+	for (size_t i = 0; i < pState->labels.size; i++)
+		if (strcmp(pState->labels.buffer[i].name, name) == 0) return &pState->labels.buffer[i];
+	
+	return NULL;
+	
+}
+
+static bool fixup_add(jit_state* pState, jit_fixup_kind kind, char* name) {
+	
+	if (!buffer_resize((void**)&pState->fixups.buffer, &pState->fixups.memSize, pState->fixups.size + 1, sizeof(jit_fixup))) return jit_fail(pState, JIT_STATUS_OUT_OF_MEMORY, NULL);
+	
+	jit_fixup* pFixup = &pState->fixups.buffer[(pState->fixups.size)++];
+	*pFixup = (jit_fixup){};
+	pFixup->kind = kind;
+	pFixup->data = (pState->pOut == &pState->data);
+	pFixup->offset = pState->pOut->size;
+	strncpy(pFixup->name, name, MAX_VALUE_LEN - 1);
+	
+	// The address itself is filled in once everything is in memory
+	return bytes_put(pState, 0, (kind == JIT_FIXUP_RELATIVE) ? 4 : 8);
+	
+}
+
+/*////////*/
+
+static int register_find(char* name, size_t* pSize) {
+	
+	for (size_t i = 0; i < (sizeof(registerTable) / sizeof(registerTable[0])); i++) {
+		if (strcmp(registerTable[i].name, name) == 0) {
+			if (pSize) *pSize = registerTable[i].size;
+			return registerTable[i].reg;
+		}
+	}
+	
+	return JIT_REGISTER_NONE;
+	
+}
+
+static bool number_parse(char* text, int64_t* pValue) {
+	
+	if (text[0] == '\0') return false;
+	
+	char* end = NULL;
+	*pValue = strtoll(text, &end, 0);
+	
+	return (*end == '\0');
+	
+}
+
+static bool memory_parse(jit_operand* pOperand, char* text) {
+	
+	pOperand->base = JIT_REGISTER_NONE;
+	pOperand->index = JIT_REGISTER_NONE;
+	pOperand->scale = 1;
+	
+	// The size, if it is given
+	for (size_t i = 0; i < (sizeof(sizeTable) / sizeof(sizeTable[0])); i++) {
+		if (strncmp(text, sizeTable[i].name, sizeTable[i].length) == 0) {
+			pOperand->size = sizeTable[i].size;
+			text += sizeTable[i].length;
+			break;
+		}
+	}
+	
+	if (*text != '[') return false;
+	text++;
+	
+	// Labels are only ever reached relative to the instruction
+	if (strncmp(text, "rel ", 4) == 0) {
+		
+		char* end = strchr(text, ']');
+		if ((!end) || ((size_t)(end - text - 4) >= MAX_VALUE_LEN)) return false;
+		
+		memcpy(pOperand->label, text + 4, end - text - 4);
+		pOperand->label[end - text - 4] = '\0';
+		pOperand->relative = true;
+		
+		return true;
+		
+	}
+	
+	// Otherwise it is a sum of registers, a scaled register and numbers
+	int64_t disp = 0;
+	bool negative = false;
+	while (*text != ']') {
+		
+		if (*text == '\0') return false;
+		if (*text == ' ') { text++; continue; }
+		if (*text == '+') { negative = false; text++; continue; }
+		if (*text == '-') { negative = true; text++; continue; }
+		
+		char word[MAX_VALUE_LEN] = {};
+		size_t length = 0;
+		while ((isalnum(text[length])) && (length < (MAX_VALUE_LEN - 1))) {
+			word[length] = text[length];
+			length++;
+		}
+		if (length == 0) return false;
+		text += length;
+		
+		// A number adds to the displacement
+		int64_t value = 0;
+		if (number_parse(word, &value)) {
+			disp += (negative) ? -value : value;
+			continue;
+		}
+		
+		size_t size = 0;
+		int reg = register_find(word, &size);
+		if ((reg == JIT_REGISTER_NONE) || (size != 8) || (negative)) return false;
+		
+		// A scaled register is the index
+		if (*text == '*') {
+			
+			text++;
+			int64_t scale = 0;
+			char digit[2] = { *text, '\0' };
+			if ((!number_parse(digit, &scale)) || ((scale != 1) && (scale != 2) && (scale != 4) && (scale != 8))) return false;
+			text++;
+			
+			if (pOperand->index != JIT_REGISTER_NONE) return false;
+			pOperand->index = reg;
+			pOperand->scale = (int)scale;
+			continue;
+			
+		}
+		
+		if (pOperand->base == JIT_REGISTER_NONE) pOperand->base = reg;
+		else if (pOperand->index == JIT_REGISTER_NONE) pOperand->index = reg;
+		else return false;
+		
+	}
+	
+	// The stack pointer can't be an index, but with a scale of one the two can swap places
+	if (pOperand->index == 4) {
+		if ((pOperand->scale != 1) || (pOperand->base == 4)) return false;
+		pOperand->index = pOperand->base;
+		pOperand->base = 4;
+	}
+	
+	if ((disp < INT32_MIN) || (disp > INT32_MAX)) return false;
+	pOperand->disp = (int32_t)disp;
+	
+	return true;
+	
+}
+
+static bool operand_parse(jit_operand* pOperand, asm_operand* pSource) {
+	
+	*pOperand = (jit_operand){};
+	
+	// The backend already worked out what kind each operand is
+	switch (pSource->type) {
+		
+		case (ASM_OPERAND_NONE) {
+			pOperand->kind = JIT_OPERAND_NONE;
+			return true;
+		}
+		
+		case (ASM_OPERAND_REGISTER) {
+			pOperand->kind = JIT_OPERAND_REGISTER;
+			pOperand->reg = register_find(pSource->value, &pOperand->size);
+			return (pOperand->reg != JIT_REGISTER_NONE);
+		}
+		
+		case (ASM_OPERAND_IMMEDIATE) {
+			pOperand->kind = JIT_OPERAND_IMMEDIATE;
+			return number_parse(pSource->value, &pOperand->imm);
+		}
+		
+		case (ASM_OPERAND_LABEL) {
+			pOperand->kind = JIT_OPERAND_LABEL;
+			strncpy(pOperand->label, pSource->value, MAX_VALUE_LEN - 1);
+			return (pSource->value[0] != '\0');
+		}
+		
+		case (ASM_OPERAND_MEMORY) {
+			pOperand->kind = JIT_OPERAND_MEMORY;
+			return memory_parse(pOperand, pSource->value);
+		}
+		
+	}
+	
+	return false;
+	
+}
+
+static size_t operand_size(jit_operand* pFirst, jit_operand* pSecond) {
+	
+	// Registers say how big they are; memory only does if it was given a size
+	if (pFirst->kind == JIT_OPERAND_REGISTER) return pFirst->size;
+	if (pSecond->kind == JIT_OPERAND_REGISTER) return pSecond->size;
+	
+	return pFirst->size;
+	
+}
+
+static bool operand_isRM(jit_operand* pOperand) {
+	return (pOperand->kind == JIT_OPERAND_REGISTER) || (pOperand->kind == JIT_OPERAND_MEMORY);
+}
+
+static bool operand_fits8(int64_t value) {
+	return (value >= INT8_MIN) && (value <= INT8_MAX);
+}
+
+static bool operand_fits32(int64_t value) {
+	return (value >= INT32_MIN) && (value <= INT32_MAX);
+}
+
+static bool operand_fitsImmediate(int64_t value, size_t size) {
+	
+	// A 64-bit operation sign extends its four bytes, while a smaller one just takes the low bytes of whichever way it was written
+	if (size == 8) return operand_fits32(value);
+	
+	return (value >= INT32_MIN) && (value <= UINT32_MAX);
+	
+}
+
+/*////////*/
+
+static bool encode_modrm(jit_state* pState, int regField, jit_operand* pRM) {
+	
+	uint8_t reg = (uint8_t)((regField & 7) << 3);
+	
+	// A register is named directly
+	if (pRM->kind == JIT_OPERAND_REGISTER) return bytes_put(pState, 0xC0 | reg | (pRM->reg & 7), 1);
+	
+	// A label is a distance from the end of the instruction
+	if (pRM->relative) return (bytes_put(pState, 0x05 | reg, 1)) && (fixup_add(pState, JIT_FIXUP_RELATIVE, pRM->label));
+	
+	int base = pRM->base;
+	int index = pRM->index;
+	
+	// Without a base, the displacement is always four bytes; rbp and r13 as a base always need one
+	uint8_t mod = 2;
+	if ((base == JIT_REGISTER_NONE) || ((pRM->disp == 0) && ((base & 7) != 5))) mod = 0;
+	else if (operand_fits8(pRM->disp)) mod = 1;
+	
+	// The stack pointer, r12, an index or no base at all all need the extra byte
+	bool sib = (index != JIT_REGISTER_NONE) || (base == JIT_REGISTER_NONE) || ((base & 7) == 4);
+	if (!bytes_put(pState, (mod << 6) | reg | ((sib) ? 4 : (base & 7)), 1)) return false;
+	
+	if (sib) {
+		uint8_t scale = (pRM->scale == 8) ? 3 : (pRM->scale == 4) ? 2 : (pRM->scale == 2) ? 1 : 0;
+		uint8_t indexBits = (index == JIT_REGISTER_NONE) ? 4 : (index & 7);
+		uint8_t baseBits = (base == JIT_REGISTER_NONE) ? 5 : (base & 7);
+		if (!bytes_put(pState, (scale << 6) | (indexBits << 3) | baseBits, 1)) return false;
+	}
+	
+	if ((base == JIT_REGISTER_NONE) || (mod == 2)) return bytes_put(pState, (uint32_t)pRM->disp, 4);
+	if (mod == 1) return bytes_put(pState, (uint8_t)pRM->disp, 1);
+	
+	return true;
+	
+}
+
+static bool encode_rm(jit_state* pState, size_t size, uint8_t escape, uint8_t opcode, int regField, bool regIsRegister, jit_operand* pRM) {
+	
+	// Words need the operand size prefix
+	if ((size == 2) && (!bytes_put(pState, 0x66, 1))) return false;
+	
+	// The prefix carries the fourth bit of each register and whether the operation is 64-bit
+	uint8_t rex = 0x40;
+	if (size == 8) rex |= 0x08;
+	if (regField & 8) rex |= 0x04;
+	if ((pRM->kind == JIT_OPERAND_REGISTER) && (pRM->reg & 8)) rex |= 0x01;
+	if ((pRM->kind == JIT_OPERAND_MEMORY) && (!pRM->relative)) {
+		if ((pRM->index != JIT_REGISTER_NONE) && (pRM->index & 8)) rex |= 0x02;
+		if ((pRM->base != JIT_REGISTER_NONE) && (pRM->base & 8)) rex |= 0x01;
+	}
+	
+	// The low bytes of rsp, rbp, rsi and rdi are only reachable with the prefix
+	bool byteReg = (size == 1) && (((regIsRegister) && (regField >= 4) && (regField < 8)) || ((pRM->kind == JIT_OPERAND_REGISTER) && (pRM->reg >= 4) && (pRM->reg < 8)));
+	if (((rex != 0x40) || (byteReg)) && (!bytes_put(pState, rex, 1))) return false;
+	
+	if ((escape) && (!bytes_put(pState, escape, 1))) return false;
+	if (!bytes_put(pState, opcode, 1)) return false;
+	
+	return encode_modrm(pState, regField, pRM);
+	
+}
+
+static bool encode_register(jit_state* pState, size_t size, uint8_t opcode, int reg) {
+	
+	// The register is added to the opcode itself
+	uint8_t rex = 0x40;
+	if (size == 8) rex |= 0x08;
+	if (reg & 8) rex |= 0x01;
+	if (((rex != 0x40) || ((size == 1) && (reg >= 4))) && (!bytes_put(pState, rex, 1))) return false;
+	
+	return bytes_put(pState, opcode + (reg & 7), 1);
+	
+}
+
+static bool encode_relative(jit_state* pState, uint8_t escape, uint8_t opcode, char* label) {
+	
+	if ((escape) && (!bytes_put(pState, escape, 1))) return false;
+	
+	return (bytes_put(pState, opcode, 1)) && (fixup_add(pState, JIT_FIXUP_RELATIVE, label));
+	
+}
+
+/*////////*/
+
+static bool encode_alu(jit_state* pState, int group, jit_operand* pTarget, jit_operand* pSource) {
+	
+	size_t size = operand_size(pTarget, pSource);
+	if (size == 0) return false;
+	
+	// Small immediates get a shorter form that sign extends a single byte
+	if ((pSource->kind == JIT_OPERAND_IMMEDIATE) && (operand_isRM(pTarget))) {
+		if (size == 1) return (encode_rm(pState, size, 0, 0x80, group, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, 1));
+		if (operand_fits8(pSource->imm)) return (encode_rm(pState, size, 0, 0x83, group, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, 1));
+		if (!operand_fitsImmediate(pSource->imm, size)) return false;
+		return (encode_rm(pState, size, 0, 0x81, group, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, (size == 2) ? 2 : 4));
+	}
+	
+	uint8_t opcode = (uint8_t)(group << 3) | ((size == 1) ? 0 : 1);
+	if ((pSource->kind == JIT_OPERAND_REGISTER) && (operand_isRM(pTarget))) return encode_rm(pState, size, 0, opcode, pSource->reg, true, pTarget);
+	if ((pTarget->kind == JIT_OPERAND_REGISTER) && (pSource->kind == JIT_OPERAND_MEMORY)) return encode_rm(pState, size, 0, opcode | 2, pTarget->reg, true, pSource);
+	
+	return false;
+	
+}
+
+static bool encode_mov(jit_state* pState, jit_operand* pTarget, jit_operand* pSource) {
+	
+	size_t size = operand_size(pTarget, pSource);
+	if (size == 0) return false;
+	
+	if (pSource->kind == JIT_OPERAND_IMMEDIATE) {
+		
+		// Memory takes at most four bytes, sign extended
+		if (pTarget->kind == JIT_OPERAND_MEMORY) {
+			if (size == 1) return (encode_rm(pState, size, 0, 0xC6, 0, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, 1));
+			if (!operand_fitsImmediate(pSource->imm, size)) return false;
+			return (encode_rm(pState, size, 0, 0xC7, 0, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, (size == 2) ? 2 : 4));
+		}
+		
+		if (pTarget->kind != JIT_OPERAND_REGISTER) return false;
+		
+		// A 64-bit register takes the shortest of sign extending, zero extending or the whole value
+		if (size == 8) {
+			if ((pSource->imm >= 0) && (pSource->imm <= UINT32_MAX)) return (encode_register(pState, 4, 0xB8, pTarget->reg)) && (bytes_put(pState, (uint64_t)pSource->imm, 4));
+			if (operand_fits32(pSource->imm)) return (encode_rm(pState, size, 0, 0xC7, 0, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, 4));
+			return (encode_register(pState, size, 0xB8, pTarget->reg)) && (bytes_put(pState, (uint64_t)pSource->imm, 8));
+		}
+		
+		if ((size == 2) && (!bytes_put(pState, 0x66, 1))) return false;
+		return (encode_register(pState, size, (size == 1) ? 0xB0 : 0xB8, pTarget->reg)) && (bytes_put(pState, (uint64_t)pSource->imm, size));
+		
+	}
+	
+	if ((pSource->kind == JIT_OPERAND_REGISTER) && (operand_isRM(pTarget))) return encode_rm(pState, size, 0, (size == 1) ? 0x88 : 0x89, pSource->reg, true, pTarget);
+	if ((pTarget->kind == JIT_OPERAND_REGISTER) && (pSource->kind == JIT_OPERAND_MEMORY)) return encode_rm(pState, size, 0, (size == 1) ? 0x8A : 0x8B, pTarget->reg, true, pSource);
+	
+	return false;
+	
+}
+
+static bool encode_test(jit_state* pState, jit_operand* pTarget, jit_operand* pSource) {
+	
+	size_t size = operand_size(pTarget, pSource);
+	if (size == 0) return false;
+	
+	if ((pSource->kind == JIT_OPERAND_IMMEDIATE) && (operand_isRM(pTarget))) {
+		if ((size != 1) && (!operand_fitsImmediate(pSource->imm, size))) return false;
+		return (encode_rm(pState, size, 0, (size == 1) ? 0xF6 : 0xF7, 0, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, (size == 1) ? 1 : (size == 2) ? 2 : 4));
+	}
+	
+	// Either order encodes the same way, since nothing is written
+	uint8_t opcode = (size == 1) ? 0x84 : 0x85;
+	if ((pSource->kind == JIT_OPERAND_REGISTER) && (operand_isRM(pTarget))) return encode_rm(pState, size, 0, opcode, pSource->reg, true, pTarget);
+	if ((pTarget->kind == JIT_OPERAND_REGISTER) && (pSource->kind == JIT_OPERAND_MEMORY)) return encode_rm(pState, size, 0, opcode, pTarget->reg, true, pSource);
+	
+	return false;
+	
+}
+
+static bool encode_shift(jit_state* pState, int group, jit_operand* pTarget, jit_operand* pSource) {
+	
+	size_t size = pTarget->size;
+	if ((size == 0) || (!operand_isRM(pTarget))) return false;
+	
+	// By cl, by one, or by a byte
+	if ((pSource->kind == JIT_OPERAND_REGISTER) && (pSource->reg == 1) && (pSource->size == 1)) return encode_rm(pState, size, 0, (size == 1) ? 0xD2 : 0xD3, group, false, pTarget);
+	if (pSource->kind != JIT_OPERAND_IMMEDIATE) return false;
+	if (pSource->imm == 1) return encode_rm(pState, size, 0, (size == 1) ? 0xD0 : 0xD1, group, false, pTarget);
+	
+	return (encode_rm(pState, size, 0, (size == 1) ? 0xC0 : 0xC1, group, false, pTarget)) && (bytes_put(pState, (uint64_t)pSource->imm, 1));
+	
+}
+
+static bool encode_unary(jit_state* pState, uint8_t opcode, int group, jit_operand* pTarget) {
+	
+	// The byte form of each of these is one below the rest
+	size_t size = pTarget->size;
+	if ((size == 0) || (!operand_isRM(pTarget))) return false;
+	
+	return encode_rm(pState, size, 0, (size == 1) ? (opcode - 1) : opcode, group, false, pTarget);
+	
+}
+
+static bool encode_imul(jit_state* pState, jit_operand* pTarget, jit_operand* pSource, jit_operand* pThird) {
+	
+	// One operand multiplies into rdx:rax
+	if (pSource->kind == JIT_OPERAND_NONE) return encode_unary(pState, 0xF7, 5, pTarget);
+	
+	if (pTarget->kind != JIT_OPERAND_REGISTER) return false;
+	size_t size = pTarget->size;
+	if (size == 1) return false;
+	
+	// Two operands with an immediate are the target multiplied in place
+	if ((pSource->kind == JIT_OPERAND_IMMEDIATE) && (pThird->kind == JIT_OPERAND_NONE)) {
+		pThird = pSource;
+		pSource = pTarget;
+	}
+	
+	if (!operand_isRM(pSource)) return false;
+	
+	if (pThird->kind == JIT_OPERAND_NONE) return encode_rm(pState, size, 0x0F, 0xAF, pTarget->reg, true, pSource);
+	if (pThird->kind != JIT_OPERAND_IMMEDIATE) return false;
+	
+	if (operand_fits8(pThird->imm)) return (encode_rm(pState, size, 0, 0x6B, pTarget->reg, true, pSource)) && (bytes_put(pState, (uint64_t)pThird->imm, 1));
+	if (!operand_fitsImmediate(pThird->imm, size)) return false;
+	
+	return (encode_rm(pState, size, 0, 0x69, pTarget->reg, true, pSource)) && (bytes_put(pState, (uint64_t)pThird->imm, (size == 2) ? 2 : 4));
+	
+}
+
+static bool encode_branch(jit_state* pState, asm_op op, jit_operand* pTarget) {
+	
+	// Labels are reached by distance, anything else through the register or memory that holds the address
+	bool call = (op == ASM_OP_CALL);
+	
+	if (pTarget->kind == JIT_OPERAND_LABEL) {
+		if (call) return encode_relative(pState, 0, 0xE8, pTarget->label);
+		if (op == ASM_OP_JMP) return encode_relative(pState, 0, 0xE9, pTarget->label);
+		return encode_relative(pState, 0x0F, 0x80 | conditionTable[op], pTarget->label);
+	}
+	
+	if ((op != ASM_OP_JMP) && (!call)) return false;
+	if (!operand_isRM(pTarget)) return false;
+	
+	return encode_rm(pState, 0, 0, 0xFF, (call) ? 2 : 4, false, pTarget);
+	
+}
+
+static bool instruction_encode(jit_state* pState, instruction* pInstruction) {
+	
+	jit_operand operands[3];
+	for (size_t i = 0; i < 3; i++) {
+		if (!operand_parse(&operands[i], &pInstruction->operands[i])) return false;
+	}
+	
+	jit_operand* pTarget = &operands[0];
+	jit_operand* pSource = &operands[1];
+	
+	switch (pInstruction->op) {
+		
+		case (ASM_OP_NONE) return true;
+		
+		case (ASM_OP_LABEL) return label_add(pState, pInstruction->operands[0].value);
+		
+		// Code is padded with no-ops, since it may be run through
+		case (ASM_OP_ALIGN) return (pTarget->kind == JIT_OPERAND_IMMEDIATE) && (bytes_align(pState, (size_t)pTarget->imm, 0x90));
+		
+		case (ASM_OP_MOV) return encode_mov(pState, pTarget, pSource);
+		
+		case (ASM_OP_MOVSXD) {
+			if ((pTarget->kind != JIT_OPERAND_REGISTER) || (pTarget->size != 8) || (!operand_isRM(pSource))) return false;
+			return encode_rm(pState, 8, 0, 0x63, pTarget->reg, true, pSource);
+		}
+		
+		case (ASM_OP_LEA) {
+			if ((pTarget->kind != JIT_OPERAND_REGISTER) || (pSource->kind != JIT_OPERAND_MEMORY)) return false;
+			return encode_rm(pState, pTarget->size, 0, 0x8D, pTarget->reg, true, pSource);
+		}
+		
+		case (ASM_OP_PUSH)
+		case (ASM_OP_POP) {
+			bool push = (pInstruction->op == ASM_OP_PUSH);
+			if (pTarget->kind == JIT_OPERAND_REGISTER) return (pTarget->size == 8) && (encode_register(pState, 4, (push) ? 0x50 : 0x58, pTarget->reg));
+			if (pTarget->kind == JIT_OPERAND_MEMORY) return encode_rm(pState, 0, 0, (push) ? 0xFF : 0x8F, (push) ? 6 : 0, false, pTarget);
+			if ((!push) || (pTarget->kind != JIT_OPERAND_IMMEDIATE) || (!operand_fits32(pTarget->imm))) return false;
+			if (operand_fits8(pTarget->imm)) return (bytes_put(pState, 0x6A, 1)) && (bytes_put(pState, (uint64_t)pTarget->imm, 1));
+			return (bytes_put(pState, 0x68, 1)) && (bytes_put(pState, (uint64_t)pTarget->imm, 4));
+		}
+		
+		case (ASM_OP_XOR)
+		case (ASM_OP_AND)
+		case (ASM_OP_ADD)
+		case (ASM_OP_SUB)
+		case (ASM_OP_SBB)
+		case (ASM_OP_CMP)
+			return encode_alu(pState, aluTable[pInstruction->op], pTarget, pSource);
+		
+		case (ASM_OP_TEST) return encode_test(pState, pTarget, pSource);
+		
+		case (ASM_OP_SHR) return encode_shift(pState, 5, pTarget, pSource);
+		case (ASM_OP_SAR) return encode_shift(pState, 7, pTarget, pSource);
+		
+		case (ASM_OP_INC) return encode_unary(pState, 0xFF, 0, pTarget);
+		case (ASM_OP_DEC) return encode_unary(pState, 0xFF, 1, pTarget);
+		case (ASM_OP_NEG) return encode_unary(pState, 0xF7, 3, pTarget);
+		case (ASM_OP_MUL) return encode_unary(pState, 0xF7, 4, pTarget);
+		case (ASM_OP_DIV) return encode_unary(pState, 0xF7, 6, pTarget);
+		case (ASM_OP_IDIV) return encode_unary(pState, 0xF7, 7, pTarget);
+		
+		case (ASM_OP_IMUL) return encode_imul(pState, pTarget, pSource, &operands[2]);
+		
+		case (ASM_OP_CDQ) return bytes_put(pState, 0x99, 1);
+		
+		case (ASM_OP_SETZ)
+		case (ASM_OP_SETNZ)
+		case (ASM_OP_SETL)
+		case (ASM_OP_SETLE)
+		case (ASM_OP_SETG)
+		case (ASM_OP_SETGE) {
+			if ((!operand_isRM(pTarget)) || ((pTarget->kind == JIT_OPERAND_REGISTER) && (pTarget->size != 1))) return false;
+			return encode_rm(pState, 1, 0x0F, 0x90 | conditionTable[pInstruction->op], 0, false, pTarget);
+		}
+		
+		case (ASM_OP_CMOVZ)
+		case (ASM_OP_CMOVNZ)
+		case (ASM_OP_CMOVL)
+		case (ASM_OP_CMOVLE)
+		case (ASM_OP_CMOVG)
+		case (ASM_OP_CMOVGE) {
+			if ((pTarget->kind != JIT_OPERAND_REGISTER) || (pTarget->size == 1) || (!operand_isRM(pSource))) return false;
+			return encode_rm(pState, pTarget->size, 0x0F, 0x40 | conditionTable[pInstruction->op], pTarget->reg, true, pSource);
+		}
+		
+		case (ASM_OP_JMP)
+		case (ASM_OP_JZ)
+		case (ASM_OP_JNZ)
+		case (ASM_OP_JA)
+		case (ASM_OP_JL)
+		case (ASM_OP_JLE)
+		case (ASM_OP_JG)
+		case (ASM_OP_JGE)
+		case (ASM_OP_CALL)
+			return encode_branch(pState, pInstruction->op, pTarget);
+		
+		case (ASM_OP_RET) return bytes_put(pState, 0xC3, 1);
+		
+	}
+	
+	return false;
+	
+}
+
+static bool text_encode(jit_state* pState, instruction* buffer, size_t size) {
+	
+	for (size_t i = 0; i < size; i++) {
+		
+		pState->pending = pState->fixups.size;
+		
+		if (!instruction_encode(pState, &buffer[i])) {
+			
+			// Say what couldn't be encoded, as well as it fits
+			char detail[MAX_VALUE_LEN] = {};
+			snprintf(detail, sizeof(detail), "%s, %s", buffer[i].operands[0].value, buffer[i].operands[1].value);
+			return jit_fail(pState, JIT_STATUS_UNENCODABLE, detail);
+			
+		}
+		
+		// Distances are measured from the end of the instruction, which is only known now
+		for (size_t j = pState->pending; j < pState->fixups.size; j++) pState->fixups.buffer[j].next = pState->pOut->size;
+		
+	}
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static bool data_encode(jit_state* pState, asm_section* pSection) {
+	
+	for (size_t i = 0; i < pSection->size; i++) {
+		
+		asm_data* pData = &pSection->buffer[i];
+		
+		if ((pData->name[0]) && (!label_add(pState, pData->name))) return false;
+		
+		switch (pData->kind) {
+			
+			case (ASM_DATA_ALIGN) {
+				if (!bytes_align(pState, pData->size, 0)) return false;
+			} break;
+			
+			case (ASM_DATA_LABEL) break;
+			
+			// Strings are written as they appear between the quotes, with a terminator
+			case (ASM_DATA_STRING) {
+				char* value = pData->values[0].value;
+				size_t length = strlen(value);
+				if ((length < 2) || (value[0] != '"') || (value[length - 1] != '"')) return jit_fail(pState, JIT_STATUS_UNENCODABLE, value);
+				for (size_t j = 1; j < (length - 1); j++) {
+					if (!bytes_put(pState, (uint8_t)value[j], 1)) return false;
+				}
+				if (!bytes_put(pState, 0, 1)) return false;
+			} break;
+			
+			// Numbers are written at their size; labels only fit in a quadword
+			case (ASM_DATA_VALUES) {
+				for (size_t j = 0; j < pData->count; j++) {
+					
+					jit_operand value;
+					if (!operand_parse(&value, &pData->values[j])) return jit_fail(pState, JIT_STATUS_UNENCODABLE, pData->values[j].value);
+					
+					if (value.kind == JIT_OPERAND_IMMEDIATE) {
+						if (!bytes_put(pState, (uint64_t)value.imm, pData->size)) return false;
+					} else if ((value.kind == JIT_OPERAND_LABEL) && (pData->size == 8)) {
+						if (!fixup_add(pState, JIT_FIXUP_ABSOLUTE, value.label)) return false;
+					} else return jit_fail(pState, JIT_STATUS_UNENCODABLE, pData->values[j].value);
+					
+				}
+			} break;
+			
+		}
+		
+	}
+	
+	return true;
+	
+}
+
+static bool import_add(jit_state* pState, char* name) {
+	
+	if (!buffer_resize((void**)&pState->imports.buffer, &pState->imports.memSize, pState->imports.size + 1, sizeof(jit_import))) return jit_fail(pState, JIT_STATUS_OUT_OF_MEMORY, NULL);
+	
+	jit_import* pImport = &pState->imports.buffer[(pState->imports.size)++];
+	pImport->name = name;
+	
+	// Each import gets a jump through a slot right after it, which is filled in once it has been found
+	pState->pOut = &pState->code;
+	if (!bytes_align(pState, 8, 0xCC)) return false;
+	if (!label_add(pState, name)) return false;
+	if (!bytes_put(pState, 0x25FF, 2)) return false;
+	if (!bytes_put(pState, 2, 4)) return false;
+	if (!bytes_put(pState, 0, 2)) return false;
+	pImport->slot = pState->code.size;
+	
+	return bytes_put(pState, 0, 8);
+	
+}
+
+static void* import_resolve(jit_state* pState, char* name) {
+	
+	// ExitProcess would end the compiler too, so it returns to it instead
+	if (strcmp(name, "ExitProcess") == 0) return pState->pMemory + label_find(pState, JIT_EXIT)->offset;
+	
+	for (size_t i = 0; i < (sizeof(libraryTable) / sizeof(libraryTable[0])); i++) {
+		
+		HMODULE library = GetModuleHandleA(libraryTable[i]);
+		if (!library) library = LoadLibraryA(libraryTable[i]);
+		if (!library) continue;
+		
+		FARPROC address = GetProcAddress(library, name);
+		if (address) return (void*)address;
+		
+	}
+	
+	return NULL;
+	
+}
+
+static bool jit_link(jit_state* pState) {
+	
+	// Anything that was never defined is imported
+	for (size_t i = 0; i < pState->fixups.size; i++) {
+		if ((!label_find(pState, pState->fixups.buffer[i].name)) && (!import_add(pState, pState->fixups.buffer[i].name))) return false;
+	}
+	
+	// Code and writable data start on pages of their own
+	pState->codeSize = (pState->code.size + JIT_PAGE_SIZE - 1) & ~(size_t)(JIT_PAGE_SIZE - 1);
+	pState->memorySize = pState->codeSize + pState->data.size;
+	
+	pState->pMemory = VirtualAlloc(NULL, pState->memorySize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (!pState->pMemory) return jit_fail(pState, JIT_STATUS_OUT_OF_MEMORY, NULL);
+	
+	memcpy(pState->pMemory, pState->code.buffer, pState->code.size);
+	memcpy(pState->pMemory + pState->codeSize, pState->data.buffer, pState->data.size);
+	
+	// Now that everything has an address, fill in every reference to it
+	for (size_t i = 0; i < pState->fixups.size; i++) {
+		
+		jit_fixup* pFixup = &pState->fixups.buffer[i];
+		jit_label* pLabel = label_find(pState, pFixup->name);
+		
+		uint8_t* pBase = pState->pMemory + ((pFixup->data) ? pState->codeSize : 0);
+		uint8_t* pTarget = pState->pMemory + ((pLabel->data) ? pState->codeSize : 0) + pLabel->offset;
+		
+		if (pFixup->kind == JIT_FIXUP_ABSOLUTE) {
+			uint64_t address = (uint64_t)(uintptr_t)pTarget;
+			memcpy(pBase + pFixup->offset, &address, 8);
+		} else {
+			int32_t distance = (int32_t)(pTarget - (pBase + pFixup->next));
+			memcpy(pBase + pFixup->offset, &distance, 4);
+		}
+		
+	}
+	
+	for (size_t i = 0; i < pState->imports.size; i++) {
+		
+		void* address = import_resolve(pState, pState->imports.buffer[i].name);
+		if (!address) return jit_fail(pState, JIT_STATUS_UNRESOLVED, pState->imports.buffer[i].name);
+		
+		uint64_t value = (uint64_t)(uintptr_t)address;
+		memcpy(pState->pMemory + pState->imports.buffer[i].slot, &value, 8);
+		
+	}
+	
+	// The code can't be written to once it can be run
+	DWORD protection = 0;
+	if (!VirtualProtect(pState->pMemory, pState->codeSize, PAGE_EXECUTE_READ, &protection)) return jit_fail(pState, JIT_STATUS_OUT_OF_MEMORY, NULL);
+	FlushInstructionCache(GetCurrentProcess(), pState->pMemory, pState->codeSize);
+	
+	return true;
+	
+}
+
+/*////////*/
+
+static LONG WINAPI jit_fault(EXCEPTION_POINTERS* pException) {
+	
+	// Only faults in the code being run are caught
+	jit_state* pState = pFaulting;
+	uint8_t* address = pException->ExceptionRecord->ExceptionAddress;
+	if ((!pState) || (address < pState->pMemory) || (address >= (pState->pMemory + pState->codeSize))) return EXCEPTION_CONTINUE_SEARCH;
+	
+	// Leave the way ExitProcess would, which puts the stack back as it was
+	pState->fault = pException->ExceptionRecord->ExceptionCode;
+	pException->ContextRecord->Rip = (DWORD64)(uintptr_t)(pState->pMemory + label_find(pState, JIT_EXIT)->offset);
+	pException->ContextRecord->Rcx = 0;
+	
+	return EXCEPTION_CONTINUE_EXECUTION;
+	
+}
+
+static bool jit_call(jit_state* pState) {
+	
+	// The entry takes nothing and returns what main did, so it can be called like any other function
+	int32_t (*entry)(void) = (int32_t (*)(void))(uintptr_t)pState->pMemory;
+	
+	pFaulting = pState;
+	PVOID handler = AddVectoredExceptionHandler(1, jit_fault);
+	
+	pState->pRun->value = entry();
+	
+	if (handler) RemoveVectoredExceptionHandler(handler);
+	pFaulting = NULL;
+	
+	if (pState->fault) {
+		
+		char detail[MAX_VALUE_LEN] = {};
+		switch (pState->fault) {
+			case (EXCEPTION_INT_DIVIDE_BY_ZERO) snprintf(detail, sizeof(detail), "divide by zero"); break;
+			case (EXCEPTION_INT_OVERFLOW) snprintf(detail, sizeof(detail), "integer overflow"); break;
+			case (EXCEPTION_ACCESS_VIOLATION) snprintf(detail, sizeof(detail), "access violation"); break;
+			case (EXCEPTION_STACK_OVERFLOW) snprintf(detail, sizeof(detail), "stack overflow"); break;
+			default: snprintf(detail, sizeof(detail), "0x%08lX", (unsigned long)pState->fault); break;
+		}
+		
+		return jit_fail(pState, JIT_STATUS_FAULT, detail);
+		
+	}
+	
+	return true;
+	
+}
+
+/*////////*/
+
+bool jit_execute(jit_run* pRun, jit_info* pInfo) {
+	
+	memset(pRun, 0, sizeof(jit_run));
+	
+	assm* pAssm = pInfo->pAsm;
+	if (!pAssm->foundMain) {
+		pRun->status = JIT_STATUS_NO_MAIN;
+		return false;
+	}
+	
+	jit_state state = {};
+	jit_state* pState = &state;
+	pState->pRun = pRun;
+	
+	// The entry comes first, then the program with its read only data; the writable data starts with the saved stack pointer
+	pState->pOut = &pState->code;
+	bool succeeded = text_encode(pState, entryTable, sizeof(entryTable) / sizeof(entryTable[0]));
+	succeeded = (succeeded) && (text_encode(pState, pAssm->text.buffer, pAssm->text.size));
+	succeeded = (succeeded) && (bytes_align(pState, 16, 0xCC)) && (data_encode(pState, &pAssm->rodata));
+	
+	pState->pOut = &pState->data;
+	succeeded = (succeeded) && (label_add(pState, JIT_SAVED)) && (bytes_put(pState, 0, 8));
+	succeeded = (succeeded) && (data_encode(pState, &pAssm->data));
+	
+	succeeded = (succeeded) && (jit_link(pState));
+	
+	pRun->codeBytes = pState->code.size;
+	pRun->dataBytes = pState->data.size;
+	pRun->imports = pState->imports.size;
+	
+	succeeded = (succeeded) && (jit_call(pState));
+	
+	// Free memory
+	if (pState->pMemory) VirtualFree(pState->pMemory, 0, MEM_RELEASE);
+	free(pState->code.buffer);
+	free(pState->data.buffer);
+	free(pState->labels.buffer);
+	free(pState->fixups.buffer);
+	free(pState->imports.buffer);
+	
+	return succeeded;
+	
+}
+
+void jit_run_print(jit_run* pRun) {
+	
+	static char* reasons[] = {
+		[JIT_STATUS_RETURNED] = "returned",
+		[JIT_STATUS_NO_MAIN] = "There is no main function to run",
+		[JIT_STATUS_UNENCODABLE] = "Could not encode",
+		[JIT_STATUS_UNRESOLVED] = "Could not find the imported function",
+		[JIT_STATUS_FAULT] = "The program faulted with",
+		[JIT_STATUS_OUT_OF_MEMORY] = "Ran out of memory",
+	};
+	
+	if (pRun->status == JIT_STATUS_RETURNED)
+		print_utf8("main returned %d", (int)pRun->value);
+	else
+		print_utf8("error: %s%s%s", reasons[pRun->status], (pRun->detail[0]) ? " " : "", pRun->detail);
+	
+	print_utf8(" from %llu bytes of code and %llu of data, with %llu imports\n",
+		(unsigned long long)pRun->codeBytes, (unsigned long long)pRun->dataBytes, (unsigned long long)pRun->imports);
+	
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+// [ MACROS ] //
+
+#define JIT_PAGE_SIZE 4096 // Code and data are kept on separate pages so each can have its own protection
+
+// [ DEFINING ] //
+
+typedef struct {
+	assm* pAsm;
+} jit_info;
+
+typedef enum {
+	JIT_STATUS_RETURNED,
+	JIT_STATUS_NO_MAIN,
+	JIT_STATUS_UNENCODABLE,
+	JIT_STATUS_UNRESOLVED,
+	JIT_STATUS_FAULT,
+	JIT_STATUS_OUT_OF_MEMORY,
+} jit_status;
+
+typedef struct {
+	
+	jit_status status;
+	char detail[MAX_VALUE_LEN]; // What was being looked at when something went wrong
+	
+	// What main returned, or what it passed to ExitProcess
+	int32_t value;
+	
+	// What was put in memory to run it
+	size_t codeBytes;
+	size_t dataBytes;
+	size_t imports;
+	
+} jit_run;
+
+// [ FUNCTIONS ] //
+
+bool jit_execute(jit_run* pRun, jit_info* pInfo);
+void jit_run_print(jit_run* pRun);
\ No newline at end of file
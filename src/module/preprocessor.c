@@ -0,0 +1,1039 @@
+// [ INCLUDING ] //
+
+#include "common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+// [ MACROS ] //
+
+#define PREPROCESSOR_MAX_PATH 1024
+
+// [ DEFINING ] //
+
+// The tokens of an #if being evaluated
+typedef struct {
+	preprocessor* pPreprocessor;
+	preprocessor_span* buffer;
+	size_t size;
+	size_t index;
+	bool failed;
+	bool expanded; // Every macro that could be has been expanded already, so any name left is zero
+} preprocessor_expression;
+
+// [ FUNCTIONS ] //
+
+static bool preprocessor_append(preprocessor_spans* pSpans, preprocessor_span newSpan) {
+	
+	if (!buffer_resize((void**)&pSpans->buffer, &pSpans->memSize, pSpans->size + 1, sizeof(preprocessor_span))) return false;
+	pSpans->buffer[(pSpans->size)++] = newSpan;
+	
+	return true;
+	
+}
+
+static uint64_t preprocessor_hash(char* text, size_t length) {
+	
+	// FNV-1a, so a lookup only compares names when the hashes already match
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (uint8_t)text[i];
+		hash *= 1099511628211ULL;
+	}
+	
+	return hash;
+	
+}
+
+/*////////*/
+
+static char* preprocessor_text(preprocessor* pPreprocessor, preprocessor_span* pSpan) {
+	return &pPreprocessor->files.buffer[pSpan->file].pCode->buffer[pSpan->offset];
+}
+
+static bool preprocessor_is(preprocessor* pPreprocessor, preprocessor_span* pSpan, char* text) {
+	size_t length = strlen(text);
+	return (pSpan->length == length) && (memcmp(preprocessor_text(pPreprocessor, pSpan), text, length) == 0);
+}
+
+static bool preprocessor_same(preprocessor* pPreprocessor, preprocessor_span* pFirst, preprocessor_span* pSecond) {
+	return (pFirst->length == pSecond->length) && (memcmp(preprocessor_text(pPreprocessor, pFirst), preprocessor_text(pPreprocessor, pSecond), pFirst->length) == 0);
+}
+
+static bool preprocessor_isName(preprocessor* pPreprocessor, preprocessor_span* pSpan) {
+	char first = preprocessor_text(pPreprocessor, pSpan)[0];
+	return (pSpan->length > 0) && (isalpha((unsigned char)first) || (first == '_'));
+}
+
+static bool preprocessor_isDirective(preprocessor* pPreprocessor, preprocessor_span* pSpan) {
+	return (pSpan->lineStart) && (preprocessor_text(pPreprocessor, pSpan)[0] == '#');
+}
+
+static void preprocessor_copy(preprocessor* pPreprocessor, preprocessor_span* pSpan, char* buffer) {
+	size_t length = (pSpan->length < MAX_VALUE_LEN) ? pSpan->length : (MAX_VALUE_LEN - 1);
+	memcpy(buffer, preprocessor_text(pPreprocessor, pSpan), length);
+	buffer[length] = '\0';
+}
+
+static void preprocessor_error(preprocessor* pPreprocessor, preprocessor_span* pSpan, char* msg, char* name) {
+	
+	// Errors are reported in the file the token was written in, not where it ended up
+	code* pCode = pPreprocessor->files.buffer[pSpan->file].pCode;
+	size_t line, column;
+	code_locate(pCode, pSpan->offset, &line, &column);
+	
+	print_utf8("%s:%llu:%llu: error: %s%s%s\n", pCode->fileName, (unsigned long long)line, (unsigned long long)column, msg, (name) ? " " : "", (name) ? name : "");
+	pPreprocessor->failed = true;
+	
+}
+
+/*////////*/
+
+static bool preprocessor_lex(preprocessor* pPreprocessor, uint16_t fileIndex) {
+	
+	preprocessor_file* pFile = &pPreprocessor->files.buffer[fileIndex];
+	code* pCode = pFile->pCode;
+	
+	// Tokens are found the same way the stream finds them, but only where they are is kept
+	pCode->index = 0;
+	size_t previousEnd = 0;
+	while (1) {
+		
+		token newToken = token_parse(pCode);
+		if (newToken.type == TOKEN_TYPE_EOF) break;
+		
+		preprocessor_span newSpan = {};
+		newSpan.offset = newToken.offset;
+		newSpan.length = (uint16_t)(pCode->index - newToken.offset);
+		newSpan.file = fileIndex;
+		newSpan.type = newToken.type;
+		
+		// A token starts a line when a newline comes between it and the token before
+		newSpan.lineStart = (pFile->spans.size == 0) || (memchr(&pCode->buffer[previousEnd], '\n', newToken.offset - previousEnd) != NULL);
+		previousEnd = pCode->index;
+		
+		if (!preprocessor_append(&pFile->spans, newSpan)) return false;
+		
+	}
+	pCode->index = 0;
+	
+	return true;
+	
+}
+
+static size_t preprocessor_lineEnd(preprocessor* pPreprocessor, preprocessor_span* pSpans, size_t size, size_t start) {
+	
+	// A backslash at the end of a line carries the directive onto the next one
+	size_t end = start + 1;
+	while ((end < size) && ((!pSpans[end].lineStart) || preprocessor_is(pPreprocessor, &pSpans[end - 1], "\\"))) end++;
+	
+	return end;
+	
+}
+
+static void preprocessor_guard(preprocessor* pPreprocessor, uint16_t fileIndex) {
+	
+	preprocessor_file* pFile = &pPreprocessor->files.buffer[fileIndex];
+	preprocessor_span* pSpans = pFile->spans.buffer;
+	size_t size = pFile->spans.size;
+	
+	// The file has to start with #ifndef NAME and #define NAME...
+	if (size < 5) return;
+	if (!preprocessor_is(pPreprocessor, &pSpans[0], "#ifndef") || pSpans[1].lineStart) return;
+	if (!preprocessor_is(pPreprocessor, &pSpans[2], "#define") || !pSpans[2].lineStart || pSpans[3].lineStart) return;
+	if (!preprocessor_same(pPreprocessor, &pSpans[1], &pSpans[3])) return;
+	
+	// ...and end with the #endif that closes the first
+	size_t depth = 0;
+	for (size_t i = 0; i < size; i++) {
+		
+		if (!preprocessor_isDirective(pPreprocessor, &pSpans[i])) continue;
+		
+		if (preprocessor_is(pPreprocessor, &pSpans[i], "#if") || preprocessor_is(pPreprocessor, &pSpans[i], "#ifdef") || preprocessor_is(pPreprocessor, &pSpans[i], "#ifndef")) depth++;
+		else if (preprocessor_is(pPreprocessor, &pSpans[i], "#endif")) {
+			if (--depth > 0) continue;
+			if (preprocessor_lineEnd(pPreprocessor, pSpans, size, i) == size) preprocessor_copy(pPreprocessor, &pSpans[1], pFile->guard);
+			return;
+		}
+		
+	}
+	
+}
+
+static int32_t preprocessor_load(preprocessor* pPreprocessor, char* fileName) {
+	
+	// A file is only read and lexed once, however many times it is included
+	for (size_t i = 0; i < pPreprocessor->files.size; i++) {
+		if (strcmp(pPreprocessor->files.buffer[i].pCode->fileName, fileName) == 0) return (int32_t)i;
+	}
+	if (pPreprocessor->files.size > UINT16_MAX) return -1;
+	
+	if (!buffer_resize((void**)&pPreprocessor->files.buffer, &pPreprocessor->files.memSize, pPreprocessor->files.size + 1, sizeof(preprocessor_file))) return -1;
+	
+	code* pCode = calloc(1, sizeof(code));
+	char* name = strdup(fileName);
+	code_info codeInfo = { name };
+	if ((pCode == NULL) || (name == NULL) || !code_create(pCode, &codeInfo)) {
+		free(pCode);
+		free(name);
+		return -1;
+	}
+	pCode->fileName = name;
+	
+	uint16_t fileIndex = (uint16_t)(pPreprocessor->files.size)++;
+	preprocessor_file* pFile = &pPreprocessor->files.buffer[fileIndex];
+	memset(pFile, 0, sizeof(preprocessor_file));
+	pFile->pCode = pCode;
+	pFile->owned = true;
+	
+	if (!preprocessor_lex(pPreprocessor, fileIndex)) return -1;
+	preprocessor_guard(pPreprocessor, fileIndex);
+	
+	return fileIndex;
+	
+}
+
+static bool preprocessor_try(char* buffer, size_t size, char* directory, size_t directoryLength, char* name) {
+	
+	// Directories given on the command line might already end in a separator
+	char* separator = ((directoryLength == 0) || (directory[directoryLength - 1] == '/') || (directory[directoryLength - 1] == '\\')) ? "" : "/";
+	
+	int written = snprintf(buffer, size, "%.*s%s%s", (int)directoryLength, directory, separator, name);
+	if ((written <= 0) || ((size_t)written >= size)) return false;
+	
+	FILE* file = fopen(buffer, "rb");
+	if (file == NULL) return false;
+	
+	fclose(file);
+	return true;
+	
+}
+
+static bool preprocessor_search(preprocessor* pPreprocessor, char* buffer, size_t size, char* name, uint16_t fromFile) {
+	
+	// Complete paths are used as they are
+	if ((name[0] == '/') || (name[0] == '\\') || ((name[0] != '\0') && (name[1] == ':'))) return preprocessor_try(buffer, size, "", 0, name);
+	
+	// Then look next to the file including it
+	char* fileName = pPreprocessor->files.buffer[fromFile].pCode->fileName;
+	size_t directoryLength = 0;
+	for (size_t i = 0; fileName[i] != '\0'; i++) if ((fileName[i] == '/') || (fileName[i] == '\\')) directoryLength = i + 1;
+	if (preprocessor_try(buffer, size, fileName, directoryLength, name)) return true;
+	
+	// Then in each directory given with -I
+	for (size_t i = 0; i < pPreprocessor->includeCount; i++) {
+		if (preprocessor_try(buffer, size, pPreprocessor->includePaths[i], strlen(pPreprocessor->includePaths[i]), name)) return true;
+	}
+	
+	return false;
+	
+}
+
+/*////////*/
+
+static int32_t* preprocessor_slot(preprocessor* pPreprocessor, uint64_t hash, char* text, size_t length) {
+	
+	// Open addressing; the table is never more than half full, so there is always an empty slot to stop on
+	size_t mask = pPreprocessor->macroTable.memSize - 1;
+	for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+		
+		int32_t* pSlot = &pPreprocessor->macroTable.buffer[i];
+		if (*pSlot < 0) return pSlot;
+		
+		preprocessor_macro* pMacro = &pPreprocessor->macros.buffer[*pSlot];
+		if ((pMacro->hash == hash) && (strlen(pMacro->name) == length) && (memcmp(pMacro->name, text, length) == 0)) return pSlot;
+		
+	}
+	
+}
+
+static bool preprocessor_table_add(preprocessor* pPreprocessor, int32_t macro) {
+	
+	// Keep the table at most half full, putting every macro in again when it grows
+	if (((pPreprocessor->macroTable.size + 1) * 2) > pPreprocessor->macroTable.memSize) {
+		
+		int32_t* oldBuffer = pPreprocessor->macroTable.buffer;
+		size_t oldMemSize = pPreprocessor->macroTable.memSize;
+		
+		size_t newMemSize = (oldMemSize == 0) ? 64 : (oldMemSize * 2);
+		int32_t* newBuffer = malloc(newMemSize * sizeof(int32_t));
+		if (!newBuffer) return false;
+		for (size_t i = 0; i < newMemSize; i++) newBuffer[i] = -1;
+		
+		pPreprocessor->macroTable.buffer = newBuffer;
+		pPreprocessor->macroTable.memSize = newMemSize;
+		for (size_t i = 0; i < oldMemSize; i++) {
+			if (oldBuffer[i] < 0) continue;
+			preprocessor_macro* pOld = &pPreprocessor->macros.buffer[oldBuffer[i]];
+			*preprocessor_slot(pPreprocessor, pOld->hash, pOld->name, strlen(pOld->name)) = oldBuffer[i];
+		}
+		free(oldBuffer);
+		
+	}
+	
+	preprocessor_macro* pMacro = &pPreprocessor->macros.buffer[macro];
+	*preprocessor_slot(pPreprocessor, pMacro->hash, pMacro->name, strlen(pMacro->name)) = macro;
+	(pPreprocessor->macroTable.size)++;
+	
+	return true;
+	
+}
+
+static int32_t preprocessor_lookup(preprocessor* pPreprocessor, char* text, size_t length, bool undefined) {
+	
+	if (pPreprocessor->macroTable.size == 0) return -1;
+	
+	// An undefined macro keeps its slot, so defining it again replaces it where it is
+	int32_t macro = *preprocessor_slot(pPreprocessor, preprocessor_hash(text, length), text, length);
+	if ((macro < 0) || (!pPreprocessor->macros.buffer[macro].defined && !undefined)) return -1;
+	
+	return macro;
+	
+}
+
+static int32_t preprocessor_find(preprocessor* pPreprocessor, preprocessor_span* pSpan) {
+	if ((pPreprocessor->macros.size == 0) || !preprocessor_isName(pPreprocessor, pSpan)) return -1;
+	return preprocessor_lookup(pPreprocessor, preprocessor_text(pPreprocessor, pSpan), pSpan->length, false);
+}
+
+static bool preprocessor_skipping(preprocessor* pPreprocessor) {
+	return (pPreprocessor->conditions.size > 0) && !pPreprocessor->conditions.buffer[pPreprocessor->conditions.size - 1].active;
+}
+
+static bool preprocessor_expanding(preprocessor* pPreprocessor) {
+	for (size_t i = 0; i < pPreprocessor->depth; i++) if (pPreprocessor->frames[i].macro >= 0) return true;
+	return false;
+}
+
+/*////////*/
+
+static bool preprocessor_push(preprocessor* pPreprocessor, preprocessor_frame newFrame, preprocessor_span* pTrigger) {
+	
+	if (pPreprocessor->depth == PREPROCESSOR_MAX_DEPTH) {
+		preprocessor_error(pPreprocessor, pTrigger, "Macros and includes nest too deeply", NULL);
+		if (newFrame.owned) free(newFrame.buffer);
+		return false;
+	}
+	
+	// Everything that comes out of a macro or include is reported where it came into the file being compiled
+	newFrame.origin = (pPreprocessor->depth == 1) ? pTrigger->offset : pPreprocessor->frames[pPreprocessor->depth - 1].origin;
+	newFrame.conditionBase = pPreprocessor->conditions.size;
+	
+	// A macro is left alone inside its own expansion, which is what stops it recursing
+	if (newFrame.macro >= 0) pPreprocessor->macros.buffer[newFrame.macro].active = true;
+	if (newFrame.file >= 0) pPreprocessor->files.buffer[newFrame.file].included = true;
+	
+	pPreprocessor->frames[(pPreprocessor->depth)++] = newFrame;
+	
+	return true;
+	
+}
+
+static void preprocessor_pop(preprocessor* pPreprocessor) {
+	
+	preprocessor_frame* pFrame = &pPreprocessor->frames[--(pPreprocessor->depth)];
+	
+	if (pFrame->macro >= 0) pPreprocessor->macros.buffer[pFrame->macro].active = false;
+	if (pFrame->owned) free(pFrame->buffer);
+	
+	// A file has to close every condition it opens
+	if ((pFrame->file >= 0) && (pPreprocessor->conditions.size > pFrame->conditionBase)) {
+		preprocessor_error(pPreprocessor, &pPreprocessor->conditions.buffer[pFrame->conditionBase].span, "Unterminated conditional", NULL);
+		pPreprocessor->conditions.size = pFrame->conditionBase;
+	}
+	
+}
+
+static bool preprocessor_pull(preprocessor* pPreprocessor, size_t floor, preprocessor_span* pSpan, uint32_t* pOffset);
+
+static bool preprocessor_expand(preprocessor* pPreprocessor, preprocessor_span* pSpans, size_t size, int32_t macro, preprocessor_span* pTrigger, preprocessor_spans* pOut) {
+	
+	// Walk the spans in a frame of their own until it runs out, keeping whatever comes out
+	size_t floor = pPreprocessor->depth;
+	preprocessor_frame newFrame = { .buffer = pSpans, .size = size, .macro = macro, .file = -1 };
+	if (!preprocessor_push(pPreprocessor, newFrame, pTrigger)) return false;
+	
+	preprocessor_span span;
+	uint32_t offset;
+	while (preprocessor_pull(pPreprocessor, floor, &span, &offset)) {
+		if (!preprocessor_append(pOut, span)) {
+			while (pPreprocessor->depth > floor) preprocessor_pop(pPreprocessor);
+			preprocessor_error(pPreprocessor, pTrigger, "Out of memory expanding", NULL);
+			return false;
+		}
+	}
+	
+	return true;
+	
+}
+
+static bool preprocessor_memo(preprocessor* pPreprocessor, int32_t macro, preprocessor_span* pName) {
+	
+	// The full expansion is kept until a macro is defined or undefined, since only that can change it; preprocessor_define and #undef are the only places either happens, and both move the generation on
+	preprocessor_macro* pMacro = &pPreprocessor->macros.buffer[macro];
+	if (pMacro->memoGeneration == pPreprocessor->generation) return true;
+	
+	pMacro->memo.size = 0;
+	preprocessor_span* pBody = &pPreprocessor->files.buffer[pMacro->file].spans.buffer[pMacro->bodyStart];
+	if (!preprocessor_expand(pPreprocessor, pBody, pMacro->bodyEnd - pMacro->bodyStart, macro, pName, &pMacro->memo)) return false;
+	pMacro->memoGeneration = pPreprocessor->generation;
+	
+	return true;
+	
+}
+
+static bool preprocessor_object(preprocessor* pPreprocessor, int32_t macro, preprocessor_span* pName) {
+	
+	preprocessor_macro* pMacro = &pPreprocessor->macros.buffer[macro];
+	
+	// Inside another macro, that macro's name is left alone, which the kept expansion doesn't account for; the body is walked as it is instead
+	if (preprocessor_expanding(pPreprocessor)) {
+		preprocessor_frame newFrame = { .buffer = &pPreprocessor->files.buffer[pMacro->file].spans.buffer[pMacro->bodyStart], .size = pMacro->bodyEnd - pMacro->bodyStart, .macro = macro, .file = -1 };
+		return preprocessor_push(pPreprocessor, newFrame, pName);
+	}
+	
+	if (!preprocessor_memo(pPreprocessor, macro, pName)) return false;
+	
+	preprocessor_frame newFrame = { .buffer = pMacro->memo.buffer, .size = pMacro->memo.size, .expanded = true, .macro = -1, .file = -1 };
+	return preprocessor_push(pPreprocessor, newFrame, pName);
+	
+}
+
+static bool preprocessor_function(preprocessor* pPreprocessor, int32_t macro, preprocessor_span* pName) {
+	
+	preprocessor_frame* pFrame = &pPreprocessor->frames[pPreprocessor->depth - 1];
+	preprocessor_macro* pMacro = &pPreprocessor->macros.buffer[macro];
+	
+	// Find where each argument starts and ends, splitting on commas outside of parentheses
+	size_t argStarts[PREPROCESSOR_MAX_ARGS + 1];
+	size_t argEnds[PREPROCESSOR_MAX_ARGS + 1];
+	size_t argCount = 0;
+	
+	size_t depth = 1;
+	size_t index = pFrame->index + 1;
+	argStarts[0] = index;
+	for (; index < pFrame->size; index++) {
+		
+		token_type type = pFrame->buffer[index].type;
+		if (type == TOKEN_TYPE_PT_OPEN_PAREN) depth++;
+		else if ((type == TOKEN_TYPE_PT_CLOSE_PAREN) && (--depth == 0)) break;
+		
+		// Everything from the last parameter on goes to __VA_ARGS__, commas and all
+		else if ((type == TOKEN_TYPE_PT_COMMA) && (depth == 1) && !((pMacro->variadic) && (argCount + 1 == pMacro->paramCount))) {
+			if (argCount == PREPROCESSOR_MAX_ARGS) break;
+			argEnds[argCount++] = index;
+			argStarts[argCount] = index + 1;
+		}
+		
+	}
+	if (index >= pFrame->size) {
+		preprocessor_error(pPreprocessor, pName, "Unterminated call to macro", pMacro->name);
+		pFrame->index = pFrame->size;
+		return false;
+	}
+	pFrame->index = index + 1;
+	
+	// Empty parentheses are no arguments at all, not a single empty one
+	if ((argCount > 0) || (argStarts[0] < index) || (pMacro->paramCount > 0)) argEnds[argCount++] = index;
+	if ((pMacro->variadic) && (argCount + 1 == pMacro->paramCount)) {
+		argStarts[argCount] = index;
+		argEnds[argCount++] = index;
+	}
+	if (argCount != pMacro->paramCount) {
+		preprocessor_error(pPreprocessor, pName, "Wrong number of arguments to macro", pMacro->name);
+		return false;
+	}
+	
+	// Arguments are expanded before they are put in, so a macro can be passed to itself
+	preprocessor_spans args[PREPROCESSOR_MAX_ARGS] = {};
+	preprocessor_spans body = {};
+	bool succeeded = true;
+	for (size_t i = 0; (i < argCount) && (succeeded); i++) {
+		succeeded = preprocessor_expand(pPreprocessor, &pFrame->buffer[argStarts[i]], argEnds[i] - argStarts[i], -1, pName, &args[i]);
+	}
+	
+	// Then each parameter in the body is replaced with its argument
+	preprocessor_file* pFile = &pPreprocessor->files.buffer[pMacro->file];
+	for (size_t i = pMacro->bodyStart; (i < pMacro->bodyEnd) && (succeeded); i++) {
+		
+		preprocessor_span* pSpan = &pFile->spans.buffer[i];
+		if (preprocessor_is(pPreprocessor, pSpan, "\\")) continue;
+		
+		int32_t param = -1;
+		if (preprocessor_isName(pPreprocessor, pSpan)) {
+			for (size_t j = 0; j < pMacro->paramCount; j++) {
+				preprocessor_span* pParam = &pFile->spans.buffer[pMacro->paramStart + (j * 2)];
+				if ((preprocessor_same(pPreprocessor, pSpan, pParam)) || ((pMacro->variadic) && (j + 1 == pMacro->paramCount) && preprocessor_is(pPreprocessor, pSpan, "__VA_ARGS__"))) {
+					param = (int32_t)j;
+					break;
+				}
+			}
+		}
+		
+		if (param < 0) succeeded = preprocessor_append(&body, *pSpan);
+		else for (size_t j = 0; (j < args[param].size) && (succeeded); j++) succeeded = preprocessor_append(&body, args[param].buffer[j]);
+		
+	}
+	
+	for (size_t i = 0; i < argCount; i++) free(args[i].buffer);
+	if (!succeeded) {
+		free(body.buffer);
+		if (!pPreprocessor->failed) preprocessor_error(pPreprocessor, pName, "Out of memory expanding", pMacro->name);
+		return false;
+	}
+	
+	// The body is walked again with the macro switched off, which expands whatever the arguments brought in
+	preprocessor_frame newFrame = { .buffer = body.buffer, .size = body.size, .owned = true, .macro = macro, .file = -1 };
+	return preprocessor_push(pPreprocessor, newFrame, pName);
+	
+}
+
+/*////////*/
+
+static int64_t preprocessor_evaluate(preprocessor_expression* pExpression);
+
+static preprocessor_span* preprocessor_peek(preprocessor_expression* pExpression) {
+	return (pExpression->index < pExpression->size) ? &pExpression->buffer[pExpression->index] : NULL;
+}
+
+static bool preprocessor_accept(preprocessor_expression* pExpression, char* text) {
+	preprocessor_span* pSpan = preprocessor_peek(pExpression);
+	if ((pSpan == NULL) || !preprocessor_is(pExpression->pPreprocessor, pSpan, text)) return false;
+	(pExpression->index)++;
+	return true;
+}
+
+static int64_t preprocessor_primary(preprocessor_expression* pExpression) {
+	
+	preprocessor* pPreprocessor = pExpression->pPreprocessor;
+	preprocessor_span* pSpan = preprocessor_peek(pExpression);
+	if (pSpan == NULL) {
+		pExpression->failed = true;
+		return 0;
+	}
+	(pExpression->index)++;
+	
+	// Handle each kind of operand appropriately
+	if (preprocessor_is(pPreprocessor, pSpan, "(")) {
+		
+		int64_t value = preprocessor_evaluate(pExpression);
+		if (!preprocessor_accept(pExpression, ")")) pExpression->failed = true;
+		return value;
+		
+	} else if (preprocessor_is(pPreprocessor, pSpan, "!")) {
+		return !preprocessor_primary(pExpression);
+	} else if (preprocessor_is(pPreprocessor, pSpan, "-")) {
+		return -preprocessor_primary(pExpression);
+	} else if (preprocessor_is(pPreprocessor, pSpan, "+")) {
+		return preprocessor_primary(pExpression);
+	} else if (preprocessor_is(pPreprocessor, pSpan, "defined")) {
+		
+		bool parenthesized = preprocessor_accept(pExpression, "(");
+		preprocessor_span* pName = preprocessor_peek(pExpression);
+		if ((pName == NULL) || !preprocessor_isName(pPreprocessor, pName)) {
+			pExpression->failed = true;
+			return 0;
+		}
+		(pExpression->index)++;
+		if ((parenthesized) && !preprocessor_accept(pExpression, ")")) pExpression->failed = true;
+		
+		return preprocessor_lookup(pPreprocessor, preprocessor_text(pPreprocessor, pName), pName->length, false) >= 0;
+		
+	} else if (isdigit((unsigned char)preprocessor_text(pPreprocessor, pSpan)[0])) {
+		
+		char value[MAX_VALUE_LEN];
+		preprocessor_copy(pPreprocessor, pSpan, value);
+		return strtoll(value, NULL, 0);
+		
+	} else if (preprocessor_isName(pPreprocessor, pSpan)) {
+		
+		// A macro stands for whatever it expands to; any other name is zero, as is any name its expansion left alone
+		int32_t macro = (pExpression->expanded) ? -1 : preprocessor_find(pPreprocessor, pSpan);
+		if ((macro < 0) || (pPreprocessor->macros.buffer[macro].function) || (pPreprocessor->macros.buffer[macro].active)) return 0;
+		
+		if (!preprocessor_memo(pPreprocessor, macro, pSpan)) {
+			pExpression->failed = true;
+			return 0;
+		}
+		
+		preprocessor_macro* pMacro = &pPreprocessor->macros.buffer[macro];
+		preprocessor_expression subexpression = { pPreprocessor, pMacro->memo.buffer, pMacro->memo.size, 0, false, true };
+		int64_t value = (subexpression.size > 0) ? preprocessor_evaluate(&subexpression) : 0;
+		if ((subexpression.failed) || (subexpression.index != subexpression.size)) pExpression->failed = true;
+		
+		return value;
+		
+	}
+	
+	pExpression->failed = true;
+	return 0;
+	
+}
+
+static int64_t preprocessor_binary(preprocessor_expression* pExpression, size_t level) {
+	
+	// Operators from the loosest binding to the tightest, the same as in C
+	static char* levels[][4] = {
+		{ "||" }, { "&&" }, { "==", "!=" }, { "<", ">", "<=", ">=" }, { "+", "-" }, { "*", "/", "%" },
+	};
+	if (level == (sizeof(levels) / sizeof(levels[0]))) return preprocessor_primary(pExpression);
+	
+	int64_t value = preprocessor_binary(pExpression, level + 1);
+	while (!pExpression->failed) {
+		
+		size_t op = 0;
+		while ((op < 4) && (levels[level][op]) && !preprocessor_accept(pExpression, levels[level][op])) op++;
+		if ((op == 4) || (levels[level][op] == NULL)) break;
+		
+		int64_t right = preprocessor_binary(pExpression, level + 1);
+		char* text = levels[level][op];
+		
+		if (strcmp(text, "||") == 0) value = value || right;
+		else if (strcmp(text, "&&") == 0) value = value && right;
+		else if (strcmp(text, "==") == 0) value = value == right;
+		else if (strcmp(text, "!=") == 0) value = value != right;
+		else if (strcmp(text, "<") == 0) value = value < right;
+		else if (strcmp(text, ">") == 0) value = value > right;
+		else if (strcmp(text, "<=") == 0) value = value <= right;
+		else if (strcmp(text, ">=") == 0) value = value >= right;
+		else if (strcmp(text, "+") == 0) value = value + right;
+		else if (strcmp(text, "-") == 0) value = value - right;
+		else if (strcmp(text, "*") == 0) value = value * right;
+		else if (right == 0) pExpression->failed = true;
+		else if (strcmp(text, "/") == 0) value = value / right;
+		else value = value % right;
+		
+	}
+	
+	return value;
+	
+}
+
+static int64_t preprocessor_evaluate(preprocessor_expression* pExpression) {
+	return preprocessor_binary(pExpression, 0);
+}
+
+static bool preprocessor_condition_value(preprocessor* pPreprocessor, preprocessor_span* pSpans, size_t start, size_t end, preprocessor_span* pDirective) {
+	
+	preprocessor_expression expression = { pPreprocessor, &pSpans[start], end - start, 0, false, false };
+	int64_t value = (end > start) ? preprocessor_evaluate(&expression) : 0;
+	
+	if ((end == start) || (expression.failed) || (expression.index != expression.size)) {
+		preprocessor_error(pPreprocessor, pDirective, "Invalid expression in conditional", NULL);
+		return false;
+	}
+	
+	return value != 0;
+	
+}
+
+/*////////*/
+
+static void preprocessor_define(preprocessor* pPreprocessor, preprocessor_frame* pFrame, size_t start, size_t end, preprocessor_span* pDirective) {
+	
+	preprocessor_span* pSpans = pFrame->buffer;
+	if ((start >= end) || !preprocessor_isName(pPreprocessor, &pSpans[start])) {
+		preprocessor_error(pPreprocessor, pDirective, "Expected a macro name after", "#define");
+		return;
+	}
+	if (pSpans[start].length >= MAX_VALUE_LEN) {
+		preprocessor_error(pPreprocessor, &pSpans[start], "Macro name is too long", NULL);
+		return;
+	}
+	
+	preprocessor_macro newMacro = {};
+	preprocessor_copy(pPreprocessor, &pSpans[start], newMacro.name);
+	newMacro.hash = preprocessor_hash(newMacro.name, pSpans[start].length);
+	newMacro.defined = true;
+	newMacro.file = (uint16_t)pFrame->file;
+	newMacro.bodyStart = start + 1;
+	
+	// A parenthesis straight after the name, with no space, makes it take arguments
+	size_t index = start + 1;
+	if ((index < end) && (pSpans[index].type == TOKEN_TYPE_PT_OPEN_PAREN) && (pSpans[index].offset == pSpans[start].offset + pSpans[start].length)) {
+		
+		newMacro.function = true;
+		newMacro.paramStart = ++index;
+		
+		while ((index < end) && (pSpans[index].type != TOKEN_TYPE_PT_CLOSE_PAREN)) {
+			
+			if (preprocessor_is(pPreprocessor, &pSpans[index], "...")) newMacro.variadic = true;
+			else if (!preprocessor_isName(pPreprocessor, &pSpans[index]) || (newMacro.variadic)) {
+				preprocessor_error(pPreprocessor, &pSpans[index], "Expected a parameter name in macro", newMacro.name);
+				return;
+			}
+			newMacro.paramCount++;
+			index++;
+			
+			// Parameters are separated by single commas
+			if ((index < end) && (pSpans[index].type == TOKEN_TYPE_PT_COMMA) && (index + 1 < end) && (pSpans[index + 1].type != TOKEN_TYPE_PT_CLOSE_PAREN)) index++;
+			else if ((index < end) && (pSpans[index].type != TOKEN_TYPE_PT_CLOSE_PAREN)) {
+				preprocessor_error(pPreprocessor, &pSpans[index], "Expected a comma between parameters of macro", newMacro.name);
+				return;
+			}
+			
+		}
+		if (index >= end) {
+			preprocessor_error(pPreprocessor, pDirective, "Missing parenthesis after the parameters of macro", newMacro.name);
+			return;
+		}
+		if (newMacro.paramCount > PREPROCESSOR_MAX_ARGS) {
+			preprocessor_error(pPreprocessor, pDirective, "Too many parameters in macro", newMacro.name);
+			return;
+		}
+		newMacro.bodyStart = index + 1;
+		
+	}
+	newMacro.bodyEnd = end;
+	
+	// Defining a macro again replaces it
+	int32_t existing = preprocessor_lookup(pPreprocessor, newMacro.name, strlen(newMacro.name), true);
+	if (existing >= 0) {
+		free(pPreprocessor->macros.buffer[existing].memo.buffer);
+		pPreprocessor->macros.buffer[existing] = newMacro;
+	} else {
+		if (!buffer_resize((void**)&pPreprocessor->macros.buffer, &pPreprocessor->macros.memSize, pPreprocessor->macros.size + 1, sizeof(preprocessor_macro))) {
+			preprocessor_error(pPreprocessor, pDirective, "Out of memory defining macro", newMacro.name);
+			return;
+		}
+		pPreprocessor->macros.buffer[(pPreprocessor->macros.size)++] = newMacro;
+		if (!preprocessor_table_add(pPreprocessor, (int32_t)(pPreprocessor->macros.size - 1))) {
+			(pPreprocessor->macros.size)--;
+			preprocessor_error(pPreprocessor, pDirective, "Out of memory defining macro", newMacro.name);
+			return;
+		}
+	}
+	
+	(pPreprocessor->generation)++;
+	
+}
+
+static void preprocessor_include(preprocessor* pPreprocessor, preprocessor_frame* pFrame, size_t start, size_t end, preprocessor_span* pDirective) {
+	
+	if (start >= end) {
+		preprocessor_error(pPreprocessor, pDirective, "Expected a file name after", "#include");
+		return;
+	}
+	
+	// The name is read from the code, since the tokenizer splits it apart at every slash and period
+	char* text = preprocessor_text(pPreprocessor, &pFrame->buffer[start]);
+	size_t length = (pFrame->buffer[end - 1].offset + pFrame->buffer[end - 1].length) - pFrame->buffer[start].offset;
+	char close = (text[0] == '"') ? '"' : (text[0] == '<') ? '>' : '\0';
+	if ((close == '\0') || (length < 3) || (text[length - 1] != close) || (length - 2 >= PREPROCESSOR_MAX_PATH)) {
+		preprocessor_error(pPreprocessor, pDirective, "Expected a quoted file name after", "#include");
+		return;
+	}
+	
+	char name[PREPROCESSOR_MAX_PATH];
+	memcpy(name, &text[1], length - 2);
+	name[length - 2] = '\0';
+	
+	char path[PREPROCESSOR_MAX_PATH];
+	int32_t fileIndex = -1;
+	if (preprocessor_search(pPreprocessor, path, sizeof(path), name, pDirective->file)) fileIndex = preprocessor_load(pPreprocessor, path);
+	if (fileIndex < 0) {
+		preprocessor_error(pPreprocessor, pDirective, "Could not read included file", name);
+		return;
+	}
+	
+	// A file that can't change anything the second time is skipped without walking its tokens
+	preprocessor_file* pFile = &pPreprocessor->files.buffer[fileIndex];
+	if ((pFile->included) && (pFile->once)) return;
+	if ((pFile->included) && (pFile->guard[0] != '\0') && (preprocessor_lookup(pPreprocessor, pFile->guard, strlen(pFile->guard), false) >= 0)) return;
+	
+	preprocessor_frame newFrame = { .buffer = pFile->spans.buffer, .size = pFile->spans.size, .macro = -1, .file = fileIndex };
+	preprocessor_push(pPreprocessor, newFrame, pDirective);
+	
+}
+
+static void preprocessor_directive(preprocessor* pPreprocessor) {
+	
+	// The directive runs to the end of its line, which is where the frame picks up again
+	preprocessor_frame* pFrame = &pPreprocessor->frames[pPreprocessor->depth - 1];
+	preprocessor_span* pSpans = pFrame->buffer;
+	size_t start = pFrame->index;
+	size_t end = preprocessor_lineEnd(pPreprocessor, pSpans, pFrame->size, start);
+	pFrame->index = end;
+	
+	// The name is either part of the same token or, after a space, the one following it
+	preprocessor_span directive = pSpans[start];
+	char name[MAX_VALUE_LEN] = {};
+	size_t argStart = start + 1;
+	if (directive.length > 1) {
+		memcpy(name, preprocessor_text(pPreprocessor, &directive) + 1, directive.length - 1);
+	} else if (argStart < end) {
+		preprocessor_copy(pPreprocessor, &pSpans[argStart], name);
+		argStart++;
+	}
+	
+	// A line with only a # on it does nothing
+	if (name[0] == '\0') return;
+	
+	// Conditions are followed even while skipping, so the right #endif closes them
+	size_t conditionCount = pPreprocessor->conditions.size - pFrame->conditionBase;
+	preprocessor_condition* pTop = (conditionCount > 0) ? &pPreprocessor->conditions.buffer[pPreprocessor->conditions.size - 1] : NULL;
+	bool parentActive = (pPreprocessor->conditions.size < 2) || pPreprocessor->conditions.buffer[pPreprocessor->conditions.size - 2].active;
+	
+	if ((strcmp(name, "if") == 0) || (strcmp(name, "ifdef") == 0) || (strcmp(name, "ifndef") == 0)) {
+		
+		preprocessor_condition newCondition = {};
+		newCondition.span = directive;
+		
+		bool active = !preprocessor_skipping(pPreprocessor);
+		if ((active) && (strcmp(name, "if") == 0)) {
+			active = preprocessor_condition_value(pPreprocessor, pSpans, argStart, end, &directive);
+		} else if (active) {
+			if ((argStart >= end) || !preprocessor_isName(pPreprocessor, &pSpans[argStart])) {
+				preprocessor_error(pPreprocessor, &directive, "Expected a macro name after", name);
+			} else {
+				bool defined = preprocessor_find(pPreprocessor, &pSpans[argStart]) >= 0;
+				active = (strcmp(name, "ifdef") == 0) ? defined : !defined;
+			}
+		}
+		newCondition.active = active;
+		newCondition.taken = active;
+		
+		if (!buffer_resize((void**)&pPreprocessor->conditions.buffer, &pPreprocessor->conditions.memSize, pPreprocessor->conditions.size + 1, sizeof(preprocessor_condition))) {
+			preprocessor_error(pPreprocessor, &directive, "Out of memory at", NULL);
+			return;
+		}
+		pPreprocessor->conditions.buffer[(pPreprocessor->conditions.size)++] = newCondition;
+		return;
+		
+	} else if ((strcmp(name, "elif") == 0) || (strcmp(name, "else") == 0) || (strcmp(name, "endif") == 0)) {
+		
+		if (pTop == NULL) {
+			preprocessor_error(pPreprocessor, &directive, "No conditional to match", name);
+			return;
+		}
+		if (strcmp(name, "endif") == 0) {
+			(pPreprocessor->conditions.size)--;
+			return;
+		}
+		if (pTop->seenElse) {
+			preprocessor_error(pPreprocessor, &directive, "Conditional already has an #else before", name);
+			return;
+		}
+		
+		// Only the first branch that holds is kept
+		if (strcmp(name, "else") == 0) {
+			pTop->active = (parentActive) && !pTop->taken;
+			pTop->seenElse = true;
+		} else {
+			pTop->active = (parentActive) && !pTop->taken && preprocessor_condition_value(pPreprocessor, pSpans, argStart, end, &directive);
+		}
+		pTop->taken |= pTop->active;
+		return;
+		
+	}
+	
+	if (preprocessor_skipping(pPreprocessor)) return;
+	
+	// Handle every other directive appropriately
+	if (strcmp(name, "define") == 0) {
+		preprocessor_define(pPreprocessor, pFrame, argStart, end, &directive);
+	} else if (strcmp(name, "undef") == 0) {
+		
+		int32_t macro = ((argStart < end) && preprocessor_isName(pPreprocessor, &pSpans[argStart])) ? preprocessor_find(pPreprocessor, &pSpans[argStart]) : -1;
+		if (macro >= 0) {
+			pPreprocessor->macros.buffer[macro].defined = false;
+			(pPreprocessor->generation)++;
+		}
+		
+	} else if (strcmp(name, "include") == 0) {
+		preprocessor_include(pPreprocessor, pFrame, argStart, end, &directive);
+	} else if (strcmp(name, "pragma") == 0) {
+		
+		// Other pragmas are for other compilers
+		if ((argStart < end) && preprocessor_is(pPreprocessor, &pSpans[argStart], "once")) pPreprocessor->files.buffer[pFrame->file].once = true;
+		
+	} else if (strcmp(name, "error") == 0) {
+		
+		char* text = preprocessor_text(pPreprocessor, &directive);
+		size_t length = (pSpans[end - 1].offset + pSpans[end - 1].length) - directive.offset;
+		char msg[MAX_VALUE_LEN * 4];
+		snprintf(msg, sizeof(msg), "%.*s", (int)length, text);
+		preprocessor_error(pPreprocessor, &directive, msg, NULL);
+		
+	} else {
+		preprocessor_error(pPreprocessor, &directive, "Unknown directive", name);
+	}
+	
+}
+
+/*////////*/
+
+static bool preprocessor_pull(preprocessor* pPreprocessor, size_t floor, preprocessor_span* pSpan, uint32_t* pOffset) {
+	
+	while (pPreprocessor->depth > floor) {
+		
+		preprocessor_frame* pFrame = &pPreprocessor->frames[pPreprocessor->depth - 1];
+		if (pFrame->index >= pFrame->size) {
+			preprocessor_pop(pPreprocessor);
+			continue;
+		}
+		
+		// Directives and skipped branches only exist in files
+		preprocessor_span* pNext = &pFrame->buffer[pFrame->index];
+		if (pFrame->file >= 0) {
+			if (preprocessor_isDirective(pPreprocessor, pNext)) {
+				preprocessor_directive(pPreprocessor);
+				continue;
+			}
+			if (preprocessor_skipping(pPreprocessor)) {
+				(pFrame->index)++;
+				continue;
+			}
+		} else if (preprocessor_is(pPreprocessor, pNext, "\\")) {
+			
+			// Line continuations in a macro body are not part of it
+			(pFrame->index)++;
+			continue;
+			
+		}
+		(pFrame->index)++;
+		
+		// Spans of the file being compiled keep their place, everything else takes the place it came in at
+		preprocessor_span span = *pNext;
+		uint32_t offset = (pFrame->file == 0) ? span.offset : pFrame->origin;
+		
+		if (!pFrame->expanded) {
+			
+			int32_t macro = preprocessor_find(pPreprocessor, &span);
+			if ((macro >= 0) && !pPreprocessor->macros.buffer[macro].active) {
+				
+				// Only a parenthesis right after its name calls a macro that takes arguments; without one the name is left alone
+				if (!pPreprocessor->macros.buffer[macro].function) {
+					preprocessor_object(pPreprocessor, macro, &span);
+					continue;
+				}
+				if ((pFrame->index < pFrame->size) && (pFrame->buffer[pFrame->index].type == TOKEN_TYPE_PT_OPEN_PAREN)) {
+					preprocessor_function(pPreprocessor, macro, &span);
+					continue;
+				}
+				
+			}
+			
+		}
+		
+		*pSpan = span;
+		*pOffset = offset;
+		return true;
+		
+	}
+	
+	return false;
+	
+}
+
+/*////////*/
+
+static bool preprocessor_hasDirectives(code* pCode) {
+	
+	// Only a # with nothing but whitespace before it on its line starts a directive
+	char* end = &pCode->buffer[pCode->size];
+	for (char* hash = memchr(pCode->buffer, '#', pCode->size); hash != NULL; hash = memchr(hash + 1, '#', end - (hash + 1))) {
+		
+		char* line = hash;
+		while ((line > pCode->buffer) && ((line[-1] == ' ') || (line[-1] == '\t'))) line--;
+		if ((line == pCode->buffer) || (line[-1] == '\n')) return true;
+		
+	}
+	
+	return false;
+	
+}
+
+bool preprocessor_create(preprocessor* pPreprocessor, preprocessor_info* pInfo) {
+	
+	// Check if valid pointers were passed
+	if ((pInfo == NULL) || (pInfo->pCode == NULL)) return false;
+	
+	memset(pPreprocessor, 0, sizeof(preprocessor));
+	pPreprocessor->includePaths = pInfo->includePaths;
+	pPreprocessor->includeCount = pInfo->includeCount;
+	pPreprocessor->generation = 1;
+	
+	// Most files have no directives, and their stream is made straight from the code
+	pPreprocessor->needed = preprocessor_hasDirectives(pInfo->pCode);
+	if (!pPreprocessor->needed) return true;
+	
+	// The file being compiled is always the first one, and the bottom frame walks it
+	if (!buffer_resize((void**)&pPreprocessor->files.buffer, &pPreprocessor->files.memSize, 1, sizeof(preprocessor_file))) return false;
+	memset(&pPreprocessor->files.buffer[0], 0, sizeof(preprocessor_file));
+	pPreprocessor->files.buffer[0].pCode = pInfo->pCode;
+	pPreprocessor->files.size = 1;
+	
+	if (!preprocessor_lex(pPreprocessor, 0)) return false;
+	
+	preprocessor_frame newFrame = { .buffer = pPreprocessor->files.buffer[0].spans.buffer, .size = pPreprocessor->files.buffer[0].spans.size, .macro = -1, .file = 0 };
+	pPreprocessor->frames[(pPreprocessor->depth)++] = newFrame;
+	pPreprocessor->files.buffer[0].included = true;
+	
+	return true;
+	
+}
+
+bool preprocessor_stream(stream* pStream, preprocessor* pPreprocessor) {
+	
+	// Allocate a buffer for the stream
+	if (!stream_resize(pStream)) return false;
+	
+	// Tokens only get their text once they are known to reach the stream
+	preprocessor_span span;
+	uint32_t offset;
+	while (preprocessor_pull(pPreprocessor, 0, &span, &offset)) {
+		
+		if (!stream_resize(pStream)) return false;
+		
+		token* pToken = &pStream->buffer[(pStream->size)++];
+		pToken->type = span.type;
+		pToken->offset = offset;
+		preprocessor_copy(pPreprocessor, &span, pToken->value);
+		
+	}
+	
+	// The stream ends on an end of file token past its last one
+	if (!stream_resize(pStream)) return false;
+	token endToken = {};
+	endToken.type = TOKEN_TYPE_EOF;
+	endToken.offset = (uint32_t)pPreprocessor->files.buffer[0].pCode->size;
+	pStream->buffer[pStream->size] = endToken;
+	
+	return !pPreprocessor->failed;
+	
+}
+
+void preprocessor_destroy(preprocessor* pPreprocessor) {
+	
+	// Drop whatever frames an error left behind
+	while (pPreprocessor->depth > 0) {
+		preprocessor_frame* pFrame = &pPreprocessor->frames[--(pPreprocessor->depth)];
+		if (pFrame->owned) free(pFrame->buffer);
+	}
+	
+	// Free memory
+	for (size_t i = 0; i < pPreprocessor->files.size; i++) {
+		
+		preprocessor_file* pFile = &pPreprocessor->files.buffer[i];
+		free(pFile->spans.buffer);
+		if (!pFile->owned) continue;
+		
+		free(pFile->pCode->fileName);
+		code_destroy(pFile->pCode);
+		free(pFile->pCode);
+		
+	}
+	for (size_t i = 0; i < pPreprocessor->macros.size; i++) free(pPreprocessor->macros.buffer[i].memo.buffer);
+	
+	free(pPreprocessor->files.buffer);
+	free(pPreprocessor->macros.buffer);
+	free(pPreprocessor->macroTable.buffer);
+	free(pPreprocessor->conditions.buffer);
+	
+	memset(pPreprocessor, 0, sizeof(preprocessor));
+	
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+// [ MACROS ] //
+
+#define PREPROCESSOR_MAX_DEPTH 256 // Includes and macro expansions that can be in progress at once
+#define PREPROCESSOR_MAX_ARGS 64 // Arguments that can be passed to a single macro
+
+// [ DEFINING ] //
+
+typedef struct {
+	code* pCode;
+	char** includePaths; // Searched after the directory of the including file
+	size_t includeCount;
+} preprocessor_info;
+
+// A token as a place in a file, so its text is only copied once it reaches the stream
+typedef struct {
+	uint32_t offset;
+	uint16_t length;
+	uint16_t file;
+	token_type type;
+	bool lineStart; // Only tokens starting a line can start a directive
+} preprocessor_span;
+
+typedef struct {
+	size_t memSize;
+	size_t size;
+	preprocessor_span* buffer;
+} preprocessor_spans;
+
+typedef struct {
+	
+	code* pCode;
+	bool owned; // Included files are read by the preprocessor; the file being compiled is not
+	
+	preprocessor_spans spans; // Every token of the file, lexed once however many times it is included
+	
+	// A file that can't change anything the second time it is included is skipped without walking its tokens
+	bool included;
+	bool once; // #pragma once
+	char guard[MAX_VALUE_LEN]; // The macro an #ifndef around the whole file tests, if there is one
+	
+} preprocessor_file;
+
+typedef struct {
+	
+	char name[MAX_VALUE_LEN];
+	uint64_t hash;
+	bool defined;
+	
+	// The body and parameters are spans in the file the macro was defined in
+	uint16_t file;
+	size_t bodyStart;
+	size_t bodyEnd;
+	bool function;
+	size_t paramStart; // Parameters are every other span from here, with commas in between
+	size_t paramCount;
+	bool variadic;
+	
+	bool active; // Being expanded, so its name is left alone inside its own expansion
+	
+	// The full expansion of a macro without parameters, made outside of any other expansion and kept until a macro is defined or undefined
+	preprocessor_spans memo;
+	size_t memoGeneration;
+	
+} preprocessor_macro;
+
+typedef struct {
+	preprocessor_span* buffer;
+	size_t size;
+	size_t index;
+	bool owned; // The buffer was built for this frame
+	bool expanded; // The spans are already fully expanded and are passed on as they are
+	int32_t macro; // The macro this frame expands, or -1
+	int32_t file; // The file this frame walks, or -1 for an expansion
+	size_t conditionBase; // Conditions opened before this file, which it can't close
+	uint32_t origin; // Where in the compiled file everything from this frame is reported
+} preprocessor_frame;
+
+typedef struct {
+	preprocessor_span span; // The directive that opened it, for reporting one that is never closed
+	bool active; // Tokens are kept
+	bool taken; // A branch has been kept, so the rest are skipped
+	bool seenElse;
+} preprocessor_condition;
+
+typedef struct {
+	
+	bool needed; // The file has directives; without any, the stream is made from the code directly
+	bool failed;
+	
+	char** includePaths;
+	size_t includeCount;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		preprocessor_file* buffer;
+	} files;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		preprocessor_macro* buffer;
+	} macros;
+	
+	// Every macro by the hash of its name, open addressed; each slot is an index into macros, or -1 when it is empty
+	struct {
+		size_t memSize;
+		size_t size;
+		int32_t* buffer;
+	} macroTable;
+	
+	struct {
+		size_t memSize;
+		size_t size;
+		preprocessor_condition* buffer;
+	} conditions;
+	
+	preprocessor_frame frames[PREPROCESSOR_MAX_DEPTH];
+	size_t depth;
+	
+	size_t generation; // Changes whenever a macro is defined or undefined
+	
+} preprocessor;
+
+// [ FUNCTIONS ] //
+
+bool preprocessor_create(preprocessor* pPreprocessor, preprocessor_info* pInfo);
+bool preprocessor_stream(stream* pStream, preprocessor* pPreprocessor);
+void preprocessor_destroy(preprocessor* pPreprocessor);
\ No newline at end of file
@@ -113,10 +113,9 @@ token_type str_isLiteral(const char* str) {
 	}
 	
 	// String literal
-	size_t i = 0;
 	if (str[0] == '"') {
 		str++;
-		while (*str != '"' && i < MAX_VALUE_LEN) {
+		while (*str != '"' && *str != '\0') {
 			str++;
 		}
 		if (*str == '"') {
@@ -202,6 +201,9 @@ token token_parse(code* pCode) {
 		code_skipComments(pCode);
 		code_skipWhitespace(pCode);
 		
+		// Record where this token starts in the file
+		if (tokenValueIndex == 0) thisToken.offset = pCode->index;
+		
 		// If our code index is at the end of the file, return EOF immediately
 		if (pCode->index >= pCode->size) {
 			thisToken.type = TOKEN_TYPE_EOF;
@@ -327,6 +329,7 @@ void stream_print(stream* pStream) {
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_KW_EXPORT) ? "KW_EXPORT" :
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_KW_MODULE) ? "KW_MODULE" :
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_KW_HEADER) ? "KW_HEADER" :
+			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_KW_REFLECT) ? "KW_REFLECT" :
 			
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_LITERAL_CHAR) ? strcat(strcat(strcpy(value, "LITERAL_CHAR ["), pStream->buffer[tokenSetIndex].value), "]") :
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_LITERAL_STR) ? strcat(strcat(strcpy(value, "LITERAL_STR ["), pStream->buffer[tokenSetIndex].value), "]") :
@@ -346,6 +349,12 @@ void stream_print(stream* pStream) {
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_DIV) ? "OP_DIV" :
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_MOD) ? "OP_MOD" :
 			
+			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_EQUAL) ? "OP_CMP_EQUAL" :
+			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_NOT_EQUAL) ? "OP_CMP_NOT_EQUAL" :
+			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_LESS) ? "OP_CMP_LESS" :
+			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_LESS_EQUAL) ? "OP_CMP_LESS_EQUAL" :
+			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_GREATER) ? "OP_CMP_GREATER" :
+			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_GREATER_EQUAL) ? "OP_CMP_GREATER_EQUAL" :
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_NOT) ? "OP_CMP_NOT" :
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_OR) ? "OP_CMP_OR" :
 			(pStream->buffer[tokenSetIndex].type == TOKEN_TYPE_OP_CMP_AND) ? "OP_CMP_AND" :
@@ -380,17 +389,82 @@ void stream_print(stream* pStream) {
 	
 }
 
+static size_t stream_find(stream* pStream, uint32_t offset) {
+	
+	// Binary search for the token that starts at the offset, if one does
+	size_t low = 0;
+	size_t high = pStream->size;
+	while (low < high) {
+		size_t middle = low + ((high - low) / 2);
+		if (pStream->buffer[middle].offset < offset)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	
+	return ((low < pStream->size) && (pStream->buffer[low].offset == offset)) ? low : SIZE_MAX;
+	
+}
+
 bool stream_create(stream* pStream, stream_info* pInfo) {
 	
+	code* pCode = pInfo->pCode;
+	stream* pPrevious = (pInfo->pPreviousCode) ? pInfo->pPreviousStream : NULL;
+	
 	// Allocate a buffer for the stream
 	if (stream_resize(pStream) == false) return false;
 	
+	// Find how many bytes at the start and at the end are the same as last time
+	size_t front = 0;
+	size_t back = 0;
+	int64_t delta = 0;
+	if (pPrevious) {
+		
+		code* pPreviousCode = pInfo->pPreviousCode;
+		size_t limit = (pCode->size < pPreviousCode->size) ? pCode->size : pPreviousCode->size;
+		
+		while ((front < limit) && (pCode->buffer[front] == pPreviousCode->buffer[front])) front++;
+		while ((back < (limit - front)) && (pCode->buffer[pCode->size - back - 1] == pPreviousCode->buffer[pPreviousCode->size - back - 1])) back++;
+		
+		delta = (int64_t)pCode->size - (int64_t)pPreviousCode->size;
+		
+		// A token is the same if the lexer read no further than the front for it, which it didn't if the next token starts far enough before the change
+		size_t kept = 0;
+		while ((kept < pPrevious->size) && (((size_t)pPrevious->buffer[kept + 1].offset + STREAM_LOOKAHEAD) <= front)) {
+			if ((pStream->size) == pStream->memSize) if (!stream_resize(pStream)) return false;
+			pStream->buffer[(pStream->size)++] = pPrevious->buffer[kept++];
+		}
+		
+		// Lexing starts again at the first token that wasn't kept, which starts before the change too
+		pCode->index = (kept > 0) ? pPrevious->buffer[kept].offset : 0;
+		
+	}
+	
 	// Add new tokens until we reach EOF
 	while (1) {
+		
 		if ((pStream->size) == pStream->memSize)  if (!stream_resize(pStream)) return false;
-		pStream->buffer[pStream->size] = token_parse(pInfo->pCode);
+		pStream->buffer[pStream->size] = token_parse(pCode);
 		if (pStream->buffer[pStream->size].type == TOKEN_TYPE_EOF) break;
+		
+		// A token that starts past the change, where one started last time, is followed by the same tokens as it was, only moved
+		uint32_t offset = pStream->buffer[pStream->size].offset;
+		size_t match = ((pPrevious) && (offset >= (pCode->size - back))) ? stream_find(pPrevious, (uint32_t)((int64_t)offset - delta)) : SIZE_MAX;
+		if (match != SIZE_MAX) {
+			
+			for (size_t i = match; i <= pPrevious->size; i++) {
+				if ((pStream->size) == pStream->memSize) if (!stream_resize(pStream)) return false;
+				pStream->buffer[pStream->size] = pPrevious->buffer[i];
+				pStream->buffer[pStream->size].offset = (uint32_t)((int64_t)pPrevious->buffer[i].offset + delta);
+				if (i < pPrevious->size) (pStream->size)++;
+			}
+			
+			break;
+			
+		}
+		
 		(pStream->size)++;
+		
 	}
 	
 	// Return success
@@ -398,6 +472,25 @@ bool stream_create(stream* pStream, stream_info* pInfo) {
 	
 }
 
+bool stream_copy(stream* pDest, stream* pSource) {
+	
+	stream newStream = {};
+	
+	// Copy the tokens, and the end of file token after them
+	newStream.buffer = calloc(pSource->size + 1, sizeof(token));
+	if (!newStream.buffer) return false;
+	memcpy(newStream.buffer, pSource->buffer, ((pSource->size + 1) * sizeof(token)));
+	newStream.memSize = pSource->size + 1;
+	newStream.size = pSource->size;
+	
+	// Set the stream to the new one
+	*pDest = newStream;
+	
+	// Return success
+	return true;
+	
+}
+
 void stream_destroy(stream* pStream) {
 	
 	// Free memory
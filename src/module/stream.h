@@ -1,5 +1,9 @@
 #pragma once
 
+// [ MACROS ] //
+
+#define STREAM_LOOKAHEAD (MAX_OPERATOR_LEN + MAX_PUNCTUATOR_LEN) // How far past the end of a token the lexer may read
+
 // [ DEFINING ] //
 
 typedef enum {
@@ -57,6 +61,7 @@ typedef enum {
 	
 	// Comparison operator tokens
 	TOKEN_TYPE_OP_CMP_EQUAL,
+	TOKEN_TYPE_OP_CMP_NOT_EQUAL,
 	TOKEN_TYPE_OP_CMP_LESS_EQUAL,
 	TOKEN_TYPE_OP_CMP_GREATER_EQUAL,
 	TOKEN_TYPE_OP_CMP_LESS,
@@ -138,30 +143,47 @@ typedef enum {
 	TOKEN_TYPE_KW_MODULE,
 	TOKEN_TYPE_KW_HEADER,
 	
+	TOKEN_TYPE_KW_REFLECT,
+	
+	// Token type count
+	TOKEN_TYPE_COUNT,
+	
 } token_type;
 
 typedef struct token {
 	token_type type;
 	char value[MAX_VALUE_LEN];
+	uint32_t offset;
 } token;
 
 /*////////*/
 
+typedef struct stream stream;
+
 typedef struct {
 	code* pCode;
 	symbol_table* pSymbolTable;
+	
+	// The file as it was last lexed, if it was; only what changed since is lexed again
+	code* pPreviousCode;
+	stream* pPreviousStream;
 } stream_info;
 
-typedef struct {
+struct stream {
 	size_t memSize;
 	size_t size;
 	size_t index;
 	token* buffer;
-} stream;
+};
 
 // [ FUNCTIONS ] //
 
+token token_parse(code* pCode);
+
 void stream_print(stream* pStream);
 
+bool stream_resize(stream* pStream);
+
 bool stream_create(stream* pStream, stream_info* pInfo);
+bool stream_copy(stream* pDest, stream* pSource);
 void stream_destroy(stream* pStream);
\ No newline at end of file
@@ -182,6 +182,38 @@ void symbol_table_print(symbol_table* pSymbolTable) {
 	
 }
 
+bool symbol_table_copy(symbol_table* pDest, symbol_table* pSource) {
+	
+	symbol_table newTable = {};
+	
+	// Copy the symbols
+	if (pSource->memSize > 0) {
+		newTable.buffer = calloc(pSource->memSize, sizeof(symbol));
+		if (!newTable.buffer) return false;
+		memcpy(newTable.buffer, pSource->buffer, (pSource->size * sizeof(symbol)));
+		newTable.memSize = pSource->memSize;
+		newTable.size = pSource->size;
+	}
+	
+	// Copy the scope index sizes
+	if (pSource->indicesSize > 0) {
+		newTable.indicesBuffer = calloc(pSource->indicesSize, sizeof(size_t));
+		if (!newTable.indicesBuffer) {
+			free(newTable.buffer);
+			return false;
+		}
+		memcpy(newTable.indicesBuffer, pSource->indicesBuffer, (pSource->indicesSize * sizeof(size_t)));
+		newTable.indicesSize = pSource->indicesSize;
+	}
+	
+	// Set the table to the new one
+	*pDest = newTable;
+	
+	// Return success
+	return true;
+	
+}
+
 bool symbol_table_create(symbol_table* pSymbolTable) {
 	
 	// Allocate a buffer for the symbol table
@@ -194,9 +226,13 @@ bool symbol_table_create(symbol_table* pSymbolTable) {
 
 void symbol_table_destroy(symbol_table* pSymbolTable) {
 	
-	// Free memory
+	// Free memory; the table can be destroyed again or recreated afterwards
 	free(pSymbolTable->buffer);
+	free(pSymbolTable->indicesBuffer);
+	pSymbolTable->buffer = NULL;
+	pSymbolTable->indicesBuffer = NULL;
 	pSymbolTable->memSize = 0;
 	pSymbolTable->size = 0;
+	pSymbolTable->indicesSize = 0;
 	
 }
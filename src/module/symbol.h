@@ -79,5 +79,6 @@ symbol* symbol_find(symbol_table* pSymbolTable, char* identifier, uint16_t class
 
 void symbol_table_print(symbol_table* pSymbolTable);
 
+bool symbol_table_copy(symbol_table* pDest, symbol_table* pSource);
 bool symbol_table_create(symbol_table* pSymbolTable);
 void symbol_table_destroy(symbol_table* pSymbolTable);
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+/* NOTES
+// A request is a server_request header followed by `size` bytes of null terminated strings: the client's
+// working directory, then each of its command line arguments. The reply is a server_response header
+// followed by `size` bytes of compiler output, after which the server closes the connection.
+*/
+
+// [ MACROS ] //
+
+#define SERVER_DEFAULT_PATH "csrcompiler.sock"
+#define SERVER_MAX_REQUEST 65536
+
+// [ DEFINING ] //
+
+typedef struct {
+	uint32_t size;
+} server_request;
+
+typedef struct {
+	int32_t status;
+	uint32_t size;
+} server_response;